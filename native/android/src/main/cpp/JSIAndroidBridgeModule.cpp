@@ -1,9 +1,14 @@
 #include "JSIAndroidBridgeModule.h"
 #include "JSIAndroidUtils.h"
 #include "SliceImportEngine.h"
+#include "SliceEncoder.h"
+#include "SliceReferenceDatabase.h"
+#include "SlicePlatform.h"
 #include "SliceImportDatabaseAdapterAndroid.h"
 #include "../../../../shared/SyncApplyEngine.h"
 #include "../../../../shared/JsonUtils.h"
+#include "../../../../shared/AsyncQueryExecutor.h"
+#include "../../../../shared/SqliteCursor.h"
 
 #include <jni.h>
 #include <fbjni/fbjni.h>
@@ -14,6 +19,7 @@
 #include "SQLiteConnection.h"
 #include <ReactCommon/TurboModuleUtils.h>
 #include <unordered_map>
+#include <algorithm>
 #include <cctype>
 
 namespace facebook::react {
@@ -37,6 +43,46 @@ void releaseImport(void* key) {
     std::lock_guard<std::mutex> lock(gImportMutex);
     gActiveImports.erase(key);
 }
+
+// Result of a query that couldn't run off the JS thread and was read synchronously
+jsi::Value resolvedPromise(jsi::Runtime &rt, jsi::Value value) {
+    auto result = std::make_shared<jsi::Value>(std::move(value));
+    return createPromiseAsJSIValue(rt, [result](jsi::Runtime &rt2, std::shared_ptr<Promise> promise) {
+        promise->resolve(*result);
+    });
+}
+
+using SnapshotReader = std::function<jsi::Value(jsi::Runtime &rt, const watermelondb::PackedResultSnapshot &snapshot)>;
+
+// Runs `sql` on a pooled reader connection on the shared executor; only `read`, which turns the
+// native snapshot into the JS result, runs on the JS thread
+jsi::Value runAsyncQuery(jsi::Runtime &rt,
+                         std::shared_ptr<CallInvoker> jsInvoker,
+                         std::shared_ptr<watermelondb::SqliteReaderPool> pool,
+                         std::string sql,
+                         std::vector<watermelondb::QueryArgument> arguments,
+                         uint64_t requestId,
+                         SnapshotReader read) {
+    return createPromiseAsJSIValue(rt, [jsInvoker, pool, sql, arguments, requestId, read](jsi::Runtime &rt2, std::shared_ptr<Promise> promise) {
+        jsi::Runtime *runtime = &rt2;
+        watermelondb::AsyncQueryExecutor::shared().submit(requestId, pool, sql, arguments,
+            [jsInvoker, runtime, promise, read](watermelondb::AsyncQueryStatus status,
+                                               std::shared_ptr<const watermelondb::PackedResultSnapshot> result,
+                                               const std::string &errorMessage) {
+                jsInvoker->invokeAsync([runtime, promise, read, status, result, errorMessage]() mutable {
+                    if (status != watermelondb::AsyncQueryStatus::Completed) {
+                        promise->reject(errorMessage);
+                        return;
+                    }
+                    try {
+                        promise->resolve(read(*runtime, *result));
+                    } catch (const jsi::JSError &error) {
+                        promise->reject(error.getMessage());
+                    }
+                });
+            });
+    });
+}
 } // namespace
 
 static void emitSocketEvent(const std::string &eventJson) {
@@ -386,8 +432,6 @@ jobject JSIAndroidBridgeModule::getDatabaseBridge() {
 }
 
 jsi::Array JSIAndroidBridgeModule::query(jsi::Runtime &rt, double tag, jsi::String table, jsi::String query) {
-    const std::lock_guard<std::mutex> lock(mutex_);
-    
     jobject databaseBridge = getDatabaseBridge();
     
     if (databaseBridge == nullptr) {
@@ -403,8 +447,6 @@ jsi::Array JSIAndroidBridgeModule::query(jsi::Runtime &rt, double tag, jsi::Stri
 }
 
 jsi::Array JSIAndroidBridgeModule::execSqlQuery(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args) {
-    const std::lock_guard<std::mutex> lock(mutex_);
-
     jobject databaseBridge = getDatabaseBridge();
 
     if (databaseBridge == nullptr) {
@@ -420,8 +462,6 @@ jsi::Array JSIAndroidBridgeModule::execSqlQuery(jsi::Runtime &rt, double tag, js
 }
 
 jsi::Array JSIAndroidBridgeModule::execSqlQueryOnWriter(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args) {
-    const std::lock_guard<std::mutex> lock(mutex_);
-
     jobject databaseBridge = getDatabaseBridge();
 
     if (databaseBridge == nullptr) {
@@ -436,10 +476,137 @@ jsi::Array JSIAndroidBridgeModule::execSqlQueryOnWriter(jsi::Runtime &rt, double
     return result.asObject(rt).asArray(rt);
 }
 
-jsi::Value JSIAndroidBridgeModule::importRemoteSlice(jsi::Runtime &rt, double tag, jsi::String sliceUrl) {
+jsi::Object JSIAndroidBridgeModule::execSqlQueryColumnar(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args) {
+    jobject databaseBridge = getDatabaseBridge();
+
+    if (databaseBridge == nullptr) {
+        throw jsi::JSError(rt, "DatabaseBridge instance not available. Make sure the DatabaseBridge native module is initialized.");
+    }
+
+    // Convert double tag to jsi::Value
+    jsi::Value tagValue = jsi::Value(tag);
+
+    jsi::Value result = watermelondb::execSqlQuery(databaseBridge, rt, tagValue, sql, args, watermelondb::ResultFormat::Columnar);
+
+    return result.asObject(rt);
+}
+
+jsi::Object JSIAndroidBridgeModule::execSqlQueryPacked(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args) {
+    jobject databaseBridge = getDatabaseBridge();
+
+    if (databaseBridge == nullptr) {
+        throw jsi::JSError(rt, "DatabaseBridge instance not available. Make sure the DatabaseBridge native module is initialized.");
+    }
+
+    // Convert double tag to jsi::Value
+    jsi::Value tagValue = jsi::Value(tag);
+
+    jsi::Value result = watermelondb::execSqlQuery(databaseBridge, rt, tagValue, sql, args, watermelondb::ResultFormat::Packed);
+
+    return result.asObject(rt);
+}
+
+jsi::Array JSIAndroidBridgeModule::execSqlQueryLazy(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args) {
+    jobject databaseBridge = getDatabaseBridge();
+
+    if (databaseBridge == nullptr) {
+        throw jsi::JSError(rt, "DatabaseBridge instance not available. Make sure the DatabaseBridge native module is initialized.");
+    }
+
+    // Convert double tag to jsi::Value
+    jsi::Value tagValue = jsi::Value(tag);
+
+    jsi::Value result = watermelondb::execSqlQuery(databaseBridge, rt, tagValue, sql, args, watermelondb::ResultFormat::LazyRows);
+
+    return result.asObject(rt).asArray(rt);
+}
+
+jsi::Value JSIAndroidBridgeModule::queryAsync(jsi::Runtime &rt, double tag, jsi::String table, jsi::String query, double requestId) {
+    jobject databaseBridge = getDatabaseBridge();
+
+    if (databaseBridge == nullptr) {
+        throw jsi::JSError(rt, "DatabaseBridge instance not available. Make sure the DatabaseBridge native module is initialized.");
+    }
+
+    const jint connectionTag = static_cast<jint>(tag);
+    auto pool = watermelondb::readerPool(databaseBridge, rt, connectionTag);
+    if (!pool) {
+        // In-memory database: no other connection can read it
+        return resolvedPromise(rt, watermelondb::query(databaseBridge, rt, jsi::Value(tag), table, query));
+    }
+
+    // Records are checked against the cache when the result reaches the JS thread, not when the
+    // query runs, so a cancelled query never marks anything as cached
+    auto cache = watermelondb::recordCache(databaseBridge, rt, connectionTag);
+    const watermelondb::Identifier tableId = watermelondb::internIdentifier(table.utf8(rt));
+    return runAsyncQuery(rt, jsInvoker_, std::move(pool), query.utf8(rt), {}, static_cast<uint64_t>(requestId),
+                         [cache, tableId](jsi::Runtime &rt2, const watermelondb::PackedResultSnapshot &snapshot) -> jsi::Value {
+        return watermelondb::snapshotRecords(rt2, snapshot, [&](const char *id, size_t length) {
+            return cache->checkAndMark(tableId, std::string_view(id, length));
+        });
+    });
+}
+
+jsi::Value JSIAndroidBridgeModule::execSqlQueryAsync(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args, double requestId) {
+    jobject databaseBridge = getDatabaseBridge();
+
+    if (databaseBridge == nullptr) {
+        throw jsi::JSError(rt, "DatabaseBridge instance not available. Make sure the DatabaseBridge native module is initialized.");
+    }
+
+    const jint connectionTag = static_cast<jint>(tag);
+    std::string sqlUtf8 = sql.utf8(rt);
+    auto pool = watermelondb::isReadOnlyQuery(sqlUtf8) ? watermelondb::readerPool(databaseBridge, rt, connectionTag) : nullptr;
+    if (!pool) {
+        // Writes, reads of temp tables and in-memory databases need the platform's connections
+        return resolvedPromise(rt, watermelondb::execSqlQuery(databaseBridge, rt, jsi::Value(tag), sql, args));
+    }
+
+    return runAsyncQuery(rt, jsInvoker_, std::move(pool), std::move(sqlUtf8), watermelondb::queryArguments(rt, args),
+                         static_cast<uint64_t>(requestId),
+                         [](jsi::Runtime &rt2, const watermelondb::PackedResultSnapshot &snapshot) -> jsi::Value {
+        return watermelondb::snapshotRows(rt2, snapshot);
+    });
+}
+
+bool JSIAndroidBridgeModule::cancelQuery(jsi::Runtime &rt, double requestId) {
+    return watermelondb::AsyncQueryExecutor::shared().cancel(static_cast<uint64_t>(requestId));
+}
+
+double JSIAndroidBridgeModule::openCursor(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args) {
+    jobject databaseBridge = getDatabaseBridge();
+
+    if (databaseBridge == nullptr) {
+        throw jsi::JSError(rt, "DatabaseBridge instance not available. Make sure the DatabaseBridge native module is initialized.");
+    }
+
+    std::string sqlUtf8 = sql.utf8(rt);
+    if (!watermelondb::isReadOnlyQuery(sqlUtf8)) {
+        throw jsi::JSError(rt, "Cursors must be read-only");
+    }
+    auto pool = watermelondb::readerPool(databaseBridge, rt, static_cast<jint>(tag));
+    return static_cast<double>(watermelondb::openCursor(rt, pool, sqlUtf8, args));
+}
+
+jsi::Object JSIAndroidBridgeModule::fetchCursor(jsi::Runtime &rt, double cursorId, double maxRows, double maxMillis) {
+    return watermelondb::fetchCursor(rt, static_cast<uint64_t>(cursorId), static_cast<size_t>(std::max(maxRows, 0.0)),
+                                     static_cast<uint32_t>(std::max(maxMillis, 0.0)));
+}
+
+bool JSIAndroidBridgeModule::closeCursor(jsi::Runtime &rt, double cursorId) {
+    return watermelondb::SqliteCursors::shared().close(static_cast<uint64_t>(cursorId));
+}
+
+jsi::Value JSIAndroidBridgeModule::importRemoteSlice(jsi::Runtime &rt, double tag, jsi::String sliceUrl, jsi::String optionsJson) {
     const double tagCopy = tag;
     const std::string sliceUrlUtf8 = sliceUrl.utf8(rt);
 
+    watermelondb::SliceImportOptions options;
+    std::string optionsError;
+    if (!watermelondb::parseSliceImportOptions(optionsJson.utf8(rt), options, optionsError)) {
+        throw jsi::JSError(rt, optionsError);
+    }
+
     jobject databaseBridge = getDatabaseBridge();
     
     if (databaseBridge == nullptr) {
@@ -448,12 +615,19 @@ jsi::Value JSIAndroidBridgeModule::importRemoteSlice(jsi::Runtime &rt, double ta
 
     auto jsInvoker = jsInvoker_;
 
-    return createPromiseAsJSIValue(rt, [databaseBridge, tagCopy, sliceUrlUtf8, jsInvoker](jsi::Runtime &rt2, std::shared_ptr<Promise> promise) {
+    return createPromiseAsJSIValue(rt, [this, databaseBridge, tagCopy, sliceUrlUtf8, options, jsInvoker](jsi::Runtime &rt2, std::shared_ptr<Promise> promise) {
         JNIEnv* env = watermelondb::getEnv();
         if (env) {
             watermelondb::configureJNI(env);
         }
-        auto dbInterface = createAndroidDatabaseInterface(databaseBridge, static_cast<jint>(tagCopy));
+        std::shared_ptr<watermelondb::DatabaseInterface> dbInterface;
+        if (!options.referencePath.empty()) {
+            dbInterface = std::make_shared<watermelondb::SliceReferenceDatabase>(options.referencePath, options.referenceIndexes);
+        } else if (options.bootstrap) {
+            dbInterface = createAndroidBootstrapDatabaseInterface(databaseBridge, static_cast<jint>(tagCopy));
+        } else {
+            dbInterface = createAndroidDatabaseInterface(databaseBridge, static_cast<jint>(tagCopy));
+        }
         if (!dbInterface) {
             jsInvoker->invokeAsync([promise]() mutable {
                 promise->reject("Failed to create Android database interface");
@@ -461,23 +635,153 @@ jsi::Value JSIAndroidBridgeModule::importRemoteSlice(jsi::Runtime &rt, double ta
             return;
         }
 
-        auto engine = std::make_shared<watermelondb::SliceImportEngine>(dbInterface);
-        void* engineKey = engine.get();
+        auto engine = std::make_shared<watermelondb::SliceImportEngine>(dbInterface, options);
+        if (options.commitMode != watermelondb::SliceCommitMode::Atomic) {
+            engine->setCommitCallback([this](const std::vector<std::string>& tables, size_t rowsCommitted) {
+                emitSyncEventLocked(watermelondb::sliceCommitEventJson(tables, rowsCommitted));
+            });
+        }
+        // Records a delta slice rewrites must stop reading as cached, or query() keeps returning bare
+        // ids for them and JS keeps the stale models. Reference slices don't touch app records.
+        const bool reportChanges = options.referencePath.empty();
+        std::shared_ptr<watermelondb::RecordCache> cache;
+        if (reportChanges) {
+            try {
+                cache = watermelondb::recordCache(databaseBridge, rt2, static_cast<jint>(tagCopy));
+            } catch (const jsi::JSError&) {
+                cache = nullptr;
+            }
+        }
+        watermelondb::SliceImportEngine* engineKey = engine.get();
+        jsi::Runtime *runtime = &rt2;
         retainImport(engine);
 
-        engine->startImport(sliceUrlUtf8, [engineKey, jsInvoker, promise](const std::string& errorMessage) mutable {
+        engine->startImport(sliceUrlUtf8, [engineKey, reportChanges, cache, jsInvoker, runtime, promise](const std::string& errorMessage) mutable {
+            // Resolve a { "changeset", "error" } envelope whenever the engine ran: with progressive
+            // commits a failed import may still have changed records (see SyncManager.importRemoteSlice)
+            // The engine is retained until releaseImport
+            watermelondb::SyncChangeset changeset;
+            if (reportChanges) {
+                changeset = engineKey->takeCommittedChangeset();
+            }
             releaseImport(engineKey);
-            jsInvoker->invokeAsync([promise, errorMessage]() mutable {
-                if (!errorMessage.empty()) {
-                    promise->reject(errorMessage);
+            const std::string resultJson = watermelondb::sliceImportResultJson(changeset, errorMessage);
+            jsInvoker->invokeAsync([promise, cache, changeset = std::move(changeset), resultJson, runtime]() mutable {
+                for (const auto& tableEntry : changeset) {
+                    if (!cache) {
+                        break;
+                    }
+                    const watermelondb::Identifier tableId = watermelondb::internIdentifier(tableEntry.first);
+                    for (const auto& id : tableEntry.second.upserted) {
+                        cache->remove(tableId, id);
+                    }
+                    for (const auto& id : tableEntry.second.deleted) {
+                        cache->remove(tableId, id);
+                    }
+                }
+                promise->resolve(jsi::String::createFromUtf8(*runtime, resultJson));
+            });
+        });
+    });
+}
+
+jsi::Value JSIAndroidBridgeModule::exportSlice(jsi::Runtime &rt, double tag, jsi::String path, jsi::String optionsJson) {
+    const jint connectionTag = static_cast<jint>(tag);
+    const std::string pathUtf8 = path.utf8(rt);
+
+    watermelondb::SliceExportOptions options;
+    std::string optionsError;
+    if (!watermelondb::parseSliceExportOptions(optionsJson.utf8(rt), options, optionsError)) {
+        throw jsi::JSError(rt, optionsError);
+    }
+
+    jobject databaseBridge = getDatabaseBridge();
+
+    if (databaseBridge == nullptr) {
+        throw jsi::JSError(rt, "DatabaseBridge instance not available. Make sure the DatabaseBridge native module is initialized.");
+    }
+
+    auto jsInvoker = jsInvoker_;
+
+    return createPromiseAsJSIValue(rt, [databaseBridge, connectionTag, pathUtf8, options, jsInvoker](jsi::Runtime &rt2, std::shared_ptr<Promise> promise) {
+        JNIEnv* env = watermelondb::getEnv();
+        if (env) {
+            watermelondb::configureJNI(env);
+        }
+        auto runOnLive = createAndroidLiveConnectionRunner(databaseBridge, connectionTag);
+        jsi::Runtime *runtime = &rt2;
+
+        // Same serial queue as slice imports, so an export never interleaves with an import's writes
+        watermelondb::platform::runOnWorkQueue([runOnLive, pathUtf8, options, jsInvoker, runtime, promise]() mutable {
+            watermelondb::SliceExportStats stats;
+            std::string errorMessage;
+            bool ok = runOnLive([&](sqlite3* db, std::string& error) {
+                return watermelondb::exportSlice(db, pathUtf8, options, &stats, error);
+            }, errorMessage);
+            std::string statsJson = watermelondb::sliceExportStatsJson(stats);
+            jsInvoker->invokeAsync([promise, ok, errorMessage, statsJson, runtime]() mutable {
+                if (!ok) {
+                    promise->reject(errorMessage.empty() ? "Slice export failed" : errorMessage);
                 } else {
-                    promise->resolve(jsi::Value::undefined());
+                    promise->resolve(jsi::String::createFromUtf8(*runtime, statsJson));
                 }
             });
         });
     });
 }
 
+void JSIAndroidBridgeModule::attachReferenceSlice(jsi::Runtime &rt, double tag, jsi::String path, jsi::String alias) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const std::string pathUtf8 = path.utf8(rt);
+    const std::string aliasUtf8 = alias.utf8(rt);
+
+    jobject databaseBridge = getDatabaseBridge();
+
+    if (databaseBridge == nullptr) {
+        throw jsi::JSError(rt, "DatabaseBridge instance not available. Make sure the DatabaseBridge native module is initialized.");
+    }
+
+    // Attached databases and temp views are per connection
+    for (bool readConnection : {false, true}) {
+        watermelondb::withSQLiteConnection(databaseBridge, rt, static_cast<jint>(tag), readConnection,
+                                           [&](sqlite3* db, std::string& error) {
+            return watermelondb::attachReferenceDatabase(db, pathUtf8, aliasUtf8, error);
+        });
+    }
+    // Pooled JSI readers pick it up before their next query
+    if (auto pool = watermelondb::readerPool(databaseBridge, rt, static_cast<jint>(tag))) {
+        pool->setConnectionHook(
+            "reference:" + aliasUtf8,
+            [pathUtf8, aliasUtf8](sqlite3* db, std::string& error) {
+                return watermelondb::attachReferenceDatabase(db, pathUtf8, aliasUtf8, error);
+            },
+            [aliasUtf8](sqlite3* db, std::string& error) {
+                return watermelondb::detachReferenceDatabase(db, aliasUtf8, error);
+            });
+    }
+}
+
+void JSIAndroidBridgeModule::detachReferenceSlice(jsi::Runtime &rt, double tag, jsi::String alias) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const std::string aliasUtf8 = alias.utf8(rt);
+
+    jobject databaseBridge = getDatabaseBridge();
+
+    if (databaseBridge == nullptr) {
+        throw jsi::JSError(rt, "DatabaseBridge instance not available. Make sure the DatabaseBridge native module is initialized.");
+    }
+
+    for (bool readConnection : {false, true}) {
+        watermelondb::withSQLiteConnection(databaseBridge, rt, static_cast<jint>(tag), readConnection,
+                                           [&](sqlite3* db, std::string& error) {
+            return watermelondb::detachReferenceDatabase(db, aliasUtf8, error);
+        });
+    }
+    if (auto pool = watermelondb::readerPool(databaseBridge, rt, static_cast<jint>(tag))) {
+        pool->removeConnectionHook("reference:" + aliasUtf8);
+    }
+}
+
 void JSIAndroidBridgeModule::configureSync(jsi::Runtime &rt, jsi::String configJson) {
     auto state = syncEventState_;
     if (state) {
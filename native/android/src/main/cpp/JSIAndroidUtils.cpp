@@ -1,5 +1,9 @@
 #include "JSIAndroidUtils.h"
 #include "../../../../shared/DatabaseUtils.h"
+#include "../../../../shared/SqliteStatementCache.h"
+#include "../../../../shared/RecordCache.h"
+#include "../../../../shared/SqliteReaderPool.h"
+#include "../../../../shared/SqliteCursor.h"
 #include <string>
 #include <cctype>
 #include <algorithm>
@@ -10,6 +14,8 @@
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#include <memory>
+#include <unordered_map>
 
 using namespace watermelondb;
 
@@ -41,7 +47,7 @@ namespace watermelondb {
                lower.find("sqlite_temp_master") != std::string::npos;
     }
 
-    static bool isReadOnlyQuery(const std::string &query) {
+    bool isReadOnlyQuery(const std::string &query) {
         if (referencesTemporaryTable(query)) {
             return false;
         }
@@ -134,7 +140,66 @@ namespace watermelondb {
         }
     }
 
-    jsi::Value execSqlQuery(jobject bridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &arguments) {
+    // Locks are per connection rather than per module: writes queue on the writer of their
+    // database, reads lease a pooled reader connection and run alongside each other and the writer
+    static std::mutex gConnectionLocksMutex;
+    static std::unordered_map<jint, std::shared_ptr<std::mutex>> gWriterLocks;
+    static std::unordered_map<jint, std::shared_ptr<SqliteReaderPool>> gReaderPools;
+
+    static std::shared_ptr<std::mutex> writerLock(jint tag) {
+        const std::lock_guard<std::mutex> lock(gConnectionLocksMutex);
+        auto &writerMutex = gWriterLocks[tag];
+        if (!writerMutex) {
+            writerMutex = std::make_shared<std::mutex>();
+        }
+        return writerMutex;
+    }
+
+    std::shared_ptr<SqliteReaderPool> readerPool(jobject bridge, jsi::Runtime &rt, jint tag) {
+        {
+            const std::lock_guard<std::mutex> lock(gConnectionLocksMutex);
+            auto found = gReaderPools.find(tag);
+            if (found != gReaderPools.end() && (!found->second || !found->second->isClosed())) {
+                return found->second;
+            }
+        }
+        // First use (or the database was closed and reopened): find the file through the platform
+        // reader once
+        std::string path;
+        withSQLiteConnection(bridge, rt, tag, true, [&](sqlite3 *db, std::string &) {
+            const char *filename = sqlite3_db_filename(db, "main");
+            path = filename ? filename : "";
+            return true;
+        });
+        auto pool = SqliteReaderPool::forPath(path);
+        const std::lock_guard<std::mutex> lock(gConnectionLocksMutex);
+        gReaderPools[tag] = pool;
+        return pool;
+    }
+
+    static SqliteReaderPool::Lease leaseReader(jsi::Runtime &rt, SqliteReaderPool &pool) {
+        std::string errorMessage;
+        auto lease = pool.acquire(errorMessage);
+        if (!lease) {
+            throw jsi::JSError(rt, errorMessage);
+        }
+        return lease;
+    }
+
+    static jsi::Value runStatement(jsi::Runtime &rt, sqlite3 *db, const std::string &sql, const jsi::Array &arguments, ResultFormat format) {
+        sqlite3_stmt* stmt = getStmt(rt, db, sql, arguments);
+        jsi::Value result;
+        try {
+            result = readResult(rt, stmt, format);
+        } catch (...) {
+            finalizeStmt(stmt);
+            throw;
+        }
+        finalizeStmt(stmt);
+        return result;
+    }
+
+    jsi::Value execSqlQuery(jobject bridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &arguments, ResultFormat format) {
         JNIEnv *env = getEnv();
         if (!env) {
             throw jsi::JSError(rt, "JNI env not available");
@@ -146,6 +211,18 @@ namespace watermelondb {
         LocalRef<jclass> myNativeModuleClass(env, env->GetObjectClass(bridge));
 
         const bool readOnly = isReadOnlyQuery(queryStr);
+        if (readOnly) {
+            if (auto pool = readerPool(bridge, rt, jTag)) {
+                auto lease = leaseReader(rt, *pool);
+                return runStatement(rt, lease.db(), queryStr, arguments, format);
+            }
+        }
+        auto writerMutex = writerLock(jTag);
+        std::unique_lock<std::mutex> writerGuard(*writerMutex, std::defer_lock);
+        if (!readOnly) {
+            writerGuard.lock();
+        }
+
         const char* getMethod = readOnly ? "getSQLiteReadConnection" : "getSQLiteConnection";
         const char* releaseMethod = readOnly ? "releaseSQLiteReadConnection" : "releaseSQLiteConnection";
 
@@ -195,24 +272,16 @@ namespace watermelondb {
         sqlite3* db = connection->db;
 
         jsi::Value result;
+        sqlite3_stmt* stmt = nullptr;
         try {
-            auto stmt = getStmt(rt, reinterpret_cast<sqlite3*>(db), sql.utf8(rt), arguments);
-
-            std::vector<jsi::Value> records = {};
-
-            while (true) {
-                if (getNextRowOrTrue(rt, stmt)) {
-                    break;
-                }
-
-                jsi::Object record = resultDictionary(rt, stmt);
+            stmt = getStmt(rt, reinterpret_cast<sqlite3*>(db), sql.utf8(rt), arguments);
 
-                records.push_back(std::move(record));
-            }
+            result = readResult(rt, stmt, format);
 
             finalizeStmt(stmt);
-            result = arrayFromStd(rt, records);
+            stmt = nullptr;
         } catch (...) {
+            finalizeStmt(stmt);
             env->CallVoidMethod(bridge, releaseConnectionMethod, jTag);
             throw;
         }
@@ -221,13 +290,16 @@ namespace watermelondb {
         return result;
     }
 
-    jsi::Value execSqlQueryOnWriter(jobject bridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &arguments) {
+    jsi::Value execSqlQueryOnWriter(jobject bridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &arguments, ResultFormat format) {
         JNIEnv *env = getEnv();
         if (!env) {
             throw jsi::JSError(rt, "JNI env not available");
         }
         jint jTag = static_cast<jint>(tag.asNumber());
 
+        auto writerMutex = writerLock(jTag);
+        const std::lock_guard<std::mutex> writerGuard(*writerMutex);
+
         LocalRef<jclass> myNativeModuleClass(env, env->GetObjectClass(bridge));
 
         // Always use the writer connection
@@ -276,24 +348,16 @@ namespace watermelondb {
         sqlite3* db = connection->db;
 
         jsi::Value result;
+        sqlite3_stmt* stmt = nullptr;
         try {
-            auto stmt = getStmt(rt, reinterpret_cast<sqlite3*>(db), sql.utf8(rt), arguments);
-
-            std::vector<jsi::Value> records = {};
-
-            while (true) {
-                if (getNextRowOrTrue(rt, stmt)) {
-                    break;
-                }
+            stmt = getStmt(rt, reinterpret_cast<sqlite3*>(db), sql.utf8(rt), arguments);
 
-                jsi::Object record = resultDictionary(rt, stmt);
-
-                records.push_back(std::move(record));
-            }
+            result = readResult(rt, stmt, format);
 
             finalizeStmt(stmt);
-            result = arrayFromStd(rt, records);
+            stmt = nullptr;
         } catch (...) {
+            finalizeStmt(stmt);
             env->CallVoidMethod(bridge, releaseConnectionMethod, jTag);
             throw;
         }
@@ -302,6 +366,29 @@ namespace watermelondb {
         return result;
     }
 
+    std::shared_ptr<RecordCache> recordCache(jobject bridge, jsi::Runtime &rt, jint tag) {
+        JNIEnv *env = getEnv();
+        if (!env) {
+            throw jsi::JSError(rt, "JNI env not available");
+        }
+        LocalRef<jclass> myNativeModuleClass(env, env->GetObjectClass(bridge));
+        jmethodID getRecordCacheMethod = env->GetMethodID(
+                myNativeModuleClass.get(),
+                "getRecordCacheHandle",
+                "(I)J"
+        );
+        jlong cacheHandle = env->CallLongMethod(bridge, getRecordCacheMethod, tag);
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+            cacheHandle = 0;
+        }
+        if (!cacheHandle) {
+            throw jsi::JSError(rt, "Record cache not available for tag " + std::to_string(tag));
+        }
+        // The copy keeps the cache alive if the driver closes meanwhile
+        return *reinterpret_cast<std::shared_ptr<RecordCache>*>(cacheHandle);
+    }
+
     jsi::Value query(jobject bridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &table, const jsi::String &query) {
         JNIEnv *env = getEnv();
         if (!env) {
@@ -316,6 +403,56 @@ namespace watermelondb {
 
         LocalRef<jclass> myNativeModuleClass(env, env->GetObjectClass(bridge));
 
+        // One JNI call per query: rows are then checked against the record cache natively
+        std::shared_ptr<RecordCache> cache = recordCache(bridge, rt, jTag);
+        const Identifier tableId = internIdentifier(tableStr);
+
+        auto readRecords = [&](sqlite3* db) {
+            auto stmt = getStmt(rt, db, queryStr, jsi::Array(rt, 0));
+
+            std::vector<jsi::Value> records = {};
+
+            auto columns = columnNames(rt, stmt);
+
+            while (true) {
+                if (getNextRowOrTrue(rt, stmt)) {
+                    break;
+                }
+
+                // Validate first column is 'id' before proceeding
+                const char* firstColumnName = sqlite3_column_name(stmt, 0);
+                if (!firstColumnName || std::string(firstColumnName) != "id") {
+                    finalizeStmt(stmt);
+                    throw jsi::JSError(rt, "Query result does not have 'id' as first column");
+                }
+
+                const char *id = (const char *)sqlite3_column_text(stmt, 0);
+
+                if (!id) {
+                    finalizeStmt(stmt);
+                    throw jsi::JSError(rt, "Failed to get ID of a record");
+                }
+
+                std::string_view idView(id, static_cast<size_t>(sqlite3_column_bytes(stmt, 0)));
+                if (cache->checkAndMark(tableId, idView)) {
+                    jsi::String jsiId = jsi::String::createFromAscii(rt, id);
+                    records.push_back(std::move(jsiId));
+                } else {
+                    jsi::Object record = resultDictionary(rt, stmt, columns);
+                    records.push_back(std::move(record));
+                }
+            }
+
+            finalizeStmt(stmt);
+
+            return arrayFromStd(rt, records);
+        };
+
+        if (auto pool = readerPool(bridge, rt, jTag)) {
+            auto lease = leaseReader(rt, *pool);
+            return readRecords(lease.db());
+        }
+
         jmethodID getConnectionMethod = env->GetMethodID(
                 myNativeModuleClass.get(),
                 "getSQLiteReadConnection",
@@ -359,63 +496,143 @@ namespace watermelondb {
             throw jsi::JSError(rt, "Failed to get SQLite connection - database handle is null");
         }
 
-        sqlite3* db = connection->db;
-
-        auto stmt = getStmt(rt, db, query.utf8(rt), jsi::Array(rt, 0));
-
-        std::vector<jsi::Value> records = {};
+        jsi::Value result;
+        try {
+            result = readRecords(connection->db);
+        } catch (...) {
+            env->CallVoidMethod(bridge, releaseConnectionMethod, jTag);
+            throw;
+        }
+        env->CallVoidMethod(bridge, releaseConnectionMethod, jTag);
 
-        while (true) {
-            if (getNextRowOrTrue(rt, stmt)) {
-                break;
-            }
+        return result;
+    }
 
-            // Validate first column is 'id' before proceeding
-            const char* firstColumnName = sqlite3_column_name(stmt, 0);
-            if (!firstColumnName || std::string(firstColumnName) != "id") {
-                finalizeStmt(stmt);
-                env->CallVoidMethod(bridge, releaseConnectionMethod, jTag);
-                throw jsi::JSError(rt, "Query result does not have 'id' as first column");
-            }
+    void withSQLiteConnection(jobject bridge, jsi::Runtime &rt, jint tag, bool readConnection,
+                              const std::function<bool(sqlite3 *, std::string &)> &work) {
+        JNIEnv *env = getEnv();
+        if (!env) {
+            throw jsi::JSError(rt, "JNI env not available");
+        }
 
-            const char *id = (const char *)sqlite3_column_text(stmt, 0);
+        auto writerMutex = writerLock(tag);
+        std::unique_lock<std::mutex> writerGuard(*writerMutex, std::defer_lock);
+        if (!readConnection) {
+            writerGuard.lock();
+        }
 
-            if (!id) {
-                throw jsi::JSError(rt, "Failed to get ID of a record");
-            }
+        LocalRef<jclass> myNativeModuleClass(env, env->GetObjectClass(bridge));
 
-            jstring jId = env->NewStringUTF(id);
-            jstring jTable = env->NewStringUTF(tableStr.c_str());
+        jmethodID getConnectionMethod = env->GetMethodID(
+                myNativeModuleClass.get(),
+                readConnection ? "getSQLiteReadConnection" : "getSQLiteConnection",
+                "(I)J"
+        );
 
-            jmethodID isCachedMethod = env->GetMethodID(
-                    myNativeModuleClass.get(),
-                    "isCached",
-                    "(ILjava/lang/String;Ljava/lang/String;)Z");
+        jmethodID releaseConnectionMethod = env->GetMethodID(
+                myNativeModuleClass.get(),
+                readConnection ? "releaseSQLiteReadConnection" : "releaseSQLiteConnection",
+                "(I)V"
+        );
 
-            bool isCached = env->CallBooleanMethod(bridge, isCachedMethod, jTag, jTable, jId);
+        SQLiteConnection* connection = reinterpret_cast<SQLiteConnection*>(env->CallLongMethod(bridge, getConnectionMethod, tag));
 
-            if (isCached) {
-                jsi::String jsiId = jsi::String::createFromAscii(rt, id);
-                records.push_back(std::move(jsiId));
-            } else {
-                jmethodID markAsCachedMethod = env->GetMethodID(
-                        myNativeModuleClass.get(),
-                        "markAsCached",
-                        "(ILjava/lang/String;Ljava/lang/String;)V");
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+            throw jsi::JSError(rt, "Database connection error for tag " + std::to_string(tag));
+        }
 
-                env->CallVoidMethod(bridge, markAsCachedMethod, jTag, jTable, jId);
-                jsi::Object record = resultDictionary(rt, stmt);
-                records.push_back(std::move(record));
+        if (!connection || !connection->db) {
+            if (connection) {
+                env->CallVoidMethod(bridge, releaseConnectionMethod, tag);
             }
-
-            env->DeleteLocalRef(jId);
-            env->DeleteLocalRef(jTable);
+            throw jsi::JSError(rt, "Failed to get SQLite connection - database handle is null");
         }
 
-        finalizeStmt(stmt);
-        env->CallVoidMethod(bridge, releaseConnectionMethod, jTag);
-
-        return arrayFromStd(rt, records);
+        std::string errorMessage;
+        bool ok = work(connection->db, errorMessage);
+        env->CallVoidMethod(bridge, releaseConnectionMethod, tag);
+        if (!ok) {
+            throw jsi::JSError(rt, errorMessage);
+        }
     }
 
 } // namespace watermelondb 
+
+// Database.close(): statements cached by the JSI query path keep the pooled connections busy, so
+// they are finalized before the pool closes them. The JSI reader pool of the file closes too.
+extern "C" JNIEXPORT void JNICALL
+Java_com_nozbe_watermelondb_Database_nativeDropStatementCaches(
+    JNIEnv* env,
+    jclass,
+    jstring path
+) {
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (!pathChars) {
+        return;
+    }
+    std::string pathStr(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+    watermelondb::SqliteCursors::shared().closeAll(pathStr);
+    watermelondb::SqliteReaderPool::dropPath(pathStr);
+    watermelondb::SqliteStatementCache::dropConnectionsTo(pathStr);
+}
+
+// RecordCache.kt: the cache lives here so query() reads it without JNI calls per row. The handle
+// is a heap-allocated shared_ptr; a query in flight holds its own copy past nativeDestroy.
+namespace {
+
+std::shared_ptr<watermelondb::RecordCache>& recordCacheFrom(jlong handle) {
+    return *reinterpret_cast<std::shared_ptr<watermelondb::RecordCache>*>(handle);
+}
+
+std::string stringFromJava(JNIEnv* env, jstring value) {
+    const char* chars = env->GetStringUTFChars(value, nullptr);
+    if (!chars) {
+        return std::string();
+    }
+    std::string result(chars);
+    env->ReleaseStringUTFChars(value, chars);
+    return result;
+}
+
+} // namespace
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_nozbe_watermelondb_RecordCache_nativeCreate(JNIEnv*, jclass) {
+    auto* cache = new std::shared_ptr<watermelondb::RecordCache>(std::make_shared<watermelondb::RecordCache>());
+    return reinterpret_cast<jlong>(cache);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_nozbe_watermelondb_RecordCache_nativeDestroy(JNIEnv*, jclass, jlong handle) {
+    delete reinterpret_cast<std::shared_ptr<watermelondb::RecordCache>*>(handle);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_nozbe_watermelondb_RecordCache_nativeIsCached(JNIEnv* env, jclass, jlong handle, jstring table, jstring id) {
+    const auto tableId = watermelondb::internIdentifier(stringFromJava(env, table));
+    return recordCacheFrom(handle)->isCached(tableId, stringFromJava(env, id)) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_nozbe_watermelondb_RecordCache_nativeMarkAsCached(JNIEnv* env, jclass, jlong handle, jstring table, jstring id) {
+    const auto tableId = watermelondb::internIdentifier(stringFromJava(env, table));
+    recordCacheFrom(handle)->markAsCached(tableId, stringFromJava(env, id));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_nozbe_watermelondb_RecordCache_nativeRemove(JNIEnv* env, jclass, jlong handle, jstring table, jstring id) {
+    const auto tableId = watermelondb::internIdentifier(stringFromJava(env, table));
+    recordCacheFrom(handle)->remove(tableId, stringFromJava(env, id));
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_nozbe_watermelondb_RecordCache_nativeClear(JNIEnv*, jclass, jlong handle) {
+    recordCacheFrom(handle)->clear();
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_nozbe_watermelondb_RecordCache_nativeSetAlwaysMiss(JNIEnv*, jclass, jlong handle, jboolean alwaysMiss) {
+    recordCacheFrom(handle)->setAlwaysMiss(alwaysMiss == JNI_TRUE);
+}
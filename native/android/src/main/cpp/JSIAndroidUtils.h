@@ -10,6 +10,15 @@
 
 #include <jsi/jsi.h>
 #include <jni.h>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "../../../../shared/DatabaseUtils.h"
+#include "../../../../shared/RecordCache.h"
+#include "../../../../shared/SqliteReaderPool.h"
+
+struct sqlite3;
 
 #ifndef LOG_TAG
 #define LOG_TAG "WatermelonDB"
@@ -18,9 +27,25 @@
 using namespace facebook;
 
 namespace watermelondb {
-    jsi::Value execSqlQuery(jobject bridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &arguments);
-    jsi::Value execSqlQueryOnWriter(jobject bridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &arguments);
+    jsi::Value execSqlQuery(jobject bridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &arguments, ResultFormat format = ResultFormat::Rows);
+    jsi::Value execSqlQueryOnWriter(jobject bridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &arguments, ResultFormat format = ResultFormat::Rows);
     jsi::Value query(jobject bridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &table, const jsi::String &query);
+
+    // Pooled read-only connections of `tag`'s database, or nullptr for an in-memory database
+    // (reads then go through the platform reader)
+    std::shared_ptr<SqliteReaderPool> readerPool(jobject bridge, jsi::Runtime &rt, jint tag);
+
+    // Whether execSqlQuery reads `query` on a reader connection: a SELECT, WITH or EXPLAIN that
+    // doesn't reference temp tables (those only exist on the writer)
+    bool isReadOnlyQuery(const std::string &query);
+
+    // Record cache of `tag`'s driver, shared with DatabaseDriver.kt
+    std::shared_ptr<RecordCache> recordCache(jobject bridge, jsi::Runtime &rt, jint tag);
+
+    // Runs `work` on the writer (or reader) connection of `tag`, acquired and released through the
+    // bridge. Throws a JSError if the connection is unavailable or `work` fails.
+    void withSQLiteConnection(jobject bridge, jsi::Runtime &rt, jint tag, bool readConnection,
+                              const std::function<bool(sqlite3 *, std::string &)> &work);
     
     JNIEnv* getEnv();
     JNIEnv* attachCurrentThread();
@@ -2,6 +2,7 @@
 #include "JSIAndroidUtils.h"
 
 #include "SliceImportEngine.h"
+#include "SliceBootstrapDatabase.h"
 #include "SqliteInsertHelper.h"
 #include "SlicePlatformAndroidQueue.h"
 
@@ -13,6 +14,7 @@
 
 using watermelondb::DatabaseInterface;
 using watermelondb::FieldValue;
+using watermelondb::RowSet;
 
 namespace watermelondb {
 namespace platform {
@@ -126,7 +128,8 @@ public:
                 ok = false;
                 return;
             }
-            if (!execSQL(db_, "COMMIT;", errorMessage)) {
+            if (!insertHelper_.finishBulkLoad(db_, errorMessage) ||
+                !execSQL(db_, "COMMIT;", errorMessage)) {
                 rollbackTransactionOnDB();
                 releaseConnection();
                 ok = false;
@@ -164,7 +167,7 @@ public:
 
     bool insertRows(const std::string &tableName,
                     const std::vector<std::string> &columns,
-                    const std::vector<std::vector<FieldValue>> &rows,
+                    const RowSet &rows,
                     std::string &errorMessage) override {
         if (rows.empty()) {
             return true;
@@ -232,6 +235,74 @@ public:
         return ok;
     }
 
+    bool beginTableLoad(const std::string &tableName, std::string &errorMessage) override {
+        bool ok = false;
+        if (!runOnAndroidWorkQueueSync([&]() {
+            if (!db_) {
+                errorMessage = "No active database connection";
+                ok = false;
+                return;
+            }
+            ok = insertHelper_.deferIndexes(db_, tableName, errorMessage);
+        }, &errorMessage)) {
+            return false;
+        }
+        return ok;
+    }
+
+    bool endTableLoad(const std::string &tableName, std::string &errorMessage) override {
+        bool ok = false;
+        if (!runOnAndroidWorkQueueSync([&]() {
+            if (!db_) {
+                errorMessage = "No active database connection";
+                ok = false;
+                return;
+            }
+            ok = insertHelper_.restoreIndexes(db_, tableName, errorMessage);
+        }, &errorMessage)) {
+            return false;
+        }
+        return ok;
+    }
+
+    bool getTableColumns(const std::string &tableName,
+                         std::vector<std::string> &columns,
+                         std::string &errorMessage) override {
+        bool ok = false;
+        if (!runOnAndroidWorkQueueSync([&]() {
+            if (!db_) {
+                errorMessage = "No active database connection";
+                ok = false;
+                return;
+            }
+            ok = SqliteInsertHelper::tableColumns(db_, tableName, columns, errorMessage);
+        }, &errorMessage)) {
+            return false;
+        }
+        return ok;
+    }
+
+    // Runs `work` with the live connection on the work queue (outside of any import transaction)
+    bool runWithConnection(const std::function<bool(sqlite3*, std::string&)>& work, std::string &errorMessage) {
+        bool ok = false;
+        if (!runOnAndroidWorkQueueSync([&]() {
+            if (transactionStarted_) {
+                errorMessage = "Transaction already started";
+                ok = false;
+                return;
+            }
+            if (!ensureConnection(errorMessage)) {
+                ok = false;
+                return;
+            }
+            ok = work(db_, errorMessage);
+            releaseConnection();
+        }, &errorMessage)) {
+            return false;
+        }
+        return ok;
+    }
+
 private:
     jobject bridgeGlobal_;
     jint connectionTag_;
@@ -325,6 +396,7 @@ private:
         execSQL(db_, "RELEASE SAVEPOINT sp;", ignored);
         execSQL(db_, "ROLLBACK;", ignored);
 
+        insertHelper_.discardDeferredIndexes();
         finalizeStatementsOnDB();
         transactionStarted_ = false;
 
@@ -337,3 +409,15 @@ private:
 std::shared_ptr<DatabaseInterface> createAndroidDatabaseInterface(jobject bridge, jint connectionTag) {
     return std::make_shared<AndroidDatabaseInterface>(bridge, connectionTag);
 }
+
+std::shared_ptr<DatabaseInterface> createAndroidBootstrapDatabaseInterface(jobject bridge, jint connectionTag) {
+    return std::make_shared<watermelondb::SliceBootstrapDatabase>(
+        createAndroidLiveConnectionRunner(bridge, connectionTag));
+}
+
+watermelondb::LiveConnectionRunner createAndroidLiveConnectionRunner(jobject bridge, jint connectionTag) {
+    auto live = std::make_shared<AndroidDatabaseInterface>(bridge, connectionTag);
+    return [live](const std::function<bool(sqlite3*, std::string&)>& work, std::string &errorMessage) {
+        return live->runWithConnection(work, errorMessage);
+    };
+}
@@ -3,8 +3,16 @@
 #include <memory>
 #include <jni.h>
 
+#include "SliceBootstrapDatabase.h"
+
 namespace watermelondb {
 class DatabaseInterface;
 }
 
 std::shared_ptr<watermelondb::DatabaseInterface> createAndroidDatabaseInterface(jobject bridge, jint connectionTag);
+
+// Bootstrap imports (SliceImportOptions::bootstrap): writes into a side file, installs it over the live database at commit
+std::shared_ptr<watermelondb::DatabaseInterface> createAndroidBootstrapDatabaseInterface(jobject bridge, jint connectionTag);
+
+// Runs work with the live connection on the work queue, outside of any import (slice exports)
+watermelondb::LiveConnectionRunner createAndroidLiveConnectionRunner(jobject bridge, jint connectionTag);
@@ -17,6 +17,7 @@ namespace {
 constexpr const char* kSliceDownloadManagerClass = "com/nozbe/watermelondb/slice/SliceDownloadManager";
 constexpr const char* kStartDownloadSig = "(Ljava/lang/String;J)V";
 constexpr const char* kCancelDownloadSig = "(J)V";
+constexpr const char* kGetCacheDirectorySig = "()Ljava/lang/String;";
 
 struct DownloadCallbackState {
     std::function<void(const uint8_t* data, size_t length)> onData;
@@ -127,6 +128,34 @@ void callCancelDownload(JNIEnv* env, int64_t handle) {
     }
 }
 
+std::string callGetCacheDirectory(JNIEnv* env) {
+    jclass cls = getSliceDownloadManagerClass(env);
+    if (!cls) {
+        return "";
+    }
+    jmethodID method = getStaticMethod(env, cls, "getCacheDirectory", kGetCacheDirectorySig);
+    if (!method) {
+        env->DeleteGlobalRef(cls);
+        return "";
+    }
+    jstring jPath = (jstring)env->CallStaticObjectMethod(cls, method);
+    env->DeleteGlobalRef(cls);
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        return "";
+    }
+    std::string path;
+    if (jPath) {
+        const char* chars = env->GetStringUTFChars(jPath, nullptr);
+        if (chars) {
+            path = chars;
+            env->ReleaseStringUTFChars(jPath, chars);
+        }
+        env->DeleteLocalRef(jPath);
+    }
+    return path;
+}
+
 } // namespace
 
 extern "C" JNIEXPORT void JNICALL
@@ -259,6 +288,18 @@ void initializeWorkQueue() {
     // No-op on Android: work queue starts on first runOnWorkQueue after JVM is available
 }
 
+void runOnWorkQueue(const std::function<void()>& work) {
+    android::runOnWorkQueue(work);
+}
+
+std::string sliceCacheDirectory() {
+    JNIEnv* env = getEnv();
+    if (!env) {
+        return "";
+    }
+    return callGetCacheDirectory(env);
+}
+
 unsigned long calculateOptimalBatchSize() {
     unsigned long long physicalMemory = 0;
     long pages = sysconf(_SC_PHYS_PAGES);
@@ -262,6 +262,7 @@ class Database(private val name: String, private val context: Context) {
     }
 
     fun close() {
+        dropStatementCaches()
         writerDb.close()
         if (readerDb != writerDb) {
             readerDb.close()
@@ -345,4 +346,20 @@ class Database(private val name: String, private val context: Context) {
             return it.getInt(0)
         }
     }
+
+    // Statements cached by the JSI query path (SqliteStatementCache) keep the pooled connections
+    // busy; they are finalized before the pool closes them. The JSI path's own reader connections
+    // (SqliteReaderPool) are closed here too.
+    private fun dropStatementCaches() {
+        try {
+            nativeDropStatementCaches(databasePath)
+        } catch (_: UnsatisfiedLinkError) {
+            // JSI bridge library not loaded: nothing was cached
+        }
+    }
+
+    companion object {
+        @JvmStatic
+        private external fun nativeDropStatementCaches(path: String)
+    }
 }
@@ -14,6 +14,7 @@ import com.facebook.react.bridge.WritableArray
 import com.facebook.react.bridge.WritableMap
 import com.facebook.react.modules.core.DeviceEventManagerModule
 import com.nozbe.watermelondb.jsi.JSIAndroidBridgeInstaller
+import com.nozbe.watermelondb.slice.SliceDownloadManager
 import com.nozbe.watermelondb.sync.BackgroundSyncBridge
 import com.nozbe.watermelondb.sync.BackgroundSyncScheduler
 import io.requery.android.database.sqlite.SQLiteUpdateHook
@@ -67,6 +68,7 @@ class DatabaseBridge(private val reactContext: ReactApplicationContext) :
         try {
             val appContext = reactContext.applicationContext
             BackgroundSyncScheduler.initContext(appContext)
+            SliceDownloadManager.initCacheDirectory(appContext)
         } catch (e: Exception) {
             android.util.Log.w("WatermelonDB", "Failed to init background sync context: ${e.message}")
         }
@@ -434,6 +436,9 @@ class DatabaseBridge(private val reactContext: ReactApplicationContext) :
         return driver.markAsCached(table, id)
     }
 
+    // Called once per JSI query, which then checks and marks rows natively
+    fun getRecordCacheHandle(tag: ConnectionTag): Long = getDriver(tag).recordCacheHandle()
+
 
     private fun getDriver(tag: ConnectionTag): DatabaseDriver {
         val connection = connections[tag]
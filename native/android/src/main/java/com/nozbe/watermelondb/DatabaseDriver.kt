@@ -49,7 +49,7 @@ class DatabaseDriver(context: Context, dbName: String) {
 
     private val log: Logger? = if (BuildConfig.DEBUG) Logger.getLogger("DB_Driver") else null
 
-    private val cachedRecords: MutableMap<TableName, MutableList<RecordID>> = mutableMapOf()
+    private val cachedRecords = RecordCache()
 
     // When CDC is enabled, skip cache optimization to ensure queries
     // return full records for data created by native sync
@@ -313,13 +313,17 @@ class DatabaseDriver(context: Context, dbName: String) {
 
     fun disableUpdateHook() = database.setUpdateHook(null)
 
-    fun close() = database.close()
+    fun close() {
+        database.close()
+        cachedRecords.release()
+    }
+
+    // Native handle of the record cache, read by the JSI query path
+    fun recordCacheHandle(): Long = cachedRecords.handle
 
     fun markAsCached(table: TableName, id: RecordID) {
         // log?.info("Mark as cached $id")
-        val cache = cachedRecords[table] ?: mutableListOf()
-        cache.add(id)
-        cachedRecords[table] = cache
+        cachedRecords.markAsCached(table, id)
     }
 
     fun isCached(table: TableName, id: RecordID): Boolean {
@@ -328,14 +332,16 @@ class DatabaseDriver(context: Context, dbName: String) {
         if (_cdcEnabled) {
             return false
         }
-        return cachedRecords[table]?.contains(id) ?: false
+        return cachedRecords.isCached(table, id)
     }
 
     fun setCDCEnabled(enabled: Boolean) {
         _cdcEnabled = enabled
+        // The JSI query path reads the cache natively
+        cachedRecords.setAlwaysMiss(enabled)
     }
 
-    private fun removeFromCache(table: TableName, id: RecordID) = cachedRecords[table]?.remove(id)
+    private fun removeFromCache(table: TableName, id: RecordID) = cachedRecords.remove(table, id)
 
     private fun setUpSchema(schema: Schema) {
         database.transaction {
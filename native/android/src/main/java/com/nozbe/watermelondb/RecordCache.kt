@@ -0,0 +1,90 @@
+package com.nozbe.watermelondb
+
+import android.util.Log
+
+// Ids of the records JS already holds, per table (see native/shared/RecordCache.h). Lives in native
+// memory so the JSI query path reads it without calling back into the JVM; `handle` is how that
+// path finds it. Falls back to in-memory sets if the native library can't be loaded.
+class RecordCache {
+    var handle: Long = if (nativeAvailable) nativeCreate() else 0L
+        private set
+
+    private val fallback: MutableMap<TableName, MutableSet<RecordID>> = mutableMapOf()
+    private var fallbackAlwaysMiss = false
+
+    fun isCached(table: TableName, id: RecordID): Boolean {
+        if (handle != 0L) {
+            return nativeIsCached(handle, table, id)
+        }
+        synchronized(fallback) {
+            return !fallbackAlwaysMiss && fallback[table]?.contains(id) == true
+        }
+    }
+
+    fun markAsCached(table: TableName, id: RecordID) {
+        if (handle != 0L) {
+            nativeMarkAsCached(handle, table, id)
+            return
+        }
+        synchronized(fallback) {
+            fallback.getOrPut(table) { mutableSetOf() }.add(id)
+        }
+    }
+
+    fun remove(table: TableName, id: RecordID) {
+        if (handle != 0L) {
+            nativeRemove(handle, table, id)
+            return
+        }
+        synchronized(fallback) {
+            fallback[table]?.remove(id)
+        }
+    }
+
+    fun clear() {
+        if (handle != 0L) {
+            nativeClear(handle)
+            return
+        }
+        synchronized(fallback) {
+            fallback.clear()
+        }
+    }
+
+    // While on, every record reads as uncached (CDC: native sync writes records JS hasn't seen)
+    fun setAlwaysMiss(alwaysMiss: Boolean) {
+        if (handle != 0L) {
+            nativeSetAlwaysMiss(handle, alwaysMiss)
+            return
+        }
+        synchronized(fallback) {
+            fallbackAlwaysMiss = alwaysMiss
+        }
+    }
+
+    // Frees the native cache; a JSI query still running keeps its own reference until it's done
+    fun release() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    companion object {
+        private val nativeAvailable: Boolean = try {
+            System.loadLibrary("watermelon-jsi-android-bridge")
+            true
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w("WatermelonDB", "RecordCache: native library not available, using JVM sets", e)
+            false
+        }
+
+        @JvmStatic private external fun nativeCreate(): Long
+        @JvmStatic private external fun nativeDestroy(handle: Long)
+        @JvmStatic private external fun nativeIsCached(handle: Long, table: String, id: String): Boolean
+        @JvmStatic private external fun nativeMarkAsCached(handle: Long, table: String, id: String)
+        @JvmStatic private external fun nativeRemove(handle: Long, table: String, id: String)
+        @JvmStatic private external fun nativeClear(handle: Long)
+        @JvmStatic private external fun nativeSetAlwaysMiss(handle: Long, alwaysMiss: Boolean)
+    }
+}
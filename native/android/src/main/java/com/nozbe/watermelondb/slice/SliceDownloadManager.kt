@@ -1,9 +1,11 @@
 package com.nozbe.watermelondb.slice
 
+import android.content.Context
 import okhttp3.Call
 import okhttp3.OkHttpClient
 import okhttp3.Request
 import okhttp3.Response
+import java.io.File
 import java.io.IOException
 import java.util.concurrent.ConcurrentHashMap
 
@@ -13,6 +15,17 @@ object SliceDownloadManager {
     private val client: OkHttpClient = OkHttpClient.Builder().build()
     private val calls: ConcurrentHashMap<Long, Call> = ConcurrentHashMap()
 
+    @Volatile
+    private var cacheDirectory: String = ""
+
+    fun initCacheDirectory(context: Context) {
+        cacheDirectory = File(context.cacheDir, "watermelondb-slices").path
+    }
+
+    // Directory for the native slice cache; empty until initCacheDirectory has been called
+    @JvmStatic
+    fun getCacheDirectory(): String = cacheDirectory
+
     @JvmStatic
     fun startDownload(url: String, handle: Long) {
         val request = Request.Builder().url(url).build()
@@ -116,16 +116,31 @@ public class Database {
         // CRITICAL: Clean up SQLite update hook before deallocation
         // If we don't do this, the hook callback can fire on a dangling pointer causing crashes
         disableUpdateHook()
+        dropStatementCaches()
     }
 
     func close() {
         disableUpdateHook()
+        dropStatementCaches()
         writer.close()
         if reader !== writer {
             reader.close()
         }
     }
     
+    // Statements cached by the JSI query path (SqliteStatementCache) keep the connections busy, so
+    // they have to be finalized before the connections are closed. The JSI path's pooled readers
+    // (SqliteReaderPool) are closed with them.
+    private func dropStatementCaches() {
+        if writer.sqliteHandle != nil {
+            watermelondb_drop_reader_pool(OpaquePointer(writer.sqliteHandle))
+            watermelondb_drop_statement_cache(OpaquePointer(writer.sqliteHandle))
+        }
+        if reader !== writer, reader.sqliteHandle != nil {
+            watermelondb_drop_statement_cache(OpaquePointer(reader.sqliteHandle))
+        }
+    }
+
     private func open() {
         guard writer.open() else {
             fatalError("Failed to open the database. \(writer.lastErrorMessage())")
@@ -389,6 +404,7 @@ public class Database {
                 throw "Failed to disable reset database mode".asError()
             }
         } else {
+            dropStatementCaches()
             guard writer.close() else {
                 throw "Could not close database".asError()
             }
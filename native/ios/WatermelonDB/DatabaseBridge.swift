@@ -142,7 +142,16 @@ final public class DatabaseBridge: RCTEventEmitter {
         
         driver.markAsCached(table, id)
     }
-    
+
+    @objc
+    public func removeFromCache(connectionTag: ConnectionTag, table: String, id: String) {
+        guard let connection = connections[connectionTag.intValue], case let .connected(driver, synchronous: true) = connection else {
+            return
+        }
+
+        driver.removeFromCache(table, id)
+    }
+
     private enum Connection {
         case connected(driver: DatabaseDriver, synchronous: Bool)
         case waiting(queue: [() -> Void])
@@ -20,11 +20,24 @@ public:
     jsi::Array query(jsi::Runtime &rt, double tag, jsi::String table, jsi::String query);
     jsi::Array execSqlQuery(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args);
     jsi::Array execSqlQueryOnWriter(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args);
+    jsi::Object execSqlQueryColumnar(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args);
+    jsi::Object execSqlQueryPacked(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args);
+    jsi::Array execSqlQueryLazy(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args);
+    jsi::Value queryAsync(jsi::Runtime &rt, double tag, jsi::String table, jsi::String query, double requestId);
+    jsi::Value execSqlQueryAsync(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args, double requestId);
+    bool cancelQuery(jsi::Runtime &rt, double requestId);
+    double openCursor(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args);
+    jsi::Object fetchCursor(jsi::Runtime &rt, double cursorId, double maxRows, double maxMillis);
+    bool closeCursor(jsi::Runtime &rt, double cursorId);
     jsi::Value importRemoteSlice(
                                  jsi::Runtime &rt, 
                                  double tag, 
-                                 jsi::String sliceUrl
+                                 jsi::String sliceUrl,
+                                 jsi::String optionsJson
                                  );
+    jsi::Value exportSlice(jsi::Runtime &rt, double tag, jsi::String path, jsi::String optionsJson);
+    void attachReferenceSlice(jsi::Runtime &rt, double tag, jsi::String path, jsi::String alias);
+    void detachReferenceSlice(jsi::Runtime &rt, double tag, jsi::String alias);
     void configureSync(jsi::Runtime &rt, jsi::String configJson);
     void startSync(jsi::Runtime &rt, jsi::String reason);
     jsi::Value syncDatabaseAsync(jsi::Runtime &rt, jsi::String reason);
@@ -54,7 +67,8 @@ private:
         bool alive = true;
     };
 
-    std::mutex mutex_;  
+    // Sync state and reference slices; queries lock per connection instead (JSIWrapperUtils)
+    std::mutex mutex_;
     int64_t nextSyncListenerId_ = 1;
     std::shared_ptr<watermelondb::SyncEngine> syncEngine_;
     std::shared_ptr<SyncEventState> syncEventState_;
@@ -1,6 +1,8 @@
 #include "JSISwiftWrapperModule.h"
 #include "JSIWrapperUtils.h"
 #include "JsonUtils.h"
+#include "AsyncQueryExecutor.h"
+#include "SqliteCursor.h"
 
 #include <ReactCommon/TurboModuleUtils.h>
 
@@ -14,7 +16,11 @@
 #import "ZstdFileUtil.h"
 #import "BackgroundSyncBridge.h"
 #include "SyncApplyEngine.h"
+#include "SliceEncoder.h"
+#include "SliceReferenceDatabase.h"
+#import "../SliceImportDatabaseAdapter.h"
 
+#include <algorithm>
 #include <exception>
 
 // Gated lock-diagnostic logging — controlled at runtime by `WMDBLockLog.isEnabled`
@@ -48,6 +54,46 @@ static void releaseSliceImporter(SliceImporter *importer) {
     }
 }
 
+// Result of a query that couldn't run off the JS thread and was read synchronously
+static jsi::Value resolvedPromise(jsi::Runtime &rt, jsi::Value value) {
+    auto result = std::make_shared<jsi::Value>(std::move(value));
+    return createPromiseAsJSIValue(rt, [result](jsi::Runtime &rt2, std::shared_ptr<Promise> promise) {
+        promise->resolve(*result);
+    });
+}
+
+using SnapshotReader = std::function<jsi::Value(jsi::Runtime &rt, const watermelondb::PackedResultSnapshot &snapshot)>;
+
+// Runs `sql` on a pooled reader connection on the shared executor; only `read`, which turns the
+// native snapshot into the JS result, runs on the JS thread
+static jsi::Value runAsyncQuery(jsi::Runtime &rt,
+                                std::shared_ptr<CallInvoker> jsInvoker,
+                                std::shared_ptr<watermelondb::SqliteReaderPool> pool,
+                                std::string sql,
+                                std::vector<watermelondb::QueryArgument> arguments,
+                                uint64_t requestId,
+                                SnapshotReader read) {
+    return createPromiseAsJSIValue(rt, [jsInvoker, pool, sql, arguments, requestId, read](jsi::Runtime &rt2, std::shared_ptr<Promise> promise) {
+        jsi::Runtime *runtime = &rt2;
+        watermelondb::AsyncQueryExecutor::shared().submit(requestId, pool, sql, arguments,
+            [jsInvoker, runtime, promise, read](watermelondb::AsyncQueryStatus status,
+                                               std::shared_ptr<const watermelondb::PackedResultSnapshot> result,
+                                               const std::string &errorMessage) {
+                jsInvoker->invokeAsync([runtime, promise, read, status, result, errorMessage]() mutable {
+                    if (status != watermelondb::AsyncQueryStatus::Completed) {
+                        promise->reject(errorMessage);
+                        return;
+                    }
+                    try {
+                        promise->resolve(read(*runtime, *result));
+                    } catch (const jsi::JSError &error) {
+                        promise->reject(error.getMessage());
+                    }
+                });
+            });
+    });
+}
+
 JSISwiftWrapperModule::JSISwiftWrapperModule(std::shared_ptr<CallInvoker> jsInvoker)
 : NativeWatermelonDBModuleCxxSpec(std::move(jsInvoker)) {
     syncEventState_ = std::make_shared<SyncEventState>();
@@ -187,8 +233,6 @@ jsi::Array JSISwiftWrapperModule::query(jsi::Runtime &rt, double tag, jsi::Strin
     RCTBridge *bridge = [RCTBridge currentBridge];
     DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
     
-    const std::lock_guard<std::mutex> lock(mutex_);
-    
     // Convert double tag to jsi::Value
     jsi::Value tagValue = jsi::Value(tag);
     
@@ -201,8 +245,6 @@ jsi::Array JSISwiftWrapperModule::execSqlQuery(jsi::Runtime &rt, double tag, jsi
     RCTBridge *bridge = [RCTBridge currentBridge];
     DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
 
-    const std::lock_guard<std::mutex> lock(mutex_);
-
     // Convert double tag to jsi::Value
     jsi::Value tagValue = jsi::Value(tag);
 
@@ -215,8 +257,6 @@ jsi::Array JSISwiftWrapperModule::execSqlQueryOnWriter(jsi::Runtime &rt, double
     RCTBridge *bridge = [RCTBridge currentBridge];
     DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
 
-    const std::lock_guard<std::mutex> lock(mutex_);
-
     // Convert double tag to jsi::Value
     jsi::Value tagValue = jsi::Value(tag);
 
@@ -225,37 +265,167 @@ jsi::Array JSISwiftWrapperModule::execSqlQueryOnWriter(jsi::Runtime &rt, double
     return result.asObject(rt).asArray(rt);
 }
 
+jsi::Object JSISwiftWrapperModule::execSqlQueryColumnar(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args) {
+    RCTBridge *bridge = [RCTBridge currentBridge];
+    DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
+
+    // Convert double tag to jsi::Value
+    jsi::Value tagValue = jsi::Value(tag);
+
+    jsi::Value result = watermelondb::execSqlQuery(db, rt, tagValue, sql, args, watermelondb::ResultFormat::Columnar);
+
+    return result.asObject(rt);
+}
+
+jsi::Object JSISwiftWrapperModule::execSqlQueryPacked(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args) {
+    RCTBridge *bridge = [RCTBridge currentBridge];
+    DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
+
+    // Convert double tag to jsi::Value
+    jsi::Value tagValue = jsi::Value(tag);
+
+    jsi::Value result = watermelondb::execSqlQuery(db, rt, tagValue, sql, args, watermelondb::ResultFormat::Packed);
+
+    return result.asObject(rt);
+}
+
+jsi::Array JSISwiftWrapperModule::execSqlQueryLazy(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args) {
+    RCTBridge *bridge = [RCTBridge currentBridge];
+    DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
+
+    // Convert double tag to jsi::Value
+    jsi::Value tagValue = jsi::Value(tag);
+
+    jsi::Value result = watermelondb::execSqlQuery(db, rt, tagValue, sql, args, watermelondb::ResultFormat::LazyRows);
+
+    return result.asObject(rt).asArray(rt);
+}
+
+jsi::Value JSISwiftWrapperModule::queryAsync(jsi::Runtime &rt, double tag, jsi::String table, jsi::String query, double requestId) {
+    RCTBridge *bridge = [RCTBridge currentBridge];
+    DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
+
+    auto tagNumber = [[NSNumber alloc] initWithDouble:tag];
+    auto pool = watermelondb::readerPool(db, tagNumber);
+    if (!pool) {
+        // In-memory database: no other connection can read it
+        return resolvedPromise(rt, watermelondb::query(db, rt, jsi::Value(tag), table, query));
+    }
+
+    // Records are checked against the cache when the result reaches the JS thread, not when the
+    // query runs, so a cancelled query never marks anything as cached
+    NSString *tableStr = [NSString stringWithUTF8String:table.utf8(rt).c_str()];
+    return runAsyncQuery(rt, jsInvoker_, std::move(pool), query.utf8(rt), {}, static_cast<uint64_t>(requestId),
+                         [db, tagNumber, tableStr](jsi::Runtime &rt2, const watermelondb::PackedResultSnapshot &snapshot) -> jsi::Value {
+        return watermelondb::snapshotRecords(rt2, snapshot, [&](const char *id, size_t length) {
+            NSString *idStr = [[NSString alloc] initWithBytes:id length:length encoding:NSUTF8StringEncoding];
+            if ([db isCachedWithConnectionTag:tagNumber table:tableStr id:idStr]) {
+                return true;
+            }
+            [db markAsCachedWithConnectionTag:tagNumber table:tableStr id:idStr];
+            return false;
+        });
+    });
+}
+
+jsi::Value JSISwiftWrapperModule::execSqlQueryAsync(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args, double requestId) {
+    RCTBridge *bridge = [RCTBridge currentBridge];
+    DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
+
+    auto tagNumber = [[NSNumber alloc] initWithDouble:tag];
+    std::string sqlUtf8 = sql.utf8(rt);
+    auto pool = watermelondb::isReadOnlyQuery(sqlUtf8) ? watermelondb::readerPool(db, tagNumber) : nullptr;
+    if (!pool) {
+        // Writes, reads of temp tables and in-memory databases need the platform's connections
+        return resolvedPromise(rt, watermelondb::execSqlQuery(db, rt, jsi::Value(tag), sql, args));
+    }
+
+    return runAsyncQuery(rt, jsInvoker_, std::move(pool), std::move(sqlUtf8), watermelondb::queryArguments(rt, args),
+                         static_cast<uint64_t>(requestId),
+                         [](jsi::Runtime &rt2, const watermelondb::PackedResultSnapshot &snapshot) -> jsi::Value {
+        return watermelondb::snapshotRows(rt2, snapshot);
+    });
+}
+
+bool JSISwiftWrapperModule::cancelQuery(jsi::Runtime &rt, double requestId) {
+    return watermelondb::AsyncQueryExecutor::shared().cancel(static_cast<uint64_t>(requestId));
+}
+
+double JSISwiftWrapperModule::openCursor(jsi::Runtime &rt, double tag, jsi::String sql, jsi::Array args) {
+    RCTBridge *bridge = [RCTBridge currentBridge];
+    DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
+
+    std::string sqlUtf8 = sql.utf8(rt);
+    if (!watermelondb::isReadOnlyQuery(sqlUtf8)) {
+        throw jsi::JSError(rt, "Cursors must be read-only");
+    }
+    auto pool = watermelondb::readerPool(db, [[NSNumber alloc] initWithDouble:tag]);
+    return static_cast<double>(watermelondb::openCursor(rt, pool, sqlUtf8, args));
+}
+
+jsi::Object JSISwiftWrapperModule::fetchCursor(jsi::Runtime &rt, double cursorId, double maxRows, double maxMillis) {
+    return watermelondb::fetchCursor(rt, static_cast<uint64_t>(cursorId), static_cast<size_t>(std::max(maxRows, 0.0)),
+                                     static_cast<uint32_t>(std::max(maxMillis, 0.0)));
+}
+
+bool JSISwiftWrapperModule::closeCursor(jsi::Runtime &rt, double cursorId) {
+    return watermelondb::SqliteCursors::shared().close(static_cast<uint64_t>(cursorId));
+}
+
 jsi::Value JSISwiftWrapperModule::importRemoteSlice(
                                                     jsi::Runtime &rt,
                                                     double tag,
-                                                    jsi::String sliceUrl
+                                                    jsi::String sliceUrl,
+                                                    jsi::String optionsJson
                                                     ) {
     const double tagCopy = tag;
     const std::string sliceUrlUtf8 = sliceUrl.utf8(rt);
+    const std::string optionsJsonUtf8 = optionsJson.utf8(rt);
     
     RCTBridge *bridge = [RCTBridge currentBridge];
     DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
     
     auto jsInvoker = jsInvoker_;
     
-    return createPromiseAsJSIValue(rt, [db, tagCopy, sliceUrlUtf8, jsInvoker](jsi::Runtime &rt2, std::shared_ptr<Promise> promise) {
-        
+    return createPromiseAsJSIValue(rt, [this, db, tagCopy, sliceUrlUtf8, optionsJsonUtf8, jsInvoker](jsi::Runtime &rt2, std::shared_ptr<Promise> promise) {
+        jsi::Runtime *runtime = &rt2;
         dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
             @autoreleasepool {
                 auto tagNumber = [[NSNumber alloc] initWithDouble:tagCopy];
                 
-                SliceImporter *importer = [[SliceImporter alloc] initWithDatabaseBridge:db connectionTag:tagNumber];
+                NSString *options = [NSString stringWithUTF8String:optionsJsonUtf8.c_str()];
+                SliceImporter *importer = [[SliceImporter alloc] initWithDatabaseBridge:db
+                                                                          connectionTag:tagNumber
+                                                                            optionsJson:options];
+                importer.commitHandler = ^(NSString *eventJson) {
+                    emitSyncEventLocked(std::string(eventJson.UTF8String ?: ""));
+                };
                 retainSliceImporter(importer);
                 
                 [importer startWithURL:[NSURL URLWithString:[NSString stringWithUTF8String:sliceUrlUtf8.c_str()]]
-                            completion:^(NSError * _Nullable error) {
+                            completion:^(NSString * _Nullable resultJson, NSError * _Nullable error) {
                     releaseSliceImporter(importer);
-                    jsInvoker->invokeAsync([promise, error]() mutable {
-                        if (error) {
+                    jsInvoker->invokeAsync([db, tagNumber, promise, resultJson, error, runtime]() mutable {
+                        if (!resultJson) {
                             promise->reject([[error localizedDescription] UTF8String]);
-                        } else {
-                            promise->resolve(jsi::Value::undefined());
+                            return;
+                        }
+                        // Records a delta slice rewrote must stop reading as cached, or query() keeps
+                        // returning bare ids for them and JS keeps the stale models
+                        NSData *data = [resultJson dataUsingEncoding:NSUTF8StringEncoding];
+                        NSDictionary *result = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
+                        NSDictionary *changeset = [result isKindOfClass:[NSDictionary class]] ? result[@"changeset"] : nil;
+                        if ([changeset isKindOfClass:[NSDictionary class]]) {
+                            for (NSString *table in changeset) {
+                                NSDictionary *tableChanges = changeset[table];
+                                for (NSString *key in @[@"upserted", @"deleted"]) {
+                                    for (NSString *recordId in tableChanges[key]) {
+                                        [db removeFromCacheWithConnectionTag:tagNumber table:table id:recordId];
+                                    }
+                                }
+                            }
                         }
+                        promise->resolve(jsi::String::createFromUtf8(*runtime, resultJson.UTF8String ?: ""));
                     });
                 }];
             }
@@ -264,6 +434,106 @@ jsi::Value JSISwiftWrapperModule::importRemoteSlice(
                                    );
 }
 
+jsi::Value JSISwiftWrapperModule::exportSlice(jsi::Runtime &rt, double tag, jsi::String path, jsi::String optionsJson) {
+    const double tagCopy = tag;
+    const std::string pathUtf8 = path.utf8(rt);
+
+    watermelondb::SliceExportOptions options;
+    std::string optionsError;
+    if (!watermelondb::parseSliceExportOptions(optionsJson.utf8(rt), options, optionsError)) {
+        throw jsi::JSError(rt, optionsError);
+    }
+
+    RCTBridge *bridge = [RCTBridge currentBridge];
+    DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
+
+    auto jsInvoker = jsInvoker_;
+
+    return createPromiseAsJSIValue(rt, [db, tagCopy, pathUtf8, options, jsInvoker](jsi::Runtime &rt2, std::shared_ptr<Promise> promise) {
+        jsi::Runtime *runtime = &rt2;
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+            @autoreleasepool {
+                auto tagNumber = [[NSNumber alloc] initWithDouble:tagCopy];
+                auto runOnLive = createIOSLiveConnectionRunner(db, tagNumber);
+
+                watermelondb::SliceExportStats stats;
+                std::string errorMessage;
+                bool ok = runOnLive([&](sqlite3 *connection, std::string &error) {
+                    return watermelondb::exportSlice(connection, pathUtf8, options, &stats, error);
+                }, errorMessage);
+                std::string statsJson = watermelondb::sliceExportStatsJson(stats);
+
+                jsInvoker->invokeAsync([promise, ok, errorMessage, statsJson, runtime]() mutable {
+                    if (!ok) {
+                        promise->reject(errorMessage.empty() ? "Slice export failed" : errorMessage);
+                    } else {
+                        promise->resolve(jsi::String::createFromUtf8(*runtime, statsJson));
+                    }
+                });
+            }
+        });
+    });
+}
+
+void JSISwiftWrapperModule::attachReferenceSlice(jsi::Runtime &rt, double tag, jsi::String path, jsi::String alias) {
+    RCTBridge *bridge = [RCTBridge currentBridge];
+    DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const std::string pathUtf8 = path.utf8(rt);
+    const std::string aliasUtf8 = alias.utf8(rt);
+    auto tagNumber = [[NSNumber alloc] initWithDouble:tag];
+
+    // Attached databases and temp views are per connection: the writer (under its semaphore) and
+    // the reader, which JSI queries use from this thread
+    std::string errorMessage;
+    auto runOnWriter = createIOSLiveConnectionRunner(db, tagNumber);
+    if (!runOnWriter([&](sqlite3 *connection, std::string &error) {
+        return watermelondb::attachReferenceDatabase(connection, pathUtf8, aliasUtf8, error);
+    }, errorMessage)) {
+        throw jsi::JSError(rt, errorMessage);
+    }
+    sqlite3 *reader = (sqlite3 *)[db getRawReadConnectionWithConnectionTag:tagNumber];
+    if (reader && !watermelondb::attachReferenceDatabase(reader, pathUtf8, aliasUtf8, errorMessage)) {
+        throw jsi::JSError(rt, errorMessage);
+    }
+    // Pooled JSI readers pick it up before their next query
+    if (auto pool = watermelondb::readerPool(db, tagNumber)) {
+        pool->setConnectionHook(
+            "reference:" + aliasUtf8,
+            [pathUtf8, aliasUtf8](sqlite3 *connection, std::string &error) {
+                return watermelondb::attachReferenceDatabase(connection, pathUtf8, aliasUtf8, error);
+            },
+            [aliasUtf8](sqlite3 *connection, std::string &error) {
+                return watermelondb::detachReferenceDatabase(connection, aliasUtf8, error);
+            });
+    }
+}
+
+void JSISwiftWrapperModule::detachReferenceSlice(jsi::Runtime &rt, double tag, jsi::String alias) {
+    RCTBridge *bridge = [RCTBridge currentBridge];
+    DatabaseBridge *db = [bridge moduleForClass: DatabaseBridge.class];
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const std::string aliasUtf8 = alias.utf8(rt);
+    auto tagNumber = [[NSNumber alloc] initWithDouble:tag];
+
+    std::string errorMessage;
+    auto runOnWriter = createIOSLiveConnectionRunner(db, tagNumber);
+    if (!runOnWriter([&](sqlite3 *connection, std::string &error) {
+        return watermelondb::detachReferenceDatabase(connection, aliasUtf8, error);
+    }, errorMessage)) {
+        throw jsi::JSError(rt, errorMessage);
+    }
+    sqlite3 *reader = (sqlite3 *)[db getRawReadConnectionWithConnectionTag:tagNumber];
+    if (reader && !watermelondb::detachReferenceDatabase(reader, aliasUtf8, errorMessage)) {
+        throw jsi::JSError(rt, errorMessage);
+    }
+    if (auto pool = watermelondb::readerPool(db, tagNumber)) {
+        pool->removeConnectionHook("reference:" + aliasUtf8);
+    }
+}
+
 void JSISwiftWrapperModule::configureSync(jsi::Runtime &rt, jsi::String configJson) {
     auto state = syncEventState_;
     if (state) {
@@ -12,13 +12,24 @@
 #import <React/RCTEventEmitter.h>
 #import <React/RCTBridgeModule.h>
 #import "WatermelonDB-Swift.h"
+#import "DatabaseUtils.h"
+#import "SqliteReaderPool.h"
+#include <memory>
 
 using namespace facebook;
 
 namespace watermelondb {
-    jsi::Value execSqlQuery(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &args);
-    jsi::Value execSqlQueryOnWriter(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &args);
+    jsi::Value execSqlQuery(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &args, ResultFormat format = ResultFormat::Rows);
+    jsi::Value execSqlQueryOnWriter(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &args, ResultFormat format = ResultFormat::Rows);
     jsi::Value query(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &table, const jsi::String &query);
+
+    // Whether execSqlQuery reads `query` on a reader connection: a SELECT, WITH or EXPLAIN that
+    // doesn't reference temp tables (those only exist on the writer)
+    bool isReadOnlyQuery(const std::string &query);
+
+    // Pooled read-only connections of the tag's database, or nullptr for an in-memory database or
+    // when the tag has no connection (reads then go through the platform reader)
+    std::shared_ptr<SqliteReaderPool> readerPool(DatabaseBridge *databaseBridge, NSNumber *tagNumber);
 } // namespace watermelondb
 
 #endif /* JSIWrapperUtils_h */
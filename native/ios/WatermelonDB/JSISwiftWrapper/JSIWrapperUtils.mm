@@ -2,6 +2,9 @@
 #include "DatabaseUtils.h"
 #include <string>
 #include <cctype>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace watermelondb {
 
@@ -18,7 +21,7 @@ static bool referencesTemporaryTable(const std::string &query) {
            lower.find("sqlite_temp_master") != std::string::npos;
 }
 
-static bool isReadOnlyQuery(const std::string &query) {
+bool isReadOnlyQuery(const std::string &query) {
     if (referencesTemporaryTable(query)) {
         return false;
     }
@@ -34,70 +37,117 @@ static bool isReadOnlyQuery(const std::string &query) {
     return prefix.rfind("select", 0) == 0 || prefix.rfind("with", 0) == 0 || prefix.rfind("explain", 0) == 0;
 }
 
-jsi::Value execSqlQuery(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &args) {
-   auto tagNumber = [[NSNumber alloc] initWithDouble:tag.asNumber()];
+// Locks are per connection rather than per module: writes queue on the writer of their database,
+// reads lease a pooled reader connection and run alongside each other and the writer
+static std::mutex gConnectionLocksMutex;
+static std::unordered_map<int, std::shared_ptr<std::mutex>> gWriterLocks;
+static std::unordered_map<int, std::shared_ptr<SqliteReaderPool>> gReaderPools;
+
+static std::shared_ptr<std::mutex> writerLock(NSNumber *tagNumber) {
+    const std::lock_guard<std::mutex> lock(gConnectionLocksMutex);
+    auto &writerMutex = gWriterLocks[tagNumber.intValue];
+    if (!writerMutex) {
+        writerMutex = std::make_shared<std::mutex>();
+    }
+    return writerMutex;
+}
 
-    const auto query = sql.utf8(rt);
-    auto db = isReadOnlyQuery(query)
-        ? [databaseBridge getRawReadConnectionWithConnectionTag:tagNumber]
-        : [databaseBridge getRawConnectionWithConnectionTag:tagNumber];
+std::shared_ptr<SqliteReaderPool> readerPool(DatabaseBridge *databaseBridge, NSNumber *tagNumber) {
+    {
+        const std::lock_guard<std::mutex> lock(gConnectionLocksMutex);
+        auto found = gReaderPools.find(tagNumber.intValue);
+        if (found != gReaderPools.end() && (!found->second || !found->second->isClosed())) {
+            return found->second;
+        }
+    }
+    // First use (or the database was closed and reopened): the platform reader knows the file
+    auto reader = static_cast<sqlite3 *>([databaseBridge getRawReadConnectionWithConnectionTag:tagNumber]);
+    if (!reader) {
+        return nullptr;
+    }
+    const char *filename = sqlite3_db_filename(reader, "main");
+    auto pool = SqliteReaderPool::forPath(filename ? filename : "");
+    const std::lock_guard<std::mutex> lock(gConnectionLocksMutex);
+    gReaderPools[tagNumber.intValue] = pool;
+    return pool;
+}
 
+static SqliteReaderPool::Lease leaseReader(jsi::Runtime &rt, SqliteReaderPool &pool) {
+    std::string errorMessage;
+    auto lease = pool.acquire(errorMessage);
+    if (!lease) {
+        throw jsi::JSError(rt, errorMessage);
+    }
+    return lease;
+}
 
-    auto stmt = getStmt(rt, static_cast<sqlite3*>(db), query, args);
+static jsi::Value runStatement(jsi::Runtime &rt, sqlite3 *db, const std::string &sql, const jsi::Array &args, ResultFormat format) {
+    auto stmt = getStmt(rt, db, sql, args);
 
-    std::vector<jsi::Value> records = {};
+    jsi::Value result;
+    try {
+        result = readResult(rt, stmt, format);
+    } catch (...) {
+        finalizeStmt(stmt);
+        throw;
+    }
 
-    while (true) {
-        if (getNextRowOrTrue(rt, stmt)) {
-            break;
-        }
+    finalizeStmt(stmt);
 
-        jsi::Object record = resultDictionary(rt, stmt);
+    return result;
+}
 
-        records.push_back(std::move(record));
-    }
+jsi::Value execSqlQuery(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &args, ResultFormat format) {
+   auto tagNumber = [[NSNumber alloc] initWithDouble:tag.asNumber()];
 
-    finalizeStmt(stmt);
+    const auto query = sql.utf8(rt);
+    if (!isReadOnlyQuery(query)) {
+        auto writerMutex = writerLock(tagNumber);
+        const std::lock_guard<std::mutex> writerGuard(*writerMutex);
+        auto db = [databaseBridge getRawConnectionWithConnectionTag:tagNumber];
+        return runStatement(rt, static_cast<sqlite3*>(db), query, args, format);
+    }
 
-    return arrayFromStd(rt, records);
+    if (auto pool = readerPool(databaseBridge, tagNumber)) {
+        auto lease = leaseReader(rt, *pool);
+        return runStatement(rt, lease.db(), query, args, format);
+    }
+    auto db = [databaseBridge getRawReadConnectionWithConnectionTag:tagNumber];
+    return runStatement(rt, static_cast<sqlite3*>(db), query, args, format);
 }
 
-jsi::Value execSqlQueryOnWriter(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &args) {
+jsi::Value execSqlQueryOnWriter(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &sql, const jsi::Array &args, ResultFormat format) {
     auto tagNumber = [[NSNumber alloc] initWithDouble:tag.asNumber()];
 
     const auto query = sql.utf8(rt);
     // Always use the writer connection
+    auto writerMutex = writerLock(tagNumber);
+    const std::lock_guard<std::mutex> writerGuard(*writerMutex);
     auto db = [databaseBridge getRawConnectionWithConnectionTag:tagNumber];
 
-    auto stmt = getStmt(rt, static_cast<sqlite3*>(db), query, args);
-
-    std::vector<jsi::Value> records = {};
-
-    while (true) {
-        if (getNextRowOrTrue(rt, stmt)) {
-            break;
-        }
-
-        jsi::Object record = resultDictionary(rt, stmt);
-
-        records.push_back(std::move(record));
-    }
-
-    finalizeStmt(stmt);
-
-    return arrayFromStd(rt, records);
+    return runStatement(rt, static_cast<sqlite3*>(db), query, args, format);
 }
 
 jsi::Value query(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Value &tag, const jsi::String &table, const jsi::String &query) {
     auto tagNumber = [[NSNumber alloc] initWithDouble:tag.asNumber()];
     auto tableStr = [NSString stringWithUTF8String:table.utf8(rt).c_str()];
 
-    auto db = [databaseBridge getRawReadConnectionWithConnectionTag:tagNumber];
+    // Leased for the whole query; an in-memory database has no pool and reads on the platform reader
+    SqliteReaderPool::Lease lease;
+    sqlite3 *db = nullptr;
+    if (auto pool = readerPool(databaseBridge, tagNumber)) {
+        lease = leaseReader(rt, *pool);
+        db = lease.db();
+    } else {
+        db = static_cast<sqlite3*>([databaseBridge getRawReadConnectionWithConnectionTag:tagNumber]);
+    }
 
-    auto stmt = getStmt(rt, static_cast<sqlite3*>(db), query.utf8(rt), jsi::Array(rt, 0));
+    auto stmt = getStmt(rt, db, query.utf8(rt), jsi::Array(rt, 0));
 
     std::vector<jsi::Value> records = {};
 
+    auto columns = columnNames(rt, stmt);
+
     while (true) {
         if (getNextRowOrTrue(rt, stmt)) {
             break;
@@ -108,6 +158,7 @@ jsi::Value query(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Va
         const char *id = (const char *)sqlite3_column_text(stmt, 0);
 
         if (!id) {
+            finalizeStmt(stmt);
             throw jsi::JSError(rt, "Failed to get ID of a record");
         }
 
@@ -120,7 +171,7 @@ jsi::Value query(DatabaseBridge *databaseBridge, jsi::Runtime &rt, const jsi::Va
             records.push_back(std::move(jsiId));
         } else {
             [databaseBridge markAsCachedWithConnectionTag:tagNumber table:tableStr id:idStr];
-            jsi::Object record = resultDictionary(rt, stmt);
+            jsi::Object record = resultDictionary(rt, stmt, columns);
             records.push_back(std::move(record));
         }
     }
@@ -2,6 +2,8 @@
 
 #include <memory>
 
+#include "SliceBootstrapDatabase.h"
+
 #ifdef __OBJC__
 @class DatabaseBridge;
 @class NSNumber;
@@ -12,3 +14,9 @@ class DatabaseInterface;
 }
 
 std::shared_ptr<watermelondb::DatabaseInterface> createIOSDatabaseInterface(DatabaseBridge *db, NSNumber *connectionTag);
+
+// Bootstrap imports (SliceImportOptions::bootstrap): writes into a side file, installs it over the live database at commit
+std::shared_ptr<watermelondb::DatabaseInterface> createIOSBootstrapDatabaseInterface(DatabaseBridge *db, NSNumber *connectionTag);
+
+// Runs work with the raw connection under the writer semaphore, outside of any import (slice exports)
+watermelondb::LiveConnectionRunner createIOSLiveConnectionRunner(DatabaseBridge *db, NSNumber *connectionTag);
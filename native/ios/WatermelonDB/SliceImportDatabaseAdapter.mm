@@ -1,6 +1,7 @@
 #import "SliceImportDatabaseAdapter.h"
 
 #include "SliceImportEngine.h"
+#include "SliceBootstrapDatabase.h"
 #include "SqliteInsertHelper.h"
 
 #import <sqlite3.h>
@@ -18,6 +19,7 @@
 
 using watermelondb::DatabaseInterface;
 using watermelondb::FieldValue;
+using watermelondb::RowSet;
 
 // Gated lock-diagnostic logging — controlled at runtime by `WMDBLockLog.isEnabled`
 // (defaults: ON in DEBUG, OFF in release). When disabled, the macro evaluates
@@ -154,7 +156,8 @@ public:
             errorMessage = "Lost cached database connection";
             return false;
         }
-        if (!execSQL(db, "COMMIT;", errorMessage)) {
+        if (!insertHelper_.finishBulkLoad(db, errorMessage) ||
+            !execSQL(db, "COMMIT;", errorMessage)) {
             WMDB_LOCK_LOG(@"[wmdb-lock] %s COMMIT failed: %s", holderName_.c_str(), errorMessage.c_str());
             rollbackTransactionOnDB(db);
             return false;
@@ -205,7 +208,7 @@ public:
 
     bool insertRows(const std::string &tableName,
                     const std::vector<std::string> &columns,
-                    const std::vector<std::vector<FieldValue>> &rows,
+                    const RowSet &rows,
                     std::string &errorMessage) override {
         if (rows.empty()) return true;
         sqlite3 *db = cachedDB_;
@@ -245,6 +248,71 @@ public:
         return execSQL(db, "RELEASE SAVEPOINT sp;", errorMessage);
     }
 
+    bool beginTableLoad(const std::string &tableName, std::string &errorMessage) override {
+        sqlite3 *db = cachedDB_;
+        if (!db) {
+            errorMessage = "No cached database connection";
+            return false;
+        }
+        return insertHelper_.deferIndexes(db, tableName, errorMessage);
+    }
+
+    bool endTableLoad(const std::string &tableName, std::string &errorMessage) override {
+        sqlite3 *db = cachedDB_;
+        if (!db) {
+            errorMessage = "No cached database connection";
+            return false;
+        }
+        return insertHelper_.restoreIndexes(db, tableName, errorMessage);
+    }
+
+    bool getTableColumns(const std::string &tableName,
+                         std::vector<std::string> &columns,
+                         std::string &errorMessage) override {
+        sqlite3 *db = cachedDB_;
+        if (!db) {
+            errorMessage = "No cached database connection";
+            return false;
+        }
+        return SqliteInsertHelper::tableColumns(db, tableName, columns, errorMessage);
+    }
+
+    // Runs `work` with the raw connection while holding the writer semaphore (outside of any import transaction)
+    bool runWithWriterConnection(const std::function<bool(sqlite3 *, std::string &)> &work, std::string &errorMessage) {
+        if (!db_) {
+            errorMessage = "DatabaseBridge deallocated";
+            return false;
+        }
+        if (transactionStarted_) {
+            errorMessage = "Transaction already started";
+            return false;
+        }
+        dispatch_semaphore_t sem = [db_ getWriterTransactionSemaphoreWithConnectionTag:connectionTag_];
+        if (!sem) {
+            errorMessage = "Could not get writer transaction semaphore";
+            return false;
+        }
+        dispatch_semaphore_wait(sem, DISPATCH_TIME_FOREVER);
+        uint64_t seq = ++sliceImportSeq;
+        char holderBuf[64];
+        snprintf(holderBuf, sizeof(holderBuf), "slice-live:%lld:#%llu",
+                 (long long)[connectionTag_ longLongValue], (unsigned long long)seq);
+        [db_ setWriterHolderWithConnectionTag:connectionTag_
+                                         name:[NSString stringWithUTF8String:holderBuf]];
+
+        bool ok = false;
+        sqlite3 *db = (sqlite3 *)[db_ getRawConnectionWithConnectionTag:connectionTag_];
+        if (!db) {
+            errorMessage = "Lost database connection";
+        } else {
+            ok = work(db, errorMessage);
+        }
+
+        [db_ clearWriterHolderWithConnectionTag:connectionTag_];
+        dispatch_semaphore_signal(sem);
+        return ok;
+    }
+
 private:
     __weak DatabaseBridge *db_;
     NSNumber *connectionTag_;
@@ -286,6 +354,7 @@ private:
         execSQL(db, "RELEASE SAVEPOINT sp;", ignored);
         execSQL(db, "ROLLBACK;", ignored);
 
+        insertHelper_.discardDeferredIndexes();
         finalizeStatementsOnDB(db);
         transactionStarted_ = false;
 
@@ -297,3 +366,14 @@ private:
 std::shared_ptr<DatabaseInterface> createIOSDatabaseInterface(DatabaseBridge *db, NSNumber *connectionTag) {
     return std::make_shared<IOSDatabaseInterface>(db, connectionTag);
 }
+
+std::shared_ptr<DatabaseInterface> createIOSBootstrapDatabaseInterface(DatabaseBridge *db, NSNumber *connectionTag) {
+    return std::make_shared<watermelondb::SliceBootstrapDatabase>(createIOSLiveConnectionRunner(db, connectionTag));
+}
+
+watermelondb::LiveConnectionRunner createIOSLiveConnectionRunner(DatabaseBridge *db, NSNumber *connectionTag) {
+    auto live = std::make_shared<IOSDatabaseInterface>(db, connectionTag);
+    return [live](const std::function<bool(sqlite3 *, std::string &)> &work, std::string &errorMessage) {
+        return live->runWithWriterConnection(work, errorMessage);
+    };
+}
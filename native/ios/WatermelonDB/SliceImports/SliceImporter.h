@@ -4,12 +4,23 @@ NS_ASSUME_NONNULL_BEGIN
 
 @class DatabaseBridge;
 
-typedef void (^SliceDownloadCompletion)(NSError * _Nullable error);
+// resultJson: once the import has run (successfully or not), the sliceImportResultJson envelope
+// { changeset, error }. error: set instead when the import couldn't be started.
+typedef void (^SliceDownloadCompletion)(NSString * _Nullable resultJson, NSError * _Nullable error);
+typedef void (^SliceCommitHandler)(NSString *eventJson);
 
 @interface SliceImporter : NSObject <NSURLSessionDataDelegate>
 
 - (instancetype)initWithDatabaseBridge:(DatabaseBridge *) db connectionTag:(NSNumber *)tag;
 
+// optionsJson: SliceImportOptions JSON, e.g. {"commitMode":"table"}. Invalid options fail the import.
+- (instancetype)initWithDatabaseBridge:(DatabaseBridge *) db
+                         connectionTag:(NSNumber *)tag
+                           optionsJson:(nullable NSString *)optionsJson;
+
+// Called (on the import work queue) with a slice_commit event after every intermediate commit
+@property (nonatomic, copy, nullable) SliceCommitHandler commitHandler;
+
 - (void)startWithURL:(NSURL *)url
           completion:(SliceDownloadCompletion)completion;
 
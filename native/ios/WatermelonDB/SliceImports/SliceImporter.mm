@@ -1,6 +1,7 @@
 #import "SliceImporter.h"
 
 #include "SliceImportEngine.h"
+#include "SliceReferenceDatabase.h"
 #include "SlicePlatform.h"
 
 #import "../SliceImportDatabaseAdapter.h"
@@ -19,6 +20,7 @@ using namespace watermelondb;
 @interface SliceImporter ()
 @property (nonatomic, weak) DatabaseBridge *db;
 @property (nonatomic, strong) NSNumber *connectionTag;
+@property (nonatomic, copy, nullable) NSString *optionsJson;
 @property (nonatomic, copy, nullable) SliceDownloadCompletion completion;
 @end
 
@@ -29,10 +31,17 @@ using namespace watermelondb;
 }
 
 - (instancetype)initWithDatabaseBridge:(DatabaseBridge *)db connectionTag:(NSNumber *)tag {
+    return [self initWithDatabaseBridge:db connectionTag:tag optionsJson:nil];
+}
+
+- (instancetype)initWithDatabaseBridge:(DatabaseBridge *)db
+                         connectionTag:(NSNumber *)tag
+                           optionsJson:(NSString *)optionsJson {
     self = [super init];
     if (self) {
         _db = db;
         _connectionTag = tag;
+        _optionsJson = [optionsJson copy];
         _hasCompleted = NO;
     }
     return self;
@@ -50,9 +59,9 @@ using namespace watermelondb;
           completion:(SliceDownloadCompletion)completion {
     if (!url) {
         if (completion) {
-            completion([NSError errorWithDomain:@"com.buildops.watermelon.slice"
-                                           code:-1
-                                       userInfo:@{NSLocalizedDescriptionKey: @"Invalid URL"}]);
+            completion(nil, [NSError errorWithDomain:@"com.buildops.watermelon.slice"
+                                                code:-1
+                                            userInfo:@{NSLocalizedDescriptionKey: @"Invalid URL"}]);
         }
         return;
     }
@@ -60,8 +69,30 @@ using namespace watermelondb;
     self.completion = completion;
     _hasCompleted = NO;
     
-    _dbInterface = createIOSDatabaseInterface(self.db, self.connectionTag);
-    _engine = std::make_shared<SliceImportEngine>(_dbInterface);
+    SliceImportOptions options;
+    std::string optionsError;
+    const char *optionsCString = self.optionsJson.UTF8String;
+    if (!parseSliceImportOptions(optionsCString ? optionsCString : "", options, optionsError)) {
+        [self completeWithErrorMessage:[NSString stringWithUTF8String:optionsError.c_str()]];
+        return;
+    }
+    
+    if (!options.referencePath.empty()) {
+        _dbInterface = std::make_shared<SliceReferenceDatabase>(options.referencePath, options.referenceIndexes);
+    } else if (options.bootstrap) {
+        _dbInterface = createIOSBootstrapDatabaseInterface(self.db, self.connectionTag);
+    } else {
+        _dbInterface = createIOSDatabaseInterface(self.db, self.connectionTag);
+    }
+    _engine = std::make_shared<SliceImportEngine>(_dbInterface, options);
+    
+    SliceCommitHandler commitHandler = self.commitHandler;
+    if (commitHandler && options.commitMode != SliceCommitMode::Atomic) {
+        _engine->setCommitCallback([commitHandler](const std::vector<std::string> &tables, size_t rowsCommitted) {
+            std::string eventJson = sliceCommitEventJson(tables, rowsCommitted);
+            commitHandler([NSString stringWithUTF8String:eventJson.c_str()]);
+        });
+    }
     
     const char *urlCString = url.absoluteString.UTF8String;
     std::string urlString = urlCString ? urlCString : "";
@@ -70,20 +101,20 @@ using namespace watermelondb;
         return;
     }
     
+    // Reference slices don't touch app records, so they have nothing to report
+    const bool reportChanges = options.referencePath.empty();
     __weak __typeof__(self) weakSelf = self;
-    _engine->startImport(urlString, [weakSelf](const std::string &errorMessage) {
+    _engine->startImport(urlString, [weakSelf, reportChanges](const std::string &errorMessage) {
         __typeof__(self) strongSelf = weakSelf;
         if (!strongSelf) {
             return;
         }
-        if (errorMessage.empty()) {
-            [strongSelf completeWithError:nil];
-        } else {
-            NSString *message = [NSString stringWithUTF8String:errorMessage.c_str()];
-            [strongSelf completeWithError:[NSError errorWithDomain:@"com.buildops.watermelon.slice"
-                                                              code:-1
-                                                          userInfo:@{NSLocalizedDescriptionKey: message ?: @"Import failed"}]];
+        SyncChangeset changeset;
+        if (reportChanges && strongSelf->_engine) {
+            changeset = strongSelf->_engine->takeCommittedChangeset();
         }
+        std::string resultJson = sliceImportResultJson(changeset, errorMessage);
+        [strongSelf completeWithResultJson:[NSString stringWithUTF8String:resultJson.c_str()] error:nil];
     });
 }
 
@@ -91,10 +122,10 @@ using namespace watermelondb;
     NSError *error = [NSError errorWithDomain:@"com.buildops.watermelon.slice"
                                          code:-1
                                      userInfo:@{NSLocalizedDescriptionKey: message ?: @"Import failed"}];
-    [self completeWithError:error];
+    [self completeWithResultJson:nil error:error];
 }
 
-- (void)completeWithError:(NSError *)error {
+- (void)completeWithResultJson:(NSString *)resultJson error:(NSError *)error {
     if (_hasCompleted) {
         return;
     }
@@ -107,7 +138,7 @@ using namespace watermelondb;
     _dbInterface.reset();
     
     if (completion) {
-        completion(error);
+        completion(resultJson, error);
     }
 }
 
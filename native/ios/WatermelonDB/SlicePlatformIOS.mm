@@ -170,6 +170,22 @@ void initializeWorkQueue() {
     dispatch_queue_set_specific(workQueue, kSliceImporterQueueKey, kSliceImporterQueueKey, NULL);
 }
 
+void runOnWorkQueue(const std::function<void()>& work) {
+    std::function<void()> workCopy = work;
+    dispatch_async(workQueue, ^{
+        workCopy();
+    });
+}
+
+std::string sliceCacheDirectory() {
+    NSArray<NSString *> *paths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES);
+    if (paths.count == 0) {
+        return "";
+    }
+    NSString *directory = [paths.firstObject stringByAppendingPathComponent:@"WatermelonDBSlices"];
+    return std::string([directory UTF8String]);
+}
+
 unsigned long calculateOptimalBatchSize() {
     // Get device memory
     NSProcessInfo *processInfo = [NSProcessInfo processInfo];
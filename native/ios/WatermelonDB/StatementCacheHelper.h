@@ -0,0 +1,19 @@
+#import <Foundation/Foundation.h>
+#import <sqlite3.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Finalizes the JSI query path's cached statements of `db` (see SqliteStatementCache).
+// Must be called before the connection is closed.
+void watermelondb_drop_statement_cache(sqlite3 *db);
+
+// Closes the JSI query path's pooled reader connections and cursors on the file of `db` (see
+// SqliteReaderPool, SqliteCursor).
+// Must be called before the database is closed or its files are deleted.
+void watermelondb_drop_reader_pool(sqlite3 *db);
+
+#ifdef __cplusplus
+}
+#endif
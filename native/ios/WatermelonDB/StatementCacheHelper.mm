@@ -0,0 +1,16 @@
+#import "StatementCacheHelper.h"
+#include "SqliteCursor.h"
+#include "SqliteReaderPool.h"
+#include "SqliteStatementCache.h"
+
+void watermelondb_drop_statement_cache(sqlite3 *db) {
+    watermelondb::SqliteStatementCache::dropConnection(db);
+}
+
+void watermelondb_drop_reader_pool(sqlite3 *db) {
+    const char *filename = sqlite3_db_filename(db, "main");
+    if (filename && filename[0]) {
+        watermelondb::SqliteCursors::shared().closeAll(filename);
+        watermelondb::SqliteReaderPool::dropPath(filename);
+    }
+}
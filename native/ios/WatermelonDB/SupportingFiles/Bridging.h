@@ -19,3 +19,9 @@
 #else
 #import "../BackgroundSyncBridge.h"
 #endif
+
+#if __has_include("StatementCacheHelper.h")
+#import "StatementCacheHelper.h"
+#else
+#import "../StatementCacheHelper.h"
+#endif
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace watermelondb {
+
+// Whether `data` has no byte >= 0x80, i.e. can be handed to JSI as ASCII (createFromAscii skips
+// the UTF-8 decoding createFromUtf8 does). Scans 16 bytes at a time with NEON or SSE2, then 8 at a
+// time in a general-purpose register.
+inline bool isAscii(const char* data, size_t length) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+    size_t i = 0;
+#if defined(__aarch64__) || defined(_M_ARM64)
+    if (length >= 16) {
+        uint8x16_t seen = vdupq_n_u8(0);
+        for (; i + 16 <= length; i += 16) {
+            seen = vorrq_u8(seen, vld1q_u8(bytes + i));
+        }
+        if (vmaxvq_u8(seen) >= 0x80) {
+            return false;
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    if (length >= 16) {
+        __m128i seen = _mm_setzero_si128();
+        for (; i + 16 <= length; i += 16) {
+            seen = _mm_or_si128(seen, _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i)));
+        }
+        if (_mm_movemask_epi8(seen) != 0) {
+            return false;
+        }
+    }
+#endif
+    uint64_t seen = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        seen |= word;
+    }
+    for (; i < length; i++) {
+        seen |= bytes[i];
+    }
+    return (seen & 0x8080808080808080ULL) == 0;
+}
+
+} // namespace watermelondb
@@ -0,0 +1,187 @@
+#include "AsyncQueryExecutor.h"
+
+#include "SqliteStatementCache.h"
+
+#include <algorithm>
+
+namespace watermelondb {
+
+namespace {
+
+// Checked by SQLite every PROGRESS_STEPS virtual machine instructions; non-zero interrupts the query
+constexpr int PROGRESS_STEPS = 1000;
+
+int interruptIfCancelled(void* cancelled) {
+    return static_cast<std::atomic<bool>*>(cancelled)->load(std::memory_order_relaxed) ? 1 : 0;
+}
+
+} // namespace
+
+bool bindQueryArguments(sqlite3_stmt* stmt, const std::vector<QueryArgument>& arguments, std::string& errorMessage) {
+    if (sqlite3_bind_parameter_count(stmt) != static_cast<int>(arguments.size())) {
+        errorMessage = "Number of args passed to query doesn't match number of arg placeholders";
+        return false;
+    }
+    for (size_t i = 0; i < arguments.size(); i++) {
+        const auto& argument = arguments[i];
+        const int index = static_cast<int>(i) + 1;
+        int result;
+        if (argument.type == QueryArgument::Type::Number) {
+            result = sqlite3_bind_double(stmt, index, argument.number);
+        } else if (argument.type == QueryArgument::Type::Text) {
+            result = sqlite3_bind_text(stmt, index, argument.text.data(), static_cast<int>(argument.text.size()), SQLITE_TRANSIENT);
+        } else if (argument.type == QueryArgument::Type::Array) {
+            result = bindBoundArray(stmt, index, argument.array);
+        } else {
+            result = sqlite3_bind_null(stmt, index);
+        }
+        if (result != SQLITE_OK) {
+            errorMessage = "Failed to bind an argument for query: " + std::string(sqlite3_errmsg(sqlite3_db_handle(stmt)));
+            return false;
+        }
+    }
+    return true;
+}
+
+AsyncQueryExecutor::AsyncQueryExecutor(size_t threadCount) {
+    const size_t count = std::max<size_t>(threadCount, 1);
+    workers_.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        workers_.emplace_back([this]() { work(); });
+    }
+}
+
+AsyncQueryExecutor::~AsyncQueryExecutor() {
+    std::deque<std::shared_ptr<Query>> queued;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        queued.swap(queue_);
+        for (auto& running : running_) {
+            running.second->cancelled = true;
+        }
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    for (auto& query : queued) {
+        query->completion(AsyncQueryStatus::Cancelled, nullptr, "Query cancelled");
+    }
+}
+
+void AsyncQueryExecutor::submit(uint64_t queryId,
+                                std::shared_ptr<SqliteReaderPool> pool,
+                                std::string sql,
+                                std::vector<QueryArgument> arguments,
+                                Completion completion) {
+    auto query = std::make_shared<Query>();
+    query->id = queryId;
+    query->pool = std::move(pool);
+    query->sql = std::move(sql);
+    query->arguments = std::move(arguments);
+    query->completion = std::move(completion);
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(query));
+    }
+    wake_.notify_one();
+}
+
+bool AsyncQueryExecutor::cancel(uint64_t queryId) {
+    std::shared_ptr<Query> dequeued;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        auto running = running_.find(queryId);
+        if (running != running_.end()) {
+            running->second->cancelled = true;
+            return true;
+        }
+        auto queued = std::find_if(queue_.begin(), queue_.end(),
+                                   [queryId](const std::shared_ptr<Query>& query) { return query->id == queryId; });
+        if (queued == queue_.end()) {
+            return false;
+        }
+        dequeued = std::move(*queued);
+        queue_.erase(queued);
+    }
+    dequeued->completion(AsyncQueryStatus::Cancelled, nullptr, "Query cancelled");
+    return true;
+}
+
+size_t AsyncQueryExecutor::inFlight() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() + running_.size();
+}
+
+AsyncQueryExecutor& AsyncQueryExecutor::shared() {
+    static AsyncQueryExecutor* executor = new AsyncQueryExecutor(SqliteReaderPool::defaultSize());
+    return *executor;
+}
+
+void AsyncQueryExecutor::work() {
+    while (true) {
+        std::shared_ptr<Query> query;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            query = std::move(queue_.front());
+            queue_.pop_front();
+            running_[query->id] = query;
+        }
+
+        std::shared_ptr<const PackedResultSnapshot> result;
+        std::string errorMessage;
+        run(*query, result, errorMessage);
+
+        // Out of running_ before it completes, so cancel() from the completion's continuation
+        // reports it as done
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            running_.erase(query->id);
+        }
+        if (query->cancelled) {
+            query->completion(AsyncQueryStatus::Cancelled, nullptr, "Query cancelled");
+        } else if (result) {
+            query->completion(AsyncQueryStatus::Completed, std::move(result), "");
+        } else {
+            query->completion(AsyncQueryStatus::Failed, nullptr, errorMessage);
+        }
+    }
+}
+
+// The completion is called by work() after the connection went back to the pool, so a
+// completion that queues another query doesn't wait on this one's connection
+void AsyncQueryExecutor::run(Query& query,
+                             std::shared_ptr<const PackedResultSnapshot>& result,
+                             std::string& errorMessage) {
+    auto lease = query.pool->acquire(errorMessage);
+    if (!lease || query.cancelled) {
+        return;
+    }
+    sqlite3* db = lease.db();
+    if (usesBoundArray(query.sql) && !registerBoundArrayModule(db, errorMessage)) {
+        return;
+    }
+    sqlite3_progress_handler(db, PROGRESS_STEPS, interruptIfCancelled, &query.cancelled);
+
+    auto cache = SqliteStatementCache::forConnection(db);
+    int resultCode = SQLITE_OK;
+    sqlite3_stmt* stmt = cache->acquire(query.sql, resultCode);
+    if (!stmt) {
+        errorMessage = resultCode != SQLITE_OK ? "Failed to prepare query statement: " + std::string(sqlite3_errmsg(db))
+                                               : "Query has no statement";
+    } else if (!sqlite3_stmt_readonly(stmt)) {
+        errorMessage = "Async queries must be read-only";
+    } else if (bindQueryArguments(stmt, query.arguments, errorMessage)) {
+        result = PackedResultSnapshot::fromStatement(stmt, errorMessage);
+    }
+    cache->release(stmt);
+
+    sqlite3_progress_handler(db, 0, nullptr, nullptr);
+}
+
+} // namespace watermelondb
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "BoundArrayVirtualTable.h"
+#include "PackedResult.h"
+#include "SqliteReaderPool.h"
+
+#include <sqlite3.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace watermelondb {
+
+// A query argument copied out of its JS value, so the query can be bound on another thread. An
+// Array is bound as a whole to one bound_array(?) placeholder (BoundArrayVirtualTable.h).
+struct QueryArgument {
+    enum class Type { Null, Number, Text, Array };
+
+    Type type = Type::Null;
+    double number = 0;
+    std::string text;
+    std::shared_ptr<const BoundArray> array;
+};
+
+// Binds `arguments` to `stmt` in order; fails if their count doesn't match the placeholders
+bool bindQueryArguments(sqlite3_stmt* stmt, const std::vector<QueryArgument>& arguments, std::string& errorMessage);
+
+enum class AsyncQueryStatus {
+    Completed,
+    Failed,
+    Cancelled,
+};
+
+// Runs read-only queries off the JS thread (queryAsync, execSqlQueryAsync): a worker leases a
+// connection from the database's SqliteReaderPool, steps the query to the end into a
+// PackedResultSnapshot, and hands that to the completion. The caller then only has to turn the
+// snapshot into JS values on the JS thread.
+//
+// Ordering: queries start in submission order but run in parallel and may complete in any order.
+// Each runs in its own read transaction, which begins when a worker starts it: it sees every write
+// committed before that (so every write whose call had returned when the query was submitted), and
+// nothing of a writer transaction still in progress. Writes submitted after the query may or may
+// not be visible.
+//
+// A query is cancelled with cancel(): dropped if still queued, interrupted (through a progress
+// handler) if running. Either way its completion runs once, with Cancelled.
+class AsyncQueryExecutor {
+public:
+    // Called on a worker thread, or on the thread calling cancel() for a query that was queued.
+    // `result` is set only for Completed.
+    using Completion = std::function<void(AsyncQueryStatus status,
+                                          std::shared_ptr<const PackedResultSnapshot> result,
+                                          const std::string& errorMessage)>;
+
+    explicit AsyncQueryExecutor(size_t threadCount);
+    // Queued queries complete as Cancelled; running ones are interrupted and waited for
+    ~AsyncQueryExecutor();
+
+    AsyncQueryExecutor(const AsyncQueryExecutor&) = delete;
+    AsyncQueryExecutor& operator=(const AsyncQueryExecutor&) = delete;
+
+    // Queues `sql` to run on a connection of `pool`. `queryId` identifies it to cancel(); ids of
+    // queries in flight must be unique.
+    void submit(uint64_t queryId,
+                std::shared_ptr<SqliteReaderPool> pool,
+                std::string sql,
+                std::vector<QueryArgument> arguments,
+                Completion completion);
+
+    // Returns false if no query `queryId` is queued or running (it already completed)
+    bool cancel(uint64_t queryId);
+
+    // Queued and running queries
+    size_t inFlight() const;
+
+    // Executor of the JSI modules, with as many workers as a reader pool has connections. Never
+    // destroyed: a query may still be running when the process exits.
+    static AsyncQueryExecutor& shared();
+
+private:
+    struct Query {
+        uint64_t id = 0;
+        std::shared_ptr<SqliteReaderPool> pool;
+        std::string sql;
+        std::vector<QueryArgument> arguments;
+        Completion completion;
+        std::atomic<bool> cancelled{false};
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::shared_ptr<Query>> queue_;
+    std::unordered_map<uint64_t, std::shared_ptr<Query>> running_;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    void work();
+    static void run(Query& query, std::shared_ptr<const PackedResultSnapshot>& result, std::string& errorMessage);
+};
+
+} // namespace watermelondb
@@ -0,0 +1,186 @@
+#include "BoundArrayVirtualTable.h"
+
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+
+namespace watermelondb {
+
+namespace {
+
+constexpr const char* kModuleName = "bound_array";
+
+// Hidden column carrying the bound values (the table-valued function argument)
+constexpr int kSourceColumn = 1;
+
+// Connections bound_array is registered on; forgotten by forgetConnection when one is closed
+std::mutex gRegisteredMutex;
+std::unordered_set<sqlite3*> gRegistered;
+
+void forgetConnection(void* db) {
+    const std::lock_guard<std::mutex> lock(gRegisteredMutex);
+    gRegistered.erase(static_cast<sqlite3*>(db));
+}
+
+struct BoundArrayCursor {
+    sqlite3_vtab_cursor base;
+    const BoundArray* values;
+    size_t row;
+};
+
+int boundArrayConnect(sqlite3* db, void*, int, const char* const*, sqlite3_vtab** outVtab, char**) {
+    int rc = sqlite3_declare_vtab(db, "CREATE TABLE x(value, src HIDDEN)");
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    auto* vtab = static_cast<sqlite3_vtab*>(sqlite3_malloc(sizeof(sqlite3_vtab)));
+    if (!vtab) {
+        return SQLITE_NOMEM;
+    }
+    std::memset(vtab, 0, sizeof(sqlite3_vtab));
+    *outVtab = vtab;
+    return SQLITE_OK;
+}
+
+int boundArrayDisconnect(sqlite3_vtab* vtab) {
+    sqlite3_free(vtab);
+    return SQLITE_OK;
+}
+
+int boundArrayBestIndex(sqlite3_vtab*, sqlite3_index_info* info) {
+    for (int i = 0; i < info->nConstraint; i++) {
+        const auto& constraint = info->aConstraint[i];
+        if (constraint.iColumn == kSourceColumn && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ && constraint.usable) {
+            info->aConstraintUsage[i].argvIndex = 1;
+            info->aConstraintUsage[i].omit = 1;
+            info->estimatedCost = 1;
+            info->idxNum = 1;
+            return SQLITE_OK;
+        }
+    }
+    // Without bound values there is nothing to scan; make sure the planner never prefers this plan
+    info->estimatedCost = 1e99;
+    info->idxNum = 0;
+    return SQLITE_OK;
+}
+
+int boundArrayOpen(sqlite3_vtab*, sqlite3_vtab_cursor** outCursor) {
+    auto* cursor = static_cast<BoundArrayCursor*>(sqlite3_malloc(sizeof(BoundArrayCursor)));
+    if (!cursor) {
+        return SQLITE_NOMEM;
+    }
+    std::memset(cursor, 0, sizeof(BoundArrayCursor));
+    *outCursor = &cursor->base;
+    return SQLITE_OK;
+}
+
+int boundArrayClose(sqlite3_vtab_cursor* cursor) {
+    sqlite3_free(cursor);
+    return SQLITE_OK;
+}
+
+int boundArrayFilter(sqlite3_vtab_cursor* base, int idxNum, const char*, int argc, sqlite3_value** argv) {
+    auto* cursor = reinterpret_cast<BoundArrayCursor*>(base);
+    cursor->row = 0;
+    cursor->values = nullptr;
+    if (idxNum == 1 && argc == 1) {
+        auto* holder = static_cast<const std::shared_ptr<const BoundArray>*>(
+            sqlite3_value_pointer(argv[0], BOUND_ARRAY_POINTER_TYPE));
+        cursor->values = holder ? holder->get() : nullptr;
+    }
+    return SQLITE_OK;
+}
+
+int boundArrayNext(sqlite3_vtab_cursor* base) {
+    reinterpret_cast<BoundArrayCursor*>(base)->row++;
+    return SQLITE_OK;
+}
+
+int boundArrayEof(sqlite3_vtab_cursor* base) {
+    auto* cursor = reinterpret_cast<BoundArrayCursor*>(base);
+    return !cursor->values || cursor->row >= cursor->values->size();
+}
+
+// Values are handed out as SQLITE_STATIC: the binding can't change while the statement runs
+int boundArrayColumn(sqlite3_vtab_cursor* base, sqlite3_context* ctx, int column) {
+    auto* cursor = reinterpret_cast<BoundArrayCursor*>(base);
+    if (column != 0) {
+        sqlite3_result_null(ctx);
+        return SQLITE_OK;
+    }
+    const BoundArrayValue& value = (*cursor->values)[cursor->row];
+    switch (value.type) {
+    case BoundArrayValue::Type::Number:
+        sqlite3_result_double(ctx, value.number);
+        break;
+    case BoundArrayValue::Type::Text:
+        sqlite3_result_text(ctx, value.text.data(), static_cast<int>(value.text.size()), SQLITE_STATIC);
+        break;
+    default:
+        sqlite3_result_null(ctx);
+        break;
+    }
+    return SQLITE_OK;
+}
+
+int boundArrayRowid(sqlite3_vtab_cursor* base, sqlite3_int64* rowid) {
+    *rowid = static_cast<sqlite3_int64>(reinterpret_cast<BoundArrayCursor*>(base)->row);
+    return SQLITE_OK;
+}
+
+const sqlite3_module& boundArrayModule() {
+    static const sqlite3_module module = [] {
+        sqlite3_module m;
+        std::memset(&m, 0, sizeof(m));
+        m.iVersion = 0;
+        // xCreate stays null: eponymous-only, usable as bound_array(...) without CREATE VIRTUAL TABLE
+        m.xConnect = boundArrayConnect;
+        m.xBestIndex = boundArrayBestIndex;
+        m.xDisconnect = boundArrayDisconnect;
+        m.xOpen = boundArrayOpen;
+        m.xClose = boundArrayClose;
+        m.xFilter = boundArrayFilter;
+        m.xNext = boundArrayNext;
+        m.xEof = boundArrayEof;
+        m.xColumn = boundArrayColumn;
+        m.xRowid = boundArrayRowid;
+        return m;
+    }();
+    return module;
+}
+
+void deleteHolder(void* holder) {
+    delete static_cast<std::shared_ptr<const BoundArray>*>(holder);
+}
+
+} // namespace
+
+bool usesBoundArray(const std::string& sql) {
+    return sql.find("bound_array") != std::string::npos;
+}
+
+// Registered outside the lock: a failed sqlite3_create_module_v2 calls forgetConnection right away
+bool registerBoundArrayModule(sqlite3* db, std::string& errorMessage) {
+    {
+        const std::lock_guard<std::mutex> lock(gRegisteredMutex);
+        if (gRegistered.count(db)) {
+            return true;
+        }
+    }
+    int rc = sqlite3_create_module_v2(db, kModuleName, &boundArrayModule(), db, forgetConnection);
+    if (rc != SQLITE_OK) {
+        errorMessage = "Failed to register bound_array module: " + std::string(sqlite3_errmsg(db));
+        return false;
+    }
+    const std::lock_guard<std::mutex> lock(gRegisteredMutex);
+    gRegistered.insert(db);
+    return true;
+}
+
+int bindBoundArray(sqlite3_stmt* stmt, int index, std::shared_ptr<const BoundArray> values) {
+    auto* holder = new std::shared_ptr<const BoundArray>(std::move(values));
+    // sqlite3_bind_pointer calls deleteHolder itself if binding fails
+    return sqlite3_bind_pointer(stmt, index, holder, BOUND_ARRAY_POINTER_TYPE, deleteHolder);
+}
+
+} // namespace watermelondb
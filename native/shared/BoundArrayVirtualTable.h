@@ -0,0 +1,42 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace watermelondb {
+
+// Eponymous virtual table that binds a whole list of values to one placeholder, so large IN lists
+// don't need one `?` per value (and don't run into SQLITE_MAX_VARIABLE_NUMBER):
+//
+//   SELECT * FROM "tasks" WHERE "id" IN bound_array(?1)
+//
+// The SQL stays the same whatever the length of the list, so its statement is cached
+// (SqliteStatementCache) instead of compiled again for every list. ?1 is bound with bindBoundArray;
+// it has a single column, `value`. A placeholder bound to anything else yields no rows.
+struct BoundArrayValue {
+    enum class Type { Null, Number, Text };
+
+    Type type = Type::Null;
+    double number = 0;
+    std::string text;
+};
+
+using BoundArray = std::vector<BoundArrayValue>;
+
+constexpr const char* BOUND_ARRAY_POINTER_TYPE = "watermelondb_bound_array";
+
+// True if `sql` calls bound_array, so its connection needs registerBoundArrayModule before the
+// statement is prepared
+bool usesBoundArray(const std::string& sql);
+
+// Registers the bound_array module on `db` unless it already has it. Connections are remembered
+// until they are closed.
+bool registerBoundArrayModule(sqlite3* db, std::string& errorMessage);
+
+// Binds `values` to parameter `index` of `stmt`. The statement keeps them alive until the parameter
+// is bound again or cleared (SqliteStatement::reset), or the statement is finalized.
+int bindBoundArray(sqlite3_stmt* stmt, int index, std::shared_ptr<const BoundArray> values);
+
+} // namespace watermelondb
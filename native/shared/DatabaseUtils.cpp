@@ -6,6 +6,14 @@
 //
 
 #include "DatabaseUtils.h"
+#include "AsciiScan.h"
+#include "PackedResult.h"
+#include "SqliteStatementCache.h"
+
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <utility>
 
 namespace watermelondb {
 
@@ -17,13 +25,47 @@ jsi::JSError dbError(jsi::Runtime &rt, sqlite3* db, std::string description) {
     return jsi::JSError(rt, message);
 }
 
+namespace {
+
+// Elements of a JS array argument, bound to one bound_array(?) placeholder
+std::shared_ptr<const BoundArray> boundArray(jsi::Runtime &rt, const jsi::Array &array) {
+    const size_t count = array.length(rt);
+    auto values = std::make_shared<BoundArray>(count);
+    for (size_t i = 0; i < count; i++) {
+        jsi::Value value = array.getValueAtIndex(rt, i);
+        BoundArrayValue &element = (*values)[i];
+        if (value.isNull() || value.isUndefined()) {
+            element.type = BoundArrayValue::Type::Null;
+        } else if (value.isString()) {
+            element.type = BoundArrayValue::Type::Text;
+            element.text = value.getString(rt).utf8(rt);
+        } else if (value.isNumber()) {
+            element.type = BoundArrayValue::Type::Number;
+            element.number = value.getNumber();
+        } else if (value.isBool()) {
+            element.type = BoundArrayValue::Type::Number;
+            element.number = value.getBool() ? 1 : 0;
+        } else {
+            throw jsi::JSError(rt, "Invalid array element type for query");
+        }
+    }
+    return values;
+}
+
+} // namespace
+
 sqlite3_stmt* getStmt(jsi::Runtime &rt, sqlite3* db, std::string sql, const jsi::Array &arguments) {
-    sqlite3_stmt *statement;
-    
-    int resultPrepare = sqlite3_prepare_v2(db, sql.c_str(), -1, &statement, nullptr);
+    if (usesBoundArray(sql)) {
+        std::string registerError;
+        if (!registerBoundArrayModule(db, registerError)) {
+            throw jsi::JSError(rt, registerError);
+        }
+    }
+
+    int resultPrepare;
+    sqlite3_stmt *statement = SqliteStatementCache::forConnection(db)->acquire(sql, resultPrepare);
     
     if (resultPrepare != SQLITE_OK) {
-        sqlite3_finalize(statement);
         throw dbError(rt, db, "Failed to prepare query statement");
     }
     
@@ -33,7 +75,7 @@ sqlite3_stmt* getStmt(jsi::Runtime &rt, sqlite3* db, std::string sql, const jsi:
     int argsCount = sqlite3_bind_parameter_count(statement);
     
     if (argsCount != arguments.length(rt)) {
-        sqlite3_reset(statement);
+        finalizeStmt(statement);
         throw jsi::JSError(rt, "Number of args passed to query doesn't match number of arg placeholders");
     }
     
@@ -50,17 +92,27 @@ sqlite3_stmt* getStmt(jsi::Runtime &rt, sqlite3* db, std::string sql, const jsi:
             bindResult = sqlite3_bind_double(statement, i + 1, value.getNumber());
         } else if (value.isBool()) {
             bindResult = sqlite3_bind_int(statement, i + 1, value.getBool());
+        } else if (value.isObject() && value.asObject(rt).isArray(rt)) {
+            std::shared_ptr<const BoundArray> values;
+            try {
+                values = boundArray(rt, value.asObject(rt).asArray(rt));
+            } catch (...) {
+                finalizeStmt(statement);
+                throw;
+            }
+            bindResult = bindBoundArray(statement, i + 1, std::move(values));
         } else if (value.isObject()) {
-            sqlite3_reset(statement);
+            finalizeStmt(statement);
             throw jsi::JSError(rt, "Invalid argument type (object) for query");
         } else {
-            sqlite3_reset(statement);
+            finalizeStmt(statement);
             throw jsi::JSError(rt, "Invalid argument type (unknown) for query");
         }
         
         if (bindResult != SQLITE_OK) {
-            sqlite3_reset(statement);
-            throw dbError(rt, db, "Failed to bind an argument for query");
+            auto error = dbError(rt, db, "Failed to bind an argument for query");
+            finalizeStmt(statement);
+            throw error;
         }
     }
     
@@ -70,7 +122,14 @@ sqlite3_stmt* getStmt(jsi::Runtime &rt, sqlite3* db, std::string sql, const jsi:
 }
 
 void finalizeStmt(sqlite3_stmt* stmt) {
-    sqlite3_finalize(stmt);
+    if (!stmt) {
+        return;
+    }
+    if (auto cache = SqliteStatementCache::existingForConnection(sqlite3_db_handle(stmt))) {
+        cache->release(stmt);
+    } else {
+        sqlite3_finalize(stmt);
+    }
 }
 
 jsi::Array arrayFromStd(jsi::Runtime &rt, std::vector<jsi::Value> &vector) {
@@ -88,35 +147,369 @@ jsi::Array arrayFromStd(jsi::Runtime &rt, std::vector<jsi::Value> &vector) {
     return array;
 }
 
+std::vector<jsi::PropNameID> columnNames(jsi::Runtime &rt, sqlite3_stmt *statement) {
+    int count = sqlite3_column_count(statement);
+    std::vector<jsi::PropNameID> names;
+    names.reserve(count);
+    for (int i = 0; i < count; i++) {
+        const char *column = sqlite3_column_name(statement, i);
+        assert(column);
+        size_t length = std::strlen(column);
+        if (isAscii(column, length)) {
+            names.push_back(jsi::PropNameID::forAscii(rt, column, length));
+        } else {
+            names.push_back(jsi::PropNameID::forUtf8(rt, reinterpret_cast<const uint8_t *>(column), length));
+        }
+    }
+    return names;
+}
+
 jsi::Object resultDictionary(jsi::Runtime &rt, sqlite3_stmt *statement) {
+    return resultDictionary(rt, statement, columnNames(rt, statement));
+}
+
+namespace {
+
+jsi::Value stringValue(jsi::Runtime &rt, const char *text, size_t length) {
+    if (isAscii(text, length)) {
+        return jsi::String::createFromAscii(rt, text, length);
+    }
+    return jsi::String::createFromUtf8(rt, reinterpret_cast<const uint8_t *>(text), length);
+}
+
+jsi::Value cellValue(jsi::Runtime &rt, const PackedResultSnapshot::Cell &cell) {
+    if (cell.tag == PackedTag::NUMBER) {
+        return jsi::Value(cell.number);
+    } else if (cell.tag == PackedTag::TEXT) {
+        return stringValue(rt, cell.text, cell.length);
+    }
+    return jsi::Value::null();
+}
+
+jsi::Value columnValue(jsi::Runtime &rt, sqlite3_stmt *statement, int i) {
+    auto type = sqlite3_column_type(statement, i);
+    if (type == SQLITE_INTEGER) {
+        sqlite3_int64 value = sqlite3_column_int64(statement, i);
+        return jsi::Value((double)value);
+    } else if (type == SQLITE_FLOAT) {
+        double value = sqlite3_column_double(statement, i);
+        return jsi::Value(value);
+    } else if (type == SQLITE_TEXT) {
+        const char *text = (const char *)sqlite3_column_text(statement, i);
+        if (!text) {
+            return jsi::Value::null();
+        }
+        return stringValue(rt, text, static_cast<size_t>(sqlite3_column_bytes(statement, i)));
+    } else if (type == SQLITE_NULL) {
+        return jsi::Value::null();
+    }
+    throw jsi::JSError(rt, "Unable to fetch record from database - unknown column type (WatermelonDB does not support blobs or custom sqlite types");
+}
+
+// Backing store of an ArrayBuffer, handed to the runtime without a copy
+template <typename T>
+class VectorBuffer : public jsi::MutableBuffer {
+public:
+    explicit VectorBuffer(std::vector<T> values) : values_(std::move(values)) {}
+
+    size_t size() const override { return values_.size() * sizeof(T); }
+    uint8_t *data() override { return reinterpret_cast<uint8_t *>(values_.data()); }
+
+private:
+    std::vector<T> values_;
+};
+
+// One result column: numbers while every value so far was INTEGER or FLOAT, JS values from the
+// first TEXT or NULL on
+struct ResultColumn {
+    bool numeric = true;
+    std::vector<double> numbers;
+    std::vector<jsi::Value> values;
+};
+
+// One row of a PackedResultSnapshot. Columns are converted to JS values when read, not up front;
+// every row of a result shares the snapshot, which lives until the last of them is collected. The
+// row's cells are located on the first read, so later reads don't walk the row again.
+class LazyRow : public jsi::HostObject {
+public:
+    LazyRow(std::shared_ptr<const PackedResultSnapshot> snapshot, size_t row) : snapshot_(std::move(snapshot)), row_(row) {}
+
+    jsi::Value get(jsi::Runtime &rt, const jsi::PropNameID &name) override {
+        int column = snapshot_->columnIndex(name.utf8(rt));
+        if (column < 0) {
+            return jsi::Value::undefined();
+        }
+        if (cells_.empty()) {
+            snapshot_->cells(row_, cells_);
+        }
+        return cellValue(rt, cells_[static_cast<size_t>(column)]);
+    }
+
+    void set(jsi::Runtime &rt, const jsi::PropNameID &name, const jsi::Value &) override {
+        throw jsi::JSError(rt, "Cannot set " + name.utf8(rt) + ": lazy query rows are read-only");
+    }
+
+    std::vector<jsi::PropNameID> getPropertyNames(jsi::Runtime &rt) override {
+        std::vector<jsi::PropNameID> names;
+        names.reserve(snapshot_->columnCount());
+        for (size_t i = 0; i < snapshot_->columnCount(); i++) {
+            const std::string &column = snapshot_->columnName(i);
+            names.push_back(jsi::PropNameID::forUtf8(rt, reinterpret_cast<const uint8_t *>(column.data()), column.size()));
+        }
+        return names;
+    }
+
+private:
+    std::shared_ptr<const PackedResultSnapshot> snapshot_;
+    size_t row_;
+    // Point into the snapshot's bytes
+    std::vector<PackedResultSnapshot::Cell> cells_;
+};
+
+} // namespace
+
+jsi::Object resultDictionary(jsi::Runtime &rt, sqlite3_stmt *statement, const std::vector<jsi::PropNameID> &columns) {
     jsi::Object dictionary(rt);
 
-    for (int i = 0, len = sqlite3_column_count(statement); i < len; i++) {
-        const char *column = sqlite3_column_name(statement, i);
-        assert(column);
+    for (int i = 0, len = static_cast<int>(columns.size()); i < len; i++) {
+        dictionary.setProperty(rt, columns[i], columnValue(rt, statement, i));
+    }
+
+    return dictionary; // TODO: Make sure this value is moved, not copied
+}
+
+jsi::Array rowsResult(jsi::Runtime &rt, sqlite3_stmt *statement) {
+    std::vector<jsi::Value> records = {};
+
+    auto columns = columnNames(rt, statement);
+
+    while (true) {
+        if (getNextRowOrTrue(rt, statement)) {
+            break;
+        }
 
-        auto type = sqlite3_column_type(statement, i);
-        if (type == SQLITE_INTEGER) {
-            sqlite3_int64 value = sqlite3_column_int64(statement, i);
-            dictionary.setProperty(rt, column, jsi::Value((double)value));
-        } else if (type == SQLITE_FLOAT) {
-            double value = sqlite3_column_double(statement, i);
-            dictionary.setProperty(rt, column, jsi::Value(value));
-        } else if (type == SQLITE_TEXT) {
-            const char *text = (const char *)sqlite3_column_text(statement, i);
-            if (text) {
-                dictionary.setProperty(rt, column, jsi::String::createFromUtf8(rt, text));
-            } else {
-                dictionary.setProperty(rt, column, jsi::Value::null());
+        jsi::Object record = resultDictionary(rt, statement, columns);
+
+        records.push_back(std::move(record));
+    }
+
+    return arrayFromStd(rt, records);
+}
+
+jsi::Object columnarResult(jsi::Runtime &rt, sqlite3_stmt *statement) {
+    int count = sqlite3_column_count(statement);
+    std::vector<ResultColumn> columns(count);
+    size_t rowCount = 0;
+
+    while (!getNextRowOrTrue(rt, statement)) {
+        for (int i = 0; i < count; i++) {
+            ResultColumn &column = columns[i];
+            auto type = sqlite3_column_type(statement, i);
+            if (column.numeric) {
+                if (type == SQLITE_INTEGER) {
+                    column.numbers.push_back((double)sqlite3_column_int64(statement, i));
+                    continue;
+                } else if (type == SQLITE_FLOAT) {
+                    column.numbers.push_back(sqlite3_column_double(statement, i));
+                    continue;
+                }
+                column.numeric = false;
+                column.values.reserve(column.numbers.size() + 1);
+                for (double number : column.numbers) {
+                    column.values.emplace_back(number);
+                }
+                column.numbers = std::vector<double>();
             }
-        } else if (type == SQLITE_NULL) {
-            dictionary.setProperty(rt, column, jsi::Value::null());
+            column.values.push_back(columnValue(rt, statement, i));
+        }
+        rowCount++;
+    }
+
+    jsi::Array names(rt, count);
+    jsi::Array values(rt, count);
+    jsi::Function float64Array = rt.global().getPropertyAsFunction(rt, "Float64Array");
+    for (int i = 0; i < count; i++) {
+        const char *name = sqlite3_column_name(statement, i);
+        assert(name);
+        names.setValueAtIndex(rt, i, stringValue(rt, name, std::strlen(name)));
+
+        ResultColumn &column = columns[i];
+        if (column.numeric && rowCount > 0) {
+            jsi::ArrayBuffer buffer(rt, std::make_shared<VectorBuffer<double>>(std::move(column.numbers)));
+            values.setValueAtIndex(rt, i, float64Array.callAsConstructor(rt, buffer));
         } else {
-            throw jsi::JSError(rt, "Unable to fetch record from database - unknown column type (WatermelonDB does not support blobs or custom sqlite types");
+            jsi::Array array(rt, column.values.size());
+            for (size_t row = 0; row < column.values.size(); row++) {
+                array.setValueAtIndex(rt, row, std::move(column.values[row]));
+            }
+            values.setValueAtIndex(rt, i, std::move(array));
         }
     }
 
-    return dictionary; // TODO: Make sure this value is moved, not copied
+    jsi::Object result(rt);
+    result.setProperty(rt, "columns", std::move(names));
+    result.setProperty(rt, "rowCount", jsi::Value((double)rowCount));
+    result.setProperty(rt, "values", std::move(values));
+    return result;
+}
+
+jsi::ArrayBuffer packedResult(jsi::Runtime &rt, sqlite3_stmt *statement) {
+    std::vector<uint8_t> bytes;
+    std::string errorMessage;
+    if (!encodePackedResult(statement, bytes, errorMessage)) {
+        throw jsi::JSError(rt, errorMessage);
+    }
+    return jsi::ArrayBuffer(rt, std::make_shared<VectorBuffer<uint8_t>>(std::move(bytes)));
+}
+
+jsi::Array lazyRowsResult(jsi::Runtime &rt, sqlite3_stmt *statement) {
+    std::string errorMessage;
+    auto snapshot = PackedResultSnapshot::fromStatement(statement, errorMessage);
+    if (!snapshot) {
+        throw jsi::JSError(rt, errorMessage);
+    }
+    jsi::Array rows(rt, snapshot->rowCount());
+    for (size_t i = 0; i < snapshot->rowCount(); i++) {
+        rows.setValueAtIndex(rt, i, jsi::Object::createFromHostObject(rt, std::make_shared<LazyRow>(snapshot, i)));
+    }
+    return rows;
+}
+
+jsi::Value readResult(jsi::Runtime &rt, sqlite3_stmt *statement, ResultFormat format) {
+    if (format == ResultFormat::Columnar) {
+        return columnarResult(rt, statement);
+    } else if (format == ResultFormat::Packed) {
+        return packedResult(rt, statement);
+    } else if (format == ResultFormat::LazyRows) {
+        return lazyRowsResult(rt, statement);
+    }
+    return rowsResult(rt, statement);
+}
+
+std::vector<QueryArgument> queryArguments(jsi::Runtime &rt, const jsi::Array &arguments) {
+    const size_t count = arguments.length(rt);
+    std::vector<QueryArgument> result(count);
+    for (size_t i = 0; i < count; i++) {
+        jsi::Value value = arguments.getValueAtIndex(rt, i);
+        QueryArgument &argument = result[i];
+        if (value.isNull() || value.isUndefined()) {
+            argument.type = QueryArgument::Type::Null;
+        } else if (value.isString()) {
+            argument.type = QueryArgument::Type::Text;
+            argument.text = value.getString(rt).utf8(rt);
+        } else if (value.isNumber()) {
+            argument.type = QueryArgument::Type::Number;
+            argument.number = value.getNumber();
+        } else if (value.isBool()) {
+            argument.type = QueryArgument::Type::Number;
+            argument.number = value.getBool() ? 1 : 0;
+        } else if (value.isObject() && value.asObject(rt).isArray(rt)) {
+            argument.type = QueryArgument::Type::Array;
+            argument.array = boundArray(rt, value.asObject(rt).asArray(rt));
+        } else if (value.isObject()) {
+            throw jsi::JSError(rt, "Invalid argument type (object) for query");
+        } else {
+            throw jsi::JSError(rt, "Invalid argument type (unknown) for query");
+        }
+    }
+    return result;
+}
+
+namespace {
+
+std::vector<jsi::PropNameID> snapshotColumnNames(jsi::Runtime &rt, const PackedResultSnapshot &snapshot) {
+    std::vector<jsi::PropNameID> names;
+    names.reserve(snapshot.columnCount());
+    for (size_t i = 0; i < snapshot.columnCount(); i++) {
+        const std::string &column = snapshot.columnName(i);
+        names.push_back(jsi::PropNameID::forUtf8(rt, reinterpret_cast<const uint8_t *>(column.data()), column.size()));
+    }
+    return names;
+}
+
+// `cells` is scratch space reused across rows
+jsi::Object snapshotRow(jsi::Runtime &rt, const PackedResultSnapshot &snapshot, size_t row, const std::vector<jsi::PropNameID> &columns,
+                        std::vector<PackedResultSnapshot::Cell> &cells) {
+    snapshot.cells(row, cells);
+    jsi::Object dictionary(rt);
+    for (size_t i = 0; i < columns.size(); i++) {
+        dictionary.setProperty(rt, columns[i], cellValue(rt, cells[i]));
+    }
+    return dictionary;
+}
+
+} // namespace
+
+jsi::Array snapshotRows(jsi::Runtime &rt, const PackedResultSnapshot &snapshot) {
+    auto columns = snapshotColumnNames(rt, snapshot);
+    std::vector<PackedResultSnapshot::Cell> cells;
+    jsi::Array rows(rt, snapshot.rowCount());
+    for (size_t i = 0; i < snapshot.rowCount(); i++) {
+        rows.setValueAtIndex(rt, i, snapshotRow(rt, snapshot, i, columns, cells));
+    }
+    return rows;
+}
+
+jsi::Array snapshotRecords(jsi::Runtime &rt, const PackedResultSnapshot &snapshot,
+                           const std::function<bool(const char *id, size_t length)> &isCachedOrMark) {
+    if (snapshot.rowCount() > 0 && (snapshot.columnCount() == 0 || snapshot.columnName(0) != "id")) {
+        throw jsi::JSError(rt, "Query result does not have 'id' as first column");
+    }
+    auto columns = snapshotColumnNames(rt, snapshot);
+    std::vector<PackedResultSnapshot::Cell> cells;
+    jsi::Array records(rt, snapshot.rowCount());
+    for (size_t i = 0; i < snapshot.rowCount(); i++) {
+        auto id = snapshot.cell(i, 0);
+        if (id.tag != PackedTag::TEXT) {
+            throw jsi::JSError(rt, "Failed to get ID of a record");
+        }
+        if (isCachedOrMark(id.text, id.length)) {
+            records.setValueAtIndex(rt, i, stringValue(rt, id.text, id.length));
+        } else {
+            records.setValueAtIndex(rt, i, snapshotRow(rt, snapshot, i, columns, cells));
+        }
+    }
+    return records;
+}
+
+uint64_t openCursor(jsi::Runtime &rt, const std::shared_ptr<SqliteReaderPool> &pool, const std::string &sql, const jsi::Array &arguments) {
+    if (!pool) {
+        throw jsi::JSError(rt, "Cursors are not available for in-memory databases");
+    }
+    std::string errorMessage;
+    const uint64_t cursorId = SqliteCursors::shared().open(pool, sql, queryArguments(rt, arguments), errorMessage);
+    if (cursorId == 0) {
+        throw jsi::JSError(rt, errorMessage);
+    }
+    return cursorId;
+}
+
+jsi::Object fetchCursor(jsi::Runtime &rt, uint64_t cursorId, size_t maxRows, uint32_t maxMillis) {
+    jsi::Object page(rt);
+    auto cursor = SqliteCursors::shared().find(cursorId);
+    if (!cursor || cursor->isDone()) {
+        SqliteCursors::shared().close(cursorId);
+        page.setProperty(rt, "rows", jsi::Array(rt, 0));
+        page.setProperty(rt, "done", true);
+        return page;
+    }
+
+    auto columns = columnNames(rt, cursor->statement());
+    std::vector<jsi::Value> rows;
+    std::string errorMessage;
+    auto result = cursor->fetch(maxRows, maxMillis, [&](sqlite3_stmt *stmt) {
+        rows.push_back(resultDictionary(rt, stmt, columns));
+    }, errorMessage);
+    if (result != SqliteCursor::FetchResult::More) {
+        SqliteCursors::shared().close(cursorId);
+    }
+    if (result == SqliteCursor::FetchResult::Failed) {
+        throw jsi::JSError(rt, errorMessage);
+    }
+
+    page.setProperty(rt, "rows", arrayFromStd(rt, rows));
+    page.setProperty(rt, "done", result == SqliteCursor::FetchResult::Done);
+    return page;
 }
 
 bool getNextRowOrTrue(jsi::Runtime &rt, sqlite3_stmt *stmt) {
@@ -9,25 +9,93 @@
 #define DatabaseUtils_hpp
 
 #import <jsi/jsi.h>
+#import <functional>
 #import <unordered_map>
 #import <unordered_set>
+#import <vector>
 #import <sqlite3.h>
 
 #import "Sqlite.h"
+#import "AsyncQueryExecutor.h"
+#import "PackedResult.h"
+#import "SqliteCursor.h"
 
 using namespace facebook;
 
 namespace watermelondb {
 
+// Returns a statement for `sql` with `arguments` bound, from the connection's statement cache
+// (SqliteStatementCache). Every statement must be given back with finalizeStmt. An array argument
+// is bound as a whole to a bound_array(?) placeholder (BoundArrayVirtualTable.h).
 sqlite3_stmt* getStmt(jsi::Runtime &rt, sqlite3* db, std::string sql, const jsi::Array &arguments);
 
+// Gives a statement back to its connection's statement cache (finalizes it if uncached)
 void finalizeStmt(sqlite3_stmt* stmt);
 
 jsi::Array arrayFromStd(jsi::Runtime &rt, std::vector<jsi::Value> &vector);
 
+// Property names for the statement's result columns. Build once per statement and pass to
+// resultDictionary for every row, instead of creating a PropNameID per cell.
+std::vector<jsi::PropNameID> columnNames(jsi::Runtime &rt, sqlite3_stmt *statement);
+
 jsi::Object resultDictionary(jsi::Runtime &rt, sqlite3_stmt *statement);
 
+jsi::Object resultDictionary(jsi::Runtime &rt, sqlite3_stmt *statement, const std::vector<jsi::PropNameID> &columns);
+
 bool getNextRowOrTrue(jsi::Runtime &rt, sqlite3_stmt *stmt);
 
+// Shape of a query result on the JSI query path
+enum class ResultFormat {
+    // An array with one object per row ({column: value})
+    Rows,
+    // One array per column; see columnarResult
+    Columnar,
+    // One ArrayBuffer; see packedResult
+    Packed,
+    // An array of read-only HostObject rows; see lazyRowsResult
+    LazyRows,
+};
+
+// Steps `statement` to the end and returns an array with one object per row
+jsi::Array rowsResult(jsi::Runtime &rt, sqlite3_stmt *statement);
+
+// Steps `statement` to the end and returns {columns, rowCount, values}: the column names, and for
+// each column its values in row order. A column that is all INTEGER/FLOAT comes back as a
+// Float64Array over a buffer filled natively; any other column as an array of values. No object is
+// created per row, so large reads cost a few appends per row here and are hydrated in JS as needed.
+jsi::Object columnarResult(jsi::Runtime &rt, sqlite3_stmt *statement);
+
+// Steps `statement` to the end and returns the rows encoded in one ArrayBuffer (PackedResult.h),
+// which takes over the native buffer without a copy. No JS value is created per cell.
+jsi::ArrayBuffer packedResult(jsi::Runtime &rt, sqlite3_stmt *statement);
+
+// Steps `statement` to the end into a native snapshot (PackedResultSnapshot) and returns one
+// HostObject per row. A row converts a column to a JS value only when that property is read, so
+// code touching a few columns of wide rows skips the rest. Rows are read-only.
+jsi::Array lazyRowsResult(jsi::Runtime &rt, sqlite3_stmt *statement);
+
+jsi::Value readResult(jsi::Runtime &rt, sqlite3_stmt *statement, ResultFormat format);
+
+// Copies `arguments` out of the runtime (with getStmt's rules) so they can be bound on a worker
+// thread (AsyncQueryExecutor)
+std::vector<QueryArgument> queryArguments(jsi::Runtime &rt, const jsi::Array &arguments);
+
+// An array with one object per row of `snapshot`, like rowsResult
+jsi::Array snapshotRows(jsi::Runtime &rt, const PackedResultSnapshot &snapshot);
+
+// The result of query() from `snapshot`, whose first column must be `id`: the id alone for a record
+// `isCachedOrMark` reports as already cached, the whole row otherwise. Call it on the JS thread,
+// where the record cache is kept consistent with what JS has been sent.
+jsi::Array snapshotRecords(jsi::Runtime &rt, const PackedResultSnapshot &snapshot,
+                           const std::function<bool(const char *id, size_t length)> &isCachedOrMark);
+
+// Opens a cursor over `sql` on a connection of `pool` (SqliteCursors) and returns its id. Throws if
+// there is no pool (in-memory database) or the cursor can't be opened.
+uint64_t openCursor(jsi::Runtime &rt, const std::shared_ptr<SqliteReaderPool> &pool, const std::string &sql, const jsi::Array &arguments);
+
+// Next page of cursor `cursorId` as {rows, done}, with one object per row like rowsResult. A
+// cursor that is done (or fails) is closed, and fetching it again returns no rows.
+jsi::Object fetchCursor(jsi::Runtime &rt, uint64_t cursorId, size_t maxRows, uint32_t maxMillis);
+
 }
 #endif /* DatabaseUtils_hpp */
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace watermelondb {
+
+// Small integer standing for a table or column name (see IdentifierInterner)
+using Identifier = uint32_t;
+
+// Assigns stable ids to table and column names, so hot paths hash and compare integers instead of
+// strings. Names are interned once (per table header, per table of a sync page) and the ids are
+// used from there on. Ids are process-wide and never reused; names are never freed, which is fine
+// for the bounded set of names in a schema. Thread-safe.
+class IdentifierInterner {
+public:
+    static IdentifierInterner& shared() {
+        static IdentifierInterner interner;
+        return interner;
+    }
+
+    Identifier intern(std::string_view name) {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        auto it = ids_.find(name);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+        const Identifier id = static_cast<Identifier>(names_.size());
+        names_.emplace_back(name);
+        // Keyed by a view of the stored name: deque elements don't move
+        ids_.emplace(names_.back(), id);
+        return id;
+    }
+
+    // `id` must come from intern(). The reference stays valid for the interner's lifetime.
+    const std::string& name(Identifier id) const {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        return names_[id];
+    }
+
+    size_t size() const {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        return names_.size();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::deque<std::string> names_;
+    std::unordered_map<std::string_view, Identifier> ids_;
+};
+
+inline Identifier internIdentifier(std::string_view name) {
+    return IdentifierInterner::shared().intern(name);
+}
+
+inline const std::string& identifierName(Identifier id) {
+    return IdentifierInterner::shared().name(id);
+}
+
+} // namespace watermelondb
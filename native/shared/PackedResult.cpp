@@ -0,0 +1,279 @@
+#include "PackedResult.h"
+
+#include <cstring>
+#include <limits>
+
+namespace watermelondb {
+
+namespace {
+
+constexpr size_t INITIAL_CAPACITY = 64 * 1024;
+
+// Appends `length` bytes to `out` and returns where they start
+uint8_t* grow(std::vector<uint8_t>& out, size_t length) {
+    const size_t at = out.size();
+    out.resize(at + length);
+    return out.data() + at;
+}
+
+void storeU32(uint8_t* at, uint32_t value) {
+    at[0] = static_cast<uint8_t>(value);
+    at[1] = static_cast<uint8_t>(value >> 8);
+    at[2] = static_cast<uint8_t>(value >> 16);
+    at[3] = static_cast<uint8_t>(value >> 24);
+}
+
+void putU16(std::vector<uint8_t>& out, uint16_t value) {
+    uint8_t* at = grow(out, 2);
+    at[0] = static_cast<uint8_t>(value);
+    at[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t value) {
+    storeU32(grow(out, 4), value);
+}
+
+void putNumber(std::vector<uint8_t>& out, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint8_t* at = grow(out, 9);
+    at[0] = static_cast<uint8_t>(PackedTag::NUMBER);
+    for (int i = 0; i < 8; i++) {
+        at[1 + i] = static_cast<uint8_t>(bits >> (i * 8));
+    }
+}
+
+void putText(std::vector<uint8_t>& out, const void* data, size_t length) {
+    uint8_t* at = grow(out, 5 + length);
+    at[0] = static_cast<uint8_t>(PackedTag::TEXT);
+    storeU32(at + 1, static_cast<uint32_t>(length));
+    if (length > 0) {
+        std::memcpy(at + 5, data, length);
+    }
+}
+
+bool fitsOffset(size_t size) {
+    return size <= std::numeric_limits<uint32_t>::max();
+}
+
+uint32_t loadU32(const uint8_t* at) {
+    return static_cast<uint32_t>(at[0]) | static_cast<uint32_t>(at[1]) << 8 |
+           static_cast<uint32_t>(at[2]) << 16 | static_cast<uint32_t>(at[3]) << 24;
+}
+
+double loadF64(const uint8_t* at) {
+    uint64_t bits = 0;
+    for (int i = 7; i >= 0; i--) {
+        bits = (bits << 8) | at[i];
+    }
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Size of the cell at `at`, or 0 if it runs past `end`
+size_t cellSize(const uint8_t* at, const uint8_t* end) {
+    if (at >= end) {
+        return 0;
+    }
+    switch (static_cast<PackedTag>(*at)) {
+    case PackedTag::NULL_VALUE:
+        return 1;
+    case PackedTag::NUMBER:
+        return end - at >= 9 ? 9 : 0;
+    case PackedTag::TEXT: {
+        if (end - at < 5) {
+            return 0;
+        }
+        const size_t size = 5 + static_cast<size_t>(loadU32(at + 1));
+        return static_cast<size_t>(end - at) >= size ? size : 0;
+    }
+    }
+    return 0;
+}
+
+PackedResultSnapshot::Cell decodeCell(const uint8_t* at) {
+    PackedResultSnapshot::Cell cell;
+    cell.tag = static_cast<PackedTag>(*at);
+    if (cell.tag == PackedTag::NUMBER) {
+        cell.number = loadF64(at + 1);
+    } else if (cell.tag == PackedTag::TEXT) {
+        cell.length = loadU32(at + 1);
+        cell.text = reinterpret_cast<const char*>(at + 5);
+    }
+    return cell;
+}
+
+} // namespace
+
+bool encodePackedResult(sqlite3_stmt* stmt, std::vector<uint8_t>& out, std::string& errorMessage) {
+    out.clear();
+    out.reserve(INITIAL_CAPACITY);
+    const int columnCount = sqlite3_column_count(stmt);
+
+    putU32(out, PACKED_RESULT_MAGIC);
+    out.push_back(PACKED_RESULT_VERSION);
+    out.push_back(0);
+    putU16(out, static_cast<uint16_t>(columnCount));
+    putU32(out, 0); // row count
+    putU32(out, 0); // row offset table
+
+    for (int i = 0; i < columnCount; i++) {
+        const char* name = sqlite3_column_name(stmt, i);
+        const size_t length = name ? std::strlen(name) : 0;
+        uint8_t* at = grow(out, 4 + length);
+        storeU32(at, static_cast<uint32_t>(length));
+        if (length > 0) {
+            std::memcpy(at + 4, name, length);
+        }
+    }
+
+    std::vector<uint32_t> rowOffsets;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (!fitsOffset(out.size())) {
+            errorMessage = "Packed query result is larger than 4 GB";
+            return false;
+        }
+        rowOffsets.push_back(static_cast<uint32_t>(out.size()));
+        for (int i = 0; i < columnCount; i++) {
+            switch (sqlite3_column_type(stmt, i)) {
+            case SQLITE_INTEGER:
+                putNumber(out, static_cast<double>(sqlite3_column_int64(stmt, i)));
+                break;
+            case SQLITE_FLOAT:
+                putNumber(out, sqlite3_column_double(stmt, i));
+                break;
+            case SQLITE_TEXT: {
+                const unsigned char* text = sqlite3_column_text(stmt, i);
+                const size_t length = static_cast<size_t>(sqlite3_column_bytes(stmt, i));
+                if (!text) {
+                    out.push_back(static_cast<uint8_t>(PackedTag::NULL_VALUE));
+                    break;
+                }
+                putText(out, text, length);
+                break;
+            }
+            case SQLITE_NULL:
+                out.push_back(static_cast<uint8_t>(PackedTag::NULL_VALUE));
+                break;
+            default:
+                errorMessage = "Unable to fetch record from database - unknown column type (WatermelonDB does not support blobs or custom sqlite types";
+                return false;
+            }
+        }
+    }
+    if (rc != SQLITE_DONE) {
+        errorMessage = "Failed to get a row for query: " + std::string(sqlite3_errmsg(sqlite3_db_handle(stmt)));
+        return false;
+    }
+
+    const size_t offsetsAt = out.size();
+    if (!fitsOffset(offsetsAt + rowOffsets.size() * sizeof(uint32_t))) {
+        errorMessage = "Packed query result is larger than 4 GB";
+        return false;
+    }
+    uint8_t* at = grow(out, rowOffsets.size() * sizeof(uint32_t));
+    for (uint32_t offset : rowOffsets) {
+        storeU32(at, offset);
+        at += sizeof(uint32_t);
+    }
+    storeU32(out.data() + 8, static_cast<uint32_t>(rowOffsets.size()));
+    storeU32(out.data() + 12, static_cast<uint32_t>(offsetsAt));
+    return true;
+}
+
+std::shared_ptr<const PackedResultSnapshot> PackedResultSnapshot::fromStatement(sqlite3_stmt* stmt, std::string& errorMessage) {
+    std::vector<uint8_t> bytes;
+    if (!encodePackedResult(stmt, bytes, errorMessage)) {
+        return nullptr;
+    }
+    // Just encoded: no need to check every cell
+    return parse(std::move(bytes), false, errorMessage);
+}
+
+std::shared_ptr<const PackedResultSnapshot> PackedResultSnapshot::fromBytes(std::vector<uint8_t> bytes, std::string& errorMessage) {
+    return parse(std::move(bytes), true, errorMessage);
+}
+
+std::shared_ptr<const PackedResultSnapshot> PackedResultSnapshot::parse(std::vector<uint8_t> bytes, bool checkCells, std::string& errorMessage) {
+    const uint8_t* data = bytes.data();
+    const size_t size = bytes.size();
+    if (size < PACKED_RESULT_HEADER_SIZE || loadU32(data) != PACKED_RESULT_MAGIC) {
+        errorMessage = "Not a packed query result";
+        return nullptr;
+    }
+    if (data[4] != PACKED_RESULT_VERSION) {
+        errorMessage = "Unsupported packed query result version " + std::to_string(data[4]);
+        return nullptr;
+    }
+
+    auto snapshot = std::shared_ptr<PackedResultSnapshot>(new PackedResultSnapshot());
+    const size_t columnCount = static_cast<size_t>(data[6]) | static_cast<size_t>(data[7]) << 8;
+    const size_t rowCount = loadU32(data + 8);
+    const size_t offsetsAt = loadU32(data + 12);
+    if (offsetsAt > size || (size - offsetsAt) / 4 < rowCount) {
+        errorMessage = "Packed query result is truncated";
+        return nullptr;
+    }
+
+    size_t at = PACKED_RESULT_HEADER_SIZE;
+    snapshot->columns_.reserve(columnCount);
+    for (size_t i = 0; i < columnCount; i++) {
+        if (offsetsAt - at < 4 || offsetsAt - at - 4 < loadU32(data + at)) {
+            errorMessage = "Packed query result is truncated";
+            return nullptr;
+        }
+        const size_t length = loadU32(data + at);
+        snapshot->columns_.emplace_back(reinterpret_cast<const char*>(data + at + 4), length);
+        // Duplicate names (e.g. from a join) resolve to the last column, as in resultDictionary
+        snapshot->columnIndexes_[snapshot->columns_.back()] = static_cast<int>(i);
+        at += 4 + length;
+    }
+
+    snapshot->rowOffsets_.reserve(rowCount);
+    for (size_t row = 0; row < rowCount; row++) {
+        const size_t rowAt = loadU32(data + offsetsAt + row * 4);
+        // Every cell of the row has to fit before the offset table
+        size_t cellAt = rowAt;
+        for (size_t column = 0; checkCells && column < columnCount; column++) {
+            const size_t cell = rowAt < at ? 0 : cellSize(data + cellAt, data + offsetsAt);
+            if (cell == 0) {
+                errorMessage = "Packed query result has a malformed row";
+                return nullptr;
+            }
+            cellAt += cell;
+        }
+        snapshot->rowOffsets_.push_back(static_cast<uint32_t>(rowAt));
+    }
+
+    snapshot->bytes_ = std::move(bytes);
+    return snapshot;
+}
+
+int PackedResultSnapshot::columnIndex(const std::string& name) const {
+    auto found = columnIndexes_.find(name);
+    return found != columnIndexes_.end() ? found->second : -1;
+}
+
+PackedResultSnapshot::Cell PackedResultSnapshot::cell(size_t row, size_t column) const {
+    const uint8_t* at = bytes_.data() + rowOffsets_[row];
+    const uint8_t* end = bytes_.data() + bytes_.size();
+    for (size_t i = 0; i < column; i++) {
+        at += cellSize(at, end);
+    }
+    return decodeCell(at);
+}
+
+void PackedResultSnapshot::cells(size_t row, std::vector<Cell>& out) const {
+    const uint8_t* at = bytes_.data() + rowOffsets_[row];
+    const uint8_t* end = bytes_.data() + bytes_.size();
+    out.clear();
+    out.reserve(columns_.size());
+    for (size_t i = 0; i < columns_.size(); i++) {
+        out.push_back(decodeCell(at));
+        at += cellSize(at, end);
+    }
+}
+
+} // namespace watermelondb
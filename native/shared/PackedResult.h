@@ -0,0 +1,78 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace watermelondb {
+
+// Compact encoding of a whole query result in one buffer, for bulk reads (exports, cache warm-ups)
+// where creating a JS string or number per cell dominates. The buffer is handed to JS as an
+// ArrayBuffer without a copy and decoded on demand there (src/adapters/sqlite/packedResult).
+//
+// All integers little-endian:
+//   header   u32 magic "WMPK", u8 version, u8 reserved, u16 column count, u32 row count,
+//            u32 byte offset of the row offset table
+//   columns  per column: u32 byte length, UTF-8 name
+//   rows     per row, per column: u8 PackedTag, then an f64 for NUMBER, or a u32 byte length and
+//            the UTF-8 bytes for TEXT (nothing for NULL)
+//   offsets  per row: u32 byte offset of its first cell
+constexpr uint32_t PACKED_RESULT_MAGIC = 0x4B504D57; // "WMPK"
+constexpr uint8_t PACKED_RESULT_VERSION = 1;
+constexpr size_t PACKED_RESULT_HEADER_SIZE = 16;
+
+enum class PackedTag : uint8_t {
+    NULL_VALUE = 0,
+    // INTEGER and FLOAT alike: JS only has doubles
+    NUMBER = 1,
+    TEXT = 2,
+};
+
+// Steps `stmt` to the end and encodes its rows into `out` (replacing its contents). Fails on
+// BLOB columns, step errors, and results over 4 GB.
+bool encodePackedResult(sqlite3_stmt* stmt, std::vector<uint8_t>& out, std::string& errorMessage);
+
+// Read-only view of an encoded result that owns its bytes. Immutable once created, so rows handed
+// out to JS can share one snapshot from any thread.
+class PackedResultSnapshot {
+public:
+    struct Cell {
+        PackedTag tag = PackedTag::NULL_VALUE;
+        double number = 0;
+        // TEXT: UTF-8 bytes inside the snapshot, not NUL-terminated
+        const char* text = nullptr;
+        size_t length = 0;
+    };
+
+    // Steps `stmt` to the end; nullptr with `errorMessage` set if encoding fails
+    static std::shared_ptr<const PackedResultSnapshot> fromStatement(sqlite3_stmt* stmt, std::string& errorMessage);
+    // Validates the header, column names and row offsets of `bytes`
+    static std::shared_ptr<const PackedResultSnapshot> fromBytes(std::vector<uint8_t> bytes, std::string& errorMessage);
+
+    size_t rowCount() const { return rowOffsets_.size(); }
+    size_t columnCount() const { return columns_.size(); }
+    const std::string& columnName(size_t column) const { return columns_[column]; }
+    // Index of the column called `name`, or -1
+    int columnIndex(const std::string& name) const;
+    // `row` and `column` must be in range. Walks the row up to `column`: use cells() to read a
+    // whole row.
+    Cell cell(size_t row, size_t column) const;
+    // Every cell of `row` in column order, decoded in one pass (replaces the contents of `out`)
+    void cells(size_t row, std::vector<Cell>& out) const;
+
+    const std::vector<uint8_t>& bytes() const { return bytes_; }
+
+private:
+    std::vector<uint8_t> bytes_;
+    std::vector<std::string> columns_;
+    std::unordered_map<std::string, int> columnIndexes_;
+    std::vector<uint32_t> rowOffsets_;
+
+    static std::shared_ptr<const PackedResultSnapshot> parse(std::vector<uint8_t> bytes, bool checkCells, std::string& errorMessage);
+};
+
+} // namespace watermelondb
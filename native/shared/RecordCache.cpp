@@ -0,0 +1,66 @@
+#include "RecordCache.h"
+
+#include <functional>
+
+namespace watermelondb {
+
+RecordCache::Shard& RecordCache::shardFor(Identifier table, std::string_view id) {
+    const size_t hash = std::hash<std::string_view>()(id) ^ (static_cast<size_t>(table) * 0x9E3779B97F4A7C15ULL);
+    return shards_[hash % SHARD_COUNT];
+}
+
+const RecordCache::Shard& RecordCache::shardFor(Identifier table, std::string_view id) const {
+    return const_cast<RecordCache*>(this)->shardFor(table, id);
+}
+
+bool RecordCache::isCached(Identifier table, std::string_view id) const {
+    if (alwaysMiss_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    const Shard& shard = shardFor(table, id);
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.ids.find(table);
+    return found != shard.ids.end() && found->second.count(std::string(id)) > 0;
+}
+
+void RecordCache::markAsCached(Identifier table, std::string_view id) {
+    Shard& shard = shardFor(table, id);
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.ids[table].emplace(id);
+}
+
+bool RecordCache::checkAndMark(Identifier table, std::string_view id) {
+    Shard& shard = shardFor(table, id);
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+    const bool inserted = shard.ids[table].emplace(id).second;
+    return !inserted && !alwaysMiss_.load(std::memory_order_relaxed);
+}
+
+void RecordCache::remove(Identifier table, std::string_view id) {
+    Shard& shard = shardFor(table, id);
+    const std::lock_guard<std::mutex> lock(shard.mutex);
+    auto found = shard.ids.find(table);
+    if (found != shard.ids.end()) {
+        found->second.erase(std::string(id));
+    }
+}
+
+void RecordCache::clear() {
+    for (Shard& shard : shards_) {
+        const std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.ids.clear();
+    }
+}
+
+size_t RecordCache::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+        const std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& table : shard.ids) {
+            total += table.second.size();
+        }
+    }
+    return total;
+}
+
+} // namespace watermelondb
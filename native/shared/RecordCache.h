@@ -0,0 +1,51 @@
+#pragma once
+
+#include "IdentifierInterner.h"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace watermelondb {
+
+// Ids of the records JS already holds, per table. query() returns just the id of a cached record
+// instead of its full row. Kept natively so the JSI query path decides per row without calling
+// into the platform; the platform driver uses the same instance through a handle.
+//
+// Split into shards by (table, id) hash, each with its own lock, so concurrent queries and
+// batches rarely contend. Thread-safe.
+class RecordCache {
+public:
+    static constexpr size_t SHARD_COUNT = 16;
+
+    bool isCached(Identifier table, std::string_view id) const;
+    void markAsCached(Identifier table, std::string_view id);
+    // Marks the record as cached; returns whether JS already had it (always false while
+    // setAlwaysMiss is on). What query() needs per row, under one lock.
+    bool checkAndMark(Identifier table, std::string_view id);
+    void remove(Identifier table, std::string_view id);
+    void clear();
+    size_t size() const;
+
+    // While on, every record reads as uncached, so queries return full rows: native sync (CDC)
+    // writes records JS has not seen under ids it may have cached
+    void setAlwaysMiss(bool alwaysMiss) { alwaysMiss_.store(alwaysMiss, std::memory_order_relaxed); }
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<Identifier, std::unordered_set<std::string>> ids;
+    };
+
+    Shard shards_[SHARD_COUNT];
+    std::atomic<bool> alwaysMiss_{false};
+
+    Shard& shardFor(Identifier table, std::string_view id);
+    const Shard& shardFor(Identifier table, std::string_view id) const;
+};
+
+} // namespace watermelondb
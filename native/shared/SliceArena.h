@@ -0,0 +1,274 @@
+#pragma once
+
+#include "SliceDecoder.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace watermelondb {
+
+// Monotonic allocator for the rows of one import batch (see BatchData).
+//
+// Allocation bumps an offset in the current block; nothing is freed individually. reset() releases
+// everything at once by rewinding to the first block, and keeps the blocks, so a batch that fits
+// in what earlier batches needed allocates nothing. Not thread-safe.
+class SliceArena {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+    explicit SliceArena(size_t blockSize = DEFAULT_BLOCK_SIZE) : blockSize_(std::max<size_t>(blockSize, 64)) {}
+
+    SliceArena(const SliceArena&) = delete;
+    SliceArena& operator=(const SliceArena&) = delete;
+
+    // `alignment` must be a power of two no larger than alignof(std::max_align_t)
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+        size_t start = (offset_ + alignment - 1) & ~(alignment - 1);
+        if (blocks_.empty() || start + size > blocks_[current_].size) {
+            nextBlock(size);
+            start = 0;
+        }
+        used_ += (start - offset_) + size;
+        offset_ = start + size;
+        if (used_ > highWaterMark_) {
+            highWaterMark_ = used_;
+        }
+        return blocks_[current_].data.get() + start;
+    }
+
+    const char* copy(const void* data, size_t size) {
+        char* bytes = static_cast<char*>(allocate(size, 1));
+        if (size > 0) {
+            std::memcpy(bytes, data, size);
+        }
+        return bytes;
+    }
+
+    // Invalidates everything allocated so far. O(1); blocks are kept for reuse.
+    void reset() {
+        current_ = 0;
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    // reset(), and returns the blocks to the system
+    void release() {
+        reset();
+        blocks_.clear();
+    }
+
+    // Bytes handed out since the last reset, including alignment padding
+    size_t bytesUsed() const { return used_; }
+    // Bytes held in blocks
+    size_t bytesReserved() const {
+        size_t total = 0;
+        for (const auto& block : blocks_) {
+            total += block.size;
+        }
+        return total;
+    }
+    // Largest bytesUsed() seen since construction: what one batch needed at most
+    size_t highWaterMark() const { return highWaterMark_; }
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    size_t blockSize_;
+    std::vector<Block> blocks_;
+    size_t current_ = 0;
+    size_t offset_ = 0;
+    size_t used_ = 0;
+    size_t highWaterMark_ = 0;
+
+    // Moves on to a block with room for `size` bytes: the next kept block that is large enough, or
+    // a new one (oversized allocations get a block of their own)
+    void nextBlock(size_t size) {
+        const size_t next = blocks_.empty() ? 0 : current_ + 1;
+        size_t found = next;
+        while (found < blocks_.size() && blocks_[found].size < size) {
+            found++;
+        }
+        if (found < blocks_.size()) {
+            std::swap(blocks_[next], blocks_[found]);
+        } else {
+            const size_t blockSize = std::max(blockSize_, size);
+            blocks_.insert(blocks_.begin() + static_cast<std::ptrdiff_t>(next),
+                           Block{std::unique_ptr<char[]>(new char[blockSize]), blockSize});
+        }
+        current_ = next;
+        offset_ = 0;
+    }
+};
+
+// Rows of one table in a batch, all of the same width. Values live in SliceArena chunks rather
+// than one vector per row, so appending a row allocates nothing once the arena is warm, and the
+// whole set goes away with SliceArena::reset().
+//
+// Values are stored inline or borrowed: TEXT/BLOB bytes owned by an appended FieldValue are copied
+// into the arena, so stored values never need their destructor run. A RowSet built without an
+// arena (e.g. from nested vectors) owns a private one. Copies own their bytes.
+class RowSet {
+public:
+    class RowView {
+    public:
+        RowView(const FieldValue* values, size_t size) : values_(values), size_(size) {}
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        const FieldValue& operator[](size_t index) const { return values_[index]; }
+        const FieldValue* begin() const { return values_; }
+        const FieldValue* end() const { return values_ + size_; }
+
+    private:
+        const FieldValue* values_;
+        size_t size_;
+    };
+
+    RowSet() = default;
+    explicit RowSet(SliceArena* arena) : arena_(arena) {}
+
+    RowSet(const std::vector<std::vector<FieldValue>>& rows) {
+        for (const auto& row : rows) {
+            append(row.data(), row.size());
+        }
+    }
+    RowSet(std::initializer_list<std::vector<FieldValue>> rows) {
+        for (const auto& row : rows) {
+            append(row.data(), row.size());
+        }
+    }
+
+    RowSet(const RowSet& other) { appendAll(other); }
+    RowSet& operator=(const RowSet& other) {
+        if (this != &other) {
+            clearRows();
+            appendAll(other);
+        }
+        return *this;
+    }
+
+    RowSet(RowSet&& other) noexcept { takeFrom(other); }
+    RowSet& operator=(RowSet&& other) noexcept {
+        if (this != &other) {
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t columnCount() const { return columns_; }
+
+    RowView operator[](size_t index) const {
+        if (columns_ == 0) {
+            return RowView(nullptr, 0);
+        }
+        return RowView(chunks_[index / rowsPerChunk_] + (index % rowsPerChunk_) * columns_, columns_);
+    }
+
+    // The first row fixes the width; shorter rows are padded with NULLs, longer ones truncated
+    void append(const FieldValue* values, size_t count) { append(values, count, false); }
+    void append(const std::vector<FieldValue>& row) { append(row.data(), row.size(), false); }
+
+    // Drops the rows; a private arena is rewound and kept for reuse
+    void clear() { clearRows(); }
+
+private:
+    static constexpr size_t CHUNK_BYTES = 4096;
+    static constexpr size_t PRIVATE_ARENA_BLOCK_SIZE = 16 * 1024;
+
+    SliceArena* arena_ = nullptr;
+    std::unique_ptr<SliceArena> ownArena_;
+    std::vector<FieldValue*> chunks_;
+    size_t size_ = 0;
+    size_t columns_ = 0;
+    size_t rowsPerChunk_ = 1;
+
+    // copyBorrowed: also copy bytes the values borrow, so the rows don't depend on their source
+    void append(const FieldValue* values, size_t count, bool copyBorrowed) {
+        if (size_ == 0 && chunks_.empty()) {
+            columns_ = count;
+            rowsPerChunk_ = std::max<size_t>(1, CHUNK_BYTES / (std::max<size_t>(columns_, 1) * sizeof(FieldValue)));
+        }
+        if (columns_ == 0) {
+            size_++;
+            return;
+        }
+        const size_t slot = size_ % rowsPerChunk_;
+        if (slot == 0) {
+            chunks_.push_back(static_cast<FieldValue*>(
+                arena().allocate(rowsPerChunk_ * columns_ * sizeof(FieldValue), alignof(FieldValue))));
+        }
+        FieldValue* row = chunks_.back() + slot * columns_;
+        for (size_t i = 0; i < columns_; i++) {
+            if (i < count) {
+                new (row + i) FieldValue(storable(values[i], copyBorrowed));
+            } else {
+                new (row + i) FieldValue();
+            }
+        }
+        size_++;
+    }
+
+    SliceArena& arena() {
+        if (!arena_) {
+            ownArena_ = std::make_unique<SliceArena>(PRIVATE_ARENA_BLOCK_SIZE);
+            arena_ = ownArena_.get();
+        }
+        return *arena_;
+    }
+
+    FieldValue storable(const FieldValue& value, bool copyBorrowed) {
+        if (!value.ownsBytes() && !(copyBorrowed && value.borrowsBytes())) {
+            return value;
+        }
+        const char* bytes = arena().copy(value.data(), value.size());
+        return value.type() == FieldValue::Type::TEXT_VALUE
+            ? FieldValue::makeTextRef(bytes, value.size())
+            : FieldValue::makeBlobRef(reinterpret_cast<const uint8_t*>(bytes), value.size());
+    }
+
+    void appendAll(const RowSet& other) {
+        for (size_t i = 0; i < other.size(); i++) {
+            RowView row = other[i];
+            append(row.begin(), row.size(), true);
+        }
+    }
+
+    // Stored values are inline or borrowed, so dropping the chunks is enough
+    void clearRows() {
+        chunks_.clear();
+        size_ = 0;
+        columns_ = 0;
+        rowsPerChunk_ = 1;
+        if (ownArena_) {
+            ownArena_->reset();
+        }
+    }
+
+    void takeFrom(RowSet& other) {
+        arena_ = other.arena_;
+        ownArena_ = std::move(other.ownArena_);
+        chunks_ = std::move(other.chunks_);
+        size_ = other.size_;
+        columns_ = other.columns_;
+        rowsPerChunk_ = other.rowsPerChunk_;
+        other.arena_ = nullptr;
+        other.chunks_.clear();
+        other.size_ = 0;
+        other.columns_ = 0;
+        other.rowsPerChunk_ = 1;
+    }
+};
+
+} // namespace watermelondb
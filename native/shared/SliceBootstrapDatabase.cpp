@@ -0,0 +1,270 @@
+#include "SliceBootstrapDatabase.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace watermelondb {
+
+namespace {
+bool execSql(sqlite3* db, const char* sql, std::string& errorMessage) {
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(db, sql, nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK) {
+        errorMessage = errMsg ? errMsg : sqlite3_errmsg(db);
+        if (errMsg) {
+            sqlite3_free(errMsg);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool vacuumInto(sqlite3* db, const std::string& path, std::string& errorMessage) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "VACUUM INTO ?", -1, &stmt, nullptr) != SQLITE_OK) {
+        errorMessage = sqlite3_errmsg(db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        errorMessage = sqlite3_errmsg(db);
+        return false;
+    }
+    return true;
+}
+
+// Readers that started before the install keep the WAL frames they can see alive, so a TRUNCATE
+// checkpoint right after the backup is often busy. Give short reads a chance to finish, but don't
+// hold the writer lock for long: SQLite's auto-checkpoint reclaims the WAL once readers move on.
+constexpr int kCheckpointAttempts = 5;
+constexpr int kCheckpointRetryDelayMs = 20;
+
+void checkpointAfterInstall(sqlite3* db) {
+    int logFrames = 0;
+    int checkpointedFrames = 0;
+    int rc = SQLITE_BUSY;
+    for (int attempt = 0; attempt < kCheckpointAttempts; attempt++) {
+        if (attempt > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(kCheckpointRetryDelayMs));
+        }
+        rc = sqlite3_wal_checkpoint_v2(db, nullptr, SQLITE_CHECKPOINT_TRUNCATE, &logFrames, &checkpointedFrames);
+        if (rc != SQLITE_BUSY) {
+            break;
+        }
+    }
+    if (rc != SQLITE_OK) {
+        platform::logError("Bootstrap install: WAL checkpoint failed (" + std::string(sqlite3_errstr(rc)) +
+                           "), " + std::to_string(checkpointedFrames) + " of " + std::to_string(logFrames) +
+                           " frames checkpointed; the WAL keeps the installed pages until a later checkpoint");
+    }
+}
+} // namespace
+
+SliceBootstrapDatabase::SliceBootstrapDatabase(LiveConnectionRunner runOnLive)
+    : runOnLive_(std::move(runOnLive)) {
+}
+
+SliceBootstrapDatabase::~SliceBootstrapDatabase() {
+    if (sideDb_) {
+        rollbackTransaction();
+    }
+}
+
+bool SliceBootstrapDatabase::beginTransaction(std::string& errorMessage) {
+    if (transactionStarted_) {
+        errorMessage = "Transaction already started";
+        return false;
+    }
+
+    // Snapshot the live database (schema + whatever rows it already has) into the side file
+    bool snapshotOk = runOnLive_([this](sqlite3* live, std::string& error) {
+        const char* livePath = sqlite3_db_filename(live, "main");
+        if (!livePath || livePath[0] == '\0') {
+            error = "Bootstrap import requires a file-backed database";
+            return false;
+        }
+        sidePath_ = std::string(livePath) + "-bootstrap";
+        removeSideFiles();
+        if (!vacuumInto(live, sidePath_, error)) {
+            error = "Failed to snapshot database for bootstrap import: " + error;
+            return false;
+        }
+        liveChangesAtSnapshot_ = sqlite3_total_changes(live);
+        return true;
+    }, errorMessage);
+    if (!snapshotOk) {
+        removeSideFiles();
+        return false;
+    }
+
+    if (sqlite3_open_v2(sidePath_.c_str(), &sideDb_, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) {
+        errorMessage = sideDb_ ? sqlite3_errmsg(sideDb_) : "Failed to open bootstrap database";
+        closeSideDatabase();
+        removeSideFiles();
+        return false;
+    }
+
+    // Nobody else can see this file and it is thrown away on failure, so durability buys nothing
+    std::string ignored;
+    execSql(sideDb_, "PRAGMA journal_mode=OFF;", ignored);
+    execSql(sideDb_, "PRAGMA synchronous=OFF;", ignored);
+    execSql(sideDb_, "PRAGMA locking_mode=EXCLUSIVE;", ignored);
+    execSql(sideDb_, "PRAGMA temp_store=MEMORY;", ignored);
+    execSql(sideDb_, "PRAGMA cache_size=-20000;", ignored);
+    if (!execSql(sideDb_, "BEGIN;", errorMessage)) {
+        closeSideDatabase();
+        removeSideFiles();
+        return false;
+    }
+    transactionStarted_ = true;
+    return true;
+}
+
+bool SliceBootstrapDatabase::commitTransaction(std::string& errorMessage) {
+    if (!transactionStarted_ || !sideDb_) {
+        errorMessage = "No transaction to commit";
+        return false;
+    }
+    if (!insertHelper_.finishBulkLoad(sideDb_, errorMessage) ||
+        !execSql(sideDb_, "COMMIT;", errorMessage)) {
+        rollbackTransaction();
+        return false;
+    }
+    transactionStarted_ = false;
+    closeSideDatabase();
+
+    const int expectedChanges = liveChangesAtSnapshot_;
+    const std::string sidePath = sidePath_;
+    bool installed = runOnLive_([expectedChanges, &sidePath](sqlite3* live, std::string& error) {
+        if (sqlite3_total_changes(live) != expectedChanges) {
+            error = "Database was modified during bootstrap import";
+            return false;
+        }
+        return installBootstrapDatabase(live, sidePath, error);
+    }, errorMessage);
+    removeSideFiles();
+    return installed;
+}
+
+void SliceBootstrapDatabase::rollbackTransaction() {
+    if (sideDb_ && transactionStarted_) {
+        // With journal_mode=OFF this doesn't restore anything; the file is deleted below
+        std::string ignored;
+        execSql(sideDb_, "ROLLBACK;", ignored);
+    }
+    transactionStarted_ = false;
+    insertHelper_.discardDeferredIndexes();
+    closeSideDatabase();
+    removeSideFiles();
+}
+
+bool SliceBootstrapDatabase::insertRows(
+    const std::string& tableName,
+    const std::vector<std::string>& columns,
+    const RowSet& rows,
+    std::string& errorMessage
+) {
+    if (!sideDb_) {
+        errorMessage = "No bootstrap database";
+        return false;
+    }
+    return insertHelper_.insertRowsMulti(sideDb_, tableName, columns, rows, errorMessage);
+}
+
+bool SliceBootstrapDatabase::insertBatch(const BatchData& batch, std::string& errorMessage) {
+    if (!sideDb_) {
+        errorMessage = "No bootstrap database";
+        return false;
+    }
+    return insertHelper_.insertBatch(sideDb_, batch, errorMessage);
+}
+
+// Savepoints exist to bound rollback work on the live database; without a journal there is
+// nothing to bound, and a failed bootstrap import discards the whole file anyway.
+bool SliceBootstrapDatabase::createSavepoint(std::string& errorMessage) {
+    (void)errorMessage;
+    return true;
+}
+
+bool SliceBootstrapDatabase::releaseSavepoint(std::string& errorMessage) {
+    (void)errorMessage;
+    return true;
+}
+
+bool SliceBootstrapDatabase::beginTableLoad(const std::string& tableName, std::string& errorMessage) {
+    if (!sideDb_) {
+        errorMessage = "No bootstrap database";
+        return false;
+    }
+    return insertHelper_.deferIndexes(sideDb_, tableName, errorMessage);
+}
+
+bool SliceBootstrapDatabase::endTableLoad(const std::string& tableName, std::string& errorMessage) {
+    if (!sideDb_) {
+        errorMessage = "No bootstrap database";
+        return false;
+    }
+    return insertHelper_.restoreIndexes(sideDb_, tableName, errorMessage);
+}
+
+// The side file is a snapshot of the live schema, so it answers for the live database
+bool SliceBootstrapDatabase::getTableColumns(const std::string& tableName,
+                                             std::vector<std::string>& columns,
+                                             std::string& errorMessage) {
+    if (!sideDb_) {
+        errorMessage = "No bootstrap database";
+        return false;
+    }
+    return SqliteInsertHelper::tableColumns(sideDb_, tableName, columns, errorMessage);
+}
+
+void SliceBootstrapDatabase::closeSideDatabase() {
+    if (!sideDb_) {
+        return;
+    }
+    insertHelper_.finalizeStatements();
+    sqlite3_close(sideDb_);
+    sideDb_ = nullptr;
+}
+
+void SliceBootstrapDatabase::removeSideFiles() {
+    if (sidePath_.empty()) {
+        return;
+    }
+    std::remove(sidePath_.c_str());
+    std::remove((sidePath_ + "-journal").c_str());
+}
+
+bool installBootstrapDatabase(sqlite3* liveDb, const std::string& sidePath, std::string& errorMessage) {
+    sqlite3* sideDb = nullptr;
+    if (sqlite3_open_v2(sidePath.c_str(), &sideDb, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        errorMessage = sideDb ? sqlite3_errmsg(sideDb) : "Failed to open bootstrap database";
+        sqlite3_close(sideDb);
+        return false;
+    }
+
+    sqlite3_backup* backup = sqlite3_backup_init(liveDb, "main", sideDb, "main");
+    if (!backup) {
+        errorMessage = sqlite3_errmsg(liveDb);
+        sqlite3_close(sideDb);
+        return false;
+    }
+    // One step: the live database is replaced in a single write transaction. In WAL mode every page
+    // of the side file goes through the WAL, so it briefly holds a full copy of the database.
+    int rc = sqlite3_backup_step(backup, -1);
+    sqlite3_backup_finish(backup);
+    if (rc != SQLITE_DONE) {
+        errorMessage = std::string("Failed to install bootstrap database: ") + sqlite3_errstr(rc);
+        sqlite3_close(sideDb);
+        return false;
+    }
+    sqlite3_close(sideDb);
+
+    checkpointAfterInstall(liveDb);
+    return true;
+}
+
+} // namespace watermelondb
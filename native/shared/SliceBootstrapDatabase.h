@@ -0,0 +1,82 @@
+#pragma once
+
+#include "SliceImportEngine.h"
+#include "SqliteInsertHelper.h"
+
+#include <sqlite3.h>
+#include <functional>
+#include <string>
+
+namespace watermelondb {
+
+// Runs `work` with the live app connection while the platform adapter holds its writer lock
+// (Android work queue, iOS writer semaphore). Returns false if the connection is unavailable or
+// `work` fails.
+using LiveConnectionRunner = std::function<bool(
+    const std::function<bool(sqlite3* db, std::string& errorMessage)>& work,
+    std::string& errorMessage
+)>;
+
+// DatabaseInterface for bootstrap imports (SliceImportOptions::bootstrap).
+//
+// Instead of writing through the live connection inside one long transaction (JS reads stuck
+// behind the writer, per-row journaling), rows go into a side file next to the live database:
+// 1. beginTransaction: `VACUUM INTO <live>-bootstrap` snapshots schema and existing rows, then the
+//    side file is opened with journal_mode=OFF and synchronous=OFF.
+// 2. Rows are inserted into the side file, with secondary indexes deferred per table.
+// 3. commitTransaction: the side file is committed and copied over the live database with the
+//    SQLite backup API (one write transaction on the live connection), then deleted.
+//
+// The import itself is unjournaled, but the install is not: in WAL mode the backup writes every
+// page of the side file through the live WAL, so the WAL briefly grows to the size of the whole
+// database. The install then tries to checkpoint and truncate it; if readers hold it open, the
+// failure is logged and the WAL is reclaimed by a later checkpoint.
+//
+// If the live connection wrote anything in between (sqlite3_total_changes moved), the install is
+// refused rather than silently discarding those writes; the caller can retry a regular import.
+class SliceBootstrapDatabase final : public DatabaseInterface {
+public:
+    explicit SliceBootstrapDatabase(LiveConnectionRunner runOnLive);
+    ~SliceBootstrapDatabase() override;
+
+    bool beginTransaction(std::string& errorMessage) override;
+    bool commitTransaction(std::string& errorMessage) override;
+    void rollbackTransaction() override;
+
+    bool insertRows(
+        const std::string& tableName,
+        const std::vector<std::string>& columns,
+        const RowSet& rows,
+        std::string& errorMessage
+    ) override;
+    bool insertBatch(const BatchData& batch, std::string& errorMessage) override;
+
+    bool createSavepoint(std::string& errorMessage) override;
+    bool releaseSavepoint(std::string& errorMessage) override;
+
+    bool beginTableLoad(const std::string& tableName, std::string& errorMessage) override;
+    bool endTableLoad(const std::string& tableName, std::string& errorMessage) override;
+    bool getTableColumns(const std::string& tableName,
+                         std::vector<std::string>& columns,
+                         std::string& errorMessage) override;
+
+    const std::string& sideDatabasePath() const { return sidePath_; }
+
+private:
+    LiveConnectionRunner runOnLive_;
+    sqlite3* sideDb_ = nullptr;
+    std::string sidePath_;
+    int liveChangesAtSnapshot_ = 0;
+    bool transactionStarted_ = false;
+    SqliteInsertHelper insertHelper_;
+
+    void closeSideDatabase();
+    void removeSideFiles();
+};
+
+// Copies `sidePath` over the main database of `liveDb` with the backup API, then checkpoints and
+// truncates the WAL (retried briefly, logged if readers keep it busy; the install still succeeds).
+// The caller must hold the writer lock for `liveDb`.
+bool installBootstrapDatabase(sqlite3* liveDb, const std::string& sidePath, std::string& errorMessage);
+
+} // namespace watermelondb
@@ -0,0 +1,307 @@
+#include "SliceCache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace watermelondb {
+
+namespace {
+constexpr const char* kEntrySuffix = ".slice";
+constexpr const char* kTempPrefix = "download-";
+// Leftovers of downloads interrupted by a crash or kill
+constexpr time_t kStaleTempSeconds = 24 * 60 * 60;
+// zstd level for slices reconstructed from patches (SliceCacheWriter::appendDecompressed)
+constexpr int kRecompressionLevel = 3;
+
+uint64_t fnv1a64(const std::string& value) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : value) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool endsWith(const std::string& value, const char* suffix) {
+    size_t length = std::strlen(suffix);
+    return value.size() >= length && value.compare(value.size() - length, length, suffix) == 0;
+}
+
+struct timespec modificationTime(const struct stat& st) {
+#if defined(__APPLE__)
+    return st.st_mtimespec;
+#else
+    return st.st_mtim;
+#endif
+}
+
+bool olderThan(const struct timespec& a, const struct timespec& b) {
+    return a.tv_sec < b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_nsec < b.tv_nsec);
+}
+} // namespace
+
+SliceCacheWriter::SliceCacheWriter(FILE* file, std::string tempPath)
+    : file_(file)
+    , tempPath_(std::move(tempPath)) {
+}
+
+SliceCacheWriter::~SliceCacheWriter() {
+    discard();
+    if (cctx_) {
+        ZSTD_freeCCtx(cctx_);
+    }
+}
+
+void SliceCacheWriter::append(const uint8_t* data, size_t length) {
+    if (failed_ || !file_ || length == 0) {
+        return;
+    }
+    if (std::fwrite(data, 1, length, file_) != length) {
+        failed_ = true;
+        return;
+    }
+    bytesWritten_ += length;
+}
+
+void SliceCacheWriter::appendDecompressed(const uint8_t* data, size_t length) {
+    if (failed_ || !file_ || length == 0) {
+        return;
+    }
+    if (!cctx_) {
+        cctx_ = ZSTD_createCCtx();
+        if (!cctx_) {
+            failed_ = true;
+            return;
+        }
+        ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, kRecompressionLevel);
+        ZSTD_CCtx_setParameter(cctx_, ZSTD_c_checksumFlag, 1);
+        compressed_.resize(ZSTD_CStreamOutSize());
+    }
+    if (!compress(data, length, ZSTD_e_continue)) {
+        failed_ = true;
+    }
+}
+
+bool SliceCacheWriter::compress(const uint8_t* data, size_t length, ZSTD_EndDirective directive) {
+    ZSTD_inBuffer input = {data, length, 0};
+    for (;;) {
+        ZSTD_outBuffer output = {compressed_.data(), compressed_.size(), 0};
+        size_t remaining = ZSTD_compressStream2(cctx_, &output, &input, directive);
+        if (ZSTD_isError(remaining)) {
+            return false;
+        }
+        append(compressed_.data(), output.pos);
+        if (failed_) {
+            return false;
+        }
+        bool done = directive == ZSTD_e_end ? remaining == 0 : input.pos == input.size;
+        if (done) {
+            return true;
+        }
+    }
+}
+
+bool SliceCacheWriter::finish() {
+    if (!file_) {
+        return false;
+    }
+    if (cctx_ && !failed_ && !compress(nullptr, 0, ZSTD_e_end)) {
+        failed_ = true;
+    }
+    bool ok = std::fflush(file_) == 0 && !failed_;
+    std::fclose(file_);
+    file_ = nullptr;
+    return ok;
+}
+
+void SliceCacheWriter::discard() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    if (!tempPath_.empty()) {
+        ::unlink(tempPath_.c_str());
+        tempPath_.clear();
+    }
+}
+
+SliceCache::SliceCache(std::string directory, uint64_t maxBytes)
+    : directory_(std::move(directory))
+    , maxBytes_(maxBytes) {
+    while (directory_.size() > 1 && directory_.back() == '/') {
+        directory_.pop_back();
+    }
+}
+
+std::string SliceCache::keyForSlice(const std::string& sliceId, uint64_t version) {
+    return sliceId + "@" + std::to_string(version);
+}
+
+std::string SliceCache::pathForKey(const std::string& key) const {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(fnv1a64(key)));
+    return directory_ + "/" + name + kEntrySuffix;
+}
+
+bool SliceCache::ensureDirectory(std::string& errorMessage) {
+    if (::mkdir(directory_.c_str(), 0700) == 0 || errno == EEXIST) {
+        return true;
+    }
+    errorMessage = "Failed to create slice cache directory: " + std::string(std::strerror(errno));
+    return false;
+}
+
+std::string SliceCache::lookup(const std::string& key) {
+    if (key.empty() || directory_.empty()) {
+        return "";
+    }
+    std::string path = pathForKey(key);
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || st.st_size == 0) {
+        return "";
+    }
+    // Bump recency
+    ::utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    return path;
+}
+
+std::unique_ptr<SliceCacheWriter> SliceCache::beginWrite(std::string& errorMessage) {
+    if (directory_.empty()) {
+        errorMessage = "Slice cache directory not available";
+        return nullptr;
+    }
+    if (!ensureDirectory(errorMessage)) {
+        return nullptr;
+    }
+    std::string pattern = directory_ + "/" + kTempPrefix + "XXXXXX";
+    std::vector<char> tempPath(pattern.begin(), pattern.end());
+    tempPath.push_back('\0');
+    int fd = ::mkstemp(tempPath.data());
+    if (fd < 0) {
+        errorMessage = "Failed to create slice cache file: " + std::string(std::strerror(errno));
+        return nullptr;
+    }
+    FILE* file = ::fdopen(fd, "wb");
+    if (!file) {
+        errorMessage = "Failed to open slice cache file: " + std::string(std::strerror(errno));
+        ::close(fd);
+        ::unlink(tempPath.data());
+        return nullptr;
+    }
+    return std::unique_ptr<SliceCacheWriter>(new SliceCacheWriter(file, tempPath.data()));
+}
+
+bool SliceCache::commit(SliceCacheWriter& writer, const std::string& key, std::string& errorMessage) {
+    if (key.empty()) {
+        errorMessage = "Missing slice cache key";
+        writer.discard();
+        return false;
+    }
+    if (!writer.finish()) {
+        errorMessage = "Failed to write slice cache file";
+        writer.discard();
+        return false;
+    }
+    if (writer.bytesWritten() == 0 || writer.bytesWritten() > maxBytes_) {
+        errorMessage = "Slice does not fit in the slice cache";
+        writer.discard();
+        return false;
+    }
+    std::string path = pathForKey(key);
+    if (::rename(writer.tempPath_.c_str(), path.c_str()) != 0) {
+        errorMessage = "Failed to publish slice cache file: " + std::string(std::strerror(errno));
+        writer.discard();
+        return false;
+    }
+    writer.tempPath_.clear();
+    evictToFit(path);
+    return true;
+}
+
+void SliceCache::remove(const std::string& key) {
+    if (!key.empty() && !directory_.empty()) {
+        ::unlink(pathForKey(key).c_str());
+    }
+}
+
+uint64_t SliceCache::sizeOnDisk() const {
+    uint64_t total = 0;
+    DIR* dir = ::opendir(directory_.c_str());
+    if (!dir) {
+        return 0;
+    }
+    while (struct dirent* entry = ::readdir(dir)) {
+        std::string name = entry->d_name;
+        if (!endsWith(name, kEntrySuffix)) {
+            continue;
+        }
+        struct stat st;
+        if (::stat((directory_ + "/" + name).c_str(), &st) == 0) {
+            total += static_cast<uint64_t>(st.st_size);
+        }
+    }
+    ::closedir(dir);
+    return total;
+}
+
+void SliceCache::evictToFit(const std::string& keepPath) {
+    struct Entry {
+        std::string path;
+        uint64_t size;
+        struct timespec mtime;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    time_t now = std::time(nullptr);
+
+    DIR* dir = ::opendir(directory_.c_str());
+    if (!dir) {
+        return;
+    }
+    while (struct dirent* entry = ::readdir(dir)) {
+        std::string name = entry->d_name;
+        std::string path = directory_ + "/" + name;
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        if (name.rfind(kTempPrefix, 0) == 0) {
+            if (now - modificationTime(st).tv_sec > kStaleTempSeconds) {
+                ::unlink(path.c_str());
+            }
+            continue;
+        }
+        if (!endsWith(name, kEntrySuffix)) {
+            continue;
+        }
+        total += static_cast<uint64_t>(st.st_size);
+        if (path != keepPath) {
+            entries.push_back({path, static_cast<uint64_t>(st.st_size), modificationTime(st)});
+        }
+    }
+    ::closedir(dir);
+
+    if (total <= maxBytes_) {
+        return;
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return olderThan(a.mtime, b.mtime);
+    });
+    for (const auto& entry : entries) {
+        if (total <= maxBytes_) {
+            break;
+        }
+        if (::unlink(entry.path.c_str()) == 0) {
+            total -= entry.size;
+        }
+    }
+}
+
+} // namespace watermelondb
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include <libzstd/zstd.h>
+
+namespace watermelondb {
+
+// Streams a download into a temporary file in the cache directory. Becomes a cache entry only
+// through SliceCache::commit; otherwise the temporary file is deleted on destruction.
+class SliceCacheWriter {
+public:
+    ~SliceCacheWriter();
+
+    SliceCacheWriter(const SliceCacheWriter&) = delete;
+    SliceCacheWriter& operator=(const SliceCacheWriter&) = delete;
+
+    // A failed write only disables caching for this download, it never fails the import
+    void append(const uint8_t* data, size_t length);
+    // For downloads that aren't the slice itself (patches): compresses the reconstructed slice as
+    // it is decoded, so the cache entry is a standalone slice. Don't mix with append().
+    void appendDecompressed(const uint8_t* data, size_t length);
+    bool hasFailed() const { return failed_; }
+    uint64_t bytesWritten() const { return bytesWritten_; }
+
+private:
+    friend class SliceCache;
+    SliceCacheWriter(FILE* file, std::string tempPath);
+
+    FILE* file_;
+    std::string tempPath_;
+    uint64_t bytesWritten_ = 0;
+    bool failed_ = false;
+    ZSTD_CCtx* cctx_ = nullptr;
+    std::vector<uint8_t> compressed_;
+
+    bool compress(const uint8_t* data, size_t length, ZSTD_EndDirective directive);
+    bool finish();
+    void discard();
+};
+
+// Size-capped on-disk LRU of compressed slices (SliceImportOptions::cache).
+//
+// Entries are content-addressed: the file name is a hash of the cache key, which is either the
+// ETag the caller got for the slice or "<sliceId>@<version>" from the slice header, so the same
+// slice version always maps to the same file no matter which URL it was downloaded from.
+// Recency is the file's mtime (bumped on every hit); commit evicts least recently used entries
+// until the directory fits in maxBytes.
+class SliceCache {
+public:
+    static constexpr uint64_t DEFAULT_MAX_BYTES = 512ULL * 1024 * 1024;
+
+    SliceCache(std::string directory, uint64_t maxBytes = DEFAULT_MAX_BYTES);
+
+    // "<sliceId>@<version>"
+    static std::string keyForSlice(const std::string& sliceId, uint64_t version);
+
+    // Path of the cached slice for `key`, or empty on a miss. A hit counts as a use for LRU.
+    std::string lookup(const std::string& key);
+
+    // Starts caching a download; nullptr if the cache directory is not writable
+    std::unique_ptr<SliceCacheWriter> beginWrite(std::string& errorMessage);
+
+    // Publishes a finished download under `key` (atomic rename) and evicts down to maxBytes.
+    // Slices larger than maxBytes are not cached.
+    bool commit(SliceCacheWriter& writer, const std::string& key, std::string& errorMessage);
+
+    void remove(const std::string& key);
+
+    // Total size of committed entries
+    uint64_t sizeOnDisk() const;
+
+    const std::string& directory() const { return directory_; }
+
+private:
+    std::string directory_;
+    uint64_t maxBytes_;
+
+    std::string pathForKey(const std::string& key) const;
+    bool ensureDirectory(std::string& errorMessage);
+    void evictToFit(const std::string& keepPath);
+};
+
+} // namespace watermelondb
@@ -1,4 +1,5 @@
 #include "SliceDecoder.h"
+#include "SliceArena.h"
 #include <cstring>
 #include <algorithm>
 #ifdef SLICE_IMPORT_PROFILE_DECODER
@@ -133,6 +134,25 @@ bool SliceDecoder::initializeDecompression() {
     return true;
 }
 
+bool SliceDecoder::setPatchReference(std::vector<uint8_t> reference) {
+    if (!streamInitialized_ || !dstream_) {
+        setError("Decompression stream not initialized");
+        return false;
+    }
+    patchReference_ = std::move(reference);
+    // A patch window spans the reference and the new slice, usually beyond zstd's default limit
+    ZSTD_bounds windowBounds = ZSTD_dParam_getBounds(ZSTD_d_windowLogMax);
+    size_t result = ZSTD_DCtx_setParameter(dstream_, ZSTD_d_windowLogMax, windowBounds.upperBound);
+    if (!ZSTD_isError(result)) {
+        result = ZSTD_DCtx_refPrefix(dstream_, patchReference_.data(), patchReference_.size());
+    }
+    if (ZSTD_isError(result)) {
+        setError(std::string("Failed to set patch reference: ") + ZSTD_getErrorName(result));
+        return false;
+    }
+    return true;
+}
+
 void SliceDecoder::reset() {
     if (dstream_) {
         ZSTD_freeDStream(dstream_);
@@ -148,6 +168,9 @@ void SliceDecoder::reset() {
     expectingTableHeader_ = true;
     expectedTables_ = 0;
     tablesParsed_ = 0;
+    deltaSlice_ = false;
+    std::vector<uint8_t>().swap(patchReference_);
+    outputObserver_ = nullptr;
     errorMessage_.clear();
 #ifdef SLICE_IMPORT_PROFILE_DECODER
     resetProfile();
@@ -166,9 +189,8 @@ void SliceDecoder::compactBuffer() {
         if (decompressedBuffer_.capacity() > MAX_BUFFER_CAPACITY) {
             // Swap with empty vector to force deallocation
             std::vector<uint8_t>().swap(decompressedBuffer_);
-        } else {
-            decompressedBuffer_.clear();
         }
+        // Otherwise keep the (already zero-initialized) storage around for the next chunk
         decompressedSize_ = 0;
         currentOffset_ = 0;
         return;
@@ -183,7 +205,6 @@ void SliceDecoder::compactBuffer() {
         std::memmove(decompressedBuffer_.data(), 
                     decompressedBuffer_.data() + currentOffset_, 
                     remaining);
-        decompressedBuffer_.resize(remaining);
         decompressedSize_ = remaining;
         currentOffset_ = 0;
     }
@@ -201,12 +222,15 @@ bool SliceDecoder::feedCompressedData(const uint8_t* data, size_t size) {
 bool SliceDecoder::decompressChunk(const uint8_t* input, size_t inputSize) {
     ZSTD_inBuffer inBuffer = {input, inputSize, 0};
     
-    // Allocate output buffer
-    size_t const outputBufferSize = ZSTD_DStreamOutSize();
-    std::vector<uint8_t> outputBuffer(outputBufferSize);
+    size_t const outputChunkSize = ZSTD_DStreamOutSize();
     
     while (inBuffer.pos < inBuffer.size) {
-        ZSTD_outBuffer outBuffer = {outputBuffer.data(), outputBufferSize, 0};
+        // Decompress straight into the tail of the parse buffer (no staging buffer + memcpy).
+        // decompressedBuffer_ may be larger than decompressedSize_; the slack is reused next time.
+        if (decompressedBuffer_.size() < decompressedSize_ + outputChunkSize) {
+            decompressedBuffer_.resize(decompressedSize_ + outputChunkSize);
+        }
+        ZSTD_outBuffer outBuffer = {decompressedBuffer_.data() + decompressedSize_, outputChunkSize, 0};
         
         size_t const result = ZSTD_decompressStream(dstream_, &outBuffer, &inBuffer);
         
@@ -215,13 +239,10 @@ bool SliceDecoder::decompressChunk(const uint8_t* input, size_t inputSize) {
             return false;
         }
         
-        if (outBuffer.pos > 0) {
-            // Append decompressed data to buffer
-            size_t oldSize = decompressedBuffer_.size();
-            decompressedBuffer_.resize(oldSize + outBuffer.pos);
-            std::memcpy(decompressedBuffer_.data() + oldSize, outputBuffer.data(), outBuffer.pos);
-            decompressedSize_ = decompressedBuffer_.size();
+        if (outputObserver_ && outBuffer.pos > 0) {
+            outputObserver_(decompressedBuffer_.data() + decompressedSize_, outBuffer.pos);
         }
+        decompressedSize_ += outBuffer.pos;
         
         // Check if we've reached the end of the frame
         if (result == 0) {
@@ -326,16 +347,24 @@ ParseStatus SliceDecoder::parseSliceHeader(SliceHeader& header) {
         }
         return ParseStatus::NeedMoreData;
     }
-    header.numberOfTables = static_cast<int64_t>(numberOfTablesResult.value);
+    // Flags live above the table count (see SLICE_FLAGS_SHIFT)
+    header.flags = numberOfTablesResult.value >> SLICE_FLAGS_SHIFT;
+    header.numberOfTables = static_cast<int64_t>(numberOfTablesResult.value & ((1ULL << SLICE_FLAGS_SHIFT) - 1));
     offset += numberOfTablesResult.bytesRead;
     
+    if ((header.flags & ~SLICE_KNOWN_FLAGS) != 0) {
+        setError("Unsupported slice flags");
+        return ParseStatus::Error;
+    }
+    
     // Validate and store expected table count
     // Note: Some slice files may have numberOfTables=0 and write tables until EOF
     // We'll handle this by not enforcing table count if it's 0
-    if (header.numberOfTables < 0 || header.numberOfTables > 10000) {
+    if (header.numberOfTables < 0 || header.numberOfTables > MAX_TABLES) {
         setError("Invalid numberOfTables: out of reasonable range");
         return ParseStatus::Error;
     }
+    deltaSlice_ = (header.flags & SLICE_FLAG_DELTA) != 0;
     
     currentOffset_ = offset;
     headerParsed_ = true;
@@ -361,18 +390,6 @@ ParseStatus SliceDecoder::parseTableHeader(TableHeader& header) {
         return ParseStatus::NeedMoreData;
     }
     
-    // Check if we've exceeded expected table count
-    // Note: If expectedTables_ is 0, we read until EndOfStream (legacy format)
-    if (expectedTables_ > 0 && tablesParsed_ >= expectedTables_) {
-        // If we've parsed all expected tables, this is end of stream
-        if (tablesParsed_ == expectedTables_) {
-            return ParseStatus::EndOfStream;
-        }
-        // More tables than expected - error
-        setError("More tables in stream than declared in header");
-        return ParseStatus::Error;
-    }
-    
     // Check for delimiter if we're not expecting a table header
     if (!expectingTableHeader_) {
         if (decompressedBuffer_[currentOffset_] != END_OF_TABLE_DELIMITER) {
@@ -414,6 +431,18 @@ ParseStatus SliceDecoder::parseTableHeader(TableHeader& header) {
         }
     }
     
+    // Check if we've exceeded expected table count (after consuming the last table's delimiter)
+    // Note: If expectedTables_ is 0, we read until EndOfStream (legacy format)
+    if (expectedTables_ > 0 && tablesParsed_ >= expectedTables_) {
+        // If we've parsed all expected tables, this is end of stream
+        if (tablesParsed_ == expectedTables_) {
+            return ParseStatus::EndOfStream;
+        }
+        // More tables than expected - error
+        setError("More tables in stream than declared in header");
+        return ParseStatus::Error;
+    }
+    
     size_t offset = currentOffset_;
     
     // Decode table name (string)
@@ -489,6 +518,13 @@ ParseStatus SliceDecoder::parseTableHeader(TableHeader& header) {
         offset += columnResult.bytesRead;
     }
     
+    header.tableId = internIdentifier(header.tableName);
+    header.columnIds.clear();
+    header.columnIds.reserve(columnCount);
+    for (const auto& column : header.columns) {
+        header.columnIds.push_back(internIdentifier(column));
+    }
+    
     currentOffset_ = offset;
     expectingTableHeader_ = false;
     tablesParsed_++;
@@ -496,24 +532,31 @@ ParseStatus SliceDecoder::parseTableHeader(TableHeader& header) {
     return ParseStatus::Ok;
 }
 
-ParseStatus SliceDecoder::parseRow(const std::vector<std::string>& columns, Row& row) {
+ParseStatus SliceDecoder::parseRow(const TableHeader& table, Row& row) {
     row.clear();
     std::vector<FieldValue> rowValues;
-    rowValues.reserve(columns.size());
+    rowValues.reserve(table.columns.size());
     
-    ParseStatus status = parseRowValues(columns, rowValues);
+    ParseStatus status = parseRowValues(table.columns, rowValues);
     if (status != ParseStatus::Ok) {
         return status;
     }
     
-    for (size_t i = 0; i < columns.size(); i++) {
-        row[columns[i]] = std::move(rowValues[i]);
+    for (size_t i = 0; i < table.columnIds.size(); i++) {
+        row[table.columnIds[i]] = std::move(rowValues[i]);
     }
     
     return ParseStatus::Ok;
 }
 
 ParseStatus SliceDecoder::parseRowValues(const std::vector<std::string>& columns, std::vector<FieldValue>& rowValues) {
+    static const std::vector<bool> keepAll;
+    return parseRowValues(columns, keepAll, rowValues);
+}
+
+ParseStatus SliceDecoder::parseRowValues(const std::vector<std::string>& columns,
+                                         const std::vector<bool>& keep,
+                                         std::vector<FieldValue>& rowValues) {
     size_t available = decompressedSize_ - currentOffset_;
     
     if (available == 0) {
@@ -530,9 +573,75 @@ ParseStatus SliceDecoder::parseRowValues(const std::vector<std::string>& columns
         return ParseStatus::EndOfTable;
     }
     
+    size_t offset = currentOffset_;
+    ParseStatus status = parseFields(columns, keep, offset, rowValues);
+    if (status != ParseStatus::Ok) {
+        return status;
+    }
+    
+    currentOffset_ = offset;
+#ifdef SLICE_IMPORT_PROFILE_DECODER
+    profile_.rows++;
+    profile_.fields += columns.size();
+#endif
+    return ParseStatus::Ok;
+}
+
+ParseStatus SliceDecoder::parseDeltaRow(const std::vector<std::string>& columns,
+                                        const std::vector<bool>& keep,
+                                        DeltaOp& op,
+                                        std::vector<FieldValue>& rowValues) {
+    static const std::vector<std::string> kIdColumn = {"id"};
+    static const std::vector<bool> kKeepAll;
+    static const std::vector<bool> kSkipId = {false};
+    
+    size_t available = decompressedSize_ - currentOffset_;
+    
+    if (available == 0) {
+        if (streamEnded_) {
+            setError("Unexpected end of stream while parsing row");
+            return ParseStatus::Error;
+        }
+        return ParseStatus::NeedMoreData;
+    }
+    
+    uint8_t opByte = decompressedBuffer_[currentOffset_];
+    if (opByte == END_OF_TABLE_DELIMITER) {
+        expectingTableHeader_ = true;
+        return ParseStatus::EndOfTable;
+    }
+    
+    size_t offset = currentOffset_ + 1;
+    ParseStatus status;
+    if (opByte == static_cast<uint8_t>(DeltaOp::UPSERT)) {
+        status = parseFields(columns, keep, offset, rowValues);
+    } else if (opByte == static_cast<uint8_t>(DeltaOp::DELETE)) {
+        // A mask that keeps nothing is a skipped table: step over the id as well
+        const bool skipRow = !keep.empty() && std::find(keep.begin(), keep.end(), true) == keep.end();
+        status = parseFields(kIdColumn, skipRow ? kSkipId : kKeepAll, offset, rowValues);
+    } else {
+        setError("Unknown delta row op");
+        return ParseStatus::Error;
+    }
+    if (status != ParseStatus::Ok) {
+        return status;
+    }
+    
+    op = static_cast<DeltaOp>(opByte);
+    currentOffset_ = offset;
+#ifdef SLICE_IMPORT_PROFILE_DECODER
+    profile_.rows++;
+    profile_.fields += rowValues.size();
+#endif
+    return ParseStatus::Ok;
+}
+
+ParseStatus SliceDecoder::parseFields(const std::vector<std::string>& columns,
+                                      const std::vector<bool>& keep,
+                                      size_t& offset,
+                                      std::vector<FieldValue>& rowValues) {
     rowValues.clear();
     rowValues.reserve(columns.size());
-    size_t offset = currentOffset_;
     
     for (size_t i = 0; i < columns.size(); i++) {
         // Decode field size (varint)
@@ -557,8 +666,21 @@ ParseStatus SliceDecoder::parseRowValues(const std::vector<std::string>& columns
             return ParseStatus::Error;
         }
         
+        if (!keep.empty() && !keep[i]) {
+            // Projected away: the size prefix is enough to step over value + type tag
+            if (decompressedSize_ < offset + fieldSize + 1) {
+                if (streamEnded_) {
+                    setError("Truncated field: missing value or type tag");
+                    return ParseStatus::Error;
+                }
+                return ParseStatus::NeedMoreData;
+            }
+            offset += fieldSize + 1;
+            continue;
+        }
+        
         if (fieldSize == 0) {
-            // NULL field: need type tag byte
+            // NULL or empty field: need type tag byte
             if (offset >= decompressedSize_) {
                 if (streamEnded_) {
                     setError("Truncated NULL field: missing type tag");
@@ -567,8 +689,15 @@ ParseStatus SliceDecoder::parseRowValues(const std::vector<std::string>& columns
                 return ParseStatus::NeedMoreData;
             }
             
-            // Skip type tag (don't validate - NULL regardless of tag value)
-            rowValues.push_back(FieldValue::makeNull());
+            // Only the empty tags are checked - NULL for any other tag value
+            const TypeTag emptyTag = static_cast<TypeTag>(decompressedBuffer_[offset]);
+            if (emptyTag == TypeTag::EMPTY_TEXT) {
+                rowValues.push_back(FieldValue::makeText("", 0));
+            } else if (emptyTag == TypeTag::EMPTY_BLOB) {
+                rowValues.push_back(FieldValue::makeBlob(nullptr, 0));
+            } else {
+                rowValues.push_back(FieldValue::makeNull());
+            }
             offset++; // Skip type tag
             continue;
         }
@@ -632,7 +761,12 @@ ParseStatus SliceDecoder::parseRowValues(const std::vector<std::string>& columns
 #ifdef SLICE_IMPORT_PROFILE_DECODER
                 auto copyStart = std::chrono::steady_clock::now();
 #endif
-                std::string text(reinterpret_cast<const char*>(decompressedBuffer_.data() + offset), fieldSize);
+                const char* text = reinterpret_cast<const char*>(decompressedBuffer_.data() + offset);
+                if (valueArena_ && fieldSize > FieldValue::INLINE_CAPACITY) {
+                    rowValues.push_back(FieldValue::makeTextRef(valueArena_->copy(text, fieldSize), fieldSize));
+                } else {
+                    rowValues.push_back(FieldValue::makeText(text, fieldSize));
+                }
 #ifdef SLICE_IMPORT_PROFILE_DECODER
                 auto copyEnd = std::chrono::steady_clock::now();
                 profile_.textCopyNs += static_cast<uint64_t>(
@@ -641,7 +775,6 @@ ParseStatus SliceDecoder::parseRowValues(const std::vector<std::string>& columns
                 profile_.textCount++;
                 profile_.textBytes += fieldSize;
 #endif
-                rowValues.push_back(FieldValue::makeText(text));
                 break;
             }
                 
@@ -649,8 +782,13 @@ ParseStatus SliceDecoder::parseRowValues(const std::vector<std::string>& columns
 #ifdef SLICE_IMPORT_PROFILE_DECODER
                 auto copyStart = std::chrono::steady_clock::now();
 #endif
-                std::vector<uint8_t> blob(decompressedBuffer_.begin() + offset,
-                                         decompressedBuffer_.begin() + offset + fieldSize);
+                const uint8_t* blob = decompressedBuffer_.data() + offset;
+                if (valueArena_ && fieldSize > FieldValue::INLINE_CAPACITY) {
+                    rowValues.push_back(FieldValue::makeBlobRef(
+                        reinterpret_cast<const uint8_t*>(valueArena_->copy(blob, fieldSize)), fieldSize));
+                } else {
+                    rowValues.push_back(FieldValue::makeBlob(blob, fieldSize));
+                }
 #ifdef SLICE_IMPORT_PROFILE_DECODER
                 auto copyEnd = std::chrono::steady_clock::now();
                 profile_.blobCopyNs += static_cast<uint64_t>(
@@ -659,7 +797,6 @@ ParseStatus SliceDecoder::parseRowValues(const std::vector<std::string>& columns
                 profile_.blobCount++;
                 profile_.blobBytes += fieldSize;
 #endif
-                rowValues.push_back(FieldValue::makeBlob(blob));
                 break;
             }
                 
@@ -671,11 +808,6 @@ ParseStatus SliceDecoder::parseRowValues(const std::vector<std::string>& columns
         offset += fieldSize + 1; // Skip value + type tag
     }
     
-    currentOffset_ = offset;
-#ifdef SLICE_IMPORT_PROFILE_DECODER
-    profile_.rows++;
-    profile_.fields += columns.size();
-#endif
     return ParseStatus::Ok;
 }
 
@@ -683,4 +815,42 @@ void SliceDecoder::setError(const std::string& error) {
     errorMessage_ = error;
 }
 
+bool decompressSlice(const uint8_t* data, size_t size, std::vector<uint8_t>& out, std::string& errorMessage) {
+    out.clear();
+    ZSTD_DStream* dstream = ZSTD_createDStream();
+    if (!dstream) {
+        errorMessage = "Failed to create ZSTD decompression stream";
+        return false;
+    }
+    unsigned long long contentSize = ZSTD_getFrameContentSize(data, size);
+    if (contentSize != ZSTD_CONTENTSIZE_UNKNOWN && contentSize != ZSTD_CONTENTSIZE_ERROR) {
+        out.reserve(static_cast<size_t>(contentSize));
+    }
+    
+    ZSTD_inBuffer input = {data, size, 0};
+    size_t const chunkSize = ZSTD_DStreamOutSize();
+    size_t result = 1;
+    bool outputFull = false;
+    // A full output buffer may leave decompressed bytes inside zstd even once the input is consumed
+    while (input.pos < input.size || outputFull) {
+        size_t used = out.size();
+        out.resize(used + chunkSize);
+        ZSTD_outBuffer output = {out.data() + used, chunkSize, 0};
+        result = ZSTD_decompressStream(dstream, &output, &input);
+        out.resize(used + output.pos);
+        outputFull = output.pos == chunkSize;
+        if (ZSTD_isError(result)) {
+            errorMessage = std::string("Decompression error: ") + ZSTD_getErrorName(result);
+            ZSTD_freeDStream(dstream);
+            return false;
+        }
+    }
+    ZSTD_freeDStream(dstream);
+    if (result != 0) {
+        errorMessage = "Truncated slice: zstd frame not finished";
+        return false;
+    }
+    return true;
+}
+
 } // namespace watermelondb
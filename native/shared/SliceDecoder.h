@@ -1,12 +1,17 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
+#include <unordered_map>
 #include <memory>
 #include <libzstd/zstd.h>
 
+#include "IdentifierInterner.h"
+
 namespace watermelondb {
 
 // Parse status for streaming operations
@@ -24,12 +29,33 @@ enum class TypeTag : uint8_t {
     INT = 0x01,
     REAL = 0x02,
     TEXT = 0x03,
-    BLOB = 0x04
+    BLOB = 0x04,
+    // A zero size prefix reads as NULL whatever the tag, so empty values get tags of their own.
+    // Decoders that predate them read an empty value as NULL.
+    EMPTY_TEXT = 0x05,
+    EMPTY_BLOB = 0x06
 };
 
 // End-of-table delimiter
 constexpr uint8_t END_OF_TABLE_DELIMITER = 0xFF;
 
+// Slice flags share the numberOfTables varint: (flags << SLICE_FLAGS_SHIFT) | numberOfTables.
+// Plain slices keep flags = 0, so their encoding is unchanged; decoders that predate a flag reject
+// the slice as having too many tables instead of misreading it.
+constexpr uint32_t SLICE_FLAGS_SHIFT = 16;
+constexpr int64_t MAX_TABLES = 10000;
+
+// Delta slice: every row starts with a DeltaOp byte and is applied as an upsert or delete on top
+// of existing data, instead of filling an empty database
+constexpr uint64_t SLICE_FLAG_DELTA = 0x1;
+constexpr uint64_t SLICE_KNOWN_FLAGS = SLICE_FLAG_DELTA;
+
+// Row ops of delta slices
+enum class DeltaOp : uint8_t {
+    UPSERT = 0x01, // followed by one field per column
+    DELETE = 0x02  // followed by a single field: the record id
+};
+
 // Memory management constants
 constexpr size_t COMPACTION_THRESHOLD = 2 * 1024 * 1024; // 2MB - compact when offset exceeds this
 constexpr size_t MAX_BUFFER_CAPACITY = 16 * 1024 * 1024; // 16MB - shrink if capacity exceeds this when empty
@@ -45,6 +71,7 @@ struct SliceHeader;
 struct TableHeader;
 class VarintDecoder;
 class SliceDecoder;
+class SliceArena;
 
 // Slice header structure
 struct SliceHeader {
@@ -53,71 +80,261 @@ struct SliceHeader {
     std::string priority;
     int64_t timestamp;
     int64_t numberOfTables;
+    uint64_t flags = 0;
+    
+    bool isDelta() const { return (flags & SLICE_FLAG_DELTA) != 0; }
 };
 
 // Table header structure
 struct TableHeader {
     std::string tableName;
     std::vector<std::string> columns;
+    // Interned tableName and columns (see IdentifierInterner)
+    Identifier tableId = 0;
+    std::vector<Identifier> columnIds;
+};
+
+// Bytes of a BLOB field (see FieldValue::visit)
+struct FieldBlob {
+    const uint8_t* data;
+    size_t size;
+};
+
+// Builds a visitor out of lambdas, one per alternative: value.visit(Overloaded{...})
+template <typename... Ts>
+struct Overloaded : Ts... {
+    using Ts::operator()...;
 };
+template <typename... Ts>
+Overloaded(Ts...) -> Overloaded<Ts...>;
 
-// Field value variant
-struct FieldValue {
-    enum class Type {
+// Field value: a 16-byte tagged value, so rows of NULLs and numbers cost no allocations.
+//
+// TEXT and BLOB values of up to INLINE_CAPACITY bytes are stored in place. Longer ones are a
+// pointer plus a 32-bit length: an owned heap copy (makeText/makeBlob), or borrowed memory that the
+// caller keeps alive for the value's lifetime (makeTextRef/makeBlobRef, e.g. a batch arena).
+// Text is not NUL-terminated; use text() or data() + size().
+class FieldValue {
+public:
+    enum class Type : uint8_t {
         NULL_VALUE,
         INT_VALUE,
         REAL_VALUE,
         TEXT_VALUE,
         BLOB_VALUE
     };
-    
-    Type type;
-    union {
-        int64_t intValue;
-        double realValue;
-    };
-    std::string textValue;
-    std::vector<uint8_t> blobValue;
-    
-    FieldValue() : type(Type::NULL_VALUE), intValue(0) {}
-    
-    static FieldValue makeNull() {
-        FieldValue val;
-        val.type = Type::NULL_VALUE;
-        return val;
+
+    static constexpr size_t INLINE_CAPACITY = 14;
+
+    FieldValue() noexcept : inlineSize_(0), tag_(0) {}
+    ~FieldValue() { release(); }
+
+    FieldValue(const FieldValue& other) : inlineSize_(0), tag_(0) { copyFrom(other); }
+    FieldValue(FieldValue&& other) noexcept : inlineSize_(0), tag_(0) { takeFrom(other); }
+
+    FieldValue& operator=(const FieldValue& other) {
+        if (this != &other) {
+            release();
+            copyFrom(other);
+        }
+        return *this;
     }
-    
+
+    FieldValue& operator=(FieldValue&& other) noexcept {
+        if (this != &other) {
+            release();
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    static FieldValue makeNull() { return FieldValue(); }
+
     static FieldValue makeInt(int64_t value) {
         FieldValue val;
-        val.type = Type::INT_VALUE;
-        val.intValue = value;
+        val.tag_ = static_cast<uint8_t>(Type::INT_VALUE);
+        std::memcpy(val.storage_, &value, sizeof(value));
         return val;
     }
-    
+
     static FieldValue makeReal(double value) {
         FieldValue val;
-        val.type = Type::REAL_VALUE;
-        val.realValue = value;
+        val.tag_ = static_cast<uint8_t>(Type::REAL_VALUE);
+        std::memcpy(val.storage_, &value, sizeof(value));
         return val;
     }
-    
+
+    static FieldValue makeText(const char* data, size_t size) {
+        return makeBytes(Type::TEXT_VALUE, data, size);
+    }
+    static FieldValue makeText(std::string_view value) {
+        return makeBytes(Type::TEXT_VALUE, value.data(), value.size());
+    }
     static FieldValue makeText(const std::string& value) {
+        return makeBytes(Type::TEXT_VALUE, value.data(), value.size());
+    }
+    static FieldValue makeText(const char* value) {
+        return makeText(std::string_view(value));
+    }
+
+    static FieldValue makeBlob(const uint8_t* data, size_t size) {
+        return makeBytes(Type::BLOB_VALUE, reinterpret_cast<const char*>(data), size);
+    }
+    static FieldValue makeBlob(const std::vector<uint8_t>& value) {
+        return makeBlob(value.data(), value.size());
+    }
+
+    // No copy beyond the inline case: `data` must outlive the value (and its copies)
+    static FieldValue makeTextRef(const char* data, size_t size) {
+        return makeBorrowed(Type::TEXT_VALUE, data, size);
+    }
+    static FieldValue makeBlobRef(const uint8_t* data, size_t size) {
+        return makeBorrowed(Type::BLOB_VALUE, reinterpret_cast<const char*>(data), size);
+    }
+
+    Type type() const { return static_cast<Type>(tag_ & TYPE_MASK); }
+    bool isNull() const { return type() == Type::NULL_VALUE; }
+
+    int64_t intValue() const {
+        int64_t value;
+        std::memcpy(&value, storage_, sizeof(value));
+        return value;
+    }
+
+    double realValue() const {
+        double value;
+        std::memcpy(&value, storage_, sizeof(value));
+        return value;
+    }
+
+    // TEXT and BLOB bytes (empty for other types)
+    const char* data() const {
+        if (storage() == Storage::Inline) {
+            return storage_;
+        }
+        const char* pointer;
+        std::memcpy(&pointer, storage_, sizeof(pointer));
+        return pointer;
+    }
+
+    size_t size() const {
+        if (storage() == Storage::Inline) {
+            return inlineSize_;
+        }
+        uint32_t size;
+        std::memcpy(&size, storage_ + sizeof(const char*), sizeof(size));
+        return size;
+    }
+
+    // Out-of-line TEXT/BLOB bytes: an owned heap copy, or borrowed memory
+    bool ownsBytes() const { return storage() == Storage::Heap; }
+    bool borrowsBytes() const { return storage() == Storage::Borrowed; }
+
+    std::string_view text() const { return std::string_view(data(), size()); }
+    const uint8_t* blobData() const { return reinterpret_cast<const uint8_t*>(data()); }
+
+    // Calls `visitor` with the value as nullptr_t, int64_t, double, std::string_view (TEXT) or
+    // FieldBlob (BLOB); every overload must return the same type
+    template <typename Visitor>
+    decltype(auto) visit(Visitor&& visitor) const {
+        switch (type()) {
+            case Type::INT_VALUE:
+                return visitor(intValue());
+            case Type::REAL_VALUE:
+                return visitor(realValue());
+            case Type::TEXT_VALUE:
+                return visitor(text());
+            case Type::BLOB_VALUE:
+                return visitor(FieldBlob{blobData(), size()});
+            case Type::NULL_VALUE:
+                break;
+        }
+        return visitor(nullptr);
+    }
+
+private:
+    enum class Storage : uint8_t {
+        Inline = 0x00,
+        Heap = 0x10,
+        Borrowed = 0x20
+    };
+    static constexpr uint8_t TYPE_MASK = 0x0F;
+    static constexpr uint8_t STORAGE_MASK = 0xF0;
+
+    // Numbers use the first 8 bytes; out-of-line bytes are a pointer followed by a uint32_t size
+    alignas(8) char storage_[INLINE_CAPACITY];
+    uint8_t inlineSize_;
+    // Type in the low nibble, Storage in the high nibble
+    uint8_t tag_;
+
+    Storage storage() const { return static_cast<Storage>(tag_ & STORAGE_MASK); }
+
+    void setPointer(Type type, Storage storage, const char* data, size_t size) {
+        const uint32_t size32 = static_cast<uint32_t>(size);
+        std::memcpy(storage_, &data, sizeof(data));
+        std::memcpy(storage_ + sizeof(data), &size32, sizeof(size32));
+        tag_ = static_cast<uint8_t>(type) | static_cast<uint8_t>(storage);
+    }
+
+    static FieldValue makeBytes(Type type, const char* data, size_t size) {
         FieldValue val;
-        val.type = Type::TEXT_VALUE;
-        val.textValue = value;
+        if (size <= INLINE_CAPACITY) {
+            if (size > 0) {
+                std::memcpy(val.storage_, data, size);
+            }
+            val.inlineSize_ = static_cast<uint8_t>(size);
+            val.tag_ = static_cast<uint8_t>(type);
+            return val;
+        }
+        char* copy = new char[size];
+        std::memcpy(copy, data, size);
+        val.setPointer(type, Storage::Heap, copy, size);
         return val;
     }
-    
-    static FieldValue makeBlob(const std::vector<uint8_t>& value) {
+
+    static FieldValue makeBorrowed(Type type, const char* data, size_t size) {
+        if (size <= INLINE_CAPACITY) {
+            return makeBytes(type, data, size);
+        }
         FieldValue val;
-        val.type = Type::BLOB_VALUE;
-        val.blobValue = value;
+        val.setPointer(type, Storage::Borrowed, data, size);
         return val;
     }
+
+    void release() {
+        if (storage() == Storage::Heap) {
+            delete[] data();
+        }
+        tag_ = 0;
+        inlineSize_ = 0;
+    }
+
+    void copyFrom(const FieldValue& other) {
+        if (other.storage() == Storage::Heap) {
+            *this = makeBytes(other.type(), other.data(), other.size());
+            return;
+        }
+        std::memcpy(storage_, other.storage_, sizeof(storage_));
+        inlineSize_ = other.inlineSize_;
+        tag_ = other.tag_;
+    }
+
+    void takeFrom(FieldValue& other) {
+        std::memcpy(storage_, other.storage_, sizeof(storage_));
+        inlineSize_ = other.inlineSize_;
+        tag_ = other.tag_;
+        other.tag_ = 0;
+        other.inlineSize_ = 0;
+    }
 };
 
-// Row data structure
-using Row = std::map<std::string, FieldValue>;
+static_assert(sizeof(FieldValue) == 16, "FieldValue should stay 16 bytes");
+
+// Row data structure: column id -> value
+using Row = std::unordered_map<Identifier, FieldValue>;
+
+// Decompresses a whole zstd-compressed slice (e.g. a cached one, as a patch reference) into `out`
+bool decompressSlice(const uint8_t* data, size_t size, std::vector<uint8_t>& out, std::string& errorMessage);
 
 // Varint decoder utility
 class VarintDecoder {
@@ -154,6 +371,21 @@ public:
     // Initialize decompression stream for a new file
     bool initializeDecompression();
     
+    // Patch decoding (zstd --patch-from): the stream is a zstd frame compressed with `reference`,
+    // the decompressed bytes of an earlier version of the slice, as prefix. The decoder keeps the
+    // reference alive for the whole stream. Call after initializeDecompression, before any data.
+    bool setPatchReference(std::vector<uint8_t> reference);
+    
+    // Called with every run of decompressed bytes, before they are parsed (e.g. to re-cache a
+    // slice reconstructed from a patch)
+    using OutputObserver = std::function<void(const uint8_t* data, size_t length)>;
+    void setOutputObserver(OutputObserver observer) { outputObserver_ = std::move(observer); }
+    
+    // TEXT/BLOB values too long to store inline are copied into `arena` and borrowed from there,
+    // instead of each getting a heap copy. The arena must outlive the parsed values; nullptr
+    // (default) goes back to heap copies.
+    void setValueArena(SliceArena* arena) { valueArena_ = arena; }
+    
     // Reset decoder for a new file
     void reset();
     
@@ -167,8 +399,23 @@ public:
     ParseStatus parseTableHeader(TableHeader& header);
     
     // Parse next row
-    ParseStatus parseRow(const std::vector<std::string>& columns, Row& row);
+    ParseStatus parseRow(const TableHeader& table, Row& row);
     ParseStatus parseRowValues(const std::vector<std::string>& columns, std::vector<FieldValue>& rowValues);
+    // Projected variant: only fields with keep[i] set are materialized into rowValues; the others
+    // are stepped over using their size prefix (no copy, no type check). Empty keep = all fields.
+    ParseStatus parseRowValues(const std::vector<std::string>& columns,
+                               const std::vector<bool>& keep,
+                               std::vector<FieldValue>& rowValues);
+    // Delta slices: parses the op byte and the row that follows it. For DeltaOp::DELETE rowValues
+    // holds just the id (empty if keep is all false); for DeltaOp::UPSERT it's the same as
+    // parseRowValues.
+    ParseStatus parseDeltaRow(const std::vector<std::string>& columns,
+                              const std::vector<bool>& keep,
+                              DeltaOp& op,
+                              std::vector<FieldValue>& rowValues);
+    
+    // Whether the parsed slice header has SLICE_FLAG_DELTA set
+    bool isDeltaSlice() const { return deltaSlice_; }
     
     // Check if end of stream
     bool isEndOfStream() const { return streamEnded_; }
@@ -210,7 +457,8 @@ private:
     bool streamInitialized_;
     bool streamEnded_;
     
-    // Decompressed data buffer
+    // Decompressed data buffer. Only the first decompressedSize_ bytes are valid; the rest is
+    // preallocated space that zstd decompresses into.
     std::vector<uint8_t> decompressedBuffer_;
     size_t decompressedSize_;
     size_t currentOffset_;
@@ -220,6 +468,12 @@ private:
     bool expectingTableHeader_;
     int64_t expectedTables_;
     int64_t tablesParsed_;
+    bool deltaSlice_ = false;
+    
+    // Patch reference (setPatchReference); zstd reads it in place
+    std::vector<uint8_t> patchReference_;
+    OutputObserver outputObserver_;
+    SliceArena* valueArena_ = nullptr;
     
     // Error tracking
     std::string errorMessage_;
@@ -231,6 +485,11 @@ private:
     // Internal helpers
     bool decompressChunk(const uint8_t* input, size_t inputSize);
     void setError(const std::string& error);
+    // Parses one field per column starting at `offset`, advancing it; currentOffset_ is untouched
+    ParseStatus parseFields(const std::vector<std::string>& columns,
+                            const std::vector<bool>& keep,
+                            size_t& offset,
+                            std::vector<FieldValue>& rowValues);
 };
 
 } // namespace watermelondb
@@ -0,0 +1,748 @@
+#include "SliceEncoder.h"
+#include "SqliteInsertHelper.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+
+#if __has_include(<simdjson.h>)
+#include <simdjson.h>
+#elif __has_include("simdjson.h")
+#include "simdjson.h"
+#else
+#error "simdjson headers not found. Please add @nozbe/simdjson or provide simdjson headers."
+#endif
+
+namespace watermelondb {
+
+namespace {
+// Raw bytes buffered before handing them to zstd
+constexpr size_t kPendingFlushBytes = 128 * 1024;
+
+std::string quoteIdentifier(const std::string& name) {
+    std::string out = "\"";
+    for (char c : name) {
+        if (c == '"') {
+            out += "\"\"";
+        } else {
+            out += c;
+        }
+    }
+    out += "\"";
+    return out;
+}
+
+bool isBookkeepingColumn(const std::string& column) {
+    return column == "_status" || column == "_changed";
+}
+
+struct StatementDeleter {
+    void operator()(sqlite3_stmt* stmt) const { sqlite3_finalize(stmt); }
+};
+using StatementPtr = std::unique_ptr<sqlite3_stmt, StatementDeleter>;
+
+bool prepare(sqlite3* db, const std::string& sql, StatementPtr& stmt, std::string& errorMessage) {
+    sqlite3_stmt* raw = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &raw, nullptr) != SQLITE_OK) {
+        errorMessage = "Failed to prepare export query: " + std::string(sqlite3_errmsg(db));
+        sqlite3_finalize(raw);
+        return false;
+    }
+    stmt.reset(raw);
+    return true;
+}
+
+bool listSyncedTables(sqlite3* db, std::vector<std::string>& tables, std::string& errorMessage) {
+    StatementPtr stmt;
+    if (!prepare(db,
+                 "SELECT m.name FROM sqlite_master m "
+                 "WHERE m.type = 'table' AND m.name NOT LIKE 'sqlite_%' "
+                 "AND EXISTS (SELECT 1 FROM pragma_table_info(m.name) WHERE name = '_status') "
+                 "ORDER BY m.rowid",
+                 stmt, errorMessage)) {
+        return false;
+    }
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+        tables.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 0)));
+    }
+    if (rc != SQLITE_DONE) {
+        errorMessage = "Failed to list tables: " + std::string(sqlite3_errmsg(db));
+        return false;
+    }
+    return true;
+}
+
+bool exportTable(sqlite3* db, SliceEncoder& encoder, const std::string& tableName, std::string& errorMessage) {
+    std::vector<std::string> localColumns;
+    if (!SqliteInsertHelper::tableColumns(db, tableName, localColumns, errorMessage)) {
+        return false;
+    }
+    if (localColumns.empty()) {
+        errorMessage = "Cannot export missing table '" + tableName + "'";
+        return false;
+    }
+
+    std::vector<std::string> columns;
+    bool hasStatus = false;
+    for (const auto& column : localColumns) {
+        if (column == "_status") {
+            hasStatus = true;
+        }
+        if (!isBookkeepingColumn(column)) {
+            columns.push_back(column);
+        }
+    }
+
+    std::string sql = "SELECT ";
+    for (size_t i = 0; i < columns.size(); i++) {
+        if (i > 0) sql += ", ";
+        sql += quoteIdentifier(columns[i]);
+    }
+    sql += " FROM " + quoteIdentifier(tableName);
+    if (hasStatus) {
+        sql += " WHERE \"_status\" IS NOT 'deleted'";
+    }
+
+    StatementPtr stmt;
+    if (!prepare(db, sql, stmt, errorMessage) || !encoder.beginTable(tableName, columns, errorMessage)) {
+        return false;
+    }
+
+    const int columnCount = static_cast<int>(columns.size());
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+        for (int i = 0; i < columnCount; i++) {
+            switch (sqlite3_column_type(stmt.get(), i)) {
+                case SQLITE_INTEGER:
+                    encoder.appendInt(sqlite3_column_int64(stmt.get(), i));
+                    break;
+                case SQLITE_FLOAT:
+                    encoder.appendReal(sqlite3_column_double(stmt.get(), i));
+                    break;
+                case SQLITE_TEXT: {
+                    const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), i));
+                    encoder.appendText(text, static_cast<size_t>(sqlite3_column_bytes(stmt.get(), i)));
+                    break;
+                }
+                case SQLITE_BLOB: {
+                    const void* blob = sqlite3_column_blob(stmt.get(), i);
+                    encoder.appendBlob(static_cast<const uint8_t*>(blob),
+                                       static_cast<size_t>(sqlite3_column_bytes(stmt.get(), i)));
+                    break;
+                }
+                default:
+                    encoder.appendNull();
+                    break;
+            }
+        }
+    }
+    if (rc != SQLITE_DONE) {
+        errorMessage = "Failed to read '" + tableName + "': " + std::string(sqlite3_errmsg(db));
+        return false;
+    }
+    return encoder.endTable(errorMessage);
+}
+
+// Writes to `<path>.partial` and renames it over `path` once the slice is complete
+class PartialFile {
+public:
+    explicit PartialFile(const std::string& path)
+        : path_(path)
+        , partialPath_(path + ".partial") {
+    }
+
+    ~PartialFile() {
+        if (file_) {
+            std::fclose(file_);
+        }
+        if (!published_) {
+            std::remove(partialPath_.c_str());
+        }
+    }
+
+    bool open(std::string& errorMessage) {
+        file_ = std::fopen(partialPath_.c_str(), "wb");
+        if (!file_) {
+            errorMessage = "Failed to create slice file: " + std::string(std::strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    SliceEncoder::Sink sink() {
+        return [this](const uint8_t* data, size_t length, std::string& errorMessage) {
+            if (std::fwrite(data, 1, length, file_) != length) {
+                errorMessage = "Failed to write slice file: " + std::string(std::strerror(errno));
+                return false;
+            }
+            return true;
+        };
+    }
+
+    bool publish(std::string& errorMessage) {
+        bool flushed = std::fflush(file_) == 0;
+        std::fclose(file_);
+        file_ = nullptr;
+        if (!flushed) {
+            errorMessage = "Failed to write slice file: " + std::string(std::strerror(errno));
+            return false;
+        }
+        if (std::rename(partialPath_.c_str(), path_.c_str()) != 0) {
+            errorMessage = "Failed to move slice file into place: " + std::string(std::strerror(errno));
+            return false;
+        }
+        published_ = true;
+        return true;
+    }
+
+private:
+    std::string path_;
+    std::string partialPath_;
+    FILE* file_ = nullptr;
+    bool published_ = false;
+};
+
+void fillStats(const SliceEncoder& encoder, uint64_t tables, SliceExportStats* stats) {
+    if (!stats) {
+        return;
+    }
+    stats->tables = tables;
+    stats->rows = encoder.rowsWritten();
+    stats->uncompressedBytes = encoder.uncompressedBytes();
+    stats->compressedBytes = encoder.compressedBytes();
+}
+} // namespace
+
+SliceEncoder::SliceEncoder(Sink sink, int compressionLevel)
+    : sink_(std::move(sink))
+    , cctx_(ZSTD_createCCtx()) {
+    if (cctx_) {
+        compressionLevel = std::max(std::min(compressionLevel, ZSTD_maxCLevel()), ZSTD_minCLevel());
+        ZSTD_CCtx_setParameter(cctx_, ZSTD_c_compressionLevel, compressionLevel);
+        ZSTD_CCtx_setParameter(cctx_, ZSTD_c_checksumFlag, 1);
+    }
+    pending_.reserve(kPendingFlushBytes + 1024);
+    output_.resize(ZSTD_CStreamOutSize());
+}
+
+SliceEncoder::~SliceEncoder() {
+    if (cctx_) {
+        ZSTD_freeCCtx(cctx_);
+    }
+}
+
+bool SliceEncoder::fail(const std::string& message, std::string& errorMessage) {
+    failure_ = message;
+    errorMessage = message;
+    state_ = State::Failed;
+    return false;
+}
+
+bool SliceEncoder::hasFailed(std::string& errorMessage) const {
+    if (state_ != State::Failed) {
+        return false;
+    }
+    errorMessage = failure_;
+    return true;
+}
+
+void SliceEncoder::appendVarint(uint64_t value) {
+    while (value >= 0x80) {
+        pending_.push_back(static_cast<uint8_t>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    pending_.push_back(static_cast<uint8_t>(value));
+}
+
+void SliceEncoder::appendBytes(const uint8_t* data, size_t length) {
+    if (length > 0) {
+        pending_.insert(pending_.end(), data, data + length);
+    }
+}
+
+void SliceEncoder::appendFixed64(uint64_t bits, TypeTag tag) {
+    pending_.push_back(8);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        pending_.push_back(static_cast<uint8_t>((bits >> shift) & 0xFF));
+    }
+    pending_.push_back(static_cast<uint8_t>(tag));
+    fieldWritten();
+}
+
+void SliceEncoder::fieldWritten() {
+    if (state_ != State::Table || (delta_ && !rowOpen_)) {
+        if (state_ != State::Failed) {
+            failure_ = state_ == State::Table ? "Delta slice field appended without beginUpsert"
+                                              : "Field appended outside of a table";
+            state_ = State::Failed;
+        }
+        return;
+    }
+    if (++fieldInRow_ == rowFieldCount_) {
+        fieldInRow_ = 0;
+        rowOpen_ = false;
+        rowsWritten_++;
+        if (pending_.size() >= kPendingFlushBytes) {
+            // A failure is reported by the next bool-returning call
+            std::string ignored;
+            compressPending(ZSTD_e_continue, ignored);
+        }
+    }
+}
+
+bool SliceEncoder::compressPending(ZSTD_EndDirective directive, std::string& errorMessage) {
+    ZSTD_inBuffer input = {pending_.data(), pending_.size(), 0};
+    uncompressedBytes_ += pending_.size();
+    for (;;) {
+        ZSTD_outBuffer output = {output_.data(), output_.size(), 0};
+        size_t remaining = ZSTD_compressStream2(cctx_, &output, &input, directive);
+        if (ZSTD_isError(remaining)) {
+            return fail(std::string("Slice compression failed: ") + ZSTD_getErrorName(remaining), errorMessage);
+        }
+        if (output.pos > 0) {
+            compressedBytes_ += output.pos;
+            std::string sinkError;
+            if (!sink_(output_.data(), output.pos, sinkError)) {
+                return fail(sinkError, errorMessage);
+            }
+        }
+        bool done = directive == ZSTD_e_end ? remaining == 0 : input.pos == input.size;
+        if (done) {
+            break;
+        }
+    }
+    pending_.clear();
+    return true;
+}
+
+bool SliceEncoder::setPatchReference(const uint8_t* reference, size_t length, std::string& errorMessage) {
+    if (hasFailed(errorMessage)) {
+        return false;
+    }
+    if (!cctx_) {
+        return fail("Failed to create zstd compression context", errorMessage);
+    }
+    if (state_ != State::Initial) {
+        return fail("Patch reference must be set before the slice header", errorMessage);
+    }
+    // Same settings as `zstd --patch-from`: a window covering the reference (plus as much of the
+    // new slice again), and long-distance matching to find the unchanged runs far back in it
+    ZSTD_bounds windowBounds = ZSTD_cParam_getBounds(ZSTD_c_windowLog);
+    int windowLog = 21; // zstd's own window at the default level
+    while (windowLog < windowBounds.upperBound && (uint64_t{1} << windowLog) < uint64_t{length} * 2) {
+        windowLog++;
+    }
+    size_t result = ZSTD_CCtx_setParameter(cctx_, ZSTD_c_windowLog, windowLog);
+    if (!ZSTD_isError(result)) {
+        result = ZSTD_CCtx_setParameter(cctx_, ZSTD_c_enableLongDistanceMatching, 1);
+    }
+    if (!ZSTD_isError(result)) {
+        result = ZSTD_CCtx_refPrefix(cctx_, reference, length);
+    }
+    if (ZSTD_isError(result)) {
+        return fail(std::string("Failed to set patch reference: ") + ZSTD_getErrorName(result), errorMessage);
+    }
+    return true;
+}
+
+bool SliceEncoder::writeSliceHeader(const SliceHeader& header, std::string& errorMessage) {
+    if (hasFailed(errorMessage)) {
+        return false;
+    }
+    if (!cctx_) {
+        return fail("Failed to create zstd compression context", errorMessage);
+    }
+    if (state_ != State::Initial) {
+        return fail("Slice header already written", errorMessage);
+    }
+    if (header.version < 0 || header.timestamp < 0 || header.numberOfTables < 0) {
+        return fail("Slice header values must not be negative", errorMessage);
+    }
+    if (header.numberOfTables > MAX_TABLES) {
+        return fail("Too many tables in slice header", errorMessage);
+    }
+    if ((header.flags & ~SLICE_KNOWN_FLAGS) != 0) {
+        return fail("Unsupported slice flags", errorMessage);
+    }
+    appendVarint(header.sliceId.size());
+    appendBytes(reinterpret_cast<const uint8_t*>(header.sliceId.data()), header.sliceId.size());
+    appendVarint(static_cast<uint64_t>(header.version));
+    appendVarint(header.priority.size());
+    appendBytes(reinterpret_cast<const uint8_t*>(header.priority.data()), header.priority.size());
+    appendVarint(static_cast<uint64_t>(header.timestamp));
+    appendVarint((header.flags << SLICE_FLAGS_SHIFT) | static_cast<uint64_t>(header.numberOfTables));
+    expectedTables_ = header.numberOfTables;
+    delta_ = header.isDelta();
+    state_ = State::Header;
+    return true;
+}
+
+bool SliceEncoder::beginTable(const std::string& tableName,
+                              const std::vector<std::string>& columns,
+                              std::string& errorMessage) {
+    if (hasFailed(errorMessage)) {
+        return false;
+    }
+    if (state_ != State::Header) {
+        return fail("beginTable called outside of a slice", errorMessage);
+    }
+    if (tableName.empty() || tableName.size() > MAX_TABLE_NAME_LENGTH) {
+        return fail("Invalid table name '" + tableName + "'", errorMessage);
+    }
+    if (columns.empty()) {
+        return fail("Table '" + tableName + "' has no columns", errorMessage);
+    }
+    appendVarint(tableName.size());
+    appendBytes(reinterpret_cast<const uint8_t*>(tableName.data()), tableName.size());
+    appendVarint(columns.size());
+    for (const auto& column : columns) {
+        if (column.empty() || column.size() > MAX_COLUMN_NAME_LENGTH) {
+            return fail("Invalid column name in '" + tableName + "'", errorMessage);
+        }
+        appendVarint(column.size());
+        appendBytes(reinterpret_cast<const uint8_t*>(column.data()), column.size());
+    }
+    columnCount_ = columns.size();
+    rowFieldCount_ = columnCount_;
+    fieldInRow_ = 0;
+    rowOpen_ = false;
+    state_ = State::Table;
+    return true;
+}
+
+void SliceEncoder::appendNull() {
+    pending_.push_back(0);
+    pending_.push_back(static_cast<uint8_t>(TypeTag::NULL_TYPE));
+    fieldWritten();
+}
+
+void SliceEncoder::appendInt(int64_t value) {
+    appendFixed64(static_cast<uint64_t>(value), TypeTag::INT);
+}
+
+void SliceEncoder::appendReal(double value) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendFixed64(bits, TypeTag::REAL);
+}
+
+void SliceEncoder::appendText(const char* data, size_t length) {
+    appendVarint(length);
+    appendBytes(reinterpret_cast<const uint8_t*>(data), length);
+    pending_.push_back(static_cast<uint8_t>(length == 0 ? TypeTag::EMPTY_TEXT : TypeTag::TEXT));
+    fieldWritten();
+}
+
+void SliceEncoder::appendBlob(const uint8_t* data, size_t length) {
+    appendVarint(length);
+    appendBytes(data, length);
+    pending_.push_back(static_cast<uint8_t>(length == 0 ? TypeTag::EMPTY_BLOB : TypeTag::BLOB));
+    fieldWritten();
+}
+
+void SliceEncoder::appendValue(const FieldValue& value) {
+    value.visit(Overloaded{
+        [this](std::nullptr_t) { appendNull(); },
+        [this](int64_t intValue) { appendInt(intValue); },
+        [this](double realValue) { appendReal(realValue); },
+        [this](std::string_view text) { appendText(text.data(), text.size()); },
+        [this](FieldBlob blob) { appendBlob(blob.data, blob.size); },
+    });
+}
+
+bool SliceEncoder::beginUpsert(std::string& errorMessage) {
+    if (!beginDeltaRow(DeltaOp::UPSERT, errorMessage)) {
+        return false;
+    }
+    rowFieldCount_ = columnCount_;
+    return true;
+}
+
+bool SliceEncoder::appendDelete(const FieldValue& id, std::string& errorMessage) {
+    if (id.isNull()) {
+        return fail("Delta slice delete needs a record id", errorMessage);
+    }
+    if (!beginDeltaRow(DeltaOp::DELETE, errorMessage)) {
+        return false;
+    }
+    rowFieldCount_ = 1;
+    appendValue(id);
+    rowFieldCount_ = columnCount_;
+    return !hasFailed(errorMessage);
+}
+
+bool SliceEncoder::beginDeltaRow(DeltaOp op, std::string& errorMessage) {
+    if (hasFailed(errorMessage)) {
+        return false;
+    }
+    if (!delta_) {
+        return fail("Delta rows can only be written to delta slices", errorMessage);
+    }
+    if (state_ != State::Table || fieldInRow_ != 0 || rowOpen_) {
+        return fail("Delta row started outside of a table or inside another row", errorMessage);
+    }
+    pending_.push_back(static_cast<uint8_t>(op));
+    rowOpen_ = true;
+    return true;
+}
+
+bool SliceEncoder::writeRow(const std::vector<FieldValue>& values, std::string& errorMessage) {
+    if (hasFailed(errorMessage)) {
+        return false;
+    }
+    if (state_ != State::Table || fieldInRow_ != 0 || rowOpen_) {
+        return fail("writeRow called outside of a table", errorMessage);
+    }
+    if (values.size() != columnCount_) {
+        return fail("Row has " + std::to_string(values.size()) + " values, expected " +
+                    std::to_string(columnCount_), errorMessage);
+    }
+    if (delta_ && !beginUpsert(errorMessage)) {
+        return false;
+    }
+    for (const auto& value : values) {
+        appendValue(value);
+    }
+    return !hasFailed(errorMessage);
+}
+
+bool SliceEncoder::endTable(std::string& errorMessage) {
+    if (hasFailed(errorMessage)) {
+        return false;
+    }
+    if (state_ != State::Table) {
+        return fail("endTable called outside of a table", errorMessage);
+    }
+    if (fieldInRow_ != 0 || rowOpen_) {
+        return fail("Incomplete row at end of table", errorMessage);
+    }
+    pending_.push_back(END_OF_TABLE_DELIMITER);
+    tablesWritten_++;
+    state_ = State::Header;
+    return true;
+}
+
+bool SliceEncoder::finish(std::string& errorMessage) {
+    if (hasFailed(errorMessage)) {
+        return false;
+    }
+    if (state_ != State::Header) {
+        return fail(state_ == State::Table ? "Table not ended" : "Nothing to finish", errorMessage);
+    }
+    if (expectedTables_ > 0 && tablesWritten_ != expectedTables_) {
+        return fail("Slice header announced " + std::to_string(expectedTables_) + " tables, wrote " +
+                    std::to_string(tablesWritten_), errorMessage);
+    }
+    if (!compressPending(ZSTD_e_end, errorMessage)) {
+        return false;
+    }
+    state_ = State::Finished;
+    return true;
+}
+
+bool parseSliceExportOptions(const std::string& json, SliceExportOptions& options, std::string& errorMessage) {
+    options = SliceExportOptions();
+    if (json.empty()) {
+        return true;
+    }
+
+    simdjson::dom::parser parser;
+    simdjson::dom::element doc;
+    if (parser.parse(json).get(doc)) {
+        errorMessage = "Invalid slice export options: malformed JSON";
+        return false;
+    }
+    simdjson::dom::object root;
+    if (doc.get(root)) {
+        errorMessage = "Invalid slice export options: expected an object";
+        return false;
+    }
+
+    simdjson::dom::array tables;
+    if (!root["tables"].get(tables)) {
+        for (simdjson::dom::element tableElement : tables) {
+            std::string_view tableName;
+            if (tableElement.get(tableName)) {
+                errorMessage = "Invalid slice export options: tables must contain table names";
+                return false;
+            }
+            options.tables.emplace_back(tableName);
+        }
+    }
+
+    std::string_view sliceId;
+    if (!root["sliceId"].get(sliceId)) {
+        options.sliceId = std::string(sliceId);
+    }
+
+    if (root["version"].error() != simdjson::NO_SUCH_FIELD) {
+        int64_t version = 0;
+        if (root["version"].get(version) || version < 0) {
+            errorMessage = "Invalid slice export options: version must be a non-negative integer";
+            return false;
+        }
+        options.version = version;
+    }
+
+    std::string_view priority;
+    if (!root["priority"].get(priority)) {
+        options.priority = std::string(priority);
+    }
+
+    if (root["compressionLevel"].error() != simdjson::NO_SUCH_FIELD) {
+        int64_t level = 0;
+        if (root["compressionLevel"].get(level) || level < ZSTD_minCLevel() || level > ZSTD_maxCLevel()) {
+            errorMessage = "Invalid slice export options: compressionLevel must be an integer between " +
+                           std::to_string(ZSTD_minCLevel()) + " and " + std::to_string(ZSTD_maxCLevel());
+            return false;
+        }
+        options.compressionLevel = static_cast<int>(level);
+    }
+
+    return true;
+}
+
+bool exportSlice(sqlite3* db,
+                 const std::string& path,
+                 const SliceExportOptions& options,
+                 SliceExportStats* stats,
+                 std::string& errorMessage) {
+    if (!db) {
+        errorMessage = "No database connection";
+        return false;
+    }
+    // Read-only, so it always ends in a rollback. A transaction the caller already has open is
+    // reused and left alone.
+    struct ReadTransaction {
+        sqlite3* db;
+        bool owned = false;
+        ~ReadTransaction() {
+            if (owned) {
+                sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            }
+        }
+    } transaction{db};
+    if (sqlite3_get_autocommit(db)) {
+        if (sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            errorMessage = "Failed to begin export transaction: " + std::string(sqlite3_errmsg(db));
+            return false;
+        }
+        transaction.owned = true;
+    }
+
+    std::vector<std::string> tables = options.tables;
+    if (tables.empty() && !listSyncedTables(db, tables, errorMessage)) {
+        return false;
+    }
+
+    PartialFile file(path);
+    if (!file.open(errorMessage)) {
+        return false;
+    }
+    SliceEncoder encoder(file.sink(), options.compressionLevel);
+
+    SliceHeader header;
+    header.sliceId = options.sliceId;
+    header.version = options.version;
+    header.priority = options.priority;
+    header.timestamp = static_cast<int64_t>(std::time(nullptr));
+    header.numberOfTables = static_cast<int64_t>(tables.size());
+    if (!encoder.writeSliceHeader(header, errorMessage)) {
+        return false;
+    }
+    for (const auto& table : tables) {
+        if (!exportTable(db, encoder, table, errorMessage)) {
+            return false;
+        }
+    }
+    if (!encoder.finish(errorMessage) || !file.publish(errorMessage)) {
+        return false;
+    }
+    fillStats(encoder, tables.size(), stats);
+    return true;
+}
+
+std::string sliceExportStatsJson(const SliceExportStats& stats) {
+    return "{\"tables\":" + std::to_string(stats.tables) +
+           ",\"rows\":" + std::to_string(stats.rows) +
+           ",\"uncompressedBytes\":" + std::to_string(stats.uncompressedBytes) +
+           ",\"compressedBytes\":" + std::to_string(stats.compressedBytes) + "}";
+}
+
+const std::vector<std::string>& syntheticSliceColumns() {
+    static const std::vector<std::string> columns = {
+        "id", "project_id", "assignee_id", "status", "title", "description",
+        "priority", "estimate", "is_archived", "created_at", "updated_at"
+    };
+    return columns;
+}
+
+bool writeSyntheticSlice(const std::string& path,
+                         const SyntheticSliceSpec& spec,
+                         SliceExportStats* stats,
+                         std::string& errorMessage) {
+    static const char* kStatuses[] = {"todo", "in_progress", "review", "done"};
+
+    PartialFile file(path);
+    if (!file.open(errorMessage)) {
+        return false;
+    }
+    SliceEncoder encoder(file.sink(), spec.compressionLevel);
+
+    SliceHeader header;
+    header.sliceId = "synthetic";
+    header.version = 1;
+    header.priority = "high";
+    header.timestamp = 1700000000;
+    header.numberOfTables = static_cast<int64_t>(spec.tableCount);
+    if (!encoder.writeSliceHeader(header, errorMessage)) {
+        return false;
+    }
+
+    uint64_t seed = spec.seed;
+    auto next = [&seed]() {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return seed >> 33;
+    };
+    std::string text;
+    for (size_t table = 0; table < spec.tableCount; table++) {
+        std::string tableName = table == 0 ? "tasks" : "tasks_" + std::to_string(table);
+        if (!encoder.beginTable(tableName, syntheticSliceColumns(), errorMessage)) {
+            return false;
+        }
+        for (size_t i = 0; i < spec.rowsPerTable; i++) {
+            char id[17];
+            std::snprintf(id, sizeof(id), "%016llx", static_cast<unsigned long long>(next() * 2654435761ULL));
+            encoder.appendText(id, 16);
+            text = "project_" + std::to_string(next() % 500);
+            encoder.appendText(text.data(), text.size());
+            text = "user_" + std::to_string(next() % 2000);
+            encoder.appendText(text.data(), text.size());
+            const char* status = kStatuses[next() % 4];
+            encoder.appendText(status, std::strlen(status));
+            text = "Task title number " + std::to_string(i);
+            encoder.appendText(text.data(), text.size());
+            text = "A longer description for the task so rows have a realistic width " + std::to_string(next());
+            encoder.appendText(text.data(), text.size());
+            encoder.appendInt(static_cast<int64_t>(next() % 5));
+            encoder.appendReal(static_cast<double>(next() % 100) / 4.0);
+            encoder.appendInt(static_cast<int64_t>(next() % 10 == 0));
+            encoder.appendInt(1600000000000LL + static_cast<int64_t>(next() % 100000000));
+            encoder.appendInt(1650000000000LL + static_cast<int64_t>(next() % 100000000));
+        }
+        if (!encoder.endTable(errorMessage)) {
+            return false;
+        }
+    }
+    if (!encoder.finish(errorMessage) || !file.publish(errorMessage)) {
+        return false;
+    }
+    fillStats(encoder, spec.tableCount, stats);
+    return true;
+}
+
+} // namespace watermelondb
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "SliceDecoder.h"
+
+#include <sqlite3.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace watermelondb {
+
+// Streaming writer for the binary slice format, the counterpart of SliceDecoder.
+//
+// Calls follow the layout of a slice:
+//   writeSliceHeader, then per table: beginTable, one append* call per field (row-major), endTable;
+//   finally finish.
+// Delta slices (header.flags with SLICE_FLAG_DELTA) prefix every row with its op: call beginUpsert
+// before the row's fields (writeRow does it for you), or appendDelete with just the record id.
+// Fields are buffered and compressed in chunks, so memory use doesn't grow with the slice; every
+// compressed chunk is handed to `sink` as soon as zstd produces it.
+//
+// Empty TEXT/BLOB values are written with their own type tags (TypeTag::EMPTY_TEXT/EMPTY_BLOB) so
+// they don't come back as NULL; decoders that predate those tags still read them as NULL.
+class SliceEncoder {
+public:
+    // Receives compressed output. Returning false aborts encoding with `errorMessage`.
+    using Sink = std::function<bool(const uint8_t* data, size_t length, std::string& errorMessage)>;
+
+    static constexpr int DEFAULT_COMPRESSION_LEVEL = 3;
+
+    // compressionLevel: zstd level (1 = fastest .. 19 = smallest; negative levels are faster still)
+    explicit SliceEncoder(Sink sink, int compressionLevel = DEFAULT_COMPRESSION_LEVEL);
+    ~SliceEncoder();
+
+    SliceEncoder(const SliceEncoder&) = delete;
+    SliceEncoder& operator=(const SliceEncoder&) = delete;
+
+    // Writes a patch instead of a standalone slice (zstd --patch-from): `reference` is the
+    // decompressed previous version of the slice, and only what differs from it ends up in the
+    // output. Decode with SliceDecoder::setPatchReference and the same bytes. `reference` must stay
+    // alive until finish. Call before writeSliceHeader.
+    bool setPatchReference(const uint8_t* reference, size_t length, std::string& errorMessage);
+
+    // header.numberOfTables must match the number of tables written (0 = unknown, tables until EOF)
+    bool writeSliceHeader(const SliceHeader& header, std::string& errorMessage);
+
+    bool beginTable(const std::string& tableName,
+                    const std::vector<std::string>& columns,
+                    std::string& errorMessage);
+
+    // Field writers; a row is complete once one field per column has been appended
+    void appendNull();
+    void appendInt(int64_t value);
+    void appendReal(double value);
+    void appendText(const char* data, size_t length);
+    void appendBlob(const uint8_t* data, size_t length);
+    void appendValue(const FieldValue& value);
+
+    // Appends a whole row; fails if the value count doesn't match the table's columns
+    bool writeRow(const std::vector<FieldValue>& values, std::string& errorMessage);
+
+    // Delta slices only: starts an upsert row; one field per column follows
+    bool beginUpsert(std::string& errorMessage);
+    // Delta slices only: writes a complete delete row for record `id`
+    bool appendDelete(const FieldValue& id, std::string& errorMessage);
+
+    // Writes the end-of-table delimiter; fails on a partially written row
+    bool endTable(std::string& errorMessage);
+
+    // Flushes everything and closes the zstd frame
+    bool finish(std::string& errorMessage);
+
+    uint64_t rowsWritten() const { return rowsWritten_; }
+    uint64_t uncompressedBytes() const { return uncompressedBytes_; }
+    uint64_t compressedBytes() const { return compressedBytes_; }
+
+private:
+    enum class State { Initial, Header, Table, Finished, Failed };
+
+    Sink sink_;
+    ZSTD_CCtx* cctx_ = nullptr;
+    std::vector<uint8_t> pending_;
+    std::vector<uint8_t> output_;
+    State state_ = State::Initial;
+    int64_t expectedTables_ = 0;
+    int64_t tablesWritten_ = 0;
+    size_t columnCount_ = 0;
+    size_t fieldInRow_ = 0;
+    // Fields making up the current row: columnCount_, or 1 for a delta delete
+    size_t rowFieldCount_ = 0;
+    bool delta_ = false;
+    // Delta slices: an op byte was written and the row's fields are pending
+    bool rowOpen_ = false;
+    uint64_t rowsWritten_ = 0;
+    uint64_t uncompressedBytes_ = 0;
+    uint64_t compressedBytes_ = 0;
+    std::string failure_;
+
+    void appendVarint(uint64_t value);
+    void appendBytes(const uint8_t* data, size_t length);
+    void appendFixed64(uint64_t bits, TypeTag tag);
+    void fieldWritten();
+    bool beginDeltaRow(DeltaOp op, std::string& errorMessage);
+    bool compressPending(ZSTD_EndDirective directive, std::string& errorMessage);
+    bool fail(const std::string& message, std::string& errorMessage);
+    bool hasFailed(std::string& errorMessage) const;
+};
+
+// What exportSlice writes, parsed from JS by parseSliceExportOptions
+struct SliceExportOptions {
+    // Tables to export, in this order. Empty = every table that has a `_status` column (the synced
+    // tables of a WatermelonDB schema), in schema order.
+    std::vector<std::string> tables;
+    std::string sliceId = "export";
+    int64_t version = 0;
+    std::string priority;
+    int compressionLevel = SliceEncoder::DEFAULT_COMPRESSION_LEVEL;
+};
+
+// Parses e.g. {"tables":["tasks","projects"],"sliceId":"handoff","version":12,"compressionLevel":9}.
+// Unknown keys are ignored. Returns false (and sets errorMessage) on malformed JSON or invalid values.
+bool parseSliceExportOptions(const std::string& json, SliceExportOptions& options, std::string& errorMessage);
+
+struct SliceExportStats {
+    uint64_t tables = 0;
+    uint64_t rows = 0;
+    uint64_t uncompressedBytes = 0;
+    uint64_t compressedBytes = 0;
+};
+
+// What exportSlice resolves with in JS, e.g. {"tables":2,"rows":1200,"uncompressedBytes":90112,"compressedBytes":20480}
+std::string sliceExportStatsJson(const SliceExportStats& stats);
+
+// Streams tables of `db` into a slice file at `path`, e.g. to hand synced data to another device.
+//
+// Rows are read inside one read transaction, so the slice is a consistent snapshot. WatermelonDB
+// bookkeeping is left out: `_status` and `_changed` are not exported (imports mark every row
+// synced) and rows pending deletion are skipped, so unpushed local changes are not preserved and
+// the slice is not a backup of the database. The slice is written next to `path` and renamed
+// into place once complete, so a failed export never leaves a truncated slice behind.
+bool exportSlice(sqlite3* db,
+                 const std::string& path,
+                 const SliceExportOptions& options,
+                 SliceExportStats* stats,
+                 std::string& errorMessage);
+
+// Shape of the synthetic slices written by writeSyntheticSlice
+struct SyntheticSliceSpec {
+    size_t rowsPerTable = 100000;
+    // Tables are named "tasks", "tasks_1", "tasks_2", ...
+    size_t tableCount = 1;
+    uint64_t seed = 42;
+    int compressionLevel = SliceEncoder::DEFAULT_COMPRESSION_LEVEL;
+};
+
+// Column layout of every synthetic table: a task-like mix of ids, short and long text, ints and reals
+const std::vector<std::string>& syntheticSliceColumns();
+
+// Writes a deterministic synthetic slice (same spec = same bytes), for benchmarks and load tests
+bool writeSyntheticSlice(const std::string& path,
+                         const SyntheticSliceSpec& spec,
+                         SliceExportStats* stats,
+                         std::string& errorMessage);
+
+} // namespace watermelondb
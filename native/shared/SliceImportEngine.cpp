@@ -1,5 +1,7 @@
 #include "SliceImportEngine.h"
+#include "SliceLocalFile.h"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <chrono>
 
@@ -11,6 +13,21 @@ constexpr size_t SAVEPOINT_INTERVAL = 10000;
 constexpr size_t MAX_BATCH_SIZE = 10000;
 constexpr size_t COMPACT_EVERY_N_CHUNKS = 16;
 
+// Local slices are fed to the decoder in windows of the mapping, same size as the iOS download
+// buffer, so decoded data is parsed and flushed at the usual cadence
+constexpr size_t LOCAL_FILE_CHUNK_SIZE = 256 * 1024;
+
+namespace {
+class LocalFileReadHandle : public platform::DownloadHandle {
+public:
+    void cancel() override { cancelled_.store(true); }
+    bool isCancelled() const { return cancelled_.load(); }
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+} // namespace
+
 #ifdef SLICE_IMPORT_VERBOSE_LOGS
 static inline void verboseInfo(const std::string& message) { platform::logInfo(message); }
 static inline void verboseDebug(const std::string& message) { platform::logDebug(message); }
@@ -36,8 +53,9 @@ static inline void logDecoderProfile(const SliceDecoder::DecodeProfile& profile)
     );
 }
 #endif
-SliceImportEngine::SliceImportEngine(std::shared_ptr<DatabaseInterface> db)
+SliceImportEngine::SliceImportEngine(std::shared_ptr<DatabaseInterface> db, SliceImportOptions options)
     : db_(db)
+    , options_(std::move(options))
     , decoder_(nullptr)
     , downloadHandle_(nullptr)
     , memoryAlertHandle_(nullptr)
@@ -50,6 +68,7 @@ SliceImportEngine::SliceImportEngine(std::shared_ptr<DatabaseInterface> db)
     , initialBatchSize_(0)
     , totalRowsInserted_(0)
     , rowsSinceSavepoint_(0)
+    , currentPriorityGroup_(0)
     , importStart_()
     , totalParseMs_(0)
     , totalFlushMs_(0)
@@ -101,11 +120,20 @@ void SliceImportEngine::startImport(
     failed_ = false;
     transactionStarted_ = false;
     headerParsed_ = false;
+    headerCacheKey_.clear();
     parsingTable_ = false;
+    currentProjection_ = SliceTableProjection();
+    localSchemaColumns_.clear();
     totalRowsInserted_ = 0;
     rowsSinceSavepoint_ = 0;
+    uncommittedTables_.clear();
+    pendingChangeset_.clear();
+    committedChangeset_.clear();
+    currentPriorityGroup_ = 0;
     batchSize_ = initialBatchSize_;
     currentBatch_.clear();
+    currentBatch_.delta = false;
+    currentBatch_.sortById = options_.sortById;
     totalParseMs_ = 0;
     totalFlushMs_ = 0;
     flushCount_ = 0;
@@ -114,6 +142,7 @@ void SliceImportEngine::startImport(
     
     // Create decoder
     decoder_ = std::make_unique<SliceDecoder>();
+    decoder_->setValueArena(&currentBatch_.arena());
     if (!decoder_->initializeDecompression()) {
         fail("Failed to initialize decompression: " + decoder_->getError());
         return;
@@ -133,6 +162,26 @@ void SliceImportEngine::startImport(
     
     platform::logInfo("Starting import from: " + url);
     
+    if (isLocalSliceUrl(url)) {
+        if (preparePatchReference()) {
+            startLocalImport(localSlicePath(url));
+        }
+        return;
+    }
+    
+    if (options_.cache) {
+        std::string cachedPath = prepareSliceCache();
+        if (!cachedPath.empty()) {
+            platform::logInfo("Importing slice from cache: " + options_.cacheKey);
+            startLocalImport(cachedPath);
+            return;
+        }
+    }
+    
+    if (!preparePatchReference()) {
+        return;
+    }
+    
     std::shared_ptr<SliceImportEngine> self = shared_from_this();
     
     // Start download (platform-specific)
@@ -152,6 +201,120 @@ void SliceImportEngine::startImport(
     }
 }
 
+void SliceImportEngine::startLocalImport(const std::string& path) {
+    auto file = std::make_shared<MappedFile>();
+    std::string error;
+    if (!file->open(path, error)) {
+        fail("Failed to open local slice: " + error);
+        return;
+    }
+    
+    auto handle = std::make_shared<LocalFileReadHandle>();
+    downloadHandle_ = handle;
+    
+    std::shared_ptr<SliceImportEngine> self = shared_from_this();
+    platform::runOnWorkQueue([self, file, handle]() {
+        size_t offset = 0;
+        while (offset < file->size()) {
+            if (handle->isCancelled() || self->failed_) {
+                return;
+            }
+            size_t length = std::min(LOCAL_FILE_CHUNK_SIZE, file->size() - offset);
+            self->handleDataChunk(file->data() + offset, length);
+            offset += length;
+        }
+        if (handle->isCancelled()) {
+            return;
+        }
+        self->handleDownloadComplete("");
+    });
+}
+
+bool SliceImportEngine::ensureSliceCache() {
+    if (cache_) {
+        return true;
+    }
+    std::string directory = platform::sliceCacheDirectory();
+    if (directory.empty()) {
+        platform::logInfo("Slice cache not available on this platform");
+        return false;
+    }
+    cache_ = std::make_unique<SliceCache>(
+        directory, options_.cacheMaxBytes > 0 ? options_.cacheMaxBytes : SliceCache::DEFAULT_MAX_BYTES);
+    return true;
+}
+
+std::string SliceImportEngine::prepareSliceCache() {
+    if (!ensureSliceCache()) {
+        return "";
+    }
+    
+    std::string cachedPath = cache_->lookup(options_.cacheKey);
+    if (!cachedPath.empty()) {
+        return cachedPath;
+    }
+    
+    // Miss: keep a copy of the compressed bytes as they arrive
+    std::string error;
+    cacheWriter_ = cache_->beginWrite(error);
+    if (!cacheWriter_) {
+        platform::logError("Slice cache disabled for this import: " + error);
+    }
+    return "";
+}
+
+bool SliceImportEngine::preparePatchReference() {
+    if (options_.patchFrom.empty()) {
+        return true;
+    }
+    
+    std::string referencePath = ensureSliceCache() ? cache_->lookup(options_.patchFrom) : "";
+    if (referencePath.empty()) {
+        fail("Patch reference slice is not cached: " + options_.patchFrom);
+        return false;
+    }
+    
+    MappedFile file;
+    std::vector<uint8_t> reference;
+    std::string error;
+    if (!file.open(referencePath, error) || !decompressSlice(file.data(), file.size(), reference, error)) {
+        // A corrupt entry can't serve as a reference again
+        cache_->remove(options_.patchFrom);
+        fail("Failed to load patch reference " + options_.patchFrom + ": " + error);
+        return false;
+    }
+    verboseInfo("Patching slice " + options_.patchFrom + " (" + std::to_string(reference.size()) + " bytes)");
+    
+    if (!decoder_->setPatchReference(std::move(reference))) {
+        fail(decoder_->getError());
+        return false;
+    }
+    
+    // The download is only a patch: cache the slice it reconstructs instead
+    if (cacheWriter_) {
+        SliceCacheWriter* writer = cacheWriter_.get();
+        decoder_->setOutputObserver([writer](const uint8_t* data, size_t length) {
+            writer->appendDecompressed(data, length);
+        });
+    }
+    return true;
+}
+
+void SliceImportEngine::storeInSliceCache() {
+    if (!cacheWriter_ || !cache_) {
+        return;
+    }
+    decoder_->setOutputObserver(nullptr);
+    const std::string& key = options_.cacheKey.empty() ? headerCacheKey_ : options_.cacheKey;
+    std::string error;
+    if (cache_->commit(*cacheWriter_, key, error)) {
+        verboseInfo("Stored slice in cache: " + key);
+    } else {
+        platform::logError("Failed to store slice in cache: " + error);
+    }
+    cacheWriter_.reset();
+}
+
 void SliceImportEngine::cancel() {
     if (!importing_) {
         return;
@@ -183,6 +346,10 @@ void SliceImportEngine::handleDataChunk(const uint8_t* data, size_t length) {
     
     auto parseStart = std::chrono::steady_clock::now();
     
+    if (cacheWriter_ && options_.patchFrom.empty()) {
+        cacheWriter_->append(data, length);
+    }
+    
     // Feed to decompressor
     if (!decoder_->feedCompressedData(data, length)) {
         fail("Decompression failed: " + decoder_->getError());
@@ -229,6 +396,9 @@ void SliceImportEngine::handleDownloadComplete(const std::string& errorMessage)
         return;
     }
     
+    // The download is a complete, well-formed slice; cache it even if the database work below fails
+    storeInSliceCache();
+    
     // Flush final batch
     std::string error;
     if (currentBatch_.totalRows > 0) {
@@ -243,13 +413,15 @@ void SliceImportEngine::handleDownloadComplete(const std::string& errorMessage)
         fail("Failed to commit transaction: " + error);
         return;
     }
+    notifyCommitted();
     
     platform::logInfo("Import completed successfully. Total rows: " + std::to_string(totalRowsInserted_));
     auto importEnd = std::chrono::steady_clock::now();
     uint64_t totalMs = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(importEnd - importStart_).count();
     platform::logInfo("Import timing: total=" + std::to_string(totalMs) + "ms, parse=" +
                       std::to_string(totalParseMs_) + "ms, flush=" + std::to_string(totalFlushMs_) +
-                      "ms, flushes=" + std::to_string(flushCount_));
+                      "ms, flushes=" + std::to_string(flushCount_) +
+                      ", batchArenaPeak=" + std::to_string(currentBatch_.arenaHighWaterMark() / 1024) + "KB");
 #ifdef SLICE_IMPORT_PROFILE_DECODER
     if (decoder_) {
         logDecoderProfile(decoder_->profile());
@@ -273,8 +445,11 @@ void SliceImportEngine::parseDecompressedData() {
                 verboseInfo("Parsed slice header: id=" + header.sliceId + 
                                 ", version=" + std::to_string(header.version) +
                                 ", priority=" + header.priority +
-                                ", tables=" + std::to_string(header.numberOfTables));
+                                ", tables=" + std::to_string(header.numberOfTables) +
+                                (header.isDelta() ? ", delta" : ""));
                 headerParsed_ = true;
+                currentBatch_.delta = header.isDelta();
+                headerCacheKey_ = SliceCache::keyForSlice(header.sliceId, header.version);
                 parseTables();
                 break;
                 
@@ -312,6 +487,9 @@ void SliceImportEngine::parseTables() {
         } else if (rowStatus == ParseStatus::EndOfTable) {
             // Table finished, clear state
             parsingTable_ = false;
+            if (!finishTable(currentTableHeader_)) {
+                return;
+            }
             // Fall through to parse next table
         }
     }
@@ -330,6 +508,10 @@ void SliceImportEngine::parseTables() {
                 verboseDebug("Parsing table: " + tableHeader.tableName + 
                                  " with " + std::to_string(tableHeader.columns.size()) + " columns");
                 
+                if (!beginTable(tableHeader)) {
+                    return;
+                }
+                
                 // Parse rows
                 ParseStatus rowStatus = parseRowsForTable(tableHeader);
                 
@@ -339,6 +521,9 @@ void SliceImportEngine::parseTables() {
                     return;
                 } else if (rowStatus == ParseStatus::EndOfTable) {
                     parsingTable_ = false;
+                    if (!finishTable(tableHeader)) {
+                        return;
+                    }
                     continue; // Next table
                 }
                 break;
@@ -372,9 +557,16 @@ ParseStatus SliceImportEngine::parseRowsForTable(const TableHeader& tableHeader)
     std::vector<FieldValue> rowValues;
     rowValues.reserve(tableHeader.columns.size());
     
+    const SliceTableProjection& projection = currentProjection_;
+    const std::vector<std::string>& insertColumns = projection.keep.empty() ? tableHeader.columns : projection.columns;
+    const bool delta = decoder_->isDeltaSlice();
+    DeltaOp op = DeltaOp::UPSERT;
+    
     while (true) {
         size_t remainingBefore = decoder_->remainingBytes();
-        ParseStatus status = decoder_->parseRowValues(tableHeader.columns, rowValues);
+        ParseStatus status = delta
+            ? decoder_->parseDeltaRow(tableHeader.columns, projection.keep, op, rowValues)
+            : decoder_->parseRowValues(tableHeader.columns, projection.keep, rowValues);
         
         switch (status) {
             case ParseStatus::Ok: {
@@ -384,8 +576,16 @@ ParseStatus SliceImportEngine::parseRowsForTable(const TableHeader& tableHeader)
                     return ParseStatus::Error;
                 }
                 
+                if (projection.skipTable) {
+                    break;
+                }
+                
                 // Add to batch
-                currentBatch_.addRow(tableHeader.tableName, tableHeader.columns, rowValues);
+                if (op == DeltaOp::DELETE) {
+                    currentBatch_.addDelete(tableHeader.tableId, rowValues[0]);
+                } else {
+                    currentBatch_.addRow(tableHeader.tableId, insertColumns, rowValues);
+                }
                 rowCount++;
                 
                 // Flush if batch full
@@ -423,6 +623,101 @@ ParseStatus SliceImportEngine::parseRowsForTable(const TableHeader& tableHeader)
     }
 }
 
+bool SliceImportEngine::beginTable(const TableHeader& tableHeader) {
+    if (!projectTable(tableHeader)) {
+        return false;
+    }
+    if (currentProjection_.skipTable) {
+        verboseInfo("Skipping table " + tableHeader.tableName + " (projected away)");
+        return true;
+    }
+    
+    if (options_.commitMode == SliceCommitMode::PriorityGroups) {
+        size_t group = options_.priorityGroupOf(tableHeader.tableName);
+        if (group != currentPriorityGroup_ && !uncommittedTables_.empty()) {
+            std::string error;
+            if (!commitCheckpoint(error)) {
+                fail("Failed to commit priority group: " + error);
+                return false;
+            }
+        }
+        currentPriorityGroup_ = group;
+    }
+
+    {
+        std::string error;
+        const auto& columns = currentProjection_.columns.empty() ? tableHeader.columns : currentProjection_.columns;
+        if (!db_->declareTable(tableHeader.tableName, columns, error)) {
+            fail("Failed to declare table " + tableHeader.tableName + ": " + error);
+            return false;
+        }
+    }
+    
+    if (options_.bulkLoad) {
+        std::string error;
+        if (!db_->beginTableLoad(tableHeader.tableName, error)) {
+            fail("Failed to prepare bulk load of " + tableHeader.tableName + ": " + error);
+            return false;
+        }
+    }
+    
+    uncommittedTables_.push_back(tableHeader.tableName);
+    return true;
+}
+
+bool SliceImportEngine::projectTable(const TableHeader& tableHeader) {
+    if (!options_.hasProjection()) {
+        currentProjection_ = SliceTableProjection();
+        return true;
+    }
+    
+    const std::vector<std::string>* localColumns = nullptr;
+    if (options_.projectToLocalSchema) {
+        auto it = localSchemaColumns_.find(tableHeader.tableName);
+        if (it == localSchemaColumns_.end()) {
+            std::vector<std::string> columns;
+            std::string error;
+            if (!db_->getTableColumns(tableHeader.tableName, columns, error)) {
+                fail("Failed to read local schema of " + tableHeader.tableName + ": " + error);
+                return false;
+            }
+            it = localSchemaColumns_.emplace(tableHeader.tableName, std::move(columns)).first;
+        }
+        localColumns = &it->second;
+    }
+    currentProjection_ = options_.projectionFor(tableHeader.tableName, tableHeader.columns, localColumns);
+    return true;
+}
+
+bool SliceImportEngine::finishTable(const TableHeader& tableHeader) {
+    if (currentProjection_.skipTable) {
+        return true;
+    }
+    
+    std::string error;
+    if (options_.bulkLoad) {
+        // Rows still sitting in the batch must land before the table's indexes are rebuilt
+        if (!flushBatch(error)) {
+            fail("Failed to flush batch: " + error);
+            return false;
+        }
+        if (!db_->endTableLoad(tableHeader.tableName, error)) {
+            fail("Failed to finish bulk load of " + tableHeader.tableName + ": " + error);
+            return false;
+        }
+    }
+    
+    if (options_.commitMode != SliceCommitMode::PerTable) {
+        return true;
+    }
+    
+    if (!commitCheckpoint(error)) {
+        fail("Failed to commit table " + tableHeader.tableName + ": " + error);
+        return false;
+    }
+    return true;
+}
+
 bool SliceImportEngine::flushBatch(std::string& errorMessage) {
     if (currentBatch_.totalRows == 0 || failed_) {
         return true;
@@ -437,6 +732,9 @@ bool SliceImportEngine::flushBatch(std::string& errorMessage) {
     auto flushEnd = std::chrono::steady_clock::now();
     totalFlushMs_ += (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(flushEnd - flushStart).count();
     flushCount_++;
+    if (currentBatch_.delta) {
+        recordDeltaChanges(currentBatch_);
+    }
     
     // Update counters
     size_t batchRowCount = currentBatch_.totalRows;
@@ -468,6 +766,45 @@ bool SliceImportEngine::flushBatch(std::string& errorMessage) {
     return true;
 }
 
+void SliceImportEngine::recordDeltaChanges(const BatchData& batch) {
+    for (const auto& tableEntry : batch.tables) {
+        auto columnsIt = batch.tableColumns.find(tableEntry.first);
+        if (columnsIt == batch.tableColumns.end()) {
+            continue;
+        }
+        const auto& columns = columnsIt->second;
+        auto idIt = std::find(columns.begin(), columns.end(), "id");
+        if (idIt == columns.end()) {
+            continue;
+        }
+        const size_t idIndex = static_cast<size_t>(idIt - columns.begin());
+        auto& upserted = pendingChangeset_[identifierName(tableEntry.first)].upserted;
+        const RowSet& rows = tableEntry.second;
+        for (size_t i = 0; i < rows.size(); i++) {
+            const FieldValue& id = rows[i][idIndex];
+            if (id.type() == FieldValue::Type::TEXT_VALUE) {
+                upserted.emplace_back(id.text());
+            }
+        }
+    }
+    for (const auto& deleteEntry : batch.deletes) {
+        auto& deleted = pendingChangeset_[identifierName(deleteEntry.first)].deleted;
+        const RowSet& rows = deleteEntry.second;
+        for (size_t i = 0; i < rows.size(); i++) {
+            const FieldValue& id = rows[i][0];
+            if (id.type() == FieldValue::Type::TEXT_VALUE) {
+                deleted.emplace_back(id.text());
+            }
+        }
+    }
+}
+
+SyncChangeset SliceImportEngine::takeCommittedChangeset() {
+    SyncChangeset changeset;
+    changeset.swap(committedChangeset_);
+    return changeset;
+}
+
 bool SliceImportEngine::beginImportTransaction(std::string& errorMessage) {
     if (!db_) {
         errorMessage = "Database interface is null";
@@ -509,11 +846,47 @@ bool SliceImportEngine::commitImportTransaction(std::string& errorMessage) {
     }
     
     transactionStarted_ = false;
+    for (auto& tableEntry : pendingChangeset_) {
+        auto& committed = committedChangeset_[tableEntry.first];
+        committed.upserted.insert(committed.upserted.end(), tableEntry.second.upserted.begin(),
+                                  tableEntry.second.upserted.end());
+        committed.deleted.insert(committed.deleted.end(), tableEntry.second.deleted.begin(),
+                                 tableEntry.second.deleted.end());
+    }
+    pendingChangeset_.clear();
     
     platform::logInfo("Import transaction committed (" + std::to_string(totalRowsInserted_) + " rows)");
     return true;
 }
 
+// Makes everything imported so far visible and continues in a fresh transaction
+bool SliceImportEngine::commitCheckpoint(std::string& errorMessage) {
+    if (!flushBatch(errorMessage)) {
+        return false;
+    }
+    
+    if (!commitImportTransaction(errorMessage)) {
+        return false;
+    }
+    notifyCommitted();
+    
+    return beginImportTransaction(errorMessage);
+}
+
+void SliceImportEngine::notifyCommitted() {
+    if (uncommittedTables_.empty()) {
+        return;
+    }
+    
+    verboseInfo("Committed " + std::to_string(uncommittedTables_.size()) + " table(s), " +
+                std::to_string(totalRowsInserted_) + " rows so far");
+    
+    if (commitCallback_) {
+        commitCallback_(uncommittedTables_, totalRowsInserted_);
+    }
+    uncommittedTables_.clear();
+}
+
 void SliceImportEngine::rollbackImportTransaction() {
     if (!db_ || !transactionStarted_) {
         return;
@@ -523,6 +896,7 @@ void SliceImportEngine::rollbackImportTransaction() {
     
     db_->rollbackTransaction();
     transactionStarted_ = false;
+    pendingChangeset_.clear();
 }
 
 void SliceImportEngine::handleMemoryPressure(platform::MemoryAlertLevel level) {
@@ -604,6 +978,9 @@ void SliceImportEngine::complete(const std::string& errorMessage) {
         decoder_.reset();
     }
     
+    // Drops the partial cache file of a failed or cancelled download
+    cacheWriter_.reset();
+    
     // Call completion callback
     if (completionCallback_) {
         completionCallback_(errorMessage);
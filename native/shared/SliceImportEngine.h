@@ -1,7 +1,11 @@
 #pragma once
 
+#include "SliceArena.h"
+#include "SliceCache.h"
 #include "SliceDecoder.h"
+#include "SliceImportOptions.h"
 #include "SlicePlatform.h"
+#include "SyncApplyEngine.h"
 #include <functional>
 #include <string>
 #include <unordered_map>
@@ -16,26 +20,95 @@ class SliceImportEngine;
 struct BatchData;
 
 // Batch structure for accumulated rows
+//
+// Rows and their TEXT/BLOB bytes are allocated from the batch's SliceArena, which clear() rewinds
+// in O(1) and keeps for the next batch. Copies of a batch own their rows (see RowSet).
+// Tables are keyed by their interned name (identifierName() gives it back).
 struct BatchData {
-    std::unordered_map<std::string, std::vector<std::vector<FieldValue>>> tables;
-    std::unordered_map<std::string, std::vector<std::string>> tableColumns;
+    std::unordered_map<Identifier, RowSet> tables;
+    std::unordered_map<Identifier, std::vector<std::string>> tableColumns;
+    // Delta slices only: table -> {id} rows to delete
+    std::unordered_map<Identifier, RowSet> deletes;
     size_t totalRows = 0;
+    // Rows of a delta slice are upserts (see SLICE_FLAG_DELTA). Set once per import; clear() keeps it.
+    // A delta carries at most one op per record, so upserts are applied before deletes per table.
+    bool delta = false;
+    // Insert each table's rows in id order (SliceImportOptions::sortById). Set once per import.
+    bool sortById = false;
+
+    BatchData() = default;
+    BatchData(const BatchData& other)
+        : tables(other.tables)
+        , tableColumns(other.tableColumns)
+        , deletes(other.deletes)
+        , totalRows(other.totalRows)
+        , delta(other.delta)
+        , sortById(other.sortById) {}
+    BatchData& operator=(const BatchData& other) {
+        if (this != &other) {
+            clear();
+            tables = other.tables;
+            tableColumns = other.tableColumns;
+            deletes = other.deletes;
+            totalRows = other.totalRows;
+            delta = other.delta;
+            sortById = other.sortById;
+        }
+        return *this;
+    }
+    BatchData(BatchData&&) = default;
+    BatchData& operator=(BatchData&&) = default;
     
     void clear() {
         tables.clear();
         tableColumns.clear();
+        deletes.clear();
         totalRows = 0;
+        if (arena_) {
+            arena_->reset();
+        }
     }
     
-    void addRow(const std::string& tableName, 
+    void addRow(Identifier table,
+                const std::vector<std::string>& columns,
+                const std::vector<FieldValue>& row) {
+        auto it = tables.find(table);
+        if (it == tables.end()) {
+            it = tables.emplace(table, RowSet(&arena())).first;
+            tableColumns.emplace(table, columns);
+        }
+        it->second.append(row);
+        totalRows++;
+    }
+    void addRow(const std::string& tableName,
                 const std::vector<std::string>& columns,
                 const std::vector<FieldValue>& row) {
-        tables[tableName].push_back(row);
-        if (tableColumns.find(tableName) == tableColumns.end()) {
-            tableColumns[tableName] = columns;
+        addRow(internIdentifier(tableName), columns, row);
+    }
+    
+    void addDelete(Identifier table, const FieldValue& id) {
+        auto it = deletes.find(table);
+        if (it == deletes.end()) {
+            it = deletes.emplace(table, RowSet(&arena())).first;
         }
+        it->second.append(&id, 1);
         totalRows++;
     }
+    void addDelete(const std::string& tableName, const FieldValue& id) {
+        addDelete(internIdentifier(tableName), id);
+    }
+
+    // Heap-allocated so that RowSets keep a stable pointer when the batch is moved
+    SliceArena& arena() {
+        if (!arena_) {
+            arena_ = std::make_unique<SliceArena>();
+        }
+        return *arena_;
+    }
+    size_t arenaHighWaterMark() const { return arena_ ? arena_->highWaterMark() : 0; }
+
+private:
+    std::unique_ptr<SliceArena> arena_;
 };
 
 // Database interface - platform implements this
@@ -57,7 +130,7 @@ public:
     virtual bool insertRows(
         const std::string& tableName,
         const std::vector<std::string>& columns,
-        const std::vector<std::vector<FieldValue>>& rows,
+        const RowSet& rows,
         std::string& errorMessage
     ) = 0;
     
@@ -72,19 +145,66 @@ public:
     
     // Release savepoint
     virtual bool releaseSavepoint(std::string& errorMessage) = 0;
+
+    // Bulk-load hooks (SliceImportOptions::bulkLoad). beginTableLoad is called before the first row
+    // of a table section, endTableLoad once all of its rows have been inserted. Implementations may
+    // defer index maintenance in between. Default: no-op.
+    virtual bool beginTableLoad(const std::string& tableName, std::string& errorMessage) {
+        (void)tableName;
+        (void)errorMessage;
+        return true;
+    }
+    virtual bool endTableLoad(const std::string& tableName, std::string& errorMessage) {
+        (void)tableName;
+        (void)errorMessage;
+        return true;
+    }
+
+    // Called before the first row of every table section that gets imported, with the columns that
+    // will be bound (after projection). Databases that build their schema from the slice create the
+    // table here (see SliceReferenceDatabase). Default: no-op.
+    virtual bool declareTable(const std::string& tableName,
+                              const std::vector<std::string>& columns,
+                              std::string& errorMessage) {
+        (void)tableName;
+        (void)columns;
+        (void)errorMessage;
+        return true;
+    }
+
+    // Column names of `tableName` in the local schema, empty if the table doesn't exist
+    // (SliceImportOptions::projectToLocalSchema). Default: not supported.
+    virtual bool getTableColumns(const std::string& tableName,
+                                 std::vector<std::string>& columns,
+                                 std::string& errorMessage) {
+        (void)tableName;
+        (void)columns;
+        errorMessage = "Local schema lookup is not supported by this database";
+        return false;
+    }
 };
 
 // Main slice import orchestration engine
 class SliceImportEngine : public std::enable_shared_from_this<SliceImportEngine> {
 public:
+    // Called after every commit with the tables that commit made visible and the total row count so far
+    using CommitCallback = std::function<void(const std::vector<std::string>& tables, size_t totalRowsCommitted)>;
+
     // Constructor
     // db: Platform-specific database interface
-    explicit SliceImportEngine(std::shared_ptr<DatabaseInterface> db);
+    // options: commit mode etc. (see SliceImportOptions.h for rollback semantics)
+    explicit SliceImportEngine(std::shared_ptr<DatabaseInterface> db,
+                               SliceImportOptions options = SliceImportOptions());
     
     // Destructor
     ~SliceImportEngine();
     
     // Start import from URL
+    // Local slices ("file://..." or an absolute path) are memory-mapped and fed to zstd in place
+    // on the work queue instead of going through platform::downloadFile. With
+    // SliceImportOptions::cache, a slice cache hit is imported the same way, and a miss is teed
+    // into the cache while it downloads. With SliceImportOptions::patchFrom the download (or local
+    // file) is a patch that the decoder applies to the cached reference slice on the fly.
     // completion: called with empty string on success, error message on failure
     void startImport(
         const std::string& url,
@@ -93,11 +213,19 @@ public:
     
     // Cancel ongoing import
     void cancel();
+
+    // Set callback invoked after each commit (must be set before startImport)
+    void setCommitCallback(CommitCallback callback) { commitCallback_ = std::move(callback); }
     
     // Get current state
     bool isImporting() const { return importing_; }
     bool hasFailed() const { return failed_; }
     
+    // Delta slices: the ids of the records upserted or deleted by everything committed so far, per
+    // table (empty for plain slices). Rows an upsert left alone because of local changes are
+    // included. Call from the completion callback; resets the changeset.
+    SyncChangeset takeCommittedChangeset();
+
     // Get statistics
     size_t getTotalRowsInserted() const { return totalRowsInserted_; }
     size_t getBatchSize() const { return batchSize_; }
@@ -105,6 +233,9 @@ public:
 private:
     // Platform database interface
     std::shared_ptr<DatabaseInterface> db_;
+
+    // Import options
+    SliceImportOptions options_;
     
     // Decoder
     std::unique_ptr<SliceDecoder> decoder_;
@@ -112,6 +243,11 @@ private:
     // Download handle
     std::shared_ptr<platform::DownloadHandle> downloadHandle_;
     
+    // Slice cache (SliceImportOptions::cache); the writer is set while a download is being cached
+    std::unique_ptr<SliceCache> cache_;
+    std::unique_ptr<SliceCacheWriter> cacheWriter_;
+    std::string headerCacheKey_;
+
     // Memory pressure handle
     std::shared_ptr<platform::MemoryAlertHandle> memoryAlertHandle_;
     
@@ -124,6 +260,9 @@ private:
     // Current table being parsed
     bool parsingTable_;
     TableHeader currentTableHeader_;
+    SliceTableProjection currentProjection_;
+    // projectToLocalSchema: local columns per table, looked up once per import
+    std::unordered_map<std::string, std::vector<std::string>> localSchemaColumns_;
     
     // Batching
     BatchData currentBatch_;
@@ -134,6 +273,16 @@ private:
     size_t totalRowsInserted_;
     size_t rowsSinceSavepoint_;
 
+    // Progressive commits: tables written since the last commit, and the priority group they belong to
+    std::vector<std::string> uncommittedTables_;
+    size_t currentPriorityGroup_;
+    CommitCallback commitCallback_;
+
+    // Delta slices: ids written since the last commit, moved to committedChangeset_ on commit and
+    // dropped on rollback
+    SyncChangeset pendingChangeset_;
+    SyncChangeset committedChangeset_;
+
     // Timing (milliseconds)
     std::chrono::steady_clock::time_point importStart_;
     uint64_t totalParseMs_;
@@ -147,17 +296,30 @@ private:
     std::function<void(const std::string&)> completionCallback_;
     
     // Internal handlers
+    void startLocalImport(const std::string& path);
+    bool ensureSliceCache();
+    std::string prepareSliceCache();
+    // SliceImportOptions::patchFrom: loads the reference slice into the decoder (fails the import
+    // if it isn't cached)
+    bool preparePatchReference();
+    void storeInSliceCache();
     void handleDataChunk(const uint8_t* data, size_t length);
     void handleDownloadComplete(const std::string& errorMessage);
     void parseDecompressedData();
     void parseTables();
     ParseStatus parseRowsForTable(const TableHeader& tableHeader);
+    bool beginTable(const TableHeader& tableHeader);
+    bool projectTable(const TableHeader& tableHeader);
+    bool finishTable(const TableHeader& tableHeader);
     
     // Database operations
     bool flushBatch(std::string& errorMessage);
+    void recordDeltaChanges(const BatchData& batch);
     bool beginImportTransaction(std::string& errorMessage);
     bool commitImportTransaction(std::string& errorMessage);
     void rollbackImportTransaction();
+    bool commitCheckpoint(std::string& errorMessage);
+    void notifyCommitted();
     
     // Memory management
     void handleMemoryPressure(platform::MemoryAlertLevel level);
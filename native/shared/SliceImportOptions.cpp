@@ -0,0 +1,275 @@
+#include "SliceImportOptions.h"
+#include "JsonUtils.h"
+
+#include <algorithm>
+
+#if __has_include(<simdjson.h>)
+#include <simdjson.h>
+#elif __has_include("simdjson.h")
+#include "simdjson.h"
+#else
+#error "simdjson headers not found. Please add @nozbe/simdjson or provide simdjson headers."
+#endif
+
+namespace watermelondb {
+
+size_t SliceImportOptions::priorityGroupOf(const std::string& tableName) const {
+    for (size_t i = 0; i < priorityGroups.size(); i++) {
+        for (const auto& name : priorityGroups[i]) {
+            if (name == tableName) {
+                return i;
+            }
+        }
+    }
+    return priorityGroups.size();
+}
+
+SliceTableProjection SliceImportOptions::projectionFor(
+    const std::string& tableName,
+    const std::vector<std::string>& sliceColumns,
+    const std::vector<std::string>* localColumns
+) const {
+    SliceTableProjection projection;
+    if (std::find(skipTables.begin(), skipTables.end(), tableName) != skipTables.end() ||
+        (localColumns && localColumns->empty())) {
+        // All-false rather than empty (= keep everything), so the decoder steps over every field
+        projection.skipTable = true;
+        projection.keep.assign(sliceColumns.size(), false);
+        return projection;
+    }
+
+    auto allowlist = columnAllowlist.find(tableName);
+    if (allowlist == columnAllowlist.end() && !localColumns) {
+        return projection;
+    }
+
+    projection.keep.reserve(sliceColumns.size());
+    for (const auto& column : sliceColumns) {
+        bool keep = (allowlist == columnAllowlist.end() ||
+                     std::find(allowlist->second.begin(), allowlist->second.end(), column) != allowlist->second.end()) &&
+                    (!localColumns ||
+                     std::find(localColumns->begin(), localColumns->end(), column) != localColumns->end());
+        projection.keep.push_back(keep);
+        if (keep) {
+            projection.columns.push_back(column);
+        }
+    }
+    if (projection.columns.empty()) {
+        projection.skipTable = true;
+    } else if (projection.columns.size() == sliceColumns.size()) {
+        // Nothing projected away: take the decoder's fast path
+        projection.keep.clear();
+        projection.columns.clear();
+    }
+    return projection;
+}
+
+bool parseSliceImportOptions(const std::string& json, SliceImportOptions& options, std::string& errorMessage) {
+    options = SliceImportOptions();
+    if (json.empty()) {
+        return true;
+    }
+
+    simdjson::dom::parser parser;
+    simdjson::dom::element doc;
+    if (parser.parse(json).get(doc)) {
+        errorMessage = "Invalid slice import options: malformed JSON";
+        return false;
+    }
+    simdjson::dom::object root;
+    if (doc.get(root)) {
+        errorMessage = "Invalid slice import options: expected an object";
+        return false;
+    }
+
+    std::string_view commitMode;
+    if (!root["commitMode"].get(commitMode)) {
+        if (commitMode == "atomic") {
+            options.commitMode = SliceCommitMode::Atomic;
+        } else if (commitMode == "table") {
+            options.commitMode = SliceCommitMode::PerTable;
+        } else if (commitMode == "priorityGroups") {
+            options.commitMode = SliceCommitMode::PriorityGroups;
+        } else {
+            errorMessage = "Invalid slice import options: unknown commitMode '" + std::string(commitMode) + "'";
+            return false;
+        }
+    }
+
+    bool bootstrap = false;
+    if (!root["bootstrap"].get(bootstrap) && bootstrap) {
+        if (options.commitMode != SliceCommitMode::Atomic) {
+            errorMessage = "Invalid slice import options: bootstrap imports are always atomic";
+            return false;
+        }
+        options.bootstrap = true;
+        options.bulkLoad = true;
+    }
+
+    bool bulkLoad = false;
+    if (!root["bulkLoad"].get(bulkLoad)) {
+        options.bulkLoad = bulkLoad;
+    }
+
+    bool sortById = false;
+    if (!root["sortById"].get(sortById)) {
+        options.sortById = sortById;
+    }
+
+    bool cache = false;
+    if (!root["cache"].get(cache)) {
+        options.cache = cache;
+    }
+
+    std::string_view cacheKey;
+    if (!root["cacheKey"].get(cacheKey) && !cacheKey.empty()) {
+        options.cacheKey = std::string(cacheKey);
+        options.cache = true;
+    }
+
+    std::string_view patchFrom;
+    if (!root["patchFrom"].get(patchFrom) && !patchFrom.empty()) {
+        options.patchFrom = std::string(patchFrom);
+        options.cache = true;
+    }
+
+    if (root["cacheMaxBytes"].error() != simdjson::NO_SUCH_FIELD) {
+        uint64_t cacheMaxBytes = 0;
+        if (root["cacheMaxBytes"].get(cacheMaxBytes) || cacheMaxBytes == 0) {
+            errorMessage = "Invalid slice import options: cacheMaxBytes must be a positive integer";
+            return false;
+        }
+        options.cacheMaxBytes = cacheMaxBytes;
+    }
+
+    simdjson::dom::array skipTables;
+    if (!root["skipTables"].get(skipTables)) {
+        for (simdjson::dom::element tableElement : skipTables) {
+            std::string_view tableName;
+            if (tableElement.get(tableName)) {
+                errorMessage = "Invalid slice import options: skipTables must contain table names";
+                return false;
+            }
+            options.skipTables.emplace_back(tableName);
+        }
+    }
+
+    simdjson::dom::object columns;
+    if (!root["columns"].get(columns)) {
+        for (auto field : columns) {
+            simdjson::dom::array columnArray;
+            if (field.value.get(columnArray)) {
+                errorMessage = "Invalid slice import options: columns must map table names to arrays";
+                return false;
+            }
+            std::vector<std::string> allowed;
+            for (simdjson::dom::element columnElement : columnArray) {
+                std::string_view columnName;
+                if (columnElement.get(columnName)) {
+                    errorMessage = "Invalid slice import options: columns must contain column names";
+                    return false;
+                }
+                allowed.emplace_back(columnName);
+            }
+            options.columnAllowlist[std::string(field.key)] = std::move(allowed);
+        }
+    }
+
+    bool projectToLocalSchema = false;
+    if (!root["projectToLocalSchema"].get(projectToLocalSchema)) {
+        options.projectToLocalSchema = projectToLocalSchema;
+    }
+
+    std::string_view referencePath;
+    if (!root["referencePath"].get(referencePath) && !referencePath.empty()) {
+        if (options.commitMode != SliceCommitMode::Atomic) {
+            errorMessage = "Invalid slice import options: reference imports are always atomic";
+            return false;
+        }
+        if (options.bootstrap || options.projectToLocalSchema) {
+            errorMessage = "Invalid slice import options: referencePath can't be combined with bootstrap or projectToLocalSchema";
+            return false;
+        }
+        options.referencePath = std::string(referencePath);
+    }
+
+    simdjson::dom::object referenceIndexes;
+    if (!root["referenceIndexes"].get(referenceIndexes)) {
+        if (options.referencePath.empty()) {
+            errorMessage = "Invalid slice import options: referenceIndexes requires referencePath";
+            return false;
+        }
+        for (auto field : referenceIndexes) {
+            simdjson::dom::array indexArray;
+            if (field.value.get(indexArray)) {
+                errorMessage = "Invalid slice import options: referenceIndexes must map table names to arrays of column lists";
+                return false;
+            }
+            std::vector<std::vector<std::string>> indexes;
+            for (simdjson::dom::element indexElement : indexArray) {
+                simdjson::dom::array columnArray;
+                if (indexElement.get(columnArray) || columnArray.size() == 0) {
+                    errorMessage = "Invalid slice import options: referenceIndexes must map table names to arrays of column lists";
+                    return false;
+                }
+                std::vector<std::string> indexColumns;
+                for (simdjson::dom::element columnElement : columnArray) {
+                    std::string_view columnName;
+                    if (columnElement.get(columnName)) {
+                        errorMessage = "Invalid slice import options: referenceIndexes must contain column names";
+                        return false;
+                    }
+                    indexColumns.emplace_back(columnName);
+                }
+                indexes.push_back(std::move(indexColumns));
+            }
+            options.referenceIndexes[std::string(field.key)] = std::move(indexes);
+        }
+    }
+
+    simdjson::dom::array groups;
+    if (!root["priorityGroups"].get(groups)) {
+        for (simdjson::dom::element groupElement : groups) {
+            simdjson::dom::array group;
+            if (groupElement.get(group)) {
+                errorMessage = "Invalid slice import options: priorityGroups must be an array of arrays";
+                return false;
+            }
+            std::vector<std::string> tables;
+            for (simdjson::dom::element tableElement : group) {
+                std::string_view tableName;
+                if (tableElement.get(tableName)) {
+                    errorMessage = "Invalid slice import options: priorityGroups must contain table names";
+                    return false;
+                }
+                tables.emplace_back(tableName);
+            }
+            options.priorityGroups.push_back(std::move(tables));
+        }
+    }
+
+    return true;
+}
+
+std::string sliceCommitEventJson(const std::vector<std::string>& tables, size_t rowsCommitted) {
+    std::string out = "{\"type\":\"slice_commit\",\"tables\":[";
+    for (size_t i = 0; i < tables.size(); i++) {
+        if (i > 0) out += ",";
+        out += "\"" + json_utils::escapeJsonString(tables[i]) + "\"";
+    }
+    out += "],\"rowsCommitted\":" + std::to_string(rowsCommitted) + "}";
+    return out;
+}
+
+std::string sliceImportResultJson(const SyncChangeset& changeset, const std::string& errorMessage) {
+    std::string out = "{\"changeset\":" + serializeChangeset(changeset) + ",\"error\":";
+    if (errorMessage.empty()) {
+        out += "null";
+    } else {
+        out += "\"" + json_utils::escapeJsonString(errorMessage) + "\"";
+    }
+    out += "}";
+    return out;
+}
+
+} // namespace watermelondb
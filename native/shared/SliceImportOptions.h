@@ -0,0 +1,121 @@
+#pragma once
+
+#include "SyncApplyEngine.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace watermelondb {
+
+// How often a slice import commits while the slice is still streaming in.
+//
+// Rollback semantics per mode:
+// - Atomic: one transaction from the first row to the last. Any failure (download, decode, insert,
+//   cancel) rolls back the whole slice, so the database is either untouched or fully imported.
+// - PerTable: a commit after every table section. A failure rolls back only the table that was
+//   being streamed; tables committed before it stay in the database. Rows are inserted with
+//   INSERT OR IGNORE, so re-running the same slice fills in what is missing.
+// - PriorityGroups: a commit whenever the next table belongs to a different priority group (and at
+//   the end). A failure rolls back only the group in flight; earlier groups stay committed.
+enum class SliceCommitMode {
+    Atomic,
+    PerTable,
+    PriorityGroups
+};
+
+// Which fields of a table section are decoded and inserted (see SliceImportOptions::projectionFor)
+struct SliceTableProjection {
+    bool skipTable = false;
+    // One flag per slice column; empty means every column is kept. All false for skipped tables.
+    std::vector<bool> keep;
+    // Kept column names in slice order, i.e. what gets bound on insert (only set when keep is)
+    std::vector<std::string> columns;
+};
+
+struct SliceImportOptions {
+    SliceCommitMode commitMode = SliceCommitMode::Atomic;
+
+    // Ordered table groups for SliceCommitMode::PriorityGroups, e.g. [["users", "projects"], ["history"]].
+    // Tables that are not listed belong to an implicit trailing group.
+    std::vector<std::vector<std::string>> priorityGroups;
+
+    // Drop non-unique secondary indexes of tables that start out empty while they are loaded and
+    // rebuild them afterwards (see SqliteInsertHelper::deferIndexes). Big win on fresh installs.
+    bool bulkLoad = false;
+
+    // Experimental. Insert each batch's rows in id order rather than slice order (see
+    // SqliteInsertHelper::sortRowsById), so the inserts of one batch land on neighbouring leaves of
+    // the primary key index. Only batches are sorted, not the whole slice, and
+    // sqlite_insert_helper_benchmarks shows no difference beyond noise with random ids.
+    bool sortById = false;
+
+    // Import into a side database file and copy it over the live database at the end, instead of
+    // writing through the live connection (see SliceBootstrapDatabase). Meant for first installs.
+    // Always atomic; implies bulkLoad unless bulkLoad is explicitly false.
+    bool bootstrap = false;
+
+    // Keep the compressed slice in the on-disk slice cache (see SliceCache) and import from there
+    // when the same slice is requested again. cacheKey identifies the slice: the ETag the caller got
+    // for it, or "<sliceId>@<version>". Without a cacheKey there is no lookup, and the download is
+    // stored under "<sliceId>@<version>" from its header. A cacheKey implies cache.
+    bool cache = false;
+    std::string cacheKey;
+    // Cache size cap in bytes (0 = SliceCache::DEFAULT_MAX_BYTES)
+    uint64_t cacheMaxBytes = 0;
+
+    // The download is a patch (`zstd --patch-from`) against the cached slice with this key, usually
+    // "<sliceId>@<previous version>", instead of a full slice. The reference is decompressed into
+    // memory for the import; the reconstructed slice is cached as a full one, so the next version
+    // can be patched against it. The import fails if the reference isn't cached. Implies cache.
+    std::string patchFrom;
+
+    // Materialize the slice into a standalone database file at this path instead of importing it into
+    // the app database (see SliceReferenceDatabase). Meant for read-only catalogs, which the adapter
+    // then attaches to its connections. referenceIndexes lists the indexes to build on each table,
+    // e.g. {"price_book": [["sku"], ["model_id", "region"]]}. Always atomic; excludes bootstrap and
+    // projectToLocalSchema.
+    std::string referencePath;
+    std::unordered_map<std::string, std::vector<std::vector<std::string>>> referenceIndexes;
+
+    // Projection. Sections of skipTables are decoded past without materializing a single field;
+    // columnAllowlist limits a table to the listed columns (the others are skipped by their size
+    // prefix, never copied). With projectToLocalSchema, columns the local table doesn't have are
+    // dropped as well, and tables that don't exist locally are skipped.
+    std::vector<std::string> skipTables;
+    std::unordered_map<std::string, std::vector<std::string>> columnAllowlist;
+    bool projectToLocalSchema = false;
+
+    bool hasProjection() const {
+        return !skipTables.empty() || !columnAllowlist.empty() || projectToLocalSchema;
+    }
+
+    // localColumns: columns of the local table when projecting to the local schema (empty if the
+    // table doesn't exist locally), nullptr otherwise
+    SliceTableProjection projectionFor(const std::string& tableName,
+                                       const std::vector<std::string>& sliceColumns,
+                                       const std::vector<std::string>* localColumns) const;
+
+    // Returns the index of the group `tableName` belongs to (priorityGroups.size() if unlisted)
+    size_t priorityGroupOf(const std::string& tableName) const;
+};
+
+// Parses options passed from JS, e.g. {"commitMode":"priorityGroups","priorityGroups":[["users"]],"bulkLoad":true}
+// or {"bootstrap":true} or {"cacheKey":"W/\"5f2a\""} or {"patchFrom":"tasks@41"}
+// or {"referencePath":"/data/catalog.db","referenceIndexes":{"price_book":[["sku"]]}}
+// or {"skipTables":["audit_log"],"columns":{"tasks":["id","title"]},"projectToLocalSchema":true}
+// Unknown keys are ignored. Returns false (and sets errorMessage) on malformed JSON or invalid values.
+bool parseSliceImportOptions(const std::string& json, SliceImportOptions& options, std::string& errorMessage);
+
+// Sync event emitted after every intermediate commit, e.g.
+// {"type":"slice_commit","tables":["users","projects"],"rowsCommitted":1200}
+std::string sliceCommitEventJson(const std::vector<std::string>& tables, size_t rowsCommitted);
+
+// What importRemoteSlice resolves once the import engine has run, whether it succeeded or not:
+// {"changeset":{"tasks":{"upserted":["t1"],"deleted":["t2"]}},"error":null}. The changeset lists the
+// records a delta slice committed (see SliceImportEngine::takeCommittedChangeset) so JS can refresh
+// them, the error is null on success. Same envelope as syncDatabaseAsync.
+std::string sliceImportResultJson(const SyncChangeset& changeset, const std::string& errorMessage);
+
+} // namespace watermelondb
@@ -0,0 +1,99 @@
+#include "SliceLocalFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace watermelondb {
+
+namespace {
+constexpr const char* kFileScheme = "file://";
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+} // namespace
+
+bool isLocalSliceUrl(const std::string& url) {
+    return url.rfind(kFileScheme, 0) == 0 || (!url.empty() && url[0] == '/');
+}
+
+std::string localSlicePath(const std::string& url) {
+    if (url.rfind(kFileScheme, 0) != 0) {
+        return url;
+    }
+    std::string encoded = url.substr(std::strlen(kFileScheme));
+    // file://localhost/path is the same as file:///path
+    if (encoded.rfind("localhost/", 0) == 0) {
+        encoded = encoded.substr(std::strlen("localhost"));
+    }
+    std::string path;
+    path.reserve(encoded.size());
+    for (size_t i = 0; i < encoded.size(); i++) {
+        if (encoded[i] == '%' && i + 2 < encoded.size()) {
+            int hi = hexValue(encoded[i + 1]);
+            int lo = hexValue(encoded[i + 2]);
+            if (hi >= 0 && lo >= 0) {
+                path += static_cast<char>((hi << 4) | lo);
+                i += 2;
+                continue;
+            }
+        }
+        path += encoded[i];
+    }
+    return path;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path, std::string& errorMessage) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        errorMessage = path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        errorMessage = path + ": " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file alive; the descriptor is no longer needed
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        errorMessage = path + ": mmap failed: " + std::strerror(errno);
+        size_ = 0;
+        return false;
+    }
+    // Read once, front to back: let the kernel read ahead aggressively and drop pages behind us
+    madvise(mapped, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const uint8_t*>(mapped);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+} // namespace watermelondb
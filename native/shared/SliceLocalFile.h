@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace watermelondb {
+
+// Slices that are already on disk (bundled seed slices, cached downloads): "file:///abs/path" or "/abs/path"
+bool isLocalSliceUrl(const std::string& url);
+
+// "file:///data/seed%20v2.slice" -> "/data/seed v2.slice"
+std::string localSlicePath(const std::string& url);
+
+// Read-only memory mapping of a whole file, so compressed bytes can be handed to zstd in place
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& errorMessage);
+    void close();
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace watermelondb
@@ -17,6 +17,13 @@ enum class MemoryAlertLevel {
 // Platform-specific initialization
 void initializeWorkQueue();
 
+// Run work asynchronously on the serial queue download callbacks are delivered on
+void runOnWorkQueue(const std::function<void()>& work);
+
+// Directory for the on-disk slice cache (inside the app's cache directory, so the OS may purge it).
+// Empty if not available.
+std::string sliceCacheDirectory();
+
 // Calculate optimal batch size based on device hardware
 unsigned long calculateOptimalBatchSize();
 
@@ -0,0 +1,393 @@
+#include "SliceReferenceDatabase.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace watermelondb {
+
+namespace {
+bool execSql(sqlite3* db, const std::string& sql, std::string& errorMessage) {
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK) {
+        errorMessage = errMsg ? errMsg : sqlite3_errmsg(db);
+        if (errMsg) {
+            sqlite3_free(errMsg);
+        }
+        return false;
+    }
+    return true;
+}
+
+std::string quoteIdentifier(const std::string& name) {
+    std::string out = "\"";
+    for (char c : name) {
+        if (c == '"') {
+            out += "\"\"";
+        } else {
+            out += c;
+        }
+    }
+    out += "\"";
+    return out;
+}
+
+bool isBookkeepingColumn(const std::string& column) {
+    return column == "_status" || column == "_changed";
+}
+
+bool fileExists(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    std::fclose(file);
+    return true;
+}
+
+// Tables of the attached schema `alias`, in creation order
+bool listTables(sqlite3* db, const std::string& alias, std::vector<std::string>& tables, std::string& errorMessage) {
+    const std::string sql = "SELECT name FROM " + quoteIdentifier(alias) +
+                            ".sqlite_master WHERE type = 'table' AND name NOT LIKE 'sqlite_%' ORDER BY rowid";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        errorMessage = sqlite3_errmsg(db);
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        tables.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        errorMessage = sqlite3_errmsg(db);
+        return false;
+    }
+    return true;
+}
+
+// ATTACH and TEMP views count as writes to a query_only connection (the platform reader), so the
+// pragma is lifted while the reference database is being wired up and restored afterwards
+class QueryOnlyLift {
+public:
+    explicit QueryOnlyLift(sqlite3* db) : db_(db) {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db_, "PRAGMA query_only;", -1, &stmt, nullptr) == SQLITE_OK &&
+            sqlite3_step(stmt) == SQLITE_ROW) {
+            queryOnly_ = sqlite3_column_int(stmt, 0) != 0;
+        }
+        sqlite3_finalize(stmt);
+        if (queryOnly_) {
+            std::string ignored;
+            execSql(db_, "PRAGMA query_only=0;", ignored);
+        }
+    }
+
+    ~QueryOnlyLift() {
+        if (queryOnly_) {
+            std::string ignored;
+            execSql(db_, "PRAGMA query_only=1;", ignored);
+        }
+    }
+
+    QueryOnlyLift(const QueryOnlyLift&) = delete;
+    QueryOnlyLift& operator=(const QueryOnlyLift&) = delete;
+
+private:
+    sqlite3* db_;
+    bool queryOnly_ = false;
+};
+
+bool validateAlias(sqlite3* db, const std::string& alias, std::string& errorMessage) {
+    if (alias.empty() || sqlite3_stricmp(alias.c_str(), "main") == 0 || sqlite3_stricmp(alias.c_str(), "temp") == 0) {
+        errorMessage = "Invalid reference database alias '" + alias + "'";
+        return false;
+    }
+    if (!sqlite3_get_autocommit(db)) {
+        errorMessage = "Cannot attach or detach a reference database inside a transaction";
+        return false;
+    }
+    return true;
+}
+
+bool dropViewsAndDetach(sqlite3* db, const std::string& alias, std::string& errorMessage) {
+    std::vector<std::string> tables;
+    if (!listTables(db, alias, tables, errorMessage)) {
+        return false;
+    }
+    std::string sql = "BEGIN;";
+    for (const auto& table : tables) {
+        sql += "DROP VIEW IF EXISTS temp." + quoteIdentifier(table) + ";";
+    }
+    sql += "COMMIT;";
+    if (!execSql(db, sql, errorMessage)) {
+        std::string ignored;
+        execSql(db, "ROLLBACK;", ignored);
+        return false;
+    }
+    if (!execSql(db, "DETACH DATABASE " + quoteIdentifier(alias) + ";", errorMessage)) {
+        errorMessage = "Failed to detach reference database: " + errorMessage;
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+SliceReferenceDatabase::SliceReferenceDatabase(std::string path, IndexSpec indexes)
+    : path_(std::move(path))
+    , partialPath_(path_ + ".partial")
+    , indexes_(std::move(indexes)) {
+}
+
+SliceReferenceDatabase::~SliceReferenceDatabase() {
+    if (db_) {
+        rollbackTransaction();
+    }
+}
+
+bool SliceReferenceDatabase::beginTransaction(std::string& errorMessage) {
+    if (transactionStarted_) {
+        errorMessage = "Transaction already started";
+        return false;
+    }
+    if (path_.empty()) {
+        errorMessage = "Reference import requires a database path";
+        return false;
+    }
+
+    removePartialFiles();
+    declaredTables_.clear();
+    if (sqlite3_open_v2(partialPath_.c_str(), &db_, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        errorMessage = "Failed to create reference database: " +
+                       std::string(db_ ? sqlite3_errmsg(db_) : "out of memory");
+        closeDatabase();
+        removePartialFiles();
+        return false;
+    }
+
+    // The file isn't visible to anyone until it is renamed into place, and a failed import deletes it
+    std::string ignored;
+    execSql(db_, "PRAGMA journal_mode=OFF;", ignored);
+    execSql(db_, "PRAGMA synchronous=OFF;", ignored);
+    execSql(db_, "PRAGMA locking_mode=EXCLUSIVE;", ignored);
+    execSql(db_, "PRAGMA temp_store=MEMORY;", ignored);
+    execSql(db_, "PRAGMA cache_size=-20000;", ignored);
+    if (!execSql(db_, "BEGIN;", errorMessage)) {
+        closeDatabase();
+        removePartialFiles();
+        return false;
+    }
+    transactionStarted_ = true;
+    return true;
+}
+
+bool SliceReferenceDatabase::commitTransaction(std::string& errorMessage) {
+    if (!transactionStarted_ || !db_) {
+        errorMessage = "No transaction to commit";
+        return false;
+    }
+    if (!createIndexes(errorMessage) ||
+        !execSql(db_, "ANALYZE;", errorMessage) ||
+        !execSql(db_, "COMMIT;", errorMessage)) {
+        rollbackTransaction();
+        return false;
+    }
+    transactionStarted_ = false;
+    closeDatabase();
+
+    if (std::rename(partialPath_.c_str(), path_.c_str()) != 0) {
+        errorMessage = "Failed to move reference database into place: " + std::string(std::strerror(errno));
+        removePartialFiles();
+        return false;
+    }
+    return true;
+}
+
+void SliceReferenceDatabase::rollbackTransaction() {
+    if (db_ && transactionStarted_) {
+        std::string ignored;
+        execSql(db_, "ROLLBACK;", ignored);
+    }
+    transactionStarted_ = false;
+    closeDatabase();
+    removePartialFiles();
+}
+
+bool SliceReferenceDatabase::insertRows(
+    const std::string& tableName,
+    const std::vector<std::string>& columns,
+    const RowSet& rows,
+    std::string& errorMessage
+) {
+    if (!db_) {
+        errorMessage = "No reference database";
+        return false;
+    }
+    return insertHelper_.insertRowsMulti(db_, tableName, columns, rows, errorMessage);
+}
+
+bool SliceReferenceDatabase::insertBatch(const BatchData& batch, std::string& errorMessage) {
+    if (!db_) {
+        errorMessage = "No reference database";
+        return false;
+    }
+    // A reference database is rebuilt from scratch every time, so there is nothing to apply a delta to
+    if (batch.delta) {
+        errorMessage = "Reference imports require a full slice, not a delta";
+        return false;
+    }
+    return insertHelper_.insertBatch(db_, batch, errorMessage);
+}
+
+// Nothing to bound without a journal; a failed reference import discards the whole file
+bool SliceReferenceDatabase::createSavepoint(std::string& errorMessage) {
+    (void)errorMessage;
+    return true;
+}
+
+bool SliceReferenceDatabase::releaseSavepoint(std::string& errorMessage) {
+    (void)errorMessage;
+    return true;
+}
+
+bool SliceReferenceDatabase::declareTable(const std::string& tableName,
+                                          const std::vector<std::string>& columns,
+                                          std::string& errorMessage) {
+    if (!db_) {
+        errorMessage = "No reference database";
+        return false;
+    }
+    if (!declaredTables_.insert(tableName).second) {
+        return true;
+    }
+
+    // Untyped columns, like WatermelonDB's own schema, so values keep the type the slice gave them
+    std::string sql = "CREATE TABLE " + quoteIdentifier(tableName) + " (";
+    for (const auto& column : columns) {
+        if (isBookkeepingColumn(column)) {
+            continue;
+        }
+        sql += quoteIdentifier(column);
+        if (column == "id") {
+            sql += " PRIMARY KEY";
+        }
+        sql += ", ";
+    }
+    sql += "\"_changed\", \"_status\");";
+    if (!execSql(db_, sql, errorMessage)) {
+        errorMessage = "Failed to create reference table " + tableName + ": " + errorMessage;
+        return false;
+    }
+    return true;
+}
+
+// Built after the rows are in: one sorted build per index instead of per-row maintenance
+bool SliceReferenceDatabase::createIndexes(std::string& errorMessage) {
+    for (const auto& entry : indexes_) {
+        const std::string& tableName = entry.first;
+        if (declaredTables_.find(tableName) == declaredTables_.end()) {
+            errorMessage = "Reference index on " + tableName + ", which is not in the slice";
+            return false;
+        }
+        for (const auto& columns : entry.second) {
+            if (columns.empty()) {
+                errorMessage = "Reference index on " + tableName + " has no columns";
+                return false;
+            }
+            std::string name = tableName;
+            std::string columnList;
+            for (size_t i = 0; i < columns.size(); i++) {
+                name += "_" + columns[i];
+                if (i > 0) columnList += ", ";
+                columnList += quoteIdentifier(columns[i]);
+            }
+            std::string sql = "CREATE INDEX IF NOT EXISTS " + quoteIdentifier(name) + " ON " +
+                              quoteIdentifier(tableName) + " (" + columnList + ");";
+            if (!execSql(db_, sql, errorMessage)) {
+                errorMessage = "Failed to create reference index " + name + ": " + errorMessage;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void SliceReferenceDatabase::closeDatabase() {
+    if (!db_) {
+        return;
+    }
+    insertHelper_.finalizeStatements();
+    sqlite3_close(db_);
+    db_ = nullptr;
+}
+
+void SliceReferenceDatabase::removePartialFiles() {
+    std::remove(partialPath_.c_str());
+    std::remove((partialPath_ + "-journal").c_str());
+}
+
+bool attachReferenceDatabase(sqlite3* db, const std::string& path, const std::string& alias, std::string& errorMessage) {
+    if (!validateAlias(db, alias, errorMessage)) {
+        return false;
+    }
+    // ATTACH would happily create an empty database in its place
+    if (!fileExists(path)) {
+        errorMessage = "Reference database not found: " + path;
+        return false;
+    }
+
+    QueryOnlyLift lift(db);
+    if (sqlite3_db_filename(db, alias.c_str()) && !dropViewsAndDetach(db, alias, errorMessage)) {
+        return false;
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    const std::string attachSql = "ATTACH DATABASE ?1 AS " + quoteIdentifier(alias);
+    if (sqlite3_prepare_v2(db, attachSql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        errorMessage = "Failed to attach reference database: " + std::string(sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        errorMessage = "Failed to attach reference database: " + std::string(sqlite3_errmsg(db));
+        return false;
+    }
+
+    std::vector<std::string> tables;
+    std::string sql = "BEGIN;";
+    if (listTables(db, alias, tables, errorMessage)) {
+        for (const auto& table : tables) {
+            const std::string quoted = quoteIdentifier(table);
+            sql += "DROP VIEW IF EXISTS temp." + quoted + ";";
+            sql += "CREATE TEMP VIEW " + quoted + " AS SELECT * FROM " + quoteIdentifier(alias) + "." + quoted + ";";
+        }
+        sql += "COMMIT;";
+        if (execSql(db, sql, errorMessage)) {
+            return true;
+        }
+        std::string ignored;
+        execSql(db, "ROLLBACK;", ignored);
+    }
+    errorMessage = "Failed to create reference views: " + errorMessage;
+    std::string ignored;
+    execSql(db, "DETACH DATABASE " + quoteIdentifier(alias) + ";", ignored);
+    return false;
+}
+
+bool detachReferenceDatabase(sqlite3* db, const std::string& alias, std::string& errorMessage) {
+    if (!validateAlias(db, alias, errorMessage)) {
+        return false;
+    }
+    if (!sqlite3_db_filename(db, alias.c_str())) {
+        return true;
+    }
+    QueryOnlyLift lift(db);
+    return dropViewsAndDetach(db, alias, errorMessage);
+}
+
+} // namespace watermelondb
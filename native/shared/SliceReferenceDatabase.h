@@ -0,0 +1,79 @@
+#pragma once
+
+#include "SliceImportEngine.h"
+#include "SqliteInsertHelper.h"
+
+#include <sqlite3.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace watermelondb {
+
+// DatabaseInterface for reference imports (SliceImportOptions::referencePath).
+//
+// Read-only catalogs (price books, equipment models) don't belong in the app database: they are
+// never edited locally and get replaced wholesale. A reference import materializes the slice into
+// a standalone SQLite file instead, which the adapter attaches to its connections (see
+// attachReferenceDatabase):
+// 1. beginTransaction: `<path>.partial` is created with journal_mode=OFF and synchronous=OFF.
+// 2. declareTable: each table is created from the slice's columns, plus `_changed` and `_status`
+//    so WatermelonDB can read the rows like its own.
+// 3. commitTransaction: the requested indexes are built once the rows are in, ANALYZE runs, and the
+//    finished file is renamed over `path`. A refresh is the same import again: the old file stays
+//    in place (and attached) until the new one is complete.
+class SliceReferenceDatabase final : public DatabaseInterface {
+public:
+    // tableName -> indexes, each a list of columns
+    using IndexSpec = std::unordered_map<std::string, std::vector<std::vector<std::string>>>;
+
+    SliceReferenceDatabase(std::string path, IndexSpec indexes);
+    ~SliceReferenceDatabase() override;
+
+    bool beginTransaction(std::string& errorMessage) override;
+    bool commitTransaction(std::string& errorMessage) override;
+    void rollbackTransaction() override;
+
+    bool insertRows(
+        const std::string& tableName,
+        const std::vector<std::string>& columns,
+        const RowSet& rows,
+        std::string& errorMessage
+    ) override;
+    bool insertBatch(const BatchData& batch, std::string& errorMessage) override;
+
+    bool createSavepoint(std::string& errorMessage) override;
+    bool releaseSavepoint(std::string& errorMessage) override;
+
+    bool declareTable(const std::string& tableName,
+                      const std::vector<std::string>& columns,
+                      std::string& errorMessage) override;
+
+    const std::string& partialPath() const { return partialPath_; }
+
+private:
+    std::string path_;
+    std::string partialPath_;
+    IndexSpec indexes_;
+    sqlite3* db_ = nullptr;
+    bool transactionStarted_ = false;
+    std::unordered_set<std::string> declaredTables_;
+    SqliteInsertHelper insertHelper_;
+
+    bool createIndexes(std::string& errorMessage);
+    void closeDatabase();
+    void removePartialFiles();
+};
+
+// Attaches the reference database at `path` to `db` as schema `alias` and exposes each of its
+// tables through a TEMP view of the same name, which shadows a main-schema table of that name for
+// unqualified queries. If `alias` is already attached it is detached first, so calling this again
+// after a refresh picks up the new file. Works on query_only connections. Must not be called inside
+// a transaction.
+bool attachReferenceDatabase(sqlite3* db, const std::string& path, const std::string& alias, std::string& errorMessage);
+
+// Drops the views created by attachReferenceDatabase and detaches `alias`. No-op if not attached.
+bool detachReferenceDatabase(sqlite3* db, const std::string& alias, std::string& errorMessage);
+
+} // namespace watermelondb
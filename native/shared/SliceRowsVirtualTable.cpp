@@ -0,0 +1,159 @@
+#include "SliceRowsVirtualTable.h"
+
+#include <cstring>
+
+namespace watermelondb {
+
+namespace {
+
+// Hidden column carrying the SliceRowsSource pointer (the table-valued function argument)
+constexpr int kSourceColumn = static_cast<int>(SLICE_ROWS_MAX_COLUMNS);
+
+struct SliceRowsCursor {
+    sqlite3_vtab_cursor base;
+    const SliceRowsSource* source;
+    size_t row;
+};
+
+const std::string& declarationSql() {
+    static const std::string sql = [] {
+        std::string out = "CREATE TABLE x(";
+        for (size_t i = 0; i < SLICE_ROWS_MAX_COLUMNS; i++) {
+            out += "c" + std::to_string(i) + ", ";
+        }
+        out += "src HIDDEN)";
+        return out;
+    }();
+    return sql;
+}
+
+int sliceRowsConnect(sqlite3* db, void*, int, const char* const*, sqlite3_vtab** outVtab, char**) {
+    int rc = sqlite3_declare_vtab(db, declarationSql().c_str());
+    if (rc != SQLITE_OK) {
+        return rc;
+    }
+    auto* vtab = static_cast<sqlite3_vtab*>(sqlite3_malloc(sizeof(sqlite3_vtab)));
+    if (!vtab) {
+        return SQLITE_NOMEM;
+    }
+    std::memset(vtab, 0, sizeof(sqlite3_vtab));
+    *outVtab = vtab;
+    return SQLITE_OK;
+}
+
+int sliceRowsDisconnect(sqlite3_vtab* vtab) {
+    sqlite3_free(vtab);
+    return SQLITE_OK;
+}
+
+int sliceRowsBestIndex(sqlite3_vtab*, sqlite3_index_info* info) {
+    for (int i = 0; i < info->nConstraint; i++) {
+        const auto& constraint = info->aConstraint[i];
+        if (constraint.iColumn == kSourceColumn && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ && constraint.usable) {
+            info->aConstraintUsage[i].argvIndex = 1;
+            info->aConstraintUsage[i].omit = 1;
+            info->estimatedCost = 1;
+            info->idxNum = 1;
+            return SQLITE_OK;
+        }
+    }
+    // Without a source there is nothing to scan; make sure the planner never prefers this plan
+    info->estimatedCost = 1e99;
+    info->idxNum = 0;
+    return SQLITE_OK;
+}
+
+int sliceRowsOpen(sqlite3_vtab*, sqlite3_vtab_cursor** outCursor) {
+    auto* cursor = static_cast<SliceRowsCursor*>(sqlite3_malloc(sizeof(SliceRowsCursor)));
+    if (!cursor) {
+        return SQLITE_NOMEM;
+    }
+    std::memset(cursor, 0, sizeof(SliceRowsCursor));
+    *outCursor = &cursor->base;
+    return SQLITE_OK;
+}
+
+int sliceRowsClose(sqlite3_vtab_cursor* cursor) {
+    sqlite3_free(cursor);
+    return SQLITE_OK;
+}
+
+int sliceRowsFilter(sqlite3_vtab_cursor* base, int idxNum, const char*, int argc, sqlite3_value** argv) {
+    auto* cursor = reinterpret_cast<SliceRowsCursor*>(base);
+    cursor->row = 0;
+    cursor->source = nullptr;
+    if (idxNum == 1 && argc == 1) {
+        cursor->source = static_cast<const SliceRowsSource*>(sqlite3_value_pointer(argv[0], SLICE_ROWS_POINTER_TYPE));
+    }
+    return SQLITE_OK;
+}
+
+int sliceRowsNext(sqlite3_vtab_cursor* base) {
+    reinterpret_cast<SliceRowsCursor*>(base)->row++;
+    return SQLITE_OK;
+}
+
+int sliceRowsEof(sqlite3_vtab_cursor* base) {
+    auto* cursor = reinterpret_cast<SliceRowsCursor*>(base);
+    return !cursor->source || !cursor->source->rows || cursor->row >= cursor->source->rows->size();
+}
+
+int sliceRowsColumn(sqlite3_vtab_cursor* base, sqlite3_context* ctx, int column) {
+    auto* cursor = reinterpret_cast<SliceRowsCursor*>(base);
+    const auto& row = (*cursor->source->rows)[cursor->row];
+    if (column < 0 || static_cast<size_t>(column) >= cursor->source->columnCount ||
+        static_cast<size_t>(column) >= row.size()) {
+        sqlite3_result_null(ctx);
+        return SQLITE_OK;
+    }
+    const FieldValue& value = row[static_cast<size_t>(column)];
+    value.visit(Overloaded{
+        [&](std::nullptr_t) { sqlite3_result_null(ctx); },
+        [&](int64_t intValue) { sqlite3_result_int64(ctx, intValue); },
+        [&](double realValue) { sqlite3_result_double(ctx, realValue); },
+        [&](std::string_view text) {
+            sqlite3_result_text(ctx, text.data(), static_cast<int>(text.size()), SQLITE_STATIC);
+        },
+        [&](FieldBlob blob) { sqlite3_result_blob(ctx, blob.data, static_cast<int>(blob.size), SQLITE_STATIC); },
+    });
+    return SQLITE_OK;
+}
+
+int sliceRowsRowid(sqlite3_vtab_cursor* base, sqlite3_int64* rowid) {
+    *rowid = static_cast<sqlite3_int64>(reinterpret_cast<SliceRowsCursor*>(base)->row);
+    return SQLITE_OK;
+}
+
+const sqlite3_module& sliceRowsModule() {
+    static const sqlite3_module module = [] {
+        sqlite3_module m;
+        std::memset(&m, 0, sizeof(m));
+        m.iVersion = 0;
+        // xCreate stays null: eponymous-only, usable as slice_rows(...) without CREATE VIRTUAL TABLE
+        m.xConnect = sliceRowsConnect;
+        m.xBestIndex = sliceRowsBestIndex;
+        m.xDisconnect = sliceRowsDisconnect;
+        m.xOpen = sliceRowsOpen;
+        m.xClose = sliceRowsClose;
+        m.xFilter = sliceRowsFilter;
+        m.xNext = sliceRowsNext;
+        m.xEof = sliceRowsEof;
+        m.xColumn = sliceRowsColumn;
+        m.xRowid = sliceRowsRowid;
+        return m;
+    }();
+    return module;
+}
+
+} // namespace
+
+bool registerSliceRowsModule(sqlite3* db, std::string& errorMessage) {
+    int rc = sqlite3_create_module_v2(db, "slice_rows", &sliceRowsModule(), nullptr, nullptr);
+    if (rc != SQLITE_OK) {
+        errorMessage = "Failed to register slice_rows module: " + std::string(sqlite3_errmsg(db));
+        return false;
+    }
+    return true;
+}
+
+} // namespace watermelondb
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "SliceArena.h"
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+
+namespace watermelondb {
+
+// Eponymous virtual table that exposes already-decoded slice rows to SQL, so a whole table section
+// can be inserted with one statement that SQLite feeds itself through xColumn:
+//
+//   INSERT OR IGNORE INTO "tasks" ("id", "title", "_status")
+//   SELECT c0, c1, 'synced' FROM slice_rows(?1)
+//
+// ?1 is bound with sqlite3_bind_pointer(stmt, 1, &source, SLICE_ROWS_POINTER_TYPE, nullptr).
+// Columns are positional (c0, c1, ...); values are handed out as SQLITE_STATIC, so `source` and its
+// rows must stay alive and unmodified until the statement has been stepped to completion.
+struct SliceRowsSource {
+    const RowSet* rows = nullptr;
+    size_t columnCount = 0;
+};
+
+constexpr const char* SLICE_ROWS_POINTER_TYPE = "watermelondb_slice_rows";
+
+// Wider tables fall back to multi-row VALUES inserts
+constexpr size_t SLICE_ROWS_MAX_COLUMNS = 128;
+
+// Registers the slice_rows module on `db`. Safe to call again on the same connection.
+bool registerSliceRowsModule(sqlite3* db, std::string& errorMessage);
+
+} // namespace watermelondb
@@ -1,6 +1,7 @@
 #include "Sqlite.h"
 #include "DatabasePlatform.h"
 #include <cassert>
+#include <stdexcept>
 
 namespace watermelondb {
 
@@ -0,0 +1,160 @@
+#include "SqliteCursor.h"
+
+#include <chrono>
+
+namespace watermelondb {
+
+SqliteCursor::SqliteCursor(std::shared_ptr<SqliteReaderPool> pool, SqliteReaderPool::Lease lease, sqlite3_stmt* stmt)
+    : pool_(std::move(pool)), lease_(std::move(lease)), stmt_(stmt) {
+}
+
+SqliteCursor::~SqliteCursor() {
+    close();
+}
+
+std::unique_ptr<SqliteCursor> SqliteCursor::open(const std::shared_ptr<SqliteReaderPool>& pool,
+                                                 const std::string& sql,
+                                                 const std::vector<QueryArgument>& arguments,
+                                                 std::string& errorMessage) {
+    auto lease = pool->tryAcquire(errorMessage);
+    if (!lease) {
+        return nullptr;
+    }
+    if (usesBoundArray(sql) && !registerBoundArrayModule(lease.db(), errorMessage)) {
+        return nullptr;
+    }
+    // Not from the statement cache: it stays leased until the cursor is done
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(lease.db(), sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr) != SQLITE_OK) {
+        errorMessage = "Failed to prepare query statement: " + std::string(sqlite3_errmsg(lease.db()));
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    if (!stmt) {
+        errorMessage = "Query has no statement";
+        return nullptr;
+    }
+    if (!sqlite3_stmt_readonly(stmt)) {
+        errorMessage = "Cursors must be read-only";
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    if (!bindQueryArguments(stmt, arguments, errorMessage)) {
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    return std::unique_ptr<SqliteCursor>(new SqliteCursor(pool, std::move(lease), stmt));
+}
+
+SqliteCursor::FetchResult SqliteCursor::fetch(size_t maxRows, uint32_t maxMillis, const RowReader& readRow, std::string& errorMessage) {
+    if (!stmt_) {
+        return FetchResult::Done;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(maxMillis);
+    size_t rows = 0;
+    while (maxRows == 0 || rows < maxRows) {
+        if (maxMillis > 0 && rows > 0 && std::chrono::steady_clock::now() >= deadline) {
+            return FetchResult::More;
+        }
+        const int result = sqlite3_step(stmt_);
+        if (result == SQLITE_DONE) {
+            close();
+            return FetchResult::Done;
+        }
+        if (result != SQLITE_ROW) {
+            errorMessage = "Failed to get a row for query: " + std::string(sqlite3_errmsg(lease_.db()));
+            close();
+            return FetchResult::Failed;
+        }
+        readRow(stmt_);
+        rows++;
+        rowsRead_++;
+    }
+    return FetchResult::More;
+}
+
+// The statement goes before the connection it was prepared on
+void SqliteCursor::close() {
+    if (stmt_) {
+        sqlite3_finalize(stmt_);
+        stmt_ = nullptr;
+    }
+    lease_ = SqliteReaderPool::Lease();
+}
+
+// Under the lock throughout, so two cursors can't both take the last connection they may hold.
+// tryAcquire() doesn't wait for a connection.
+uint64_t SqliteCursors::open(const std::shared_ptr<SqliteReaderPool>& pool,
+                             const std::string& sql,
+                             const std::vector<QueryArgument>& arguments,
+                             std::string& errorMessage) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    size_t holding = 0;
+    for (const auto& entry : cursors_) {
+        if (entry.second->pool() == pool && !entry.second->isDone()) {
+            holding++;
+        }
+    }
+    if (holding + 1 >= pool->size()) {
+        errorMessage = "Too many open cursors: close a cursor before opening another";
+        return 0;
+    }
+    std::shared_ptr<SqliteCursor> cursor = SqliteCursor::open(pool, sql, arguments, errorMessage);
+    if (!cursor) {
+        return 0;
+    }
+    const uint64_t cursorId = nextId_++;
+    cursors_[cursorId] = std::move(cursor);
+    return cursorId;
+}
+
+std::shared_ptr<SqliteCursor> SqliteCursors::find(uint64_t cursorId) const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    auto found = cursors_.find(cursorId);
+    return found != cursors_.end() ? found->second : nullptr;
+}
+
+bool SqliteCursors::close(uint64_t cursorId) {
+    std::shared_ptr<SqliteCursor> cursor;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        auto found = cursors_.find(cursorId);
+        if (found == cursors_.end()) {
+            return false;
+        }
+        cursor = std::move(found->second);
+        cursors_.erase(found);
+    }
+    cursor->close();
+    return true;
+}
+
+void SqliteCursors::closeAll(const std::string& path) {
+    std::vector<std::shared_ptr<SqliteCursor>> closing;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = cursors_.begin(); it != cursors_.end();) {
+            if (it->second->pool()->path() == path) {
+                closing.push_back(std::move(it->second));
+                it = cursors_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto& cursor : closing) {
+        cursor->close();
+    }
+}
+
+size_t SqliteCursors::openCount() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return cursors_.size();
+}
+
+SqliteCursors& SqliteCursors::shared() {
+    static SqliteCursors* cursors = new SqliteCursors();
+    return *cursors;
+}
+
+} // namespace watermelondb
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "AsyncQueryExecutor.h"
+#include "SqliteReaderPool.h"
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace watermelondb {
+
+// A read-only query stepped in place a page at a time (openCursor / fetchCursor / closeCursor), so
+// large reads are paged through with constant memory instead of being collected up front.
+//
+// The cursor holds a pooled reader connection and its own prepared statement until it is done or
+// closed. Pages come from one read transaction: later pages don't see writes committed after the
+// first fetch. That transaction also keeps the WAL from being checkpointed past it, so cursors that
+// aren't read to the end should be closed. Not thread-safe: one caller at a time.
+class SqliteCursor {
+public:
+    enum class FetchResult {
+        // The page is full (or out of time); there may be more rows
+        More,
+        // The last row was read; the statement and connection are released
+        Done,
+        Failed,
+    };
+
+    // Called with the statement positioned on each fetched row
+    using RowReader = std::function<void(sqlite3_stmt* stmt)>;
+
+    // Prepares `sql` on a connection of `pool` leased without waiting. nullptr with `errorMessage`
+    // set if no connection is free, `sql` doesn't compile or isn't read-only, or `arguments` don't
+    // match its placeholders.
+    static std::unique_ptr<SqliteCursor> open(const std::shared_ptr<SqliteReaderPool>& pool,
+                                              const std::string& sql,
+                                              const std::vector<QueryArgument>& arguments,
+                                              std::string& errorMessage);
+    ~SqliteCursor();
+
+    SqliteCursor(const SqliteCursor&) = delete;
+    SqliteCursor& operator=(const SqliteCursor&) = delete;
+
+    // Steps up to `maxRows` rows (0: no limit), stopping early once `maxMillis` have passed (0: no
+    // limit; at least one row is read per fetch), and passes each to `readRow`
+    FetchResult fetch(size_t maxRows, uint32_t maxMillis, const RowReader& readRow, std::string& errorMessage);
+
+    // Releases the statement and the connection; fetch() returns Done after
+    void close();
+    bool isDone() const { return stmt_ == nullptr; }
+
+    // For column names; nullptr once done
+    sqlite3_stmt* statement() const { return stmt_; }
+    const std::shared_ptr<SqliteReaderPool>& pool() const { return pool_; }
+    uint64_t rowsRead() const { return rowsRead_; }
+
+private:
+    SqliteCursor(std::shared_ptr<SqliteReaderPool> pool, SqliteReaderPool::Lease lease, sqlite3_stmt* stmt);
+
+    std::shared_ptr<SqliteReaderPool> pool_;
+    SqliteReaderPool::Lease lease_;
+    sqlite3_stmt* stmt_ = nullptr;
+    uint64_t rowsRead_ = 0;
+};
+
+// Open cursors by id, for the JSI modules. Cursors of one pool may hold all but one of its
+// connections, so queries always have one to run on. Thread-safe.
+class SqliteCursors {
+public:
+    // Opens a cursor (SqliteCursor::open) and returns its id, or 0 with `errorMessage` set
+    uint64_t open(const std::shared_ptr<SqliteReaderPool>& pool,
+                  const std::string& sql,
+                  const std::vector<QueryArgument>& arguments,
+                  std::string& errorMessage);
+
+    // Cursor `cursorId`, or nullptr if it was closed (or never opened)
+    std::shared_ptr<SqliteCursor> find(uint64_t cursorId) const;
+
+    // Closes and forgets the cursor; returns false if there is none
+    bool close(uint64_t cursorId);
+
+    // Closes and forgets the cursors on the database file at `path`. Call before its reader pool
+    // is dropped (SqliteReaderPool::dropPath), or they keep their connections open.
+    void closeAll(const std::string& path);
+
+    size_t openCount() const;
+
+    static SqliteCursors& shared();
+
+private:
+    mutable std::mutex mutex_;
+    uint64_t nextId_ = 1;
+    std::unordered_map<uint64_t, std::shared_ptr<SqliteCursor>> cursors_;
+};
+
+} // namespace watermelondb
@@ -1,10 +1,145 @@
 #include "SqliteInsertHelper.h"
+#include "SliceRowsVirtualTable.h"
 
 #include <algorithm>
+#include <cctype>
 #include <cmath>
+#include <cstring>
 
 namespace watermelondb {
 
+namespace {
+bool execSql(sqlite3* db, const std::string& sql, std::string& errorMessage) {
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK) {
+        errorMessage = errMsg ? errMsg : sqlite3_errmsg(db);
+        if (errMsg) {
+            sqlite3_free(errMsg);
+        }
+        return false;
+    }
+    return true;
+}
+
+struct SortKey {
+    const unsigned char* data;
+    size_t size;
+    uint32_t row;
+};
+
+// memcmp order from byte `depth` on, shorter keys first: SQLite's BINARY collation
+bool keyLess(const SortKey& a, const SortKey& b, size_t depth) {
+    const size_t common = std::min(a.size, b.size);
+    if (common > depth) {
+        int cmp = std::memcmp(a.data + depth, b.data + depth, common - depth);
+        if (cmp != 0) {
+            return cmp < 0;
+        }
+    }
+    return a.size < b.size;
+}
+
+// Below this many keys a bucket is finished with insertion sort
+constexpr size_t RADIX_SMALL_BUCKET = 32;
+// Keys sharing a prefix this long (not ids) are finished with a comparison sort instead
+constexpr size_t RADIX_MAX_DEPTH = 64;
+
+// Stable MSD radix sort of keys that are equal up to `depth`. scratch holds at least `count` keys.
+void radixSortKeys(SortKey* keys, size_t count, size_t depth, SortKey* scratch) {
+    if (count < RADIX_SMALL_BUCKET) {
+        for (size_t i = 1; i < count; i++) {
+            SortKey key = keys[i];
+            size_t j = i;
+            while (j > 0 && keyLess(key, keys[j - 1], depth)) {
+                keys[j] = keys[j - 1];
+                j--;
+            }
+            keys[j] = key;
+        }
+        return;
+    }
+    if (depth >= RADIX_MAX_DEPTH) {
+        std::stable_sort(keys, keys + count, [depth](const SortKey& a, const SortKey& b) {
+            return keyLess(a, b, depth);
+        });
+        return;
+    }
+
+    // Bucket 0: keys that end at `depth`, which sort before any longer key
+    size_t bucketStart[258] = {0};
+    for (size_t i = 0; i < count; i++) {
+        const size_t bucket = keys[i].size > depth ? keys[i].data[depth] + 1u : 0u;
+        bucketStart[bucket + 1]++;
+    }
+    for (size_t bucket = 1; bucket < 258; bucket++) {
+        bucketStart[bucket] += bucketStart[bucket - 1];
+    }
+    size_t next[257];
+    std::copy(bucketStart, bucketStart + 257, next);
+    for (size_t i = 0; i < count; i++) {
+        const size_t bucket = keys[i].size > depth ? keys[i].data[depth] + 1u : 0u;
+        scratch[next[bucket]++] = keys[i];
+    }
+    std::copy(scratch, scratch + count, keys);
+
+    for (size_t bucket = 1; bucket < 257; bucket++) {
+        const size_t bucketSize = bucketStart[bucket + 1] - bucketStart[bucket];
+        if (bucketSize > 1) {
+            radixSortKeys(keys + bucketStart[bucket], bucketSize, depth + 1, scratch);
+        }
+    }
+}
+
+bool isUniqueIndexSql(const std::string& sql) {
+    // "CREATE UNIQUE INDEX ..." (case-insensitive, any whitespace)
+    std::string normalized;
+    normalized.reserve(20);
+    for (char c : sql) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            if (!normalized.empty() && normalized.back() != ' ') {
+                normalized += ' ';
+            }
+            continue;
+        }
+        normalized += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        if (normalized.size() >= 13) {
+            break;
+        }
+    }
+    return normalized.rfind("CREATE UNIQUE", 0) == 0;
+}
+
+// Upsert tail for delta slices, mirroring SyncApplyEngine's pull conflict handling: rows with
+// unpushed local creates/deletes are left alone, `updated` rows keep the columns listed in
+// `_changed`, and everything else takes the incoming values
+bool buildUpsertClause(const std::vector<std::string>& columns, std::string& clause, std::string& errorMessage) {
+    if (std::find(columns.begin(), columns.end(), "id") == columns.end()) {
+        errorMessage = "Delta slice table has no id column";
+        return false;
+    }
+    std::string assignments;
+    for (const auto& column : columns) {
+        if (column == "id") {
+            continue;
+        }
+        if (!assignments.empty()) {
+            assignments += ", ";
+        }
+        std::string quoted = "\"" + column + "\"";
+        assignments += quoted + " = CASE WHEN \"_status\" = 'updated' AND instr(',' || \"_changed\" || ',', '," +
+                       column + ",') > 0 THEN " + quoted + " ELSE excluded." + quoted + " END";
+    }
+    if (assignments.empty()) {
+        clause = " ON CONFLICT(\"id\") DO NOTHING";
+        return true;
+    }
+    clause = " ON CONFLICT(\"id\") DO UPDATE SET " + assignments +
+             " WHERE coalesce(\"_status\", 'synced') NOT IN ('created', 'deleted')";
+    return true;
+}
+} // namespace
+
 bool SqliteInsertHelper::bindFieldValue(
     sqlite3* db,
     sqlite3_stmt* stmt,
@@ -12,30 +147,17 @@ bool SqliteInsertHelper::bindFieldValue(
     const FieldValue& value,
     std::string& errorMessage
 ) {
-    int rc = SQLITE_OK;
-    switch (value.type) {
-        case FieldValue::Type::NULL_VALUE:
-            rc = sqlite3_bind_null(stmt, paramIndex);
-            break;
-        case FieldValue::Type::INT_VALUE:
-            rc = sqlite3_bind_int64(stmt, paramIndex, value.intValue);
-            break;
-        case FieldValue::Type::REAL_VALUE:
-            rc = sqlite3_bind_double(stmt, paramIndex, value.realValue);
-            break;
-        case FieldValue::Type::TEXT_VALUE:
-            rc = sqlite3_bind_text(stmt, paramIndex, value.textValue.c_str(), -1, SQLITE_STATIC);
-            break; 
-        case FieldValue::Type::BLOB_VALUE:
-            rc = sqlite3_bind_blob(
-                stmt,
-                paramIndex,
-                value.blobValue.data(),
-                static_cast<int>(value.blobValue.size()),
-                SQLITE_STATIC
-            );
-            break;
-    }
+    int rc = value.visit(Overloaded{
+        [&](std::nullptr_t) { return sqlite3_bind_null(stmt, paramIndex); },
+        [&](int64_t intValue) { return sqlite3_bind_int64(stmt, paramIndex, intValue); },
+        [&](double realValue) { return sqlite3_bind_double(stmt, paramIndex, realValue); },
+        [&](std::string_view text) {
+            return sqlite3_bind_text(stmt, paramIndex, text.data(), static_cast<int>(text.size()), SQLITE_STATIC);
+        },
+        [&](FieldBlob blob) {
+            return sqlite3_bind_blob(stmt, paramIndex, blob.data, static_cast<int>(blob.size), SQLITE_STATIC);
+        },
+    });
 
     if (rc != SQLITE_OK) {
         errorMessage = sqlite3_errmsg(db);
@@ -45,31 +167,33 @@ bool SqliteInsertHelper::bindFieldValue(
     return true;
 }
 
-std::string SqliteInsertHelper::buildColumnsSignature(const std::vector<std::string>& columns) {
-    std::string signature;
-    signature.reserve(columns.size() * 8);
-    for (size_t i = 0; i < columns.size(); i++) {
-        if (i > 0) {
-            signature += ",";
-        }
-        signature += columns[i];
+SqliteInsertHelper::StatementKey SqliteInsertHelper::makeStatementKey(
+    StatementKind kind,
+    const std::string& tableName,
+    const std::vector<std::string>& columns
+) {
+    StatementKey key;
+    key.kind = kind;
+    key.table = internIdentifier(tableName);
+    key.columns.reserve(columns.size());
+    for (const auto& column : columns) {
+        key.columns.push_back(internIdentifier(column));
     }
-    return signature;
+    return key;
 }
 
 sqlite3_stmt* SqliteInsertHelper::getCachedMultiRowStatement(
     sqlite3* db,
     const std::string& tableName,
     const std::vector<std::string>& columns,
-    const std::string& columnsSignature,
-    int rowsInChunk,
+    const StatementKey& key,
     bool shouldCache,
+    bool upsert,
     std::string& errorMessage
 ) {
-    std::string cacheKey = tableName + "|" + columnsSignature + "|" + std::to_string(rowsInChunk);
-
+    const size_t rowsInChunk = key.rows;
     if (shouldCache) {
-        auto it = statementCache_.find(cacheKey);
+        auto it = statementCache_.find(key);
         if (it != statementCache_.end()) {
             return it->second;
         }
@@ -85,7 +209,7 @@ sqlite3_stmt* SqliteInsertHelper::getCachedMultiRowStatement(
     }
 
     std::string valuesClause;
-    for (int rowIdx = 0; rowIdx < rowsInChunk; rowIdx++) {
+    for (size_t rowIdx = 0; rowIdx < rowsInChunk; rowIdx++) {
         if (rowIdx > 0) {
             valuesClause += ", ";
         }
@@ -96,10 +220,20 @@ sqlite3_stmt* SqliteInsertHelper::getCachedMultiRowStatement(
             }
             valuesClause += "?";
         }
-        valuesClause += ", 'synced')";
+        valuesClause += upsert ? ", 'synced', '')" : ", 'synced')";
     }
 
-    std::string sql = "INSERT OR IGNORE INTO \"" + tableName + "\" (" + columnNames + ", \"_status\") VALUES " + valuesClause;
+    std::string sql;
+    if (upsert) {
+        std::string upsertClause;
+        if (!buildUpsertClause(columns, upsertClause, errorMessage)) {
+            return nullptr;
+        }
+        sql = "INSERT INTO \"" + tableName + "\" (" + columnNames + ", \"_status\", \"_changed\") VALUES " +
+              valuesClause + upsertClause;
+    } else {
+        sql = "INSERT OR IGNORE INTO \"" + tableName + "\" (" + columnNames + ", \"_status\") VALUES " + valuesClause;
+    }
 
     sqlite3_stmt* stmt = nullptr;
     int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr);
@@ -109,7 +243,7 @@ sqlite3_stmt* SqliteInsertHelper::getCachedMultiRowStatement(
     }
 
     if (shouldCache) {
-        statementCache_[cacheKey] = stmt;
+        statementCache_[key] = stmt;
     }
 
     return stmt;
@@ -119,7 +253,18 @@ bool SqliteInsertHelper::insertRowsMulti(
     sqlite3* db,
     const std::string& tableName,
     const std::vector<std::string>& columns,
-    const std::vector<std::vector<FieldValue>>& rows,
+    const RowSet& rows,
+    std::string& errorMessage
+) {
+    return writeRowsMulti(db, tableName, columns, rows, false, errorMessage);
+}
+
+bool SqliteInsertHelper::writeRowsMulti(
+    sqlite3* db,
+    const std::string& tableName,
+    const std::vector<std::string>& columns,
+    const RowSet& rows,
+    bool upsert,
     std::string& errorMessage
 ) {
     if (rows.empty()) {
@@ -136,7 +281,7 @@ bool SqliteInsertHelper::insertRowsMulti(
         maxRowsPerStmt = 1;
     }
 
-    std::string columnsSignature = buildColumnsSignature(columns);
+    StatementKey key = makeStatementKey(upsert ? StatementKind::Upsert : StatementKind::Insert, tableName, columns);
 
     size_t totalRows = rows.size();
     size_t offset = 0;
@@ -144,13 +289,14 @@ bool SqliteInsertHelper::insertRowsMulti(
         int chunkSize = static_cast<int>(std::min(static_cast<size_t>(maxRowsPerStmt), totalRows - offset));
         bool shouldCache = (chunkSize == maxRowsPerStmt);
 
+        key.rows = static_cast<size_t>(chunkSize);
         sqlite3_stmt* stmt = getCachedMultiRowStatement(
             db,
             tableName,
             columns,
-            columnsSignature,
-            chunkSize,
+            key,
             shouldCache,
+            upsert,
             errorMessage
         );
         if (!stmt) {
@@ -195,6 +341,227 @@ bool SqliteInsertHelper::insertRowsMulti(
     return true;
 }
 
+bool SqliteInsertHelper::insertRowsSelect(
+    sqlite3* db,
+    const std::string& tableName,
+    const std::vector<std::string>& columns,
+    const RowSet& rows,
+    std::string& errorMessage
+) {
+    return writeRowsSelect(db, tableName, columns, rows, false, errorMessage);
+}
+
+bool SqliteInsertHelper::upsertRows(
+    sqlite3* db,
+    const std::string& tableName,
+    const std::vector<std::string>& columns,
+    const RowSet& rows,
+    std::string& errorMessage
+) {
+    return useVirtualTable_
+        ? writeRowsSelect(db, tableName, columns, rows, true, errorMessage)
+        : writeRowsMulti(db, tableName, columns, rows, true, errorMessage);
+}
+
+bool SqliteInsertHelper::sliceRowsAvailable(sqlite3* db) {
+    if (db != sliceRowsDb_) {
+        sliceRowsDb_ = db;
+        std::string registerError;
+        sliceRowsUnavailable_ = !registerSliceRowsModule(db, registerError);
+    }
+    return !sliceRowsUnavailable_;
+}
+
+bool SqliteInsertHelper::writeRowsSelect(
+    sqlite3* db,
+    const std::string& tableName,
+    const std::vector<std::string>& columns,
+    const RowSet& rows,
+    bool upsert,
+    std::string& errorMessage
+) {
+    if (rows.empty() || columns.empty()) {
+        return true;
+    }
+
+    if (!sliceRowsAvailable(db) || columns.size() > SLICE_ROWS_MAX_COLUMNS) {
+        return writeRowsMulti(db, tableName, columns, rows, upsert, errorMessage);
+    }
+
+    StatementKey cacheKey =
+        makeStatementKey(upsert ? StatementKind::UpsertSelect : StatementKind::InsertSelect, tableName, columns);
+    sqlite3_stmt* stmt = nullptr;
+    auto it = statementCache_.find(cacheKey);
+    if (it != statementCache_.end()) {
+        stmt = it->second;
+    } else {
+        std::string columnNames;
+        std::string selectList;
+        for (size_t i = 0; i < columns.size(); i++) {
+            columnNames += "\"" + columns[i] + "\", ";
+            selectList += "c" + std::to_string(i) + ", ";
+        }
+        std::string sql;
+        if (upsert) {
+            std::string upsertClause;
+            if (!buildUpsertClause(columns, upsertClause, errorMessage)) {
+                return false;
+            }
+            // "WHERE 1" keeps SQLite from parsing ON CONFLICT as a join constraint
+            sql = "INSERT INTO \"" + tableName + "\" (" + columnNames + "\"_status\", \"_changed\") SELECT " +
+                  selectList + "'synced', '' FROM slice_rows(?1) WHERE 1" + upsertClause;
+        } else {
+            sql = "INSERT OR IGNORE INTO \"" + tableName + "\" (" + columnNames + "\"_status\") SELECT " +
+                  selectList + "'synced' FROM slice_rows(?1)";
+        }
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            errorMessage = sqlite3_errmsg(db);
+            return false;
+        }
+        statementCache_[cacheKey] = stmt;
+    }
+
+    SliceRowsSource source;
+    source.rows = &rows;
+    source.columnCount = columns.size();
+
+    sqlite3_reset(stmt);
+    sqlite3_bind_pointer(stmt, 1, &source, SLICE_ROWS_POINTER_TYPE, nullptr);
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+        errorMessage = sqlite3_errmsg(db);
+    }
+    // Don't leave a pointer to the stack-allocated source bound
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return rc == SQLITE_DONE;
+}
+
+bool SqliteInsertHelper::deleteRows(
+    sqlite3* db,
+    const std::string& tableName,
+    const RowSet& ids,
+    std::string& errorMessage
+) {
+    if (ids.empty()) {
+        return true;
+    }
+
+    if (useVirtualTable_ && sliceRowsAvailable(db)) {
+        StatementKey cacheKey = makeStatementKey(StatementKind::DeleteSelect, tableName, {});
+        sqlite3_stmt* stmt = nullptr;
+        auto it = statementCache_.find(cacheKey);
+        if (it != statementCache_.end()) {
+            stmt = it->second;
+        } else {
+            std::string sql = "DELETE FROM \"" + tableName + "\" WHERE \"id\" IN (SELECT c0 FROM slice_rows(?1))";
+            if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+                errorMessage = sqlite3_errmsg(db);
+                return false;
+            }
+            statementCache_[cacheKey] = stmt;
+        }
+
+        SliceRowsSource source;
+        source.rows = &ids;
+        source.columnCount = 1;
+
+        sqlite3_reset(stmt);
+        sqlite3_bind_pointer(stmt, 1, &source, SLICE_ROWS_POINTER_TYPE, nullptr);
+        int rc = sqlite3_step(stmt);
+        if (rc != SQLITE_DONE) {
+            errorMessage = sqlite3_errmsg(db);
+        }
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        return rc == SQLITE_DONE;
+    }
+
+    // Same chunking as SyncApplyEngine's deletes; the full-size statement is cached
+    const size_t chunkSize = 900;
+    StatementKey cacheKey = makeStatementKey(StatementKind::Delete, tableName, {});
+    cacheKey.rows = chunkSize;
+    for (size_t offset = 0; offset < ids.size(); offset += chunkSize) {
+        size_t count = std::min(chunkSize, ids.size() - offset);
+        bool shouldCache = count == chunkSize;
+        sqlite3_stmt* stmt = nullptr;
+        auto it = shouldCache ? statementCache_.find(cacheKey) : statementCache_.end();
+        if (it != statementCache_.end()) {
+            stmt = it->second;
+        } else {
+            std::string placeholders;
+            for (size_t i = 0; i < count; i++) {
+                placeholders += i > 0 ? ", ?" : "?";
+            }
+            std::string sql = "DELETE FROM \"" + tableName + "\" WHERE \"id\" IN (" + placeholders + ")";
+            if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+                errorMessage = sqlite3_errmsg(db);
+                return false;
+            }
+            if (shouldCache) {
+                statementCache_[cacheKey] = stmt;
+            }
+        }
+
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        bool ok = true;
+        for (size_t i = 0; i < count && ok; i++) {
+            const auto& row = ids[offset + i];
+            static const FieldValue kNullValue = FieldValue::makeNull();
+            ok = bindFieldValue(db, stmt, static_cast<int>(i) + 1, row.empty() ? kNullValue : row[0], errorMessage);
+        }
+        if (ok && sqlite3_step(stmt) != SQLITE_DONE) {
+            errorMessage = sqlite3_errmsg(db);
+            ok = false;
+        }
+        if (!shouldCache) {
+            sqlite3_finalize(stmt);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SqliteInsertHelper::sortOrderByKey(const RowSet& rows, size_t keyColumn, std::vector<uint32_t>& order) {
+    order.clear();
+    if (keyColumn >= rows.columnCount()) {
+        return false;
+    }
+    std::vector<SortKey> keys;
+    keys.reserve(rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        const FieldValue& key = rows[i][keyColumn];
+        if (key.type() != FieldValue::Type::TEXT_VALUE) {
+            return false;
+        }
+        keys.push_back({reinterpret_cast<const unsigned char*>(key.data()), key.size(), static_cast<uint32_t>(i)});
+    }
+    std::vector<SortKey> scratch(keys.size());
+    radixSortKeys(keys.data(), keys.size(), 0, scratch.data());
+    order.reserve(keys.size());
+    for (const auto& key : keys) {
+        order.push_back(key.row);
+    }
+    return true;
+}
+
+bool SqliteInsertHelper::sortRowsById(const RowSet& rows, const std::vector<std::string>& columns) {
+    auto idColumn = std::find(columns.begin(), columns.end(), "id");
+    if (rows.size() < 2 || idColumn == columns.end() ||
+        !sortOrderByKey(rows, static_cast<size_t>(idColumn - columns.begin()), sortOrder_)) {
+        return false;
+    }
+    sortedRows_.clear();
+    for (uint32_t row : sortOrder_) {
+        RowSet::RowView values = rows[row];
+        sortedRows_.append(values.begin(), values.size());
+    }
+    return true;
+}
+
 bool SqliteInsertHelper::insertBatch(
     sqlite3* db,
     const BatchData& batch,
@@ -204,24 +571,172 @@ bool SqliteInsertHelper::insertBatch(
         return true;
     }
 
-    std::vector<std::string> tableNames;
-    tableNames.reserve(batch.tables.size());
+    std::vector<Identifier> tables;
+    tables.reserve(batch.tables.size() + batch.deletes.size());
     for (const auto& pair : batch.tables) {
-        tableNames.push_back(pair.first);
+        tables.push_back(pair.first);
+    }
+    for (const auto& pair : batch.deletes) {
+        if (batch.tables.find(pair.first) == batch.tables.end()) {
+            tables.push_back(pair.first);
+        }
+    }
+    // Same order on every run: by table name
+    std::sort(tables.begin(), tables.end(), [](Identifier a, Identifier b) {
+        return identifierName(a) < identifierName(b);
+    });
+
+    for (Identifier table : tables) {
+        const std::string& tableName = identifierName(table);
+        auto rowsIt = batch.tables.find(table);
+        if (rowsIt != batch.tables.end()) {
+            const auto& columns = batch.tableColumns.at(table);
+            const RowSet* rows = &rowsIt->second;
+            if (batch.sortById && sortRowsById(*rows, columns)) {
+                rows = &sortedRows_;
+            }
+            bool ok;
+            if (batch.delta) {
+                ok = upsertRows(db, tableName, columns, *rows, errorMessage);
+            } else {
+                ok = useVirtualTable_
+                    ? insertRowsSelect(db, tableName, columns, *rows, errorMessage)
+                    : insertRowsMulti(db, tableName, columns, *rows, errorMessage);
+            }
+            sortedRows_.clear();
+            if (!ok) {
+                return false;
+            }
+        }
+        auto deletesIt = batch.deletes.find(table);
+        if (deletesIt != batch.deletes.end() &&
+            !deleteRows(db, tableName, deletesIt->second, errorMessage)) {
+            return false;
+        }
     }
-    std::sort(tableNames.begin(), tableNames.end());
 
-    for (const auto& tableName : tableNames) {
-        const auto& rows = batch.tables.at(tableName);
-        const auto& columns = batch.tableColumns.at(tableName);
-        if (!insertRowsMulti(db, tableName, columns, rows, errorMessage)) {
+    return true;
+}
+
+bool SqliteInsertHelper::deferIndexes(sqlite3* db, const std::string& tableName, std::string& errorMessage) {
+    if (hasDeferredIndexes(tableName)) {
+        return true;
+    }
+
+    // Only worth it (and only safe to rebuild cheaply) when the table starts out empty
+    std::string emptySql = "SELECT 1 FROM \"" + tableName + "\" LIMIT 1";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, emptySql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        errorMessage = sqlite3_errmsg(db);
+        return false;
+    }
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc == SQLITE_ROW) {
+        return true;
+    }
+    if (rc != SQLITE_DONE) {
+        errorMessage = sqlite3_errmsg(db);
+        return false;
+    }
+
+    // Automatic indexes (PRIMARY KEY / UNIQUE constraints) have NULL sql and can't be dropped
+    const char* indexSql = "SELECT name, sql FROM sqlite_master WHERE type = 'index' AND tbl_name = ? AND sql IS NOT NULL";
+    if (sqlite3_prepare_v2(db, indexSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        errorMessage = sqlite3_errmsg(db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, tableName.c_str(), -1, SQLITE_TRANSIENT);
+
+    std::vector<std::string> names;
+    std::vector<std::string> definitions;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        const char* sql = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        if (!name || !sql || isUniqueIndexSql(sql)) {
+            continue;
+        }
+        names.emplace_back(name);
+        definitions.emplace_back(sql);
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        errorMessage = sqlite3_errmsg(db);
+        return false;
+    }
+
+    for (const auto& name : names) {
+        if (!execSql(db, "DROP INDEX \"" + name + "\"", errorMessage)) {
+            return false;
+        }
+    }
+    deferredIndexes_[tableName] = std::move(definitions);
+    return true;
+}
+
+bool SqliteInsertHelper::tableColumns(
+    sqlite3* db,
+    const std::string& tableName,
+    std::vector<std::string>& columns,
+    std::string& errorMessage
+) {
+    columns.clear();
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT name FROM pragma_table_info(?)", -1, &stmt, nullptr) != SQLITE_OK) {
+        errorMessage = sqlite3_errmsg(db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, tableName.c_str(), -1, SQLITE_TRANSIENT);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        if (name) {
+            columns.emplace_back(name);
+        }
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        errorMessage = sqlite3_errmsg(db);
+        return false;
+    }
+    return true;
+}
+
+bool SqliteInsertHelper::restoreIndexes(sqlite3* db, const std::string& tableName, std::string& errorMessage) {
+    auto it = deferredIndexes_.find(tableName);
+    if (it == deferredIndexes_.end()) {
+        return true;
+    }
+    for (const auto& sql : it->second) {
+        if (!execSql(db, sql, errorMessage)) {
             return false;
         }
+        indexesRebuilt_ = true;
     }
+    deferredIndexes_.erase(it);
+    return true;
+}
 
+bool SqliteInsertHelper::finishBulkLoad(sqlite3* db, std::string& errorMessage) {
+    while (!deferredIndexes_.empty()) {
+        std::string tableName = deferredIndexes_.begin()->first;
+        if (!restoreIndexes(db, tableName, errorMessage)) {
+            return false;
+        }
+    }
+    if (indexesRebuilt_) {
+        indexesRebuilt_ = false;
+        std::string ignored;
+        execSql(db, "PRAGMA optimize", ignored);
+    }
     return true;
 }
 
+void SqliteInsertHelper::discardDeferredIndexes() {
+    deferredIndexes_.clear();
+    indexesRebuilt_ = false;
+}
+
 void SqliteInsertHelper::finalizeStatements() {
     for (auto& entry : statementCache_) {
         if (entry.second) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "IdentifierInterner.h"
 #include "SliceImportEngine.h"
 #include <sqlite3.h>
 #include <string>
@@ -16,20 +17,134 @@ public:
         sqlite3* db,
         const std::string& tableName,
         const std::vector<std::string>& columns,
-        const std::vector<std::vector<FieldValue>>& rows,
+        const RowSet& rows,
         std::string& errorMessage
     );
 
+    // Same contract as insertRowsMulti, but through the slice_rows virtual table (see
+    // SliceRowsVirtualTable.h): one INSERT ... SELECT per call that SQLite feeds through xColumn,
+    // instead of chunked multi-row VALUES statements bound field by field. Tables wider than
+    // SLICE_ROWS_MAX_COLUMNS, or connections where the module can't be registered, fall back to
+    // insertRowsMulti.
+    bool insertRowsSelect(
+        sqlite3* db,
+        const std::string& tableName,
+        const std::vector<std::string>& columns,
+        const RowSet& rows,
+        std::string& errorMessage
+    );
+
+    // Delta slices: like insertRowsSelect/insertRowsMulti (per setUseVirtualTable), but rows that
+    // already exist are updated instead of ignored. Rows with unpushed local creates or deletes are
+    // left untouched, and `updated` rows keep the columns listed in `_changed`, same as a sync pull.
+    // `columns` must include "id".
+    bool upsertRows(
+        sqlite3* db,
+        const std::string& tableName,
+        const std::vector<std::string>& columns,
+        const RowSet& rows,
+        std::string& errorMessage
+    );
+
+    // Deletes the records whose id is the first value of each row in `ids`
+    bool deleteRows(
+        sqlite3* db,
+        const std::string& tableName,
+        const RowSet& ids,
+        std::string& errorMessage
+    );
+
+    // Per table: inserts (or, for delta batches, upserts) the batch's rows, then applies its deletes
     bool insertBatch(
         sqlite3* db,
         const BatchData& batch,
         std::string& errorMessage
     );
 
+    // Row order of `rows` by their TEXT value in `keyColumn`, in SQLite's BINARY collation order
+    // (MSD radix sort on the key bytes; stable, so duplicate keys keep their relative order).
+    // Returns false and leaves `order` empty if any key isn't TEXT.
+    static bool sortOrderByKey(const RowSet& rows, size_t keyColumn, std::vector<uint32_t>& order);
+
+    // Whether insertBatch goes through insertRowsSelect (default) or insertRowsMulti
+    void setUseVirtualTable(bool enabled) { useVirtualTable_ = enabled; }
+
     void finalizeStatements();
 
+    // Bulk-load mode. When `tableName` is empty, captures its non-unique secondary indexes from
+    // sqlite_master and drops them so rows are appended without per-row index maintenance.
+    // UNIQUE indexes are kept because INSERT OR IGNORE relies on them.
+    // Must run inside the import transaction: a rollback restores the dropped indexes.
+    bool deferIndexes(sqlite3* db, const std::string& tableName, std::string& errorMessage);
+
+    // Recreates the indexes dropped by deferIndexes() (one sorted build per index)
+    bool restoreIndexes(sqlite3* db, const std::string& tableName, std::string& errorMessage);
+
+    // Call before COMMIT: restores any indexes still deferred and runs PRAGMA optimize if any
+    // index was rebuilt, so the planner has fresh statistics for the new data
+    bool finishBulkLoad(sqlite3* db, std::string& errorMessage);
+
+    // Call after ROLLBACK (which already brought the dropped indexes back)
+    void discardDeferredIndexes();
+
+    // Column names of `tableName` (PRAGMA table_info); empty if the table doesn't exist
+    static bool tableColumns(
+        sqlite3* db,
+        const std::string& tableName,
+        std::vector<std::string>& columns,
+        std::string& errorMessage
+    );
+
+    bool hasDeferredIndexes(const std::string& tableName) const {
+        return deferredIndexes_.find(tableName) != deferredIndexes_.end();
+    }
+
 private:
-    std::unordered_map<std::string, sqlite3_stmt*> statementCache_;
+    enum class StatementKind : uint8_t {
+        Insert,
+        Upsert,
+        InsertSelect,
+        UpsertSelect,
+        Delete,
+        DeleteSelect
+    };
+
+    // Cached statements are keyed by interned names, so lookups hash a few integers
+    struct StatementKey {
+        StatementKind kind;
+        Identifier table;
+        std::vector<Identifier> columns;
+        size_t rows = 0;
+
+        bool operator==(const StatementKey& other) const {
+            return kind == other.kind && table == other.table && rows == other.rows && columns == other.columns;
+        }
+    };
+
+    struct StatementKeyHash {
+        size_t operator()(const StatementKey& key) const {
+            size_t hash = static_cast<size_t>(key.kind);
+            auto combine = [&hash](size_t value) { hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2); };
+            combine(key.table);
+            combine(key.rows);
+            for (Identifier column : key.columns) {
+                combine(column);
+            }
+            return hash;
+        }
+    };
+
+    std::unordered_map<StatementKey, sqlite3_stmt*, StatementKeyHash> statementCache_;
+    // tableName -> CREATE INDEX statements to replay
+    std::unordered_map<std::string, std::vector<std::string>> deferredIndexes_;
+    bool indexesRebuilt_ = false;
+    bool useVirtualTable_ = true;
+    // Rows of the table being inserted in id order (BatchData::sortById); cleared after each insert
+    RowSet sortedRows_;
+    std::vector<uint32_t> sortOrder_;
+    // Connection slice_rows was last registered on, and whether registration failed there
+    sqlite3* sliceRowsDb_ = nullptr;
+    bool sliceRowsUnavailable_ = false;
 
     static bool bindFieldValue(
         sqlite3* db,
@@ -39,15 +154,43 @@ private:
         std::string& errorMessage
     );
 
-    static std::string buildColumnsSignature(const std::vector<std::string>& columns);
+    static StatementKey makeStatementKey(StatementKind kind,
+                                         const std::string& tableName,
+                                         const std::vector<std::string>& columns);
+
+    // Copies `rows` into sortedRows_ in order of their "id" column. False (rows are inserted as
+    // they are) if there is no id column or an id isn't TEXT.
+    bool sortRowsById(const RowSet& rows, const std::vector<std::string>& columns);
+
+    // Registers slice_rows on `db` the first time it's seen; false if the module is unavailable
+    bool sliceRowsAvailable(sqlite3* db);
+
+    bool writeRowsMulti(
+        sqlite3* db,
+        const std::string& tableName,
+        const std::vector<std::string>& columns,
+        const RowSet& rows,
+        bool upsert,
+        std::string& errorMessage
+    );
+
+    bool writeRowsSelect(
+        sqlite3* db,
+        const std::string& tableName,
+        const std::vector<std::string>& columns,
+        const RowSet& rows,
+        bool upsert,
+        std::string& errorMessage
+    );
 
+    // key.rows is the number of rows in the chunk
     sqlite3_stmt* getCachedMultiRowStatement(
         sqlite3* db,
         const std::string& tableName,
         const std::vector<std::string>& columns,
-        const std::string& columnsSignature,
-        int rowsInChunk,
+        const StatementKey& key,
         bool shouldCache,
+        bool upsert,
         std::string& errorMessage
     );
 };
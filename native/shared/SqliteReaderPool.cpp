@@ -0,0 +1,273 @@
+#include "SqliteReaderPool.h"
+
+#include "SqliteStatementCache.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace watermelondb {
+
+namespace {
+
+std::mutex gPoolsMutex;
+std::unordered_map<std::string, std::shared_ptr<SqliteReaderPool>> gPools;
+
+} // namespace
+
+SqliteReaderPool::Lease::Lease(std::shared_ptr<SqliteReaderPool> pool, size_t slot, sqlite3* db)
+    : pool_(std::move(pool)), slot_(slot), db_(db) {
+}
+
+SqliteReaderPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(std::move(other.pool_)), slot_(other.slot_), db_(other.db_) {
+    other.db_ = nullptr;
+}
+
+SqliteReaderPool::Lease& SqliteReaderPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        if (pool_ && db_) {
+            pool_->release(slot_);
+        }
+        pool_ = std::move(other.pool_);
+        slot_ = other.slot_;
+        db_ = other.db_;
+        other.db_ = nullptr;
+    }
+    return *this;
+}
+
+SqliteReaderPool::Lease::~Lease() {
+    if (pool_ && db_) {
+        pool_->release(slot_);
+    }
+}
+
+SqliteReaderPool::SqliteReaderPool(std::string path, size_t size)
+    : path_(std::move(path)), slots_(std::max<size_t>(size, 1)) {
+}
+
+SqliteReaderPool::~SqliteReaderPool() {
+    for (auto& slot : slots_) {
+        closeSlot(slot);
+    }
+}
+
+SqliteReaderPool::Lease SqliteReaderPool::acquire(std::string& errorMessage) {
+    return acquire(errorMessage, true);
+}
+
+SqliteReaderPool::Lease SqliteReaderPool::tryAcquire(std::string& errorMessage) {
+    return acquire(errorMessage, false);
+}
+
+SqliteReaderPool::Lease SqliteReaderPool::acquire(std::string& errorMessage, bool wait) {
+    size_t index = 0;
+    std::map<std::string, Hook> hooks;
+    bool needsHooks = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto idleSlot = [this]() {
+            // Prefer an open connection; open a new one only when all open ones are leased
+            auto found = std::find_if(slots_.begin(), slots_.end(),
+                                      [](const Slot& slot) { return !slot.leased && slot.db; });
+            if (found == slots_.end()) {
+                found = std::find_if(slots_.begin(), slots_.end(), [](const Slot& slot) { return !slot.leased; });
+            }
+            return found;
+        };
+        auto found = idleSlot();
+        if (found == slots_.end() && !closed_ && !wait) {
+            errorMessage = "All " + std::to_string(slots_.size()) + " reader connections of " + path_ + " are leased";
+            return Lease();
+        }
+        if (found == slots_.end() && !closed_) {
+            stats_.waits++;
+            available_.wait(lock, [&]() {
+                found = idleSlot();
+                return closed_ || found != slots_.end();
+            });
+        }
+        if (closed_) {
+            errorMessage = "Reader pool of " + path_ + " is closed";
+            return Lease();
+        }
+        found->leased = true;
+        index = static_cast<size_t>(found - slots_.begin());
+        needsHooks = found->hooksGeneration != hooksGeneration_;
+        if (needsHooks) {
+            hooks = hooks_;
+            found->hooksGeneration = hooksGeneration_;
+        }
+        stats_.leases++;
+    }
+
+    // The slot is ours now: open it and bring its hooks up to date without holding the lock
+    Slot& slot = slots_[index];
+    bool ok = slot.db || openSlot(slot, errorMessage);
+    if (ok && needsHooks) {
+        ok = syncHooks(slot, hooks, errorMessage);
+    }
+    if (!ok) {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            // Retry the hooks next time
+            slot.hooksGeneration = 0;
+        }
+        release(index);
+        return Lease();
+    }
+    return Lease(shared_from_this(), index, slot.db);
+}
+
+void SqliteReaderPool::release(size_t index) {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        Slot& slot = slots_[index];
+        slot.leased = false;
+        if (closed_) {
+            closeSlot(slot);
+        }
+    }
+    available_.notify_one();
+}
+
+void SqliteReaderPool::setConnectionHook(const std::string& key, ConnectionHook apply, ConnectionHook undo) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    Hook& hook = hooks_[key];
+    hook.version = nextHookVersion_++;
+    hook.apply = std::move(apply);
+    hook.undo = std::move(undo);
+    hooksGeneration_++;
+}
+
+void SqliteReaderPool::removeConnectionHook(const std::string& key) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (hooks_.erase(key) > 0) {
+        hooksGeneration_++;
+    }
+}
+
+void SqliteReaderPool::close() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        for (auto& slot : slots_) {
+            if (!slot.leased) {
+                closeSlot(slot);
+            }
+        }
+    }
+    available_.notify_all();
+}
+
+bool SqliteReaderPool::isClosed() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return closed_;
+}
+
+SqliteReaderPool::Stats SqliteReaderPool::stats() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+size_t SqliteReaderPool::defaultSize() {
+    const size_t cores = std::thread::hardware_concurrency();
+    return std::min<size_t>(std::max<size_t>(cores, 2), 8);
+}
+
+// NOMUTEX: a connection is only ever used by the thread holding its lease
+bool SqliteReaderPool::openSlot(Slot& slot, std::string& errorMessage) {
+    sqlite3* db = nullptr;
+    const int flags = SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX;
+    if (sqlite3_open_v2(path_.c_str(), &db, flags, nullptr) != SQLITE_OK) {
+        errorMessage = "Failed to open reader connection: " + std::string(db ? sqlite3_errmsg(db) : "out of memory");
+        sqlite3_close_v2(db);
+        return false;
+    }
+    sqlite3_busy_timeout(db, 5000);
+    char* error = nullptr;
+    if (sqlite3_exec(db, "PRAGMA query_only=1", nullptr, nullptr, &error) != SQLITE_OK) {
+        errorMessage = "Failed to set up reader connection: " + std::string(error ? error : "unknown error");
+        sqlite3_free(error);
+        sqlite3_close_v2(db);
+        return false;
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    slot.db = db;
+    stats_.opened++;
+    return true;
+}
+
+bool SqliteReaderPool::syncHooks(Slot& slot, const std::map<std::string, Hook>& hooks, std::string& errorMessage) {
+    if (slot.applied.empty() && hooks.empty()) {
+        return true;
+    }
+    // TEMP views and ATTACH count as writes under query_only
+    sqlite3_exec(slot.db, "PRAGMA query_only=0", nullptr, nullptr, nullptr);
+    bool ok = true;
+    for (auto it = slot.applied.begin(); ok && it != slot.applied.end();) {
+        auto current = hooks.find(it->first);
+        if (current != hooks.end() && current->second.version == it->second.version) {
+            ++it;
+            continue;
+        }
+        if (it->second.undo && !it->second.undo(slot.db, errorMessage)) {
+            ok = false;
+            break;
+        }
+        it = slot.applied.erase(it);
+    }
+    for (auto it = hooks.begin(); ok && it != hooks.end(); ++it) {
+        if (slot.applied.count(it->first)) {
+            continue;
+        }
+        if (it->second.apply && !it->second.apply(slot.db, errorMessage)) {
+            ok = false;
+            break;
+        }
+        slot.applied[it->first] = AppliedHook{it->second.version, it->second.undo};
+    }
+    sqlite3_exec(slot.db, "PRAGMA query_only=1", nullptr, nullptr, nullptr);
+    return ok;
+}
+
+// Statements cached for the connection keep it busy, so they go first
+void SqliteReaderPool::closeSlot(Slot& slot) {
+    if (!slot.db) {
+        return;
+    }
+    SqliteStatementCache::dropConnection(slot.db);
+    sqlite3_close_v2(slot.db);
+    slot.db = nullptr;
+    slot.applied.clear();
+    slot.hooksGeneration = 0;
+}
+
+std::shared_ptr<SqliteReaderPool> SqliteReaderPool::forPath(const std::string& path) {
+    if (path.empty()) {
+        return nullptr;
+    }
+    const std::lock_guard<std::mutex> lock(gPoolsMutex);
+    auto& pool = gPools[path];
+    if (!pool || pool->isClosed()) {
+        pool = std::make_shared<SqliteReaderPool>(path, defaultSize());
+    }
+    return pool;
+}
+
+void SqliteReaderPool::dropPath(const std::string& path) {
+    std::shared_ptr<SqliteReaderPool> pool;
+    {
+        const std::lock_guard<std::mutex> lock(gPoolsMutex);
+        auto found = gPools.find(path);
+        if (found == gPools.end()) {
+            return;
+        }
+        pool = std::move(found->second);
+        gPools.erase(found);
+    }
+    pool->close();
+}
+
+} // namespace watermelondb
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace watermelondb {
+
+// Read-only connections to one database file, leased one query at a time, so reads on different
+// threads run in parallel (WAL lets them run alongside the writer too) instead of queueing for the
+// platform's single reader connection.
+//
+// Connections are opened on first need, up to `size`, with query_only on. acquire() blocks while
+// all of them are leased. Per-connection state that the platform reader has (attached reference
+// databases and their temp views) is registered as a connection hook and applied to each pooled
+// connection before its next lease.
+//
+// In-memory databases can't be shared between connections, so forPath() has no pool for them.
+// Thread-safe.
+class SqliteReaderPool : public std::enable_shared_from_this<SqliteReaderPool> {
+public:
+    using ConnectionHook = std::function<bool(sqlite3* db, std::string& errorMessage)>;
+
+    struct Stats {
+        uint64_t leases = 0;
+        // Leases that had to wait for a connection to be given back
+        uint64_t waits = 0;
+        size_t opened = 0;
+    };
+
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        sqlite3* db() const { return db_; }
+        explicit operator bool() const { return db_ != nullptr; }
+
+    private:
+        friend class SqliteReaderPool;
+        Lease(std::shared_ptr<SqliteReaderPool> pool, size_t slot, sqlite3* db);
+
+        std::shared_ptr<SqliteReaderPool> pool_;
+        size_t slot_ = 0;
+        sqlite3* db_ = nullptr;
+    };
+
+    SqliteReaderPool(std::string path, size_t size);
+    ~SqliteReaderPool();
+
+    SqliteReaderPool(const SqliteReaderPool&) = delete;
+    SqliteReaderPool& operator=(const SqliteReaderPool&) = delete;
+
+    // A connection for the caller's exclusive use until the lease is destroyed, or an empty lease
+    // with `errorMessage` set if the pool is closed or a connection can't be opened or set up
+    Lease acquire(std::string& errorMessage);
+    // Like acquire(), but fails instead of waiting when every connection is leased
+    Lease tryAcquire(std::string& errorMessage);
+
+    // `apply` runs on every pooled connection before its next lease; `undo` runs on the connections
+    // it was applied to once the hook is removed or replaced. Both run outside a transaction with
+    // query_only lifted (the connection is still opened read-only: only TEMP objects and ATTACH).
+    void setConnectionHook(const std::string& key, ConnectionHook apply, ConnectionHook undo);
+    void removeConnectionHook(const std::string& key);
+
+    // Closes idle connections now and leased ones when they are given back; acquire() fails after
+    void close();
+    bool isClosed() const;
+
+    Stats stats() const;
+    const std::string& path() const { return path_; }
+    size_t size() const { return slots_.size(); }
+
+    // Number of cores, at least 2 and at most 8: reads are CPU-bound once the pages are cached
+    static size_t defaultSize();
+
+    // Open pool of the database file at `path` (as reported by sqlite3_db_filename), created on
+    // first use; nullptr for an in-memory or temporary database (empty path)
+    static std::shared_ptr<SqliteReaderPool> forPath(const std::string& path);
+    // close() and forget the pool of `path`. Call before the database's files are closed or deleted.
+    static void dropPath(const std::string& path);
+
+private:
+    struct Hook {
+        uint64_t version = 0;
+        ConnectionHook apply;
+        ConnectionHook undo;
+    };
+
+    struct AppliedHook {
+        uint64_t version = 0;
+        ConnectionHook undo;
+    };
+
+    struct Slot {
+        sqlite3* db = nullptr;
+        bool leased = false;
+        uint64_t hooksGeneration = 0;
+        std::map<std::string, AppliedHook> applied;
+    };
+
+    std::string path_;
+    std::vector<Slot> slots_;
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    std::map<std::string, Hook> hooks_;
+    uint64_t hooksGeneration_ = 1;
+    uint64_t nextHookVersion_ = 1;
+    bool closed_ = false;
+    Stats stats_;
+
+    Lease acquire(std::string& errorMessage, bool wait);
+    void release(size_t slot);
+    bool openSlot(Slot& slot, std::string& errorMessage);
+    static bool syncHooks(Slot& slot, const std::map<std::string, Hook>& hooks, std::string& errorMessage);
+    static void closeSlot(Slot& slot);
+};
+
+} // namespace watermelondb
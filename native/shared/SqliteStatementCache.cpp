@@ -0,0 +1,204 @@
+#include "SqliteStatementCache.h"
+
+#include <vector>
+
+namespace watermelondb {
+
+namespace {
+
+std::mutex gCachesMutex;
+std::unordered_map<sqlite3*, std::shared_ptr<SqliteStatementCache>> gCaches;
+
+} // namespace
+
+SqliteStatementCache::SqliteStatementCache(sqlite3* db, size_t capacity) : db_(db), capacity_(capacity) {
+}
+
+SqliteStatementCache::~SqliteStatementCache() {
+    for (auto& entry : entries_) {
+        sqlite3_finalize(entry.statement.stmt);
+        entry.statement.stmt = nullptr;
+    }
+    sqlite3_finalize(schemaVersionStmt_);
+}
+
+sqlite3_stmt* SqliteStatementCache::acquire(const std::string& sql, int& resultCode) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    checkSchemaVersion();
+
+    auto found = bySql_.find(sql);
+    if (found != bySql_.end() && !found->second->leased) {
+        stats_.hits++;
+        Entry& entry = *found->second;
+        entries_.splice(entries_.begin(), entries_, found->second);
+        entry.leased = true;
+        resultCode = SQLITE_OK;
+        return entry.statement.stmt;
+    }
+
+    stats_.misses++;
+    sqlite3_stmt* stmt = nullptr;
+    resultCode = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
+    if (resultCode != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    if (found != bySql_.end() || capacity_ == 0 || !stmt) {
+        // Already leased under this SQL (or nothing to cache): lent out uncached
+        return stmt;
+    }
+
+    entries_.emplace_front(sql, stmt);
+    entries_.front().leased = true;
+    bySql_[sql] = entries_.begin();
+    byStatement_[stmt] = entries_.begin();
+    evictIdle();
+    return stmt;
+}
+
+void SqliteStatementCache::release(sqlite3_stmt* stmt) {
+    if (!stmt) {
+        return;
+    }
+    const std::lock_guard<std::mutex> lock(mutex_);
+    auto found = byStatement_.find(stmt);
+    if (found == byStatement_.end()) {
+        sqlite3_finalize(stmt);
+        return;
+    }
+    Entry& entry = *found->second;
+    if (entry.stale) {
+        erase(found->second);
+        return;
+    }
+    entry.statement.reset();
+    entry.leased = false;
+    evictIdle();
+}
+
+void SqliteStatementCache::clear() {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    invalidate();
+}
+
+SqliteStatementCache::Stats SqliteStatementCache::stats() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.size = entries_.size();
+    return stats;
+}
+
+// One step of a cached PRAGMA: reads the schema cookie from the database header, which is much
+// cheaper than the prepare a cache hit saves
+void SqliteStatementCache::checkSchemaVersion() {
+    if (!schemaVersionStmt_ &&
+        sqlite3_prepare_v2(db_, "PRAGMA schema_version", -1, &schemaVersionStmt_, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(schemaVersionStmt_);
+        schemaVersionStmt_ = nullptr;
+        return;
+    }
+    int64_t version = -1;
+    if (sqlite3_step(schemaVersionStmt_) == SQLITE_ROW) {
+        version = sqlite3_column_int64(schemaVersionStmt_, 0);
+    }
+    sqlite3_reset(schemaVersionStmt_);
+    if (version < 0 || version == schemaVersion_) {
+        return;
+    }
+    if (schemaVersion_ >= 0 && !entries_.empty()) {
+        stats_.invalidations++;
+        invalidate();
+    }
+    schemaVersion_ = version;
+}
+
+void SqliteStatementCache::invalidate() {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        auto next = std::next(it);
+        if (it->leased) {
+            it->stale = true;
+        } else {
+            erase(it);
+        }
+        it = next;
+    }
+}
+
+void SqliteStatementCache::erase(EntryList::iterator it) {
+    auto bySql = bySql_.find(it->sql);
+    if (bySql != bySql_.end() && bySql->second == it) {
+        bySql_.erase(bySql);
+    }
+    byStatement_.erase(it->statement.stmt);
+    sqlite3_finalize(it->statement.stmt);
+    it->statement.stmt = nullptr;
+    entries_.erase(it);
+}
+
+// Drops idle statements from the least recently used end until the cache is within capacity.
+// Leased statements are never evicted, so the cache can run over while many are leased.
+void SqliteStatementCache::evictIdle() {
+    auto it = entries_.end();
+    while (entries_.size() > capacity_ && it != entries_.begin()) {
+        auto candidate = std::prev(it);
+        if (candidate->leased) {
+            it = candidate;
+            continue;
+        }
+        erase(candidate);
+        stats_.evictions++;
+    }
+}
+
+std::shared_ptr<SqliteStatementCache> SqliteStatementCache::forConnection(sqlite3* db) {
+    const std::lock_guard<std::mutex> lock(gCachesMutex);
+    auto& cache = gCaches[db];
+    if (!cache) {
+        cache = std::make_shared<SqliteStatementCache>(db);
+    }
+    return cache;
+}
+
+std::shared_ptr<SqliteStatementCache> SqliteStatementCache::existingForConnection(sqlite3* db) {
+    const std::lock_guard<std::mutex> lock(gCachesMutex);
+    auto found = gCaches.find(db);
+    return found != gCaches.end() ? found->second : nullptr;
+}
+
+void SqliteStatementCache::dropConnection(sqlite3* db) {
+    std::shared_ptr<SqliteStatementCache> cache;
+    {
+        const std::lock_guard<std::mutex> lock(gCachesMutex);
+        auto found = gCaches.find(db);
+        if (found == gCaches.end()) {
+            return;
+        }
+        cache = std::move(found->second);
+        gCaches.erase(found);
+    }
+    // The connection is about to close: leased statements go too
+    const std::lock_guard<std::mutex> lock(cache->mutex_);
+    while (!cache->entries_.empty()) {
+        cache->erase(cache->entries_.begin());
+    }
+    sqlite3_finalize(cache->schemaVersionStmt_);
+    cache->schemaVersionStmt_ = nullptr;
+}
+
+void SqliteStatementCache::dropConnectionsTo(const std::string& path) {
+    std::vector<sqlite3*> connections;
+    {
+        const std::lock_guard<std::mutex> lock(gCachesMutex);
+        for (const auto& cache : gCaches) {
+            const char* filename = sqlite3_db_filename(cache.first, "main");
+            if (filename && path == filename) {
+                connections.push_back(cache.first);
+            }
+        }
+    }
+    for (sqlite3* db : connections) {
+        dropConnection(db);
+    }
+}
+
+} // namespace watermelondb
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Sqlite.h"
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace watermelondb {
+
+// Prepared statements of one connection, keyed by SQL text, so a query shape that is run again is
+// bound and stepped instead of compiled again. Holds at most `capacity` idle statements and evicts
+// the least recently used one beyond that.
+//
+// A statement is leased with acquire() and given back with release(), which resets it and clears
+// its bindings (SqliteStatement::reset). If the same SQL is acquired again while leased, the second
+// lease gets an uncached statement that release() finalizes. The cache is emptied whenever the
+// database's schema_version changes, whichever connection made the change.
+//
+// Cached statements keep the connection busy: drop the cache (dropConnection) before the
+// connection is closed. Thread-safe.
+class SqliteStatementCache {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 256;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        // Times the cache was emptied because the schema changed
+        uint64_t invalidations = 0;
+        size_t size = 0;
+    };
+
+    explicit SqliteStatementCache(sqlite3* db, size_t capacity = DEFAULT_CAPACITY);
+    ~SqliteStatementCache();
+
+    SqliteStatementCache(const SqliteStatementCache&) = delete;
+    SqliteStatementCache& operator=(const SqliteStatementCache&) = delete;
+
+    // Returns a reset statement with no bindings, or nullptr with the result of sqlite3_prepare_v2
+    // in `resultCode` (the error message is on the connection)
+    sqlite3_stmt* acquire(const std::string& sql, int& resultCode);
+
+    // Gives back a statement returned by acquire()
+    void release(sqlite3_stmt* stmt);
+
+    // Finalizes every idle statement; leased ones are finalized when they are released
+    void clear();
+
+    Stats stats() const;
+    sqlite3* connection() const { return db_; }
+
+    // Cache of `db`, created on first use
+    static std::shared_ptr<SqliteStatementCache> forConnection(sqlite3* db);
+    // Cache of `db` if it has one
+    static std::shared_ptr<SqliteStatementCache> existingForConnection(sqlite3* db);
+    // Finalizes and forgets the cache of `db`, leased statements included. Call before closing the
+    // connection, once no statement of it is in use.
+    static void dropConnection(sqlite3* db);
+    // dropConnection() for every connection to the database file at `path` (all pooled
+    // connections of a database are closed together)
+    static void dropConnectionsTo(const std::string& path);
+
+private:
+    struct Entry {
+        Entry(const std::string& sql, sqlite3_stmt* stmt) : sql(sql), statement(stmt) {}
+
+        std::string sql;
+        SqliteStatement statement;
+        bool leased = false;
+        // Schema changed while leased: finalize on release instead of caching
+        bool stale = false;
+    };
+    using EntryList = std::list<Entry>;
+
+    sqlite3* db_;
+    size_t capacity_;
+    mutable std::mutex mutex_;
+    // Most recently used first
+    EntryList entries_;
+    std::unordered_map<std::string, EntryList::iterator> bySql_;
+    std::unordered_map<sqlite3_stmt*, EntryList::iterator> byStatement_;
+    sqlite3_stmt* schemaVersionStmt_ = nullptr;
+    int64_t schemaVersion_ = -1;
+    Stats stats_;
+
+    void checkSchemaVersion();
+    // Finalizes idle statements and marks leased ones stale
+    void invalidate();
+    void erase(EntryList::iterator it);
+    void evictIdle();
+};
+
+} // namespace watermelondb
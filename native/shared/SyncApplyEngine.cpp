@@ -1,6 +1,7 @@
 #include "SyncApplyEngine.h"
 #include "JsonUtils.h"
 #include "DatabasePlatform.h"
+#include "IdentifierInterner.h"
 
 #include <algorithm>
 #include <cctype>
@@ -788,11 +789,35 @@ static bool applyPartialUpdate(sqlite3* db, const std::string& table, const Json
     return true;
 }
 
-static std::string formatTableCounts(const std::unordered_map<std::string, size_t>& counts) {
-    if (counts.empty()) {
+// Per-table state of one applySyncPayload page, keyed by interned table name
+struct TableApplyState {
+    bool existenceChecked = false;
+    bool exists = false;
+    // Conflict resolution: locally-dirty records (lazy-loaded)
+    bool dirtyLoaded = false;
+    DirtyRecordCache dirtyRecords;
+    JsonValue deletes;
+    size_t upserts = 0;
+    size_t deleteCount = 0;
+    size_t skippedDirty = 0;
+    size_t merged = 0;
+    // MOBILE-6276: ids actually written (upsert or partial-merge) / hard-deleted this page
+    std::vector<std::string> upsertedIds;
+    std::vector<std::string> deletedIds;
+};
+
+using TableApplyStates = std::unordered_map<Identifier, TableApplyState>;
+
+static std::string formatTableCounts(const TableApplyStates& tables, size_t TableApplyState::*count) {
+    std::vector<std::pair<std::string, size_t>> sorted;
+    for (const auto& entry : tables) {
+        if (entry.second.*count > 0) {
+            sorted.emplace_back(identifierName(entry.first), entry.second.*count);
+        }
+    }
+    if (sorted.empty()) {
         return "";
     }
-    std::vector<std::pair<std::string, size_t>> sorted(counts.begin(), counts.end());
     std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
     std::ostringstream out;
     for (size_t i = 0; i < sorted.size(); i++) {
@@ -840,29 +865,17 @@ bool applySyncPayload(sqlite3* db, const std::string& payload, std::string& erro
         return false;
     }
     
-    std::unordered_map<std::string, JsonValue> deletesByTable;
-    std::unordered_map<std::string, size_t> upsertsByTable;
-    std::unordered_map<std::string, size_t> deletesCountByTable;
-    std::unordered_set<std::string> skippedTables;
+    // Items usually come grouped by table: the last table's state is reused without a lookup
+    TableApplyStates tables;
+    std::string lastTable;
+    TableApplyState* state = nullptr;
     size_t totalItems = 0;
     size_t totalUpserts = 0;
     size_t totalDeletes = 0;
     size_t totalSkipped = 0;
-    std::string maxSequenceId;
-
-    // Conflict resolution: cache of locally-dirty records per table (lazy-loaded)
-    std::unordered_map<std::string, DirtyRecordCache> dirtyRecordCache;
-    std::unordered_set<std::string> loadedDirtyTables;
     size_t totalSkippedDirty = 0;
     size_t totalMerged = 0;
-    std::unordered_map<std::string, size_t> skippedDirtyByTable;
-    std::unordered_map<std::string, size_t> mergedByTable;
-
-    // MOBILE-6276: ids actually written (upsert or partial-merge) / hard-deleted this page, so the
-    // caller can tell the JS layer exactly what changed instead of guessing. Folded into `changeset`
-    // only after COMMIT succeeds.
-    std::unordered_map<std::string, std::vector<std::string>> upsertedIdsByTable;
-    std::unordered_map<std::string, std::vector<std::string>> deletedIdsByTable;
+    std::string maxSequenceId;
 
     for (const auto& entry : items->arrayValue) {
         if (entry.type != JsonValue::Type::Object) {
@@ -897,15 +910,19 @@ bool applySyncPayload(sqlite3* db, const std::string& payload, std::string& erro
             rowPtr = &rowPayload;
         }
         
+        if (!state || table != lastTable) {
+            state = &tables[internIdentifier(table)];
+            lastTable = table;
+        }
+
         // Skip tables that don't exist in the local SQLite schema.
         // This handles schema version mismatches where the API returns
         // data for tables the app hasn't created yet.
-        if (skippedTables.count(table)) {
-            totalSkipped++;
-            continue;
+        if (!state->existenceChecked) {
+            state->exists = tableExistsInDb(db, table);
+            state->existenceChecked = true;
         }
-        if (!tableExistsInDb(db, table)) {
-            skippedTables.insert(table);
+        if (!state->exists) {
             totalSkipped++;
             continue;
         }
@@ -923,16 +940,16 @@ bool applySyncPayload(sqlite3* db, const std::string& payload, std::string& erro
                                                 : (deleteId.type == JsonValue::Type::Number)
                                                       ? deleteId.numberValue
                                                       : std::string();
-            JsonValue& deleteArray = deletesByTable[table];
+            JsonValue& deleteArray = state->deletes;
             if (deleteArray.type != JsonValue::Type::Array) {
                 deleteArray.type = JsonValue::Type::Array;
                 deleteArray.arrayValue.clear();
             }
             deleteArray.arrayValue.emplace_back(std::move(deleteId));
             totalDeletes++;
-            deletesCountByTable[table]++;
+            state->deleteCount++;
             if (!deleteIdStr.empty()) {
-                deletedIdsByTable[table].push_back(deleteIdStr);
+                state->deletedIds.push_back(deleteIdStr);
             }
         } else {
             if (!rowPtr || rowPtr->type != JsonValue::Type::Object) {
@@ -946,23 +963,20 @@ bool applySyncPayload(sqlite3* db, const std::string& payload, std::string& erro
             readStringField(*rowPtr, "id", recordId);
 
             // Lazy-load dirty records for this table on first encounter
-            if (!recordId.empty() && loadedDirtyTables.find(table) == loadedDirtyTables.end()) {
-                if (!loadDirtyRecordsForTable(db, table, dirtyRecordCache[table], errorMessage)) {
+            if (!recordId.empty() && !state->dirtyLoaded) {
+                if (!loadDirtyRecordsForTable(db, table, state->dirtyRecords, errorMessage)) {
                     execSql(db, "ROLLBACK", errorMessage);
                     return false;
                 }
-                loadedDirtyTables.insert(table);
+                state->dirtyLoaded = true;
             }
 
             // Look up whether this record has local uncommitted changes
             const DirtyRecordInfo* dirtyInfo = nullptr;
             if (!recordId.empty()) {
-                auto tableIt = dirtyRecordCache.find(table);
-                if (tableIt != dirtyRecordCache.end()) {
-                    auto recordIt = tableIt->second.find(recordId);
-                    if (recordIt != tableIt->second.end()) {
-                        dirtyInfo = &recordIt->second;
-                    }
+                auto recordIt = state->dirtyRecords.find(recordId);
+                if (recordIt != state->dirtyRecords.end()) {
+                    dirtyInfo = &recordIt->second;
                 }
             }
 
@@ -972,7 +986,7 @@ bool applySyncPayload(sqlite3* db, const std::string& payload, std::string& erro
                 // which merges remote fields and resets _status to 'synced'. We skip entirely
                 // because locally-created records should not be server-mutated before push.
                 totalSkippedDirty++;
-                skippedDirtyByTable[table]++;
+                state->skippedDirty++;
             } else if (dirtyInfo && dirtyInfo->status == "updated") {
                 // Record has locally-modified columns — partial update, preserving _changed columns
                 if (!applyPartialUpdate(db, table, *rowPtr, recordId, dirtyInfo->changed, errorMessage)) {
@@ -980,9 +994,9 @@ bool applySyncPayload(sqlite3* db, const std::string& payload, std::string& erro
                     return false;
                 }
                 totalMerged++;
-                mergedByTable[table]++;
+                state->merged++;
                 if (!recordId.empty()) {
-                    upsertedIdsByTable[table].push_back(recordId);
+                    state->upsertedIds.push_back(recordId);
                 }
             } else {
                 // Record is synced or new — full overwrite
@@ -991,16 +1005,19 @@ bool applySyncPayload(sqlite3* db, const std::string& payload, std::string& erro
                     return false;
                 }
                 totalUpserts++;
-                upsertsByTable[table]++;
+                state->upserts++;
                 if (!recordId.empty()) {
-                    upsertedIdsByTable[table].push_back(recordId);
+                    state->upsertedIds.push_back(recordId);
                 }
             }
         }
     }
     
-    for (const auto& entry : deletesByTable) {
-        if (!applyDeletes(db, entry.first, entry.second, errorMessage)) {
+    for (const auto& entry : tables) {
+        if (entry.second.deleteCount == 0) {
+            continue;
+        }
+        if (!applyDeletes(db, identifierName(entry.first), entry.second.deletes, errorMessage)) {
             execSql(db, "ROLLBACK", errorMessage);
             return false;
         }
@@ -1020,17 +1037,18 @@ bool applySyncPayload(sqlite3* db, const std::string& payload, std::string& erro
 
     // MOBILE-6276: only after the page's transaction commits, append its committed ids into the
     // caller's accumulator (so a rolled-back page never leaks into the reported changeset).
-    for (auto& kv : upsertedIdsByTable) {
-        auto& dst = changeset[kv.first].upserted;
-        dst.insert(dst.end(), kv.second.begin(), kv.second.end());
-    }
-    for (auto& kv : deletedIdsByTable) {
-        auto& dst = changeset[kv.first].deleted;
-        dst.insert(dst.end(), kv.second.begin(), kv.second.end());
+    for (auto& entry : tables) {
+        TableApplyState& tableState = entry.second;
+        if (tableState.upsertedIds.empty() && tableState.deletedIds.empty()) {
+            continue;
+        }
+        TableChangeset& dst = changeset[identifierName(entry.first)];
+        dst.upserted.insert(dst.upserted.end(), tableState.upsertedIds.begin(), tableState.upsertedIds.end());
+        dst.deleted.insert(dst.deleted.end(), tableState.deletedIds.begin(), tableState.deletedIds.end());
     }
 
-    const std::string upsertsSummary = formatTableCounts(upsertsByTable);
-    const std::string deletesSummary = formatTableCounts(deletesCountByTable);
+    const std::string upsertsSummary = formatTableCounts(tables, &TableApplyState::upserts);
+    const std::string deletesSummary = formatTableCounts(tables, &TableApplyState::deleteCount);
     std::string message = "SyncApplyEngine batch applied: items=" + std::to_string(totalItems) +
                           ", upserts=" + std::to_string(totalUpserts) +
                           ", deletes=" + std::to_string(totalDeletes) +
@@ -1040,9 +1058,12 @@ bool applySyncPayload(sqlite3* db, const std::string& payload, std::string& erro
         message += ", skipped=" + std::to_string(totalSkipped);
         message += ", skippedTables=[";
         bool first = true;
-        for (const auto& t : skippedTables) {
+        for (const auto& entry : tables) {
+            if (entry.second.exists) {
+                continue;
+            }
             if (!first) message += ", ";
-            message += t;
+            message += identifierName(entry.first);
             first = false;
         }
         message += "]";
@@ -1054,13 +1075,13 @@ bool applySyncPayload(sqlite3* db, const std::string& payload, std::string& erro
         message += ", deletesByTable=[" + deletesSummary + "]";
     }
     if (totalSkippedDirty > 0) {
-        const std::string skippedDirtySummary = formatTableCounts(skippedDirtyByTable);
+        const std::string skippedDirtySummary = formatTableCounts(tables, &TableApplyState::skippedDirty);
         if (!skippedDirtySummary.empty()) {
             message += ", preservedDirtyByTable=[" + skippedDirtySummary + "]";
         }
     }
     if (totalMerged > 0) {
-        const std::string mergedSummary = formatTableCounts(mergedByTable);
+        const std::string mergedSummary = formatTableCounts(tables, &TableApplyState::merged);
         if (!mergedSummary.empty()) {
             message += ", mergedByTable=[" + mergedSummary + "]";
         }
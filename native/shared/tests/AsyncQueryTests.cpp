@@ -0,0 +1,278 @@
+#include "../AsyncQueryExecutor.h"
+
+#include <sqlite3.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+static int gFailures = 0;
+
+void expectTrue(bool value, const char* message) {
+    if (!value) {
+        std::cerr << "FAIL: " << message << "\n";
+        gFailures++;
+    }
+}
+
+bool execSql(sqlite3* db, const char* sql, std::string& error) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        if (errMsg) {
+            error = errMsg;
+            sqlite3_free(errMsg);
+        } else {
+            error = "sqlite3_exec failed";
+        }
+        return false;
+    }
+    return true;
+}
+
+void removeDatabase(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+sqlite3* openWriter(const std::string& path) {
+    removeDatabase(path);
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    std::string error;
+    execSql(db, "PRAGMA journal_mode=WAL", error);
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, name TEXT, position INTEGER)", error);
+    execSql(db, "INSERT INTO tasks (id, name, position) VALUES ('t1', 'alpha', 1), ('t2', 'bravo', 2)", error);
+    return db;
+}
+
+std::string fullPath(sqlite3* db) {
+    const char* filename = sqlite3_db_filename(db, "main");
+    return filename ? filename : "";
+}
+
+int64_t countRows(sqlite3* db) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT count(*) FROM tasks", -1, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+    int64_t count = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        count = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+// Completion of one query, waited for on the test thread
+struct Outcome {
+    std::mutex mutex;
+    std::condition_variable done;
+    bool completed = false;
+    watermelondb::AsyncQueryStatus status = watermelondb::AsyncQueryStatus::Failed;
+    std::shared_ptr<const watermelondb::PackedResultSnapshot> result;
+    std::string errorMessage;
+    int calls = 0;
+
+    watermelondb::AsyncQueryExecutor::Completion completion() {
+        return [this](watermelondb::AsyncQueryStatus queryStatus,
+                      std::shared_ptr<const watermelondb::PackedResultSnapshot> queryResult,
+                      const std::string& queryError) {
+            // Notified under the lock: the waiter may destroy the Outcome as soon as it wakes up
+            const std::lock_guard<std::mutex> lock(mutex);
+            status = queryStatus;
+            result = std::move(queryResult);
+            errorMessage = queryError;
+            completed = true;
+            calls++;
+            done.notify_all();
+        };
+    }
+
+    bool wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return completed; });
+        return completed;
+    }
+};
+
+watermelondb::QueryArgument textArgument(const std::string& text) {
+    watermelondb::QueryArgument argument;
+    argument.type = watermelondb::QueryArgument::Type::Text;
+    argument.text = text;
+    return argument;
+}
+
+watermelondb::QueryArgument numberArgument(double number) {
+    watermelondb::QueryArgument argument;
+    argument.type = watermelondb::QueryArgument::Type::Number;
+    argument.number = number;
+    return argument;
+}
+
+std::string cellText(const watermelondb::PackedResultSnapshot& result, size_t row, size_t column) {
+    const auto cell = result.cell(row, column);
+    return cell.tag == watermelondb::PackedTag::TEXT ? std::string(cell.text, cell.length) : "";
+}
+
+void test_completes_with_snapshot() {
+    sqlite3* writer = openWriter("async_query_test.db");
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 2);
+    watermelondb::AsyncQueryExecutor executor(2);
+
+    Outcome outcome;
+    executor.submit(1, pool, "SELECT id, name, position FROM tasks WHERE position >= ? AND name != ? ORDER BY position",
+                    {numberArgument(1), textArgument("bravo")}, outcome.completion());
+    expectTrue(outcome.wait(), "query should complete");
+    expectTrue(outcome.status == watermelondb::AsyncQueryStatus::Completed, "query should succeed");
+    expectTrue(outcome.result && outcome.result->rowCount() == 1, "query should return one row");
+    if (outcome.result && outcome.result->rowCount() == 1) {
+        expectTrue(cellText(*outcome.result, 0, 0) == "t1", "row should be t1");
+        expectTrue(outcome.result->cell(0, 2).number == 1, "position should be a number");
+    }
+
+    // Committed writes are visible to queries submitted after them
+    std::string error;
+    execSql(writer, "INSERT INTO tasks (id, name, position) VALUES ('t3', 'charlie', 3)", error);
+    Outcome afterWrite;
+    executor.submit(2, pool, "SELECT count(*) AS count FROM tasks", {}, afterWrite.completion());
+    expectTrue(afterWrite.wait(), "query after write should complete");
+    expectTrue(afterWrite.result && afterWrite.result->cell(0, 0).number == 3, "query should see the committed write");
+
+    // ... but not a writer transaction still in progress
+    execSql(writer, "BEGIN", error);
+    execSql(writer, "INSERT INTO tasks (id, name, position) VALUES ('t4', 'delta', 4)", error);
+    Outcome duringWrite;
+    executor.submit(3, pool, "SELECT count(*) AS count FROM tasks", {}, duringWrite.completion());
+    expectTrue(duringWrite.wait(), "query during write should complete");
+    expectTrue(duringWrite.result && duringWrite.result->cell(0, 0).number == 3,
+               "query should not see an uncommitted write");
+    execSql(writer, "COMMIT", error);
+
+    expectTrue(executor.inFlight() == 0, "no query should be left in flight");
+    pool->close();
+    sqlite3_close(writer);
+    removeDatabase("async_query_test.db");
+}
+
+void test_failures() {
+    sqlite3* writer = openWriter("async_query_failures_test.db");
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 1);
+    watermelondb::AsyncQueryExecutor executor(1);
+
+    Outcome write;
+    executor.submit(1, pool, "DELETE FROM tasks", {}, write.completion());
+    expectTrue(write.wait(), "write should complete");
+    expectTrue(write.status == watermelondb::AsyncQueryStatus::Failed, "writes should be rejected");
+    expectTrue(write.errorMessage.find("read-only") != std::string::npos, "error should say why");
+    expectTrue(countRows(writer) == 2, "rejected write should not run");
+
+    Outcome arguments;
+    executor.submit(2, pool, "SELECT * FROM tasks WHERE id = ?", {}, arguments.completion());
+    expectTrue(arguments.wait(), "query with missing args should complete");
+    expectTrue(arguments.status == watermelondb::AsyncQueryStatus::Failed, "missing args should fail");
+
+    Outcome syntax;
+    executor.submit(3, pool, "SELEKT 1", {}, syntax.completion());
+    expectTrue(syntax.wait(), "invalid query should complete");
+    expectTrue(syntax.status == watermelondb::AsyncQueryStatus::Failed, "invalid query should fail");
+    expectTrue(!syntax.errorMessage.empty(), "invalid query should have an error message");
+
+    pool->close();
+    Outcome closed;
+    executor.submit(4, pool, "SELECT 1", {}, closed.completion());
+    expectTrue(closed.wait(), "query on a closed pool should complete");
+    expectTrue(closed.status == watermelondb::AsyncQueryStatus::Failed, "query on a closed pool should fail");
+
+    sqlite3_close(writer);
+    removeDatabase("async_query_failures_test.db");
+}
+
+void test_cancel() {
+    sqlite3* writer = openWriter("async_query_cancel_test.db");
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 1);
+    watermelondb::AsyncQueryExecutor executor(1);
+
+    // Occupies the only worker until it is interrupted
+    const char* endless = "WITH RECURSIVE counter(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM counter) "
+                          "SELECT count(*) FROM counter";
+    Outcome running;
+    executor.submit(1, pool, endless, {}, running.completion());
+    Outcome queued;
+    executor.submit(2, pool, "SELECT * FROM tasks", {}, queued.completion());
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    expectTrue(executor.cancel(2), "queued query should be cancellable");
+    {
+        const std::lock_guard<std::mutex> lock(queued.mutex);
+        expectTrue(queued.completed, "queued query should complete as soon as it's cancelled");
+        expectTrue(queued.status == watermelondb::AsyncQueryStatus::Cancelled, "queued query should be cancelled");
+    }
+
+    expectTrue(executor.cancel(1), "running query should be cancellable");
+    expectTrue(running.wait(), "running query should be interrupted");
+    expectTrue(running.status == watermelondb::AsyncQueryStatus::Cancelled, "running query should be cancelled");
+    expectTrue(!running.result, "cancelled query should have no result");
+
+    expectTrue(!executor.cancel(1), "completed query should not be cancellable");
+    expectTrue(!executor.cancel(42), "unknown query should not be cancellable");
+
+    // The interrupted connection is back in the pool and usable
+    Outcome after;
+    executor.submit(3, pool, "SELECT * FROM tasks", {}, after.completion());
+    expectTrue(after.wait(), "query after cancel should complete");
+    expectTrue(after.status == watermelondb::AsyncQueryStatus::Completed, "query after cancel should succeed");
+    expectTrue(after.result && after.result->rowCount() == 2, "query after cancel should return rows");
+    expectTrue(running.calls == 1 && queued.calls == 1, "completions should run once");
+
+    pool->close();
+    sqlite3_close(writer);
+    removeDatabase("async_query_cancel_test.db");
+}
+
+void test_destructor_cancels() {
+    sqlite3* writer = openWriter("async_query_shutdown_test.db");
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 1);
+    Outcome running;
+    Outcome queued;
+    {
+        watermelondb::AsyncQueryExecutor executor(1);
+        executor.submit(1, pool,
+                        "WITH RECURSIVE counter(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM counter) "
+                        "SELECT count(*) FROM counter",
+                        {}, running.completion());
+        executor.submit(2, pool, "SELECT 1", {}, queued.completion());
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    expectTrue(running.completed && running.status == watermelondb::AsyncQueryStatus::Cancelled,
+               "running query should be cancelled on shutdown");
+    expectTrue(queued.completed && queued.status == watermelondb::AsyncQueryStatus::Cancelled,
+               "queued query should be cancelled on shutdown");
+
+    pool->close();
+    sqlite3_close(writer);
+    removeDatabase("async_query_shutdown_test.db");
+}
+
+} // namespace
+
+int main() {
+    test_completes_with_snapshot();
+    test_failures();
+    test_cancel();
+    test_destructor_cancels();
+
+    if (gFailures > 0) {
+        std::cerr << gFailures << " test(s) failed\n";
+        return 1;
+    }
+    std::cout << "All AsyncQueryExecutor tests passed\n";
+    return 0;
+}
@@ -0,0 +1,288 @@
+#include "../BoundArrayVirtualTable.h"
+#include "../AsyncQueryExecutor.h"
+#include "../SqliteStatementCache.h"
+
+#include <sqlite3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+static int gFailures = 0;
+
+void expectTrue(bool value, const char* message) {
+    if (!value) {
+        std::cerr << "FAIL: " << message << "\n";
+        gFailures++;
+    }
+}
+
+bool execSql(sqlite3* db, const char* sql, std::string& error) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        if (errMsg) {
+            error = errMsg;
+            sqlite3_free(errMsg);
+        } else {
+            error = "sqlite3_exec failed";
+        }
+        return false;
+    }
+    return true;
+}
+
+// `rowCount` tasks "t1"... with positions 1...rowCount
+sqlite3* openDatabase(int rowCount) {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, name TEXT, position INTEGER)", error);
+    execSql(db, "BEGIN", error);
+    sqlite3_stmt* insert = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO tasks (id, name, position) VALUES (?, ?, ?)", -1, &insert, nullptr);
+    for (int i = 1; i <= rowCount; i++) {
+        const std::string id = "t" + std::to_string(i);
+        const std::string name = "task " + std::to_string(i);
+        sqlite3_bind_text(insert, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(insert, 2, name.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(insert, 3, i);
+        sqlite3_step(insert);
+        sqlite3_reset(insert);
+    }
+    sqlite3_finalize(insert);
+    execSql(db, "COMMIT", error);
+    return db;
+}
+
+watermelondb::BoundArrayValue text(const std::string& value) {
+    watermelondb::BoundArrayValue element;
+    element.type = watermelondb::BoundArrayValue::Type::Text;
+    element.text = value;
+    return element;
+}
+
+watermelondb::BoundArrayValue number(double value) {
+    watermelondb::BoundArrayValue element;
+    element.type = watermelondb::BoundArrayValue::Type::Number;
+    element.number = value;
+    return element;
+}
+
+std::shared_ptr<watermelondb::BoundArray> ids(int from, int to) {
+    auto values = std::make_shared<watermelondb::BoundArray>();
+    for (int i = from; i <= to; i++) {
+        values->push_back(text("t" + std::to_string(i)));
+    }
+    return values;
+}
+
+// Steps `stmt` to the end and returns the first column of each row
+std::vector<std::string> readColumn(sqlite3_stmt* stmt) {
+    std::vector<std::string> values;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const auto* value = sqlite3_column_text(stmt, 0);
+        values.emplace_back(value ? reinterpret_cast<const char*>(value) : "");
+    }
+    return values;
+}
+
+void test_in_list() {
+    sqlite3* db = openDatabase(5);
+    std::string error;
+    expectTrue(watermelondb::registerBoundArrayModule(db, error), "module should register");
+    expectTrue(watermelondb::registerBoundArrayModule(db, error), "registering again should be a no-op");
+
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db, "SELECT id FROM tasks WHERE id IN bound_array(?) ORDER BY position", -1, &stmt, nullptr);
+    expectTrue(stmt != nullptr, "query with bound_array should prepare");
+
+    auto values = std::make_shared<watermelondb::BoundArray>();
+    values->push_back(text("t4"));
+    values->push_back(text("t2"));
+    values->push_back(text("missing"));
+    values->push_back(watermelondb::BoundArrayValue());
+    expectTrue(watermelondb::bindBoundArray(stmt, 1, values) == SQLITE_OK, "array should bind");
+    auto rows = readColumn(stmt);
+    expectTrue(rows.size() == 2 && rows[0] == "t2" && rows[1] == "t4", "query should return the listed rows");
+
+    // Rebinding releases the previous values
+    sqlite3_reset(stmt);
+    expectTrue(watermelondb::bindBoundArray(stmt, 1, std::make_shared<watermelondb::BoundArray>()) == SQLITE_OK,
+               "empty array should bind");
+    expectTrue(values.use_count() == 1, "statement should release values when rebound");
+    expectTrue(readColumn(stmt).empty(), "empty array should match nothing");
+
+    // Anything but an array matches nothing
+    sqlite3_reset(stmt);
+    sqlite3_bind_text(stmt, 1, "t1", -1, SQLITE_TRANSIENT);
+    expectTrue(readColumn(stmt).empty(), "a scalar should not be read as an array");
+    sqlite3_finalize(stmt);
+
+    // Numbers compare with numeric columns
+    sqlite3_prepare_v2(db, "SELECT id FROM tasks WHERE position IN bound_array(?1) OR position = ?2 ORDER BY position", -1,
+                       &stmt, nullptr);
+    auto positions = std::make_shared<watermelondb::BoundArray>();
+    positions->push_back(number(1));
+    positions->push_back(number(3));
+    watermelondb::bindBoundArray(stmt, 1, positions);
+    sqlite3_bind_int(stmt, 2, 5);
+    rows = readColumn(stmt);
+    expectTrue(rows.size() == 3 && rows[0] == "t1" && rows[1] == "t3" && rows[2] == "t5",
+               "numbers should match integer columns");
+    sqlite3_finalize(stmt);
+    expectTrue(positions.use_count() == 1, "finalizing should release values");
+
+    // Also as a table in joins and subqueries
+    sqlite3_prepare_v2(db, "SELECT count(*) FROM bound_array(?)", -1, &stmt, nullptr);
+    watermelondb::bindBoundArray(stmt, 1, ids(1, 7));
+    rows = readColumn(stmt);
+    expectTrue(rows.size() == 1 && rows[0] == "7", "bound_array should be selectable as a table");
+    sqlite3_finalize(stmt);
+
+    sqlite3_close(db);
+}
+
+// One placeholder whatever the list length: more ids than SQLITE_MAX_VARIABLE_NUMBER allows, and
+// the same cached statement for every length
+void test_long_lists_and_cache() {
+    sqlite3* db = openDatabase(50000);
+    std::string error;
+    watermelondb::registerBoundArrayModule(db, error);
+    watermelondb::SqliteStatementCache cache(db);
+    const std::string sql = "SELECT count(*) FROM tasks WHERE id IN bound_array(?)";
+
+    const int lengths[] = {10, 40000, 3};
+    for (int length : lengths) {
+        int resultCode = SQLITE_OK;
+        sqlite3_stmt* stmt = cache.acquire(sql, resultCode);
+        expectTrue(stmt != nullptr, "cached statement should prepare");
+        if (!stmt) {
+            continue;
+        }
+        auto values = ids(1, length);
+        expectTrue(watermelondb::bindBoundArray(stmt, 1, values) == SQLITE_OK, "long array should bind");
+        auto rows = readColumn(stmt);
+        expectTrue(rows.size() == 1 && rows[0] == std::to_string(length), "query should match every listed id");
+        cache.release(stmt);
+        expectTrue(values.use_count() == 1, "releasing to the cache should clear the binding");
+    }
+    auto stats = cache.stats();
+    expectTrue(stats.misses == 1 && stats.hits == 2, "every list length should share one statement");
+
+    cache.clear();
+    sqlite3_close(db);
+}
+
+void test_query_arguments() {
+    sqlite3* db = openDatabase(5);
+    std::string error;
+    watermelondb::registerBoundArrayModule(db, error);
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db, "SELECT id FROM tasks WHERE id IN bound_array(?) AND position > ? ORDER BY position", -1, &stmt,
+                       nullptr);
+
+    watermelondb::QueryArgument list;
+    list.type = watermelondb::QueryArgument::Type::Array;
+    list.array = ids(1, 4);
+    watermelondb::QueryArgument minimum;
+    minimum.type = watermelondb::QueryArgument::Type::Number;
+    minimum.number = 2;
+    expectTrue(watermelondb::bindQueryArguments(stmt, {list, minimum}, error), "array argument should bind");
+    auto rows = readColumn(stmt);
+    expectTrue(rows.size() == 2 && rows[0] == "t3" && rows[1] == "t4", "array argument should filter rows");
+    sqlite3_finalize(stmt);
+    expectTrue(list.array.use_count() == 1, "array argument should be released with the statement");
+
+    sqlite3_close(db);
+}
+
+// Connections are forgotten when closed, so a new connection (maybe at the same address) gets the
+// module again
+void test_registration() {
+    expectTrue(watermelondb::usesBoundArray("SELECT * FROM t WHERE id IN bound_array(?)"), "bound_array call is detected");
+    expectTrue(!watermelondb::usesBoundArray("SELECT * FROM t WHERE id IN (?, ?)"), "plain SQL doesn't need the module");
+
+    for (int i = 0; i < 3; i++) {
+        sqlite3* db = openDatabase(2);
+        std::string error;
+        expectTrue(watermelondb::registerBoundArrayModule(db, error), "module should register on a new connection");
+        sqlite3_stmt* stmt = nullptr;
+        expectTrue(sqlite3_prepare_v2(db, "SELECT value FROM bound_array(?)", -1, &stmt, nullptr) == SQLITE_OK,
+                   "new connection should have bound_array");
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+    }
+}
+
+// bound_array_tests --benchmark [ids]: `queries` lookups of `idCount` ids each, with the ids inlined
+// in the SQL (a new statement per list, as Q.oneOf encodes them) vs bound to one cached statement
+void benchmark_in_lists(int idCount) {
+    const int queries = 20;
+    sqlite3* db = openDatabase(std::max(idCount * 2, 1000));
+    std::string error;
+    watermelondb::registerBoundArrayModule(db, error);
+
+    using Clock = std::chrono::steady_clock;
+    auto millis = [](Clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+
+    {
+        const auto start = Clock::now();
+        size_t matched = 0;
+        for (int q = 0; q < queries; q++) {
+            std::string sql = "SELECT id, name FROM tasks WHERE id IN (";
+            for (int i = 1; i <= idCount; i++) {
+                sql += (i > 1 ? ", 't" : "'t") + std::to_string(i + q) + "'";
+            }
+            sql += ")";
+            sqlite3_stmt* stmt = nullptr;
+            sqlite3_prepare_v2(db, sql.c_str(), static_cast<int>(sql.size()), &stmt, nullptr);
+            matched += readColumn(stmt).size();
+            sqlite3_finalize(stmt);
+        }
+        std::printf("%-12s %8.2f ms per query (%zu rows)\n", "inlined", millis(Clock::now() - start) / queries, matched);
+    }
+    {
+        watermelondb::SqliteStatementCache cache(db);
+        const auto start = Clock::now();
+        size_t matched = 0;
+        for (int q = 0; q < queries; q++) {
+            int resultCode = SQLITE_OK;
+            sqlite3_stmt* stmt = cache.acquire("SELECT id, name FROM tasks WHERE id IN bound_array(?)", resultCode);
+            watermelondb::bindBoundArray(stmt, 1, ids(1 + q, idCount + q));
+            matched += readColumn(stmt).size();
+            cache.release(stmt);
+        }
+        std::printf("%-12s %8.2f ms per query (%zu rows)\n", "bound_array", millis(Clock::now() - start) / queries,
+                    matched);
+        cache.clear();
+    }
+
+    sqlite3_close(db);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+        benchmark_in_lists(argc > 2 ? std::atoi(argv[2]) : 10000);
+        return 0;
+    }
+
+    test_in_list();
+    test_long_lists_and_cache();
+    test_query_arguments();
+    test_registration();
+
+    if (gFailures > 0) {
+        std::cerr << gFailures << " test(s) failed\n";
+        return 1;
+    }
+    std::cout << "All bound_array tests passed\n";
+    return 0;
+}
@@ -1,9 +1,15 @@
 #include "../DatabaseUtils.h"
+#include "../AsciiScan.h"
+#include "../PackedResult.h"
 
 #include <hermes/hermes.h>
 #include <jsi/jsi.h>
 #include <sqlite3.h>
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -127,13 +133,347 @@ void test_arrayFromStd_and_getNextRowOrTrue() {
     sqlite3_close(db);
 }
 
+void test_isAscii() {
+    expectTrue(watermelondb::isAscii("", 0), "empty string is ASCII");
+    std::string text(100, 'a');
+    for (size_t length : {1, 7, 8, 15, 16, 17, 31, 32, 33, 100}) {
+        expectTrue(watermelondb::isAscii(text.data(), length), "plain text should be ASCII");
+        for (size_t position : {size_t(0), length / 2, length - 1}) {
+            std::string withHighByte = text.substr(0, length);
+            withHighByte[position] = static_cast<char>(0xC3);
+            expectTrue(!watermelondb::isAscii(withHighByte.data(), length), "a byte >= 0x80 should be found anywhere");
+        }
+    }
+}
+
+void test_resultDictionary_with_column_names() {
+    auto runtime = facebook::hermes::makeHermesRuntime();
+    auto& rt = *runtime;
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, name TEXT, \"nazwa_zadania_ż\" TEXT)", error);
+    execSql(db, "INSERT INTO tasks VALUES ('t1', 'alpha', 'zażółć gęślą jaźń'), ('t2', 'a much longer ascii name', NULL)", error);
+
+    jsi::Array args(rt, 0);
+    sqlite3_stmt* stmt = watermelondb::getStmt(rt, db, "SELECT * FROM tasks ORDER BY id", args);
+    auto columns = watermelondb::columnNames(rt, stmt);
+    expectTrue(columns.size() == 3, "one property name per column");
+
+    expectTrue(!watermelondb::getNextRowOrTrue(rt, stmt), "expected first row");
+    jsi::Object first = watermelondb::resultDictionary(rt, stmt, columns);
+    expectTrue(first.getProperty(rt, "name").asString(rt).utf8(rt) == "alpha", "ASCII text should match");
+    expectTrue(first.getProperty(rt, "nazwa_zadania_ż").asString(rt).utf8(rt) == "zażółć gęślą jaźń",
+               "non-ASCII column names and text should round-trip");
+
+    expectTrue(!watermelondb::getNextRowOrTrue(rt, stmt), "expected second row");
+    jsi::Object second = watermelondb::resultDictionary(rt, stmt, columns);
+    expectTrue(second.getProperty(rt, "name").asString(rt).utf8(rt) == "a much longer ascii name",
+               "property names should be reused for every row");
+    expectTrue(second.getProperty(rt, "nazwa_zadania_ż").isNull(), "NULL should map to null");
+
+    watermelondb::finalizeStmt(stmt);
+    sqlite3_close(db);
+}
+
+void test_columnarResult() {
+    auto runtime = facebook::hermes::makeHermesRuntime();
+    auto& rt = *runtime;
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, position INTEGER, score REAL, name TEXT)", error);
+    execSql(db, "INSERT INTO tasks VALUES ('t1', 1, 0.5, 'alpha'), ('t2', 2, NULL, NULL), ('t3', 3, 2.5, 'ż')", error);
+
+    jsi::Array args(rt, 0);
+    sqlite3_stmt* stmt = watermelondb::getStmt(rt, db, "SELECT * FROM tasks ORDER BY id", args);
+    jsi::Object result = watermelondb::columnarResult(rt, stmt);
+    watermelondb::finalizeStmt(stmt);
+
+    expectTrue(result.getProperty(rt, "rowCount").asNumber() == 3, "rowCount should count rows");
+    jsi::Array columns = result.getProperty(rt, "columns").asObject(rt).asArray(rt);
+    expectTrue(columns.length(rt) == 4, "one name per column");
+    expectTrue(columns.getValueAtIndex(rt, 1).asString(rt).utf8(rt) == "position", "column names in order");
+
+    jsi::Array values = result.getProperty(rt, "values").asObject(rt).asArray(rt);
+    jsi::Object position = values.getValueAtIndex(rt, 1).asObject(rt);
+    jsi::Function float64Array = rt.global().getPropertyAsFunction(rt, "Float64Array");
+    expectTrue(position.instanceOf(rt, float64Array), "all-integer column should be a Float64Array");
+    expectTrue(position.getProperty(rt, "length").asNumber() == 3, "typed array holds every row");
+    expectTrue(position.getProperty(rt, "2").asNumber() == 3, "typed array values in row order");
+
+    jsi::Object score = values.getValueAtIndex(rt, 2).asObject(rt);
+    expectTrue(score.isArray(rt), "column with a NULL should be a plain array");
+    jsi::Array scoreArray = score.asArray(rt);
+    expectTrue(scoreArray.getValueAtIndex(rt, 0).asNumber() == 0.5, "numbers before the NULL are kept");
+    expectTrue(scoreArray.getValueAtIndex(rt, 1).isNull(), "NULL maps to null");
+    expectTrue(scoreArray.getValueAtIndex(rt, 2).asNumber() == 2.5, "numbers after the NULL are kept");
+
+    jsi::Array names = values.getValueAtIndex(rt, 3).asObject(rt).asArray(rt);
+    expectTrue(names.getValueAtIndex(rt, 2).asString(rt).utf8(rt) == "ż", "non-ASCII text should round-trip");
+
+    stmt = watermelondb::getStmt(rt, db, "SELECT id, position FROM tasks WHERE 0", args);
+    jsi::Object empty = watermelondb::columnarResult(rt, stmt);
+    watermelondb::finalizeStmt(stmt);
+    expectTrue(empty.getProperty(rt, "rowCount").asNumber() == 0, "empty result has no rows");
+    jsi::Array emptyValues = empty.getProperty(rt, "values").asObject(rt).asArray(rt);
+    expectTrue(emptyValues.getValueAtIndex(rt, 1).asObject(rt).isArray(rt), "empty columns are plain arrays");
+
+    sqlite3_close(db);
+}
+
+void test_packedResult() {
+    auto runtime = facebook::hermes::makeHermesRuntime();
+    auto& rt = *runtime;
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, position INTEGER)", error);
+    execSql(db, "INSERT INTO tasks VALUES ('t1', 1), ('t2', 2)", error);
+
+    jsi::Array args(rt, 0);
+    sqlite3_stmt* stmt = watermelondb::getStmt(rt, db, "SELECT * FROM tasks", args);
+    jsi::ArrayBuffer buffer = watermelondb::packedResult(rt, stmt);
+    watermelondb::finalizeStmt(stmt);
+
+    expectTrue(buffer.size(rt) > watermelondb::PACKED_RESULT_HEADER_SIZE, "buffer holds the encoded rows");
+    uint32_t magic = 0;
+    std::memcpy(&magic, buffer.data(rt), sizeof(magic));
+    expectTrue(magic == watermelondb::PACKED_RESULT_MAGIC, "buffer starts with the packed result header");
+
+    stmt = watermelondb::getStmt(rt, db, "SELECT x'00'", args);
+    bool threw = false;
+    try {
+        watermelondb::packedResult(rt, stmt);
+    } catch (const jsi::JSError&) {
+        threw = true;
+    }
+    watermelondb::finalizeStmt(stmt);
+    expectTrue(threw, "encoding errors should throw a JSError");
+
+    sqlite3_close(db);
+}
+
+void test_lazyRowsResult() {
+    auto runtime = facebook::hermes::makeHermesRuntime();
+    auto& rt = *runtime;
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, position INTEGER, name TEXT)", error);
+    execSql(db, "INSERT INTO tasks VALUES ('t1', 1, 'zażółć'), ('t2', 2, NULL)", error);
+
+    jsi::Array args(rt, 0);
+    sqlite3_stmt* stmt = watermelondb::getStmt(rt, db, "SELECT * FROM tasks ORDER BY id", args);
+    jsi::Array rows = watermelondb::lazyRowsResult(rt, stmt);
+    watermelondb::finalizeStmt(stmt);
+    // Rows read from the snapshot, not the statement
+    sqlite3_close(db);
+
+    expectTrue(rows.length(rt) == 2, "one row per result row");
+    jsi::Object first = rows.getValueAtIndex(rt, 0).asObject(rt);
+    expectTrue(first.isHostObject(rt), "rows are host objects");
+    expectTrue(first.getProperty(rt, "id").asString(rt).utf8(rt) == "t1", "text column");
+    expectTrue(first.getProperty(rt, "position").asNumber() == 1, "number column");
+    expectTrue(first.getProperty(rt, "name").asString(rt).utf8(rt) == "zażółć", "non-ASCII text");
+    expectTrue(first.getProperty(rt, "missing").isUndefined(), "unknown column is undefined");
+
+    jsi::Object second = rows.getValueAtIndex(rt, 1).asObject(rt);
+    expectTrue(second.getProperty(rt, "name").isNull(), "NULL maps to null");
+    expectTrue(second.getPropertyNames(rt).length(rt) == 3, "every column is enumerable");
+
+    bool threw = false;
+    try {
+        second.setProperty(rt, "name", jsi::Value(1));
+    } catch (const jsi::JSError&) {
+        threw = true;
+    }
+    expectTrue(threw, "rows are read-only");
+}
+
+void test_snapshotResults() {
+    auto runtime = facebook::hermes::makeHermesRuntime();
+    auto& rt = *runtime;
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, position INTEGER, name TEXT)", error);
+    execSql(db, "INSERT INTO tasks VALUES ('t1', 1, 'zażółć'), ('t2', 2, NULL)", error);
+
+    jsi::Array args(rt, 3);
+    args.setValueAtIndex(rt, 0, jsi::String::createFromAscii(rt, "t1"));
+    args.setValueAtIndex(rt, 1, jsi::Value(true));
+    args.setValueAtIndex(rt, 2, jsi::Value::null());
+    auto arguments = watermelondb::queryArguments(rt, args);
+    expectTrue(arguments.size() == 3, "one argument per value");
+    expectTrue(arguments[0].type == watermelondb::QueryArgument::Type::Text && arguments[0].text == "t1", "text argument");
+    expectTrue(arguments[1].type == watermelondb::QueryArgument::Type::Number && arguments[1].number == 1, "bool argument");
+    expectTrue(arguments[2].type == watermelondb::QueryArgument::Type::Null, "null argument");
+
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db, "SELECT * FROM tasks ORDER BY id", -1, &stmt, nullptr);
+    auto snapshot = watermelondb::PackedResultSnapshot::fromStatement(stmt, error);
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    expectTrue(snapshot != nullptr, "snapshot should be created");
+    if (!snapshot) {
+        return;
+    }
+
+    jsi::Array rows = watermelondb::snapshotRows(rt, *snapshot);
+    expectTrue(rows.length(rt) == 2, "one object per row");
+    jsi::Object first = rows.getValueAtIndex(rt, 0).asObject(rt);
+    expectTrue(first.getProperty(rt, "name").asString(rt).utf8(rt) == "zażółć", "non-ASCII text");
+    expectTrue(first.getProperty(rt, "position").asNumber() == 1, "number column");
+    expectTrue(rows.getValueAtIndex(rt, 1).asObject(rt).getProperty(rt, "name").isNull(), "NULL maps to null");
+
+    std::vector<std::string> marked;
+    jsi::Array records = watermelondb::snapshotRecords(rt, *snapshot, [&](const char* id, size_t length) {
+        std::string value(id, length);
+        if (value == "t1") {
+            return true;
+        }
+        marked.push_back(value);
+        return false;
+    });
+    expectTrue(records.length(rt) == 2, "one record per row");
+    expectTrue(records.getValueAtIndex(rt, 0).asString(rt).utf8(rt) == "t1", "cached record is its id");
+    expectTrue(records.getValueAtIndex(rt, 1).asObject(rt).getProperty(rt, "id").asString(rt).utf8(rt) == "t2",
+               "uncached record is its row");
+    expectTrue(marked.size() == 1 && marked[0] == "t2", "uncached records are marked");
+}
+
+// resultDictionary before property names were built once per statement: a PropNameID per cell,
+// created from the C string, and every text value decoded as UTF-8
+jsi::Object legacyResultDictionary(jsi::Runtime &rt, sqlite3_stmt *statement) {
+    jsi::Object dictionary(rt);
+    for (int i = 0, len = sqlite3_column_count(statement); i < len; i++) {
+        const char *column = sqlite3_column_name(statement, i);
+        auto type = sqlite3_column_type(statement, i);
+        if (type == SQLITE_INTEGER) {
+            dictionary.setProperty(rt, column, jsi::Value((double)sqlite3_column_int64(statement, i)));
+        } else if (type == SQLITE_FLOAT) {
+            dictionary.setProperty(rt, column, jsi::Value(sqlite3_column_double(statement, i)));
+        } else if (type == SQLITE_TEXT) {
+            const char *text = (const char *)sqlite3_column_text(statement, i);
+            dictionary.setProperty(rt, column, jsi::String::createFromUtf8(rt, text));
+        } else {
+            dictionary.setProperty(rt, column, jsi::Value::null());
+        }
+    }
+    return dictionary;
+}
+
+// database_utils_tests --benchmark [rows]: reads a 30-column table into JS objects, the way the
+// JSI query path does, with per-cell and per-statement property names, and in the columnar shape
+void benchmark_resultDictionary(int rowCount) {
+    auto runtime = facebook::hermes::makeHermesRuntime();
+    auto& rt = *runtime;
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+
+    const int columnCount = 30;
+    std::string createSql = "CREATE TABLE tasks (id TEXT PRIMARY KEY";
+    std::string insertSql = "INSERT INTO tasks VALUES (?";
+    for (int c = 1; c < columnCount; c++) {
+        createSql += ", column_" + std::to_string(c);
+        insertSql += ", ?";
+    }
+    execSql(db, (createSql + ")").c_str(), error);
+    execSql(db, "BEGIN", error);
+    sqlite3_stmt* insert = nullptr;
+    sqlite3_prepare_v2(db, (insertSql + ")").c_str(), -1, &insert, nullptr);
+    for (int r = 0; r < rowCount; r++) {
+        std::string id = "record" + std::to_string(r);
+        sqlite3_bind_text(insert, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+        for (int c = 1; c < columnCount; c++) {
+            if (c % 3 == 0) {
+                sqlite3_bind_int64(insert, c + 1, r * c);
+            } else if (c % 3 == 1) {
+                sqlite3_bind_text(insert, c + 1, "some synced text value", -1, SQLITE_STATIC);
+            } else {
+                sqlite3_bind_null(insert, c + 1);
+            }
+        }
+        sqlite3_step(insert);
+        sqlite3_reset(insert);
+    }
+    sqlite3_finalize(insert);
+    execSql(db, "COMMIT", error);
+
+    const int runs = 3;
+    for (int mode : {0, 1, 2, 3, 4}) {
+        const bool perStatement = mode == 1;
+        double best = 0;
+        for (int run = 0; run < runs; run++) {
+            auto start = std::chrono::steady_clock::now();
+            jsi::Array args(rt, 0);
+            sqlite3_stmt* stmt = watermelondb::getStmt(rt, db, "SELECT * FROM tasks", args);
+            std::vector<jsi::Value> records;
+            records.reserve(rowCount);
+            if (mode == 4) {
+                // What a list screen does: a few columns of every row
+                jsi::Array rows = watermelondb::lazyRowsResult(rt, stmt);
+                for (size_t i = 0, length = rows.length(rt); i < length; i++) {
+                    jsi::Object row = rows.getValueAtIndex(rt, i).asObject(rt);
+                    for (const char* column : {"id", "column_1", "column_3", "column_4"}) {
+                        records.push_back(row.getProperty(rt, column));
+                    }
+                }
+            } else if (mode == 3) {
+                records.push_back(watermelondb::packedResult(rt, stmt));
+            } else if (mode == 2) {
+                records.push_back(watermelondb::columnarResult(rt, stmt));
+            } else if (perStatement) {
+                auto columns = watermelondb::columnNames(rt, stmt);
+                while (!watermelondb::getNextRowOrTrue(rt, stmt)) {
+                    records.push_back(watermelondb::resultDictionary(rt, stmt, columns));
+                }
+            } else {
+                while (!watermelondb::getNextRowOrTrue(rt, stmt)) {
+                    records.push_back(legacyResultDictionary(rt, stmt));
+                }
+            }
+            watermelondb::finalizeStmt(stmt);
+            auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (run == 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        std::printf("  %-42s %8.1f ms  (%d rows x %d columns, best of %d)\n",
+                    mode == 4 ? "lazy rows, 4 columns read per row"
+                        : mode == 3 ? "packed (one ArrayBuffer)"
+                        : mode == 2 ? "columnar (one array per column)"
+                        : perStatement ? "property names per statement, ASCII scan" : "property name per cell, UTF-8 only",
+                    best, rowCount, columnCount, runs);
+    }
+    sqlite3_close(db);
+}
+
 } // namespace
 
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+        benchmark_resultDictionary(argc > 2 ? std::atoi(argv[2]) : 5000);
+        return 0;
+    }
+
     test_getStmt_and_resultDictionary();
     test_getStmt_mismatched_args();
     test_getStmt_invalid_argument_type();
     test_arrayFromStd_and_getNextRowOrTrue();
+    test_isAscii();
+    test_resultDictionary_with_column_names();
+    test_columnarResult();
+    test_packedResult();
+    test_lazyRowsResult();
+    test_snapshotResults();
 
     if (gFailures > 0) {
         std::cerr << gFailures << " test(s) failed\n";
@@ -0,0 +1,235 @@
+#include "../PackedResult.h"
+
+#include <sqlite3.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+static int gFailures = 0;
+
+void expectTrue(bool value, const char* message) {
+    if (!value) {
+        std::cerr << "FAIL: " << message << "\n";
+        gFailures++;
+    }
+}
+
+bool execSql(sqlite3* db, const char* sql, std::string& error) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        if (errMsg) {
+            error = errMsg;
+            sqlite3_free(errMsg);
+        } else {
+            error = "sqlite3_exec failed";
+        }
+        return false;
+    }
+    return true;
+}
+
+bool encode(sqlite3* db, const char* sql, std::vector<uint8_t>& out, std::string& error) {
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+    bool ok = watermelondb::encodePackedResult(stmt, out, error);
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+uint32_t readU32(const std::vector<uint8_t>& bytes, size_t at) {
+    return static_cast<uint32_t>(bytes[at]) | static_cast<uint32_t>(bytes[at + 1]) << 8 |
+           static_cast<uint32_t>(bytes[at + 2]) << 16 | static_cast<uint32_t>(bytes[at + 3]) << 24;
+}
+
+double readF64(const std::vector<uint8_t>& bytes, size_t at) {
+    uint64_t bits = 0;
+    for (int i = 7; i >= 0; i--) {
+        bits = (bits << 8) | bytes[at + i];
+    }
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// A decoded cell, the way the JS decoder reads it
+struct Cell {
+    watermelondb::PackedTag tag;
+    double number = 0;
+    std::string text;
+};
+
+std::vector<Cell> readRow(const std::vector<uint8_t>& bytes, size_t row, size_t columnCount) {
+    const size_t offsetsAt = readU32(bytes, 12);
+    size_t at = readU32(bytes, offsetsAt + row * 4);
+    std::vector<Cell> cells;
+    for (size_t i = 0; i < columnCount; i++) {
+        Cell cell;
+        cell.tag = static_cast<watermelondb::PackedTag>(bytes[at++]);
+        if (cell.tag == watermelondb::PackedTag::NUMBER) {
+            cell.number = readF64(bytes, at);
+            at += 8;
+        } else if (cell.tag == watermelondb::PackedTag::TEXT) {
+            const uint32_t length = readU32(bytes, at);
+            cell.text.assign(reinterpret_cast<const char*>(bytes.data() + at + 4), length);
+            at += 4 + length;
+        }
+        cells.push_back(cell);
+    }
+    return cells;
+}
+
+void test_encode_header_and_rows() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, position INTEGER, score REAL, name TEXT)", error);
+    execSql(db, "INSERT INTO tasks VALUES ('t1', 1, 0.5, 'alpha'), ('t2', -7, NULL, ''), ('t3', 9007199254740991, 2.5, 'zażółć')", error);
+
+    std::vector<uint8_t> bytes;
+    expectTrue(encode(db, "SELECT * FROM tasks ORDER BY id", bytes, error), "encode should succeed");
+
+    expectTrue(readU32(bytes, 0) == watermelondb::PACKED_RESULT_MAGIC, "magic");
+    expectTrue(bytes[4] == watermelondb::PACKED_RESULT_VERSION, "version");
+    expectTrue((bytes[6] | bytes[7] << 8) == 4, "column count");
+    expectTrue(readU32(bytes, 8) == 3, "row count");
+    expectTrue(readU32(bytes, 12) + 3 * 4 == bytes.size(), "row offsets close the buffer");
+
+    size_t at = watermelondb::PACKED_RESULT_HEADER_SIZE;
+    std::vector<std::string> names;
+    for (int i = 0; i < 4; i++) {
+        const uint32_t length = readU32(bytes, at);
+        names.emplace_back(reinterpret_cast<const char*>(bytes.data() + at + 4), length);
+        at += 4 + length;
+    }
+    expectTrue(names == std::vector<std::string>({"id", "position", "score", "name"}), "column names in order");
+    expectTrue(readU32(bytes, readU32(bytes, 12)) == at, "first row starts after the names");
+
+    auto first = readRow(bytes, 0, 4);
+    expectTrue(first[0].tag == watermelondb::PackedTag::TEXT && first[0].text == "t1", "text cell");
+    expectTrue(first[1].tag == watermelondb::PackedTag::NUMBER && first[1].number == 1, "integer cell");
+    expectTrue(first[2].tag == watermelondb::PackedTag::NUMBER && first[2].number == 0.5, "float cell");
+
+    auto second = readRow(bytes, 1, 4);
+    expectTrue(second[1].number == -7, "negative integer");
+    expectTrue(second[2].tag == watermelondb::PackedTag::NULL_VALUE, "NULL cell");
+    expectTrue(second[3].tag == watermelondb::PackedTag::TEXT && second[3].text.empty(), "empty text is not NULL");
+
+    auto third = readRow(bytes, 2, 4);
+    expectTrue(third[1].number == 9007199254740991.0, "largest safe integer round-trips");
+    expectTrue(third[3].text == "zażółć", "UTF-8 bytes are kept as is");
+
+    sqlite3_close(db);
+}
+
+void test_encode_empty_result() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY)", error);
+
+    std::vector<uint8_t> bytes = {1, 2, 3};
+    expectTrue(encode(db, "SELECT * FROM tasks", bytes, error), "encode should succeed");
+    expectTrue(readU32(bytes, 8) == 0, "no rows");
+    expectTrue(readU32(bytes, 12) == bytes.size(), "empty row offset table at the end");
+    expectTrue(bytes.size() == watermelondb::PACKED_RESULT_HEADER_SIZE + 4 + 2, "header and one column name");
+
+    sqlite3_close(db);
+}
+
+void test_encode_rejects_blobs() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    std::vector<uint8_t> bytes;
+    expectTrue(!encode(db, "SELECT x'00ff'", bytes, error), "blobs are not supported");
+    expectTrue(!error.empty(), "error message for blobs");
+    sqlite3_close(db);
+}
+
+void test_snapshot_reads_cells() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, position INTEGER, name TEXT)", error);
+    execSql(db, "INSERT INTO tasks VALUES ('t1', 1, 'alpha'), ('t2', 2, NULL)", error);
+
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db, "SELECT id, position, name, position AS name FROM tasks ORDER BY id", -1, &stmt, nullptr);
+    auto snapshot = watermelondb::PackedResultSnapshot::fromStatement(stmt, error);
+    sqlite3_finalize(stmt);
+    expectTrue(snapshot != nullptr, "snapshot from a statement");
+    expectTrue(snapshot->rowCount() == 2 && snapshot->columnCount() == 4, "snapshot dimensions");
+    expectTrue(snapshot->columnIndex("id") == 0, "column lookup by name");
+    expectTrue(snapshot->columnIndex("missing") == -1, "unknown column");
+    expectTrue(snapshot->columnIndex("name") == 3, "duplicate names resolve to the last column");
+
+    auto name = snapshot->cell(0, 2);
+    expectTrue(name.tag == watermelondb::PackedTag::TEXT && std::string(name.text, name.length) == "alpha", "text cell");
+    auto position = snapshot->cell(1, 1);
+    expectTrue(position.tag == watermelondb::PackedTag::NUMBER && position.number == 2, "number cell after a text cell");
+    expectTrue(snapshot->cell(1, 2).tag == watermelondb::PackedTag::NULL_VALUE, "NULL cell");
+    expectTrue(snapshot->cell(1, 3).number == 2, "cell after a NULL cell");
+
+    std::vector<watermelondb::PackedResultSnapshot::Cell> cells = {{}, {}, {}, {}, {}};
+    for (size_t row = 0; row < snapshot->rowCount(); row++) {
+        snapshot->cells(row, cells);
+        expectTrue(cells.size() == snapshot->columnCount(), "whole row replaces the previous cells");
+        for (size_t column = 0; column < cells.size(); column++) {
+            auto cell = snapshot->cell(row, column);
+            expectTrue(cells[column].tag == cell.tag && cells[column].number == cell.number &&
+                       cells[column].text == cell.text && cells[column].length == cell.length,
+                       "whole row matches cell by cell");
+        }
+    }
+
+    sqlite3_close(db);
+}
+
+void test_snapshot_rejects_malformed_bytes() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    std::vector<uint8_t> bytes;
+    encode(db, "SELECT 'some text' AS name, 1 AS position", bytes, error);
+
+    expectTrue(watermelondb::PackedResultSnapshot::fromBytes(bytes, error) != nullptr, "valid bytes parse");
+
+    std::vector<uint8_t> badMagic = bytes;
+    badMagic[0] ^= 0xFF;
+    expectTrue(!watermelondb::PackedResultSnapshot::fromBytes(badMagic, error), "bad magic is rejected");
+
+    std::vector<uint8_t> truncated(bytes.begin(), bytes.begin() + 20);
+    expectTrue(!watermelondb::PackedResultSnapshot::fromBytes(truncated, error), "truncated bytes are rejected");
+
+    // Text length running into the row offset table
+    std::vector<uint8_t> longText = bytes;
+    const size_t rowAt = readU32(bytes, readU32(bytes, 12));
+    longText[rowAt + 1] = 0xFF;
+    expectTrue(!watermelondb::PackedResultSnapshot::fromBytes(longText, error), "overlong text is rejected");
+
+    std::vector<uint8_t> badTag = bytes;
+    badTag[rowAt] = 7;
+    expectTrue(!watermelondb::PackedResultSnapshot::fromBytes(badTag, error), "unknown tags are rejected");
+
+    sqlite3_close(db);
+}
+
+} // namespace
+
+int main() {
+    test_encode_header_and_rows();
+    test_encode_empty_result();
+    test_encode_rejects_blobs();
+    test_snapshot_reads_cells();
+    test_snapshot_rejects_malformed_bytes();
+
+    if (gFailures > 0) {
+        std::cerr << gFailures << " test(s) failed\n";
+        return 1;
+    }
+    std::cout << "All PackedResult tests passed\n";
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "../RecordCache.h"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+static int gFailures = 0;
+
+void expectTrue(bool value, const char* message) {
+    if (!value) {
+        std::cerr << "FAIL: " << message << "\n";
+        gFailures++;
+    }
+}
+
+void test_mark_and_remove() {
+    watermelondb::RecordCache cache;
+    const auto tasks = watermelondb::internIdentifier("tasks");
+    const auto projects = watermelondb::internIdentifier("projects");
+
+    expectTrue(!cache.isCached(tasks, "t1"), "empty cache has nothing");
+    cache.markAsCached(tasks, "t1");
+    expectTrue(cache.isCached(tasks, "t1"), "marked record is cached");
+    expectTrue(!cache.isCached(projects, "t1"), "ids are per table");
+
+    cache.remove(tasks, "t1");
+    expectTrue(!cache.isCached(tasks, "t1"), "removed record is not cached");
+    cache.remove(projects, "never-added");
+
+    cache.markAsCached(tasks, "t1");
+    cache.markAsCached(projects, "p1");
+    expectTrue(cache.size() == 2, "size counts every table");
+    cache.clear();
+    expectTrue(cache.size() == 0 && !cache.isCached(projects, "p1"), "clear drops every table");
+}
+
+void test_check_and_mark() {
+    watermelondb::RecordCache cache;
+    const auto tasks = watermelondb::internIdentifier("tasks");
+
+    expectTrue(!cache.checkAndMark(tasks, "t1"), "first sight returns the full row");
+    expectTrue(cache.checkAndMark(tasks, "t1"), "second sight returns the id");
+
+    cache.setAlwaysMiss(true);
+    expectTrue(!cache.isCached(tasks, "t1"), "always-miss hides cached records");
+    expectTrue(!cache.checkAndMark(tasks, "t2"), "always-miss returns full rows");
+    cache.setAlwaysMiss(false);
+    expectTrue(cache.isCached(tasks, "t2"), "records are still marked while always-miss is on");
+}
+
+void test_concurrent_marking() {
+    watermelondb::RecordCache cache;
+    const auto tasks = watermelondb::internIdentifier("tasks");
+    const int threadCount = 8;
+    const int idsPerThread = 2000;
+
+    // Every thread marks the same ids: each id must be reported new exactly once
+    std::vector<int> firstSights(threadCount, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < idsPerThread; i++) {
+                if (!cache.checkAndMark(tasks, "record" + std::to_string(i))) {
+                    firstSights[t]++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    int total = 0;
+    for (int count : firstSights) {
+        total += count;
+    }
+    expectTrue(total == idsPerThread, "each id is new to exactly one thread");
+    expectTrue(cache.size() == static_cast<size_t>(idsPerThread), "no id is stored twice");
+}
+
+} // namespace
+
+int main() {
+    test_mark_and_remove();
+    test_check_and_mark();
+    test_concurrent_marking();
+
+    if (gFailures > 0) {
+        std::cerr << gFailures << " test(s) failed\n";
+        return 1;
+    }
+    std::cout << "All RecordCache tests passed\n";
+    return 0;
+}
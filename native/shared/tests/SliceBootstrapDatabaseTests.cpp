@@ -0,0 +1,246 @@
+#include "../SliceBootstrapDatabase.h"
+
+#include <sqlite3.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace watermelondb::platform {
+
+std::vector<std::string> loggedErrors;
+
+void logInfo(const std::string&) {}
+
+void logError(const std::string& message) {
+    loggedErrors.push_back(message);
+}
+
+} // namespace watermelondb::platform
+
+namespace {
+
+static int gFailures = 0;
+
+void expectTrue(bool value, const char* message) {
+    if (!value) {
+        std::cerr << "FAIL: " << message << "\n";
+        gFailures++;
+    }
+}
+
+bool execSql(sqlite3* db, const char* sql, std::string& error) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        if (errMsg) {
+            error = errMsg;
+            sqlite3_free(errMsg);
+        } else {
+            error = "sqlite3_exec failed";
+        }
+        return false;
+    }
+    return true;
+}
+
+int querySingleInt(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return -1;
+    }
+    int value = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+std::string querySingleText(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return "";
+    }
+    std::string value;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* text = sqlite3_column_text(stmt, 0);
+        value = text ? reinterpret_cast<const char*>(text) : "";
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+long fileSize(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return 0;
+    }
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fclose(file);
+    return size;
+}
+
+bool fileExists(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file) {
+        std::fclose(file);
+        return true;
+    }
+    return false;
+}
+
+const char* kLivePath = "slice_bootstrap_test.db";
+
+sqlite3* openLiveDatabase() {
+    std::remove(kLivePath);
+    std::remove("slice_bootstrap_test.db-wal");
+    std::remove("slice_bootstrap_test.db-shm");
+    sqlite3* db = nullptr;
+    sqlite3_open(kLivePath, &db);
+    std::string error;
+    execSql(db, "PRAGMA journal_mode=WAL", error);
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, project_id TEXT, _status TEXT)", error);
+    execSql(db, "CREATE INDEX tasks_project_id ON tasks (project_id)", error);
+    execSql(db, "CREATE TABLE local_storage (key TEXT PRIMARY KEY, value TEXT)", error);
+    execSql(db, "INSERT INTO local_storage (key, value) VALUES ('schema', '7')", error);
+    return db;
+}
+
+void closeLiveDatabase(sqlite3* db) {
+    sqlite3_close(db);
+    std::remove(kLivePath);
+    std::remove("slice_bootstrap_test.db-wal");
+    std::remove("slice_bootstrap_test.db-shm");
+}
+
+watermelondb::LiveConnectionRunner runnerFor(sqlite3* live) {
+    return [live](const std::function<bool(sqlite3*, std::string&)>& work, std::string& error) {
+        return work(live, error);
+    };
+}
+
+watermelondb::BatchData makeBatch(int count) {
+    watermelondb::BatchData batch;
+    std::vector<std::string> columns = {"id", "project_id"};
+    for (int i = 0; i < count; i++) {
+        batch.addRow("tasks", columns, {
+            watermelondb::FieldValue::makeText("t" + std::to_string(i)),
+            watermelondb::FieldValue::makeText("p" + std::to_string(i % 3))
+        });
+    }
+    return batch;
+}
+
+void test_bootstrap_import_installs_side_database() {
+    sqlite3* live = openLiveDatabase();
+    watermelondb::SliceBootstrapDatabase bootstrap(runnerFor(live));
+    std::string error;
+
+    expectTrue(bootstrap.beginTransaction(error), "begin should snapshot the live database");
+    expectTrue(fileExists(bootstrap.sideDatabasePath()), "side database should exist during import");
+    expectTrue(bootstrap.beginTableLoad("tasks", error), "beginTableLoad should succeed");
+    expectTrue(bootstrap.insertBatch(makeBatch(100), error), "insert into side database should succeed");
+    expectTrue(bootstrap.endTableLoad("tasks", error), "endTableLoad should succeed");
+
+    expectTrue(querySingleInt(live, "SELECT COUNT(*) FROM tasks") == 0, "live database untouched before commit");
+
+    expectTrue(bootstrap.commitTransaction(error), ("commit should install: " + error).c_str());
+    expectTrue(!fileExists(bootstrap.sideDatabasePath()), "side database should be removed after install");
+    expectTrue(querySingleInt(live, "SELECT COUNT(*) FROM tasks") == 100, "rows should be installed");
+    expectTrue(querySingleInt(live, "SELECT COUNT(*) FROM tasks WHERE _status = 'synced'") == 100, "rows should be synced");
+    expectTrue(querySingleText(live, "SELECT value FROM local_storage WHERE key = 'schema'") == "7",
+               "pre-existing rows should survive");
+    expectTrue(querySingleInt(live, "SELECT COUNT(*) FROM sqlite_master WHERE name = 'tasks_project_id'") == 1,
+               "deferred index should be rebuilt");
+    expectTrue(querySingleText(live, "PRAGMA journal_mode") == "wal", "live database should stay in WAL mode");
+    expectTrue(watermelondb::platform::loggedErrors.empty(), "checkpoint should succeed without readers");
+    expectTrue(fileSize("slice_bootstrap_test.db-wal") == 0, "WAL should be truncated after install");
+
+    closeLiveDatabase(live);
+}
+
+void test_bootstrap_rollback_leaves_live_database() {
+    sqlite3* live = openLiveDatabase();
+    std::string sidePath;
+    {
+        watermelondb::SliceBootstrapDatabase bootstrap(runnerFor(live));
+        std::string error;
+        bootstrap.beginTransaction(error);
+        bootstrap.insertBatch(makeBatch(10), error);
+        sidePath = bootstrap.sideDatabasePath();
+        bootstrap.rollbackTransaction();
+    }
+    expectTrue(!sidePath.empty() && !fileExists(sidePath), "rollback should delete the side database");
+    expectTrue(querySingleInt(live, "SELECT COUNT(*) FROM tasks") == 0, "rollback should not touch the live database");
+    closeLiveDatabase(live);
+}
+
+void test_bootstrap_refuses_to_overwrite_concurrent_writes() {
+    sqlite3* live = openLiveDatabase();
+    watermelondb::SliceBootstrapDatabase bootstrap(runnerFor(live));
+    std::string error;
+    bootstrap.beginTransaction(error);
+    bootstrap.insertBatch(makeBatch(10), error);
+
+    execSql(live, "INSERT INTO tasks (id, project_id, _status) VALUES ('local', 'p0', 'created')", error);
+
+    expectTrue(!bootstrap.commitTransaction(error), "install should be refused after a concurrent write");
+    expectTrue(querySingleInt(live, "SELECT COUNT(*) FROM tasks") == 1, "concurrent write should be preserved");
+    expectTrue(!fileExists(bootstrap.sideDatabasePath()), "side database should be removed after refusal");
+    closeLiveDatabase(live);
+}
+
+void test_bootstrap_install_reports_busy_checkpoint() {
+    sqlite3* live = openLiveDatabase();
+    std::string error;
+    watermelondb::platform::loggedErrors.clear();
+
+    // A reader with an open snapshot keeps the WAL from being truncated
+    sqlite3* reader = nullptr;
+    sqlite3_open(kLivePath, &reader);
+    execSql(reader, "BEGIN", error);
+    querySingleInt(reader, "SELECT COUNT(*) FROM tasks");
+
+    watermelondb::SliceBootstrapDatabase bootstrap(runnerFor(live));
+    bootstrap.beginTransaction(error);
+    bootstrap.insertBatch(makeBatch(100), error);
+    expectTrue(bootstrap.commitTransaction(error), "install should succeed while a reader is open");
+    expectTrue(querySingleInt(live, "SELECT COUNT(*) FROM tasks") == 100, "rows should be installed");
+    expectTrue(watermelondb::platform::loggedErrors.size() == 1 &&
+                   watermelondb::platform::loggedErrors[0].find("checkpoint") != std::string::npos,
+               "busy checkpoint should be logged");
+    expectTrue(fileSize("slice_bootstrap_test.db-wal") > 0, "WAL should still hold the installed pages");
+
+    execSql(reader, "COMMIT", error);
+    sqlite3_close(reader);
+    sqlite3_wal_checkpoint_v2(live, nullptr, SQLITE_CHECKPOINT_TRUNCATE, nullptr, nullptr);
+    expectTrue(fileSize("slice_bootstrap_test.db-wal") == 0, "WAL should truncate once the reader is gone");
+    closeLiveDatabase(live);
+}
+
+void test_bootstrap_requires_file_database() {
+    sqlite3* memoryDb = nullptr;
+    sqlite3_open(":memory:", &memoryDb);
+    watermelondb::SliceBootstrapDatabase bootstrap(runnerFor(memoryDb));
+    std::string error;
+    expectTrue(!bootstrap.beginTransaction(error), "in-memory database cannot be bootstrapped");
+    sqlite3_close(memoryDb);
+}
+
+} // namespace
+
+int main() {
+    test_bootstrap_import_installs_side_database();
+    test_bootstrap_rollback_leaves_live_database();
+    test_bootstrap_refuses_to_overwrite_concurrent_writes();
+    test_bootstrap_install_reports_busy_checkpoint();
+    test_bootstrap_requires_file_database();
+
+    if (gFailures > 0) {
+        std::cerr << gFailures << " test(s) failed\n";
+        return 1;
+    }
+    std::cout << "All SliceBootstrapDatabase tests passed\n";
+    return 0;
+}
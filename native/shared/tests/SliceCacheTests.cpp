@@ -0,0 +1,194 @@
+#include "../SliceCache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+static int gFailures = 0;
+
+void expectTrue(bool value, const char* message) {
+    if (!value) {
+        std::cerr << "FAIL: " << message << "\n";
+        gFailures++;
+    }
+}
+
+const char* kCacheDirectory = "slice_cache_test_dir";
+
+size_t countFiles() {
+    size_t count = 0;
+    DIR* dir = opendir(kCacheDirectory);
+    if (!dir) {
+        return 0;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+void clearCacheDirectory() {
+    DIR* dir = opendir(kCacheDirectory);
+    if (!dir) {
+        return;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') {
+            std::remove((std::string(kCacheDirectory) + "/" + entry->d_name).c_str());
+        }
+    }
+    closedir(dir);
+    rmdir(kCacheDirectory);
+}
+
+std::string readFile(const std::string& path) {
+    std::string contents;
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return contents;
+    }
+    char buffer[256];
+    size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.append(buffer, read);
+    }
+    std::fclose(file);
+    return contents;
+}
+
+// Backdates an entry so LRU order doesn't depend on filesystem timestamp granularity
+void setAge(const std::string& path, time_t secondsAgo) {
+    struct timespec times[2];
+    times[0].tv_sec = time(nullptr) - secondsAgo;
+    times[0].tv_nsec = 0;
+    times[1] = times[0];
+    utimensat(AT_FDCWD, path.c_str(), times, 0);
+}
+
+bool store(watermelondb::SliceCache& cache, const std::string& key, const std::string& contents) {
+    std::string error;
+    auto writer = cache.beginWrite(error);
+    if (!writer) {
+        return false;
+    }
+    // Split like a download would be
+    size_t half = contents.size() / 2;
+    writer->append(reinterpret_cast<const uint8_t*>(contents.data()), half);
+    writer->append(reinterpret_cast<const uint8_t*>(contents.data()) + half, contents.size() - half);
+    return cache.commit(*writer, key, error);
+}
+
+void test_store_and_lookup() {
+    clearCacheDirectory();
+    watermelondb::SliceCache cache(kCacheDirectory);
+    expectTrue(cache.lookup("tasks@3").empty(), "empty cache should miss");
+
+    expectTrue(store(cache, "tasks@3", "compressed slice bytes"), "store should succeed");
+    std::string path = cache.lookup("tasks@3");
+    expectTrue(!path.empty(), "stored slice should hit");
+    expectTrue(readFile(path) == "compressed slice bytes", "cached bytes should match");
+    expectTrue(cache.lookup("tasks@4").empty(), "other versions should miss");
+    expectTrue(cache.sizeOnDisk() == std::string("compressed slice bytes").size(), "size should be tracked");
+    expectTrue(countFiles() == 1, "no temporary files should be left behind");
+
+    // Same key, new bytes: replaced in place
+    expectTrue(store(cache, "tasks@3", "v2"), "overwrite should succeed");
+    expectTrue(readFile(cache.lookup("tasks@3")) == "v2", "overwrite should replace the entry");
+    expectTrue(countFiles() == 1, "overwrite should not add files");
+
+    cache.remove("tasks@3");
+    expectTrue(cache.lookup("tasks@3").empty(), "removed entry should miss");
+    clearCacheDirectory();
+}
+
+void test_evicts_least_recently_used() {
+    clearCacheDirectory();
+    watermelondb::SliceCache cache(kCacheDirectory, 250);
+    std::string hundredBytes(100, 'x');
+
+    expectTrue(store(cache, "a", hundredBytes), "store a");
+    expectTrue(store(cache, "b", hundredBytes), "store b");
+    setAge(cache.lookup("a"), 300);
+    setAge(cache.lookup("b"), 200);
+
+    // Using `a` makes `b` the least recently used
+    expectTrue(!cache.lookup("a").empty(), "a should hit");
+    expectTrue(store(cache, "c", hundredBytes), "store c");
+
+    expectTrue(!cache.lookup("a").empty(), "recently used entry should survive");
+    expectTrue(cache.lookup("b").empty(), "least recently used entry should be evicted");
+    expectTrue(!cache.lookup("c").empty(), "new entry should be kept");
+    expectTrue(cache.sizeOnDisk() <= 250, "cache should fit its cap");
+    clearCacheDirectory();
+}
+
+void test_rejects_oversized_and_abandoned_writes() {
+    clearCacheDirectory();
+    watermelondb::SliceCache cache(kCacheDirectory, 50);
+    expectTrue(!store(cache, "big", std::string(100, 'x')), "slice larger than the cap should not be cached");
+    expectTrue(cache.lookup("big").empty(), "oversized slice should miss");
+    expectTrue(countFiles() == 0, "oversized slice should not leave files");
+
+    {
+        std::string error;
+        auto writer = cache.beginWrite(error);
+        expectTrue(writer != nullptr, "beginWrite should succeed");
+        writer->append(reinterpret_cast<const uint8_t*>("partial"), 7);
+        expectTrue(countFiles() == 1, "download should be written to a temporary file");
+    }
+    expectTrue(countFiles() == 0, "abandoned download should be deleted");
+    clearCacheDirectory();
+}
+
+void test_recompresses_decompressed_writes() {
+    clearCacheDirectory();
+    watermelondb::SliceCache cache(kCacheDirectory);
+    std::string error;
+    auto writer = cache.beginWrite(error);
+    std::string raw;
+    for (int i = 0; i < 5000; i++) {
+        raw += "row " + std::to_string(i % 50) + ";";
+    }
+    writer->appendDecompressed(reinterpret_cast<const uint8_t*>(raw.data()), raw.size() / 2);
+    writer->appendDecompressed(reinterpret_cast<const uint8_t*>(raw.data()) + raw.size() / 2, raw.size() - raw.size() / 2);
+    expectTrue(cache.commit(*writer, "tasks@5", error), "recompressed entry should be committed");
+
+    std::string compressed = readFile(cache.lookup("tasks@5"));
+    expectTrue(!compressed.empty() && compressed.size() < raw.size(), "entry should be compressed");
+    std::string roundtrip(raw.size() + 1, '\0');
+    size_t size = ZSTD_decompress(&roundtrip[0], roundtrip.size(), compressed.data(), compressed.size());
+    roundtrip.resize(ZSTD_isError(size) ? 0 : size);
+    expectTrue(roundtrip == raw, "entry should decompress to the written bytes");
+    clearCacheDirectory();
+}
+
+void test_key_for_slice() {
+    expectTrue(watermelondb::SliceCache::keyForSlice("tasks", 42) == "tasks@42", "key should combine id and version");
+}
+
+} // namespace
+
+int main() {
+    test_store_and_lookup();
+    test_evicts_least_recently_used();
+    test_rejects_oversized_and_abandoned_writes();
+    test_recompresses_decompressed_writes();
+    test_key_for_slice();
+
+    if (gFailures > 0) {
+        std::cerr << gFailures << " test(s) failed\n";
+        return 1;
+    }
+    std::cout << "All SliceCache tests passed\n";
+    return 0;
+}
@@ -1,7 +1,9 @@
 #define private public
 #include "../SliceDecoder.h"
 #undef private
+#include "../SliceArena.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <string>
@@ -82,9 +84,12 @@ void test_parse_header_table_row() {
     expectTrue(table.columns.size() == 2, "columns parsed");
 
     watermelondb::Row row;
-    expectTrue(decoder.parseRow(table.columns, row) == watermelondb::ParseStatus::Ok, "parseRow ok");
-    expectTrue(row["id"].textValue == "t1", "row id parsed");
-    expectTrue(row["name"].textValue == "Alpha", "row name parsed");
+    expectTrue(table.tableId == watermelondb::internIdentifier("tasks") &&
+               table.columnIds.size() == 2 && watermelondb::identifierName(table.columnIds[1]) == "name",
+               "table and column names interned");
+    expectTrue(decoder.parseRow(table, row) == watermelondb::ParseStatus::Ok, "parseRow ok");
+    expectTrue(row[watermelondb::internIdentifier("id")].text() == "t1", "row id parsed");
+    expectTrue(row[watermelondb::internIdentifier("name")].text() == "Alpha", "row name parsed");
 
     std::vector<watermelondb::FieldValue> rowValues;
     expectTrue(decoder.parseRowValues(table.columns, rowValues) == watermelondb::ParseStatus::EndOfTable,
@@ -93,6 +98,71 @@ void test_parse_header_table_row() {
                "end of stream detected");
 }
 
+void test_delta_rows() {
+    std::vector<uint8_t> data;
+    appendString(data, "delta1");
+    appendVarint(data, 2);
+    appendString(data, "high");
+    appendVarint(data, 123);
+    appendVarint(data, (watermelondb::SLICE_FLAG_DELTA << watermelondb::SLICE_FLAGS_SHIFT) | 1);
+
+    appendString(data, "tasks");
+    appendVarint(data, 2);
+    appendString(data, "id");
+    appendString(data, "name");
+
+    data.push_back(static_cast<uint8_t>(watermelondb::DeltaOp::UPSERT));
+    appendTextField(data, "t1");
+    appendTextField(data, "Alpha");
+    data.push_back(static_cast<uint8_t>(watermelondb::DeltaOp::DELETE));
+    appendTextField(data, "t2");
+    data.push_back(0x7F); // unknown op
+
+    watermelondb::SliceDecoder decoder;
+    decoder.streamInitialized_ = true;
+    decoder.streamEnded_ = true;
+    decoder.decompressedBuffer_ = data;
+    decoder.decompressedSize_ = data.size();
+    decoder.currentOffset_ = 0;
+
+    watermelondb::SliceHeader header;
+    expectTrue(decoder.parseSliceHeader(header) == watermelondb::ParseStatus::Ok, "delta header should parse");
+    expectTrue(header.isDelta() && decoder.isDeltaSlice(), "delta flag should be decoded");
+    expectTrue(header.numberOfTables == 1, "table count should be split from the flags");
+
+    watermelondb::TableHeader table;
+    expectTrue(decoder.parseTableHeader(table) == watermelondb::ParseStatus::Ok, "delta table header should parse");
+
+    std::vector<watermelondb::FieldValue> values;
+    watermelondb::DeltaOp op = watermelondb::DeltaOp::DELETE;
+    expectTrue(decoder.parseDeltaRow(table.columns, {}, op, values) == watermelondb::ParseStatus::Ok,
+               "upsert row should parse");
+    expectTrue(op == watermelondb::DeltaOp::UPSERT && values.size() == 2 && values[1].text() == "Alpha",
+               "upsert row should carry every column");
+    expectTrue(decoder.parseDeltaRow(table.columns, {}, op, values) == watermelondb::ParseStatus::Ok,
+               "delete row should parse");
+    expectTrue(op == watermelondb::DeltaOp::DELETE && values.size() == 1 && values[0].text() == "t2",
+               "delete row should carry only the id");
+    expectTrue(decoder.parseDeltaRow(table.columns, {}, op, values) == watermelondb::ParseStatus::Error,
+               "unknown op should error");
+
+    // Flags this decoder doesn't know must not be misread as a plain slice
+    std::vector<uint8_t> unknown;
+    appendString(unknown, "future");
+    appendVarint(unknown, 1);
+    appendString(unknown, "high");
+    appendVarint(unknown, 1);
+    appendVarint(unknown, (uint64_t{0x2} << watermelondb::SLICE_FLAGS_SHIFT) | 1);
+    watermelondb::SliceDecoder futureDecoder;
+    futureDecoder.streamInitialized_ = true;
+    futureDecoder.streamEnded_ = true;
+    futureDecoder.decompressedBuffer_ = unknown;
+    futureDecoder.decompressedSize_ = unknown.size();
+    futureDecoder.currentOffset_ = 0;
+    expectTrue(futureDecoder.parseSliceHeader(header) == watermelondb::ParseStatus::Error,
+               "unknown slice flags should error");
+}
+
 void test_invalid_column_count() {
     std::vector<uint8_t> data;
     appendString(data, "tasks");
@@ -131,13 +201,229 @@ void test_invalid_field_size() {
                "field size exceeding max should error");
 }
 
+void test_empty_values() {
+    std::vector<uint8_t> data;
+    for (auto tag : {watermelondb::TypeTag::EMPTY_TEXT, watermelondb::TypeTag::EMPTY_BLOB,
+                     watermelondb::TypeTag::NULL_TYPE, watermelondb::TypeTag::TEXT}) {
+        appendVarint(data, 0);
+        data.push_back(static_cast<uint8_t>(tag));
+    }
+
+    watermelondb::SliceDecoder decoder;
+    decoder.streamInitialized_ = true;
+    decoder.streamEnded_ = true;
+    decoder.decompressedBuffer_ = data;
+    decoder.decompressedSize_ = data.size();
+    decoder.currentOffset_ = 0;
+
+    using Type = watermelondb::FieldValue::Type;
+    std::vector<std::string> columns = {"empty_text", "empty_blob", "null", "legacy"};
+    std::vector<watermelondb::FieldValue> values;
+    expectTrue(decoder.parseRowValues(columns, values) == watermelondb::ParseStatus::Ok, "row of empty values should parse");
+    expectTrue(values.size() == 4, "every field should be decoded");
+    if (values.size() == 4) {
+        expectTrue(values[0].type() == Type::TEXT_VALUE && values[0].size() == 0, "EMPTY_TEXT should decode to ''");
+        expectTrue(values[1].type() == Type::BLOB_VALUE && values[1].size() == 0, "EMPTY_BLOB should decode to an empty blob");
+        expectTrue(values[2].isNull(), "zero-size NULL should decode to NULL");
+        expectTrue(values[3].isNull(), "zero-size field with any other tag should still decode to NULL");
+    }
+}
+
+void test_projected_row_skips_fields() {
+    std::vector<uint8_t> data;
+    appendTextField(data, "t1");
+    // Blob with a byte that would be an invalid type tag if it were read as one
+    appendVarint(data, 3);
+    data.insert(data.end(), {0xFF, 0x07, 0x09});
+    data.push_back(static_cast<uint8_t>(watermelondb::TypeTag::BLOB));
+    appendVarint(data, 0);
+    data.push_back(static_cast<uint8_t>(watermelondb::TypeTag::NULL_TYPE));
+    appendTextField(data, "Alpha");
+    appendTextField(data, "t2");
+    appendVarint(data, 3);
+    data.insert(data.end(), {0x01, 0x02, 0x03});
+    data.push_back(static_cast<uint8_t>(watermelondb::TypeTag::BLOB));
+    appendVarint(data, 0);
+    data.push_back(static_cast<uint8_t>(watermelondb::TypeTag::NULL_TYPE));
+    appendTextField(data, "Beta");
+
+    watermelondb::SliceDecoder decoder;
+    decoder.streamInitialized_ = true;
+    decoder.streamEnded_ = false;
+    decoder.decompressedBuffer_ = data;
+    decoder.decompressedSize_ = data.size();
+    decoder.currentOffset_ = 0;
+
+    std::vector<std::string> columns = {"id", "audit", "deleted_at", "name"};
+    std::vector<bool> keep = {true, false, false, true};
+    std::vector<watermelondb::FieldValue> values;
+    expectTrue(decoder.parseRowValues(columns, keep, values) == watermelondb::ParseStatus::Ok, "projected row should parse");
+    expectTrue(values.size() == 2, "only kept fields should be materialized");
+    expectTrue(values[0].text() == "t1" && values[1].text() == "Alpha", "kept fields keep their values");
+    expectTrue(decoder.parseRowValues(columns, keep, values) == watermelondb::ParseStatus::Ok, "next row should parse");
+    expectTrue(values.size() == 2 && values[1].text() == "Beta", "skipping should land on the next row");
+    expectTrue(decoder.remainingBytes() == 0, "projected rows should consume the whole row");
+
+    // A skipped field that isn't fully buffered yet still needs more data
+    decoder.decompressedBuffer_ = data;
+    decoder.decompressedSize_ = 5;
+    decoder.currentOffset_ = 0;
+    expectTrue(decoder.parseRowValues(columns, keep, values) == watermelondb::ParseStatus::NeedMoreData,
+               "truncated skipped field should wait for more data");
+    expectTrue(decoder.currentOffset_ == 0, "incomplete row should not advance");
+}
+
+void test_streamed_decompression_across_chunks() {
+    std::vector<uint8_t> raw;
+    appendString(raw, "slice1");
+    appendVarint(raw, 1);
+    appendString(raw, "high");
+    appendVarint(raw, 123);
+    appendVarint(raw, 1);
+    appendString(raw, "tasks");
+    appendVarint(raw, 1);
+    appendString(raw, "id");
+    const int rowCount = 20000;
+    for (int i = 0; i < rowCount; i++) {
+        appendTextField(raw, "task_" + std::to_string(i));
+    }
+    raw.push_back(watermelondb::END_OF_TABLE_DELIMITER);
+
+    std::vector<uint8_t> compressed(ZSTD_compressBound(raw.size()));
+    size_t compressedSize = ZSTD_compress(compressed.data(), compressed.size(), raw.data(), raw.size(), 3);
+    expectTrue(!ZSTD_isError(compressedSize), "compression should succeed");
+
+    watermelondb::SliceDecoder decoder;
+    expectTrue(decoder.initializeDecompression(), "decompression should initialize");
+    watermelondb::SliceHeader header;
+    watermelondb::TableHeader table;
+    bool headerParsed = false;
+    bool tableParsed = false;
+    int rowsParsed = 0;
+    std::vector<watermelondb::FieldValue> rowValues;
+
+    // Small chunks so decompressed output lands in the buffer tail many times, with compaction in between
+    const size_t chunkSize = 97;
+    for (size_t offset = 0; offset < compressedSize; offset += chunkSize) {
+        size_t length = std::min(chunkSize, compressedSize - offset);
+        expectTrue(decoder.feedCompressedData(compressed.data() + offset, length), "feed should succeed");
+        if (!headerParsed) {
+            headerParsed = decoder.parseSliceHeader(header) == watermelondb::ParseStatus::Ok;
+        }
+        if (headerParsed && !tableParsed) {
+            tableParsed = decoder.parseTableHeader(table) == watermelondb::ParseStatus::Ok;
+        }
+        while (tableParsed && decoder.parseRowValues(table.columns, rowValues) == watermelondb::ParseStatus::Ok) {
+            if (rowValues[0].text() != "task_" + std::to_string(rowsParsed)) {
+                expectTrue(false, "row values should survive buffer reuse");
+                break;
+            }
+            rowsParsed++;
+        }
+        decoder.compactBuffer();
+    }
+
+    expectTrue(decoder.isEndOfStream(), "stream should end");
+    expectTrue(rowsParsed == rowCount, "every row should be parsed");
+}
+
 } // namespace
 
+void test_field_value_storage() {
+    using watermelondb::FieldValue;
+    expectTrue(sizeof(FieldValue) == 16, "FieldValue should be 16 bytes");
+
+    FieldValue shortText = FieldValue::makeText("task_123");
+    expectTrue(shortText.storage() == FieldValue::Storage::Inline, "short text should be stored inline");
+    expectTrue(shortText.text() == "task_123", "inline text should roundtrip");
+
+    const std::string longString = "a description longer than the inline capacity";
+    FieldValue longText = FieldValue::makeText(longString);
+    expectTrue(longText.storage() == FieldValue::Storage::Heap, "long text should be copied to the heap");
+    FieldValue copy = longText;
+    expectTrue(copy.text() == longString && copy.data() != longText.data(), "copies should own their bytes");
+    FieldValue moved = std::move(copy);
+    expectTrue(moved.text() == longString && copy.isNull(), "moves should transfer ownership");
+
+    FieldValue borrowed = FieldValue::makeTextRef(longString.data(), longString.size());
+    expectTrue(borrowed.storage() == FieldValue::Storage::Borrowed && borrowed.data() == longString.data(),
+               "borrowed text should point at the caller's bytes");
+
+    const std::string withNul("a\0b", 3);
+    expectTrue(FieldValue::makeText(withNul).text() == withNul, "embedded NULs should survive");
+
+    const uint8_t bytes[] = {0x00, 0xFF, 0x10};
+    FieldValue blob = FieldValue::makeBlob(bytes, sizeof(bytes));
+    expectTrue(blob.type() == FieldValue::Type::BLOB_VALUE && blob.size() == 3 && blob.blobData()[1] == 0xFF,
+               "blob should roundtrip");
+
+    auto describe = [](const FieldValue& value) {
+        return value.visit(watermelondb::Overloaded{
+            [](std::nullptr_t) { return std::string("null"); },
+            [](int64_t v) { return "int:" + std::to_string(v); },
+            [](double) { return std::string("real"); },
+            [](std::string_view text) { return "text:" + std::string(text); },
+            [](watermelondb::FieldBlob blob) { return "blob:" + std::to_string(blob.size); },
+        });
+    };
+    expectTrue(describe(FieldValue::makeNull()) == "null", "visit NULL");
+    expectTrue(describe(FieldValue::makeInt(-7)) == "int:-7", "visit INT");
+    expectTrue(describe(FieldValue::makeReal(0.5)) == "real", "visit REAL");
+    expectTrue(describe(shortText) == "text:task_123", "visit TEXT");
+    expectTrue(describe(blob) == "blob:3", "visit BLOB");
+}
+
+void test_identifier_interner() {
+    watermelondb::IdentifierInterner interner;
+    const watermelondb::Identifier tasks = interner.intern("tasks");
+    const watermelondb::Identifier projects = interner.intern("projects");
+    expectTrue(tasks != projects, "different names should get different ids");
+    expectTrue(interner.intern(std::string("tas") + "ks") == tasks, "interning again should return the same id");
+    expectTrue(interner.name(tasks) == "tasks" && interner.name(projects) == "projects", "ids should map back to names");
+    expectTrue(interner.size() == 2, "names should be stored once");
+}
+
+void test_long_values_go_to_value_arena() {
+    const std::string longText = "a description longer than the inline capacity";
+    std::vector<uint8_t> data;
+    appendTextField(data, "t1");
+    appendTextField(data, longText);
+    appendVarint(data, 20);
+    data.insert(data.end(), 20, 0xAB);
+    data.push_back(static_cast<uint8_t>(watermelondb::TypeTag::BLOB));
+
+    watermelondb::SliceArena arena;
+    watermelondb::SliceDecoder decoder;
+    decoder.setValueArena(&arena);
+    decoder.streamInitialized_ = true;
+    decoder.streamEnded_ = false;
+    decoder.decompressedBuffer_ = data;
+    decoder.decompressedSize_ = data.size();
+    decoder.currentOffset_ = 0;
+
+    std::vector<std::string> columns = {"id", "description", "payload"};
+    std::vector<watermelondb::FieldValue> values;
+    expectTrue(decoder.parseRowValues(columns, values) == watermelondb::ParseStatus::Ok, "row should parse");
+    expectTrue(values.size() == 3, "every field should be materialized");
+    expectTrue(values[0].text() == "t1" && !values[0].borrowsBytes(), "short text should stay inline");
+    expectTrue(values[1].text() == longText && values[1].borrowsBytes(), "long text should be borrowed from the arena");
+    expectTrue(values[2].size() == 20 && values[2].blobData()[19] == 0xAB && values[2].borrowsBytes(),
+               "long blob should be borrowed from the arena");
+    expectTrue(arena.bytesUsed() == longText.size() + 20, "only long values should take arena space");
+}
+
 int main() {
     test_varint_and_string_decode();
     test_parse_header_table_row();
+    test_delta_rows();
+    test_streamed_decompression_across_chunks();
     test_invalid_column_count();
     test_invalid_field_size();
+    test_empty_values();
+    test_projected_row_skips_fields();
+    test_field_value_storage();
+    test_long_values_go_to_value_arena();
+    test_identifier_interner();
 
     if (gFailures > 0) {
         std::cerr << gFailures << " test(s) failed\n";
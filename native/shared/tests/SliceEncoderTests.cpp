@@ -0,0 +1,477 @@
+#include "../SliceEncoder.h"
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+static int gFailures = 0;
+
+void expectTrue(bool value, const char* message) {
+    if (!value) {
+        std::cerr << "FAIL: " << message << "\n";
+        gFailures++;
+    }
+}
+
+std::vector<uint8_t> blobOf(const watermelondb::FieldValue& value) {
+    return std::vector<uint8_t>(value.blobData(), value.blobData() + value.size());
+}
+
+struct DecodedTable {
+    watermelondb::TableHeader header;
+    std::vector<std::vector<watermelondb::FieldValue>> rows;
+};
+
+struct DecodedSlice {
+    bool ok = false;
+    watermelondb::SliceHeader header;
+    std::vector<DecodedTable> tables;
+};
+
+// Feeds `compressed` to the decoder in small chunks, like a download would
+DecodedSlice decode(const std::vector<uint8_t>& compressed) {
+    DecodedSlice slice;
+    watermelondb::SliceDecoder decoder;
+    decoder.initializeDecompression();
+    bool headerParsed = false;
+    bool inTable = false;
+    const size_t chunkSize = 1000;
+    for (size_t offset = 0; offset < compressed.size(); offset += chunkSize) {
+        size_t length = std::min(chunkSize, compressed.size() - offset);
+        if (!decoder.feedCompressedData(compressed.data() + offset, length)) {
+            return slice;
+        }
+        if (!headerParsed) {
+            watermelondb::ParseStatus status = decoder.parseSliceHeader(slice.header);
+            if (status == watermelondb::ParseStatus::Error) {
+                return slice;
+            }
+            if (status != watermelondb::ParseStatus::Ok) {
+                continue;
+            }
+            headerParsed = true;
+        }
+        while (true) {
+            if (!inTable) {
+                watermelondb::TableHeader table;
+                watermelondb::ParseStatus status = decoder.parseTableHeader(table);
+                if (status == watermelondb::ParseStatus::Error) {
+                    return slice;
+                }
+                if (status != watermelondb::ParseStatus::Ok) {
+                    break;
+                }
+                slice.tables.push_back({table, {}});
+                inTable = true;
+            }
+            DecodedTable& table = slice.tables.back();
+            std::vector<watermelondb::FieldValue> values;
+            watermelondb::ParseStatus status;
+            while ((status = decoder.parseRowValues(table.header.columns, values)) == watermelondb::ParseStatus::Ok) {
+                table.rows.push_back(values);
+                values.clear();
+            }
+            if (status == watermelondb::ParseStatus::Error) {
+                return slice;
+            }
+            if (status != watermelondb::ParseStatus::EndOfTable) {
+                break;
+            }
+            inTable = false;
+        }
+        decoder.compactBuffer();
+    }
+    slice.ok = headerParsed && !inTable && decoder.isEndOfStream();
+    return slice;
+}
+
+std::vector<uint8_t> readFile(const std::string& path) {
+    std::vector<uint8_t> contents;
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return contents;
+    }
+    uint8_t buffer[4096];
+    size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.insert(contents.end(), buffer, buffer + read);
+    }
+    std::fclose(file);
+    return contents;
+}
+
+bool fileExists(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file) {
+        std::fclose(file);
+        return true;
+    }
+    return false;
+}
+
+bool exec(sqlite3* db, const char* sql) {
+    return sqlite3_exec(db, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+watermelondb::SliceEncoder::Sink bufferSink(std::vector<uint8_t>& out) {
+    return [&out](const uint8_t* data, size_t length, std::string&) {
+        out.insert(out.end(), data, data + length);
+        return true;
+    };
+}
+
+watermelondb::SliceHeader makeHeader(int64_t tables) {
+    watermelondb::SliceHeader header;
+    header.sliceId = "encoder-test";
+    header.version = 300;
+    header.priority = "high";
+    header.timestamp = 1700000000;
+    header.numberOfTables = tables;
+    return header;
+}
+
+void test_roundtrip_through_decoder() {
+    std::vector<uint8_t> compressed;
+    watermelondb::SliceEncoder encoder(bufferSink(compressed));
+    std::string error;
+    expectTrue(encoder.writeSliceHeader(makeHeader(2), error), "header should be written");
+
+    expectTrue(encoder.beginTable("tasks", {"id", "count", "score", "data", "note"}, error), "beginTable tasks");
+    for (int i = 0; i < 500; i++) {
+        std::vector<watermelondb::FieldValue> row;
+        row.push_back(watermelondb::FieldValue::makeText("task-" + std::to_string(i)));
+        row.push_back(watermelondb::FieldValue::makeInt(i % 2 ? -i * 1000000007LL : i));
+        row.push_back(watermelondb::FieldValue::makeReal(i / 8.0));
+        row.push_back(watermelondb::FieldValue::makeBlob({0xFF, static_cast<uint8_t>(i), 0x00}));
+        row.push_back(i % 3 ? watermelondb::FieldValue::makeNull() : watermelondb::FieldValue::makeText(""));
+        expectTrue(encoder.writeRow(row, error), "writeRow should succeed");
+    }
+    expectTrue(encoder.endTable(error), "endTable tasks");
+
+    // Tables without rows are valid too
+    expectTrue(encoder.beginTable("projects", {"id"}, error), "beginTable projects");
+    expectTrue(encoder.endTable(error), "endTable projects");
+    expectTrue(encoder.finish(error), "finish should succeed");
+    expectTrue(encoder.rowsWritten() == 500, "rows should be counted");
+    expectTrue(encoder.compressedBytes() == compressed.size(), "compressed bytes should be counted");
+    expectTrue(encoder.uncompressedBytes() > encoder.compressedBytes(), "slice should compress");
+
+    DecodedSlice slice = decode(compressed);
+    expectTrue(slice.ok, "encoded slice should decode to the end");
+    expectTrue(slice.header.sliceId == "encoder-test" && slice.header.version == 300 &&
+               slice.header.priority == "high" && slice.header.timestamp == 1700000000 &&
+               slice.header.numberOfTables == 2, "header should roundtrip");
+    expectTrue(slice.tables.size() == 2, "both tables should decode");
+    if (slice.tables.size() != 2) {
+        return;
+    }
+    const DecodedTable& tasks = slice.tables[0];
+    expectTrue(tasks.header.tableName == "tasks" && tasks.header.columns.size() == 5, "table header should roundtrip");
+    expectTrue(tasks.rows.size() == 500, "every row should decode");
+    bool valuesMatch = tasks.rows.size() == 500;
+    for (int i = 0; valuesMatch && i < 500; i++) {
+        const auto& row = tasks.rows[static_cast<size_t>(i)];
+        valuesMatch = row.size() == 5 &&
+                      row[0].text() == "task-" + std::to_string(i) &&
+                      row[1].type() == watermelondb::FieldValue::Type::INT_VALUE &&
+                      row[1].intValue() == (i % 2 ? -i * 1000000007LL : i) &&
+                      row[2].type() == watermelondb::FieldValue::Type::REAL_VALUE &&
+                      row[2].realValue() == i / 8.0 &&
+                      blobOf(row[3]) == std::vector<uint8_t>({0xFF, static_cast<uint8_t>(i), 0x00}) &&
+                      (i % 3 ? row[4].isNull()
+                             : row[4].type() == watermelondb::FieldValue::Type::TEXT_VALUE && row[4].size() == 0);
+    }
+    expectTrue(valuesMatch, "values should roundtrip with their types");
+    expectTrue(slice.tables[1].header.tableName == "projects" && slice.tables[1].rows.empty(),
+               "empty table should roundtrip");
+}
+
+void test_delta_slice_roundtrip() {
+    std::vector<uint8_t> compressed;
+    watermelondb::SliceEncoder encoder(bufferSink(compressed));
+    std::string error;
+    watermelondb::SliceHeader header = makeHeader(1);
+    header.flags = watermelondb::SLICE_FLAG_DELTA;
+    expectTrue(encoder.writeSliceHeader(header, error), "delta header should be written");
+    expectTrue(encoder.beginTable("tasks", {"id", "name"}, error), "beginTable tasks");
+    expectTrue(encoder.writeRow({watermelondb::FieldValue::makeText("t1"), watermelondb::FieldValue::makeText("a")}, error),
+               "writeRow should write an upsert");
+    expectTrue(encoder.beginUpsert(error), "beginUpsert should succeed");
+    encoder.appendText("t2", 2);
+    encoder.appendText("b", 1);
+    expectTrue(encoder.appendDelete(watermelondb::FieldValue::makeText("t3"), error), "appendDelete should succeed");
+    expectTrue(encoder.endTable(error) && encoder.finish(error), "delta slice should finish");
+    expectTrue(encoder.rowsWritten() == 3, "upserts and deletes should be counted");
+
+    watermelondb::SliceDecoder decoder;
+    decoder.initializeDecompression();
+    expectTrue(decoder.feedCompressedData(compressed.data(), compressed.size()), "delta slice should decompress");
+    watermelondb::SliceHeader decoded;
+    expectTrue(decoder.parseSliceHeader(decoded) == watermelondb::ParseStatus::Ok && decoded.isDelta() &&
+               decoded.numberOfTables == 1, "delta header should roundtrip");
+    watermelondb::TableHeader table;
+    expectTrue(decoder.parseTableHeader(table) == watermelondb::ParseStatus::Ok, "delta table should decode");
+    std::vector<std::string> ops;
+    std::vector<watermelondb::FieldValue> values;
+    watermelondb::DeltaOp op;
+    while (decoder.parseDeltaRow(table.columns, {}, op, values) == watermelondb::ParseStatus::Ok) {
+        ops.push_back((op == watermelondb::DeltaOp::UPSERT ? "upsert:" : "delete:") + std::string(values[0].text()) +
+                      ":" + std::to_string(values.size()));
+    }
+    expectTrue(ops == std::vector<std::string>({"upsert:t1:2", "upsert:t2:2", "delete:t3:1"}),
+               "delta rows should roundtrip in order");
+
+    // Delta rows need their op; plain slices have none
+    std::vector<uint8_t> ignored;
+    watermelondb::SliceEncoder missingOp(bufferSink(ignored));
+    missingOp.writeSliceHeader(header, error);
+    missingOp.beginTable("tasks", {"id"}, error);
+    missingOp.appendText("t1", 2);
+    expectTrue(!missingOp.endTable(error), "delta fields without beginUpsert should fail");
+
+    watermelondb::SliceEncoder plain(bufferSink(ignored));
+    plain.writeSliceHeader(makeHeader(1), error);
+    plain.beginTable("tasks", {"id"}, error);
+    expectTrue(!plain.appendDelete(watermelondb::FieldValue::makeText("t1"), error),
+               "deletes should be rejected in plain slices");
+
+    watermelondb::SliceEncoder tooMany(bufferSink(ignored));
+    expectTrue(!tooMany.writeSliceHeader(makeHeader(watermelondb::MAX_TABLES + 1), error),
+               "table counts that collide with the flags should be rejected");
+}
+
+// 20k task rows; `edited` rows get a new title, as between two versions of a slice
+std::vector<uint8_t> encodeTaskVersion(int64_t version, int edited, const std::vector<uint8_t>* reference) {
+    std::vector<uint8_t> compressed;
+    watermelondb::SliceEncoder encoder(bufferSink(compressed));
+    std::string error;
+    if (reference) {
+        encoder.setPatchReference(reference->data(), reference->size(), error);
+    }
+    watermelondb::SliceHeader header = makeHeader(1);
+    header.version = version;
+    encoder.writeSliceHeader(header, error);
+    encoder.beginTable("tasks", {"id", "title", "position"}, error);
+    for (int i = 0; i < 20000; i++) {
+        std::string title = (i < edited ? "edited task " : "task ") + std::to_string(i * 7919 % 20011);
+        encoder.writeRow({watermelondb::FieldValue::makeText("task-" + std::to_string(i)),
+                          watermelondb::FieldValue::makeText(title),
+                          watermelondb::FieldValue::makeInt(i * 31 % 1000)},
+                         error);
+    }
+    encoder.endTable(error);
+    return encoder.finish(error) ? compressed : std::vector<uint8_t>();
+}
+
+void test_patch_from_previous_version() {
+    std::string error;
+    std::vector<uint8_t> previousCompressed = encodeTaskVersion(1, 0, nullptr);
+    std::vector<uint8_t> previous;
+    expectTrue(watermelondb::decompressSlice(previousCompressed.data(), previousCompressed.size(), previous, error),
+               "previous version should decompress");
+    std::vector<uint8_t> full = encodeTaskVersion(2, 200, nullptr);
+    std::vector<uint8_t> patch = encodeTaskVersion(2, 200, &previous);
+    expectTrue(!patch.empty() && patch.size() * 5 < full.size(), "patch should be a fraction of the full slice");
+
+    // Without the reference the patch is undecodable; with it, it decodes to the new version
+    expectTrue(!decode(patch).ok, "patch should not decode on its own");
+    std::vector<uint8_t> expected;
+    std::vector<uint8_t> reconstructed;
+    watermelondb::decompressSlice(full.data(), full.size(), expected, error);
+    watermelondb::SliceDecoder decoder;
+    decoder.initializeDecompression();
+    expectTrue(decoder.setPatchReference(previous), "patch reference should be accepted");
+    decoder.setOutputObserver([&reconstructed](const uint8_t* data, size_t length) {
+        reconstructed.insert(reconstructed.end(), data, data + length);
+    });
+    expectTrue(decoder.feedCompressedData(patch.data(), patch.size()) && decoder.isEndOfStream(),
+               "patch should decode with its reference");
+    expectTrue(!expected.empty() && reconstructed == expected, "patch should reconstruct the new version exactly");
+
+    // A reference can only be set before the stream starts
+    watermelondb::SliceEncoder late(bufferSink(full));
+    late.writeSliceHeader(makeHeader(0), error);
+    expectTrue(!late.setPatchReference(previous.data(), previous.size(), error),
+               "patch reference after the header should be rejected");
+}
+
+void test_rejects_malformed_slices() {
+    std::vector<uint8_t> compressed;
+    std::string error;
+    {
+        watermelondb::SliceEncoder encoder(bufferSink(compressed));
+        encoder.writeSliceHeader(makeHeader(1), error);
+        encoder.beginTable("tasks", {"id", "title"}, error);
+        expectTrue(!encoder.writeRow({watermelondb::FieldValue::makeText("t1")}, error), "short row should fail");
+        expectTrue(!encoder.endTable(error), "encoder should stay failed");
+    }
+    {
+        watermelondb::SliceEncoder encoder(bufferSink(compressed));
+        encoder.writeSliceHeader(makeHeader(1), error);
+        encoder.beginTable("tasks", {"id", "title"}, error);
+        encoder.appendText("t1", 2);
+        expectTrue(!encoder.endTable(error), "partial row should fail endTable");
+    }
+    {
+        watermelondb::SliceEncoder encoder(bufferSink(compressed));
+        encoder.writeSliceHeader(makeHeader(2), error);
+        encoder.beginTable("tasks", {"id"}, error);
+        encoder.endTable(error);
+        expectTrue(!encoder.finish(error), "table count mismatch should fail finish");
+    }
+    {
+        watermelondb::SliceEncoder encoder(bufferSink(compressed));
+        encoder.appendInt(1);
+        expectTrue(!encoder.writeSliceHeader(makeHeader(0), error), "fields outside of a table should fail");
+    }
+    {
+        watermelondb::SliceEncoder encoder([](const uint8_t*, size_t, std::string& sinkError) {
+            sinkError = "disk full";
+            return false;
+        });
+        encoder.writeSliceHeader(makeHeader(0), error);
+        expectTrue(!encoder.finish(error) && error == "disk full", "sink errors should be reported");
+    }
+}
+
+void test_export_from_sqlite() {
+    const std::string dbPath = "slice_encoder_test.db";
+    const std::string slicePath = "slice_encoder_test.slice";
+    std::remove(dbPath.c_str());
+    std::remove(slicePath.c_str());
+
+    sqlite3* db = nullptr;
+    sqlite3_open(dbPath.c_str(), &db);
+    exec(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, _changed TEXT, _status TEXT, title TEXT, position INTEGER, weight REAL, payload BLOB);");
+    exec(db, "CREATE TABLE projects (id TEXT PRIMARY KEY, _changed TEXT, _status TEXT, name TEXT);");
+    exec(db, "CREATE TABLE local_storage (key TEXT PRIMARY KEY, value TEXT);");
+    exec(db, "INSERT INTO tasks VALUES ('t1', '', 'synced', 'One', 1, 0.5, x'0102');");
+    exec(db, "INSERT INTO tasks VALUES ('t2', 'title', 'updated', 'Two', 2, NULL, NULL);");
+    exec(db, "INSERT INTO tasks VALUES ('t3', '', 'deleted', 'Three', 3, 1.5, NULL);");
+    exec(db, "INSERT INTO projects VALUES ('p1', '', 'created', 'Project');");
+    exec(db, "INSERT INTO projects VALUES ('p2', '', 'synced', '');");
+    exec(db, "INSERT INTO local_storage VALUES ('lastPulledAt', '1');");
+
+    watermelondb::SliceExportOptions options;
+    options.sliceId = "backup";
+    options.version = 7;
+    watermelondb::SliceExportStats stats;
+    std::string error;
+    expectTrue(watermelondb::exportSlice(db, slicePath, options, &stats, error), "export should succeed");
+    expectTrue(stats.tables == 2 && stats.rows == 4, "stats should count synced tables and live rows");
+    expectTrue(!fileExists(slicePath + ".partial"), "partial file should be renamed into place");
+    expectTrue(sqlite3_get_autocommit(db) != 0, "export should end its read transaction");
+
+    DecodedSlice slice = decode(readFile(slicePath));
+    expectTrue(slice.ok, "exported slice should decode");
+    expectTrue(slice.header.sliceId == "backup" && slice.header.version == 7, "options should land in the header");
+    expectTrue(slice.tables.size() == 2, "only tables with _status should be exported by default");
+    if (slice.tables.size() == 2) {
+        const DecodedTable& tasks = slice.tables[0];
+        expectTrue(tasks.header.tableName == "tasks", "tables should follow schema order");
+        expectTrue(tasks.header.columns == std::vector<std::string>({"id", "title", "position", "weight", "payload"}),
+                   "bookkeeping columns should not be exported");
+        expectTrue(tasks.rows.size() == 2, "deleted rows should be skipped");
+        if (tasks.rows.size() == 2) {
+            expectTrue(tasks.rows[0][0].text() == "t1" && tasks.rows[0][2].intValue() == 1 &&
+                       tasks.rows[0][3].realValue() == 0.5 &&
+                       blobOf(tasks.rows[0][4]) == std::vector<uint8_t>({0x01, 0x02}),
+                       "values should keep their SQLite types");
+            expectTrue(tasks.rows[1][3].type() == watermelondb::FieldValue::Type::NULL_VALUE,
+                       "NULLs should be exported");
+        }
+        expectTrue(slice.tables[1].header.tableName == "projects" && slice.tables[1].rows.size() == 2,
+                   "every synced table should be exported");
+        if (slice.tables[1].rows.size() == 2) {
+            const auto& name = slice.tables[1].rows[1][1];
+            expectTrue(name.type() == watermelondb::FieldValue::Type::TEXT_VALUE && name.size() == 0,
+                       "empty strings should not come back as NULL");
+        }
+    }
+
+    options.tables = {"projects"};
+    expectTrue(watermelondb::exportSlice(db, slicePath, options, &stats, error), "explicit table export should succeed");
+    slice = decode(readFile(slicePath));
+    expectTrue(slice.tables.size() == 1 && slice.tables[0].header.tableName == "projects",
+               "explicit tables should be honored");
+
+    options.tables = {"missing"};
+    expectTrue(!watermelondb::exportSlice(db, slicePath, options, &stats, error), "missing table should fail");
+    expectTrue(!fileExists(slicePath + ".partial"), "failed export should not leave a partial file");
+    expectTrue(sqlite3_get_autocommit(db) != 0, "failed export should end its read transaction");
+
+    sqlite3_close(db);
+    std::remove(dbPath.c_str());
+    std::remove(slicePath.c_str());
+}
+
+void test_synthetic_slice() {
+    const std::string path = "slice_encoder_synthetic.slice";
+    watermelondb::SyntheticSliceSpec spec;
+    spec.rowsPerTable = 20000;
+    spec.tableCount = 2;
+    watermelondb::SliceExportStats stats;
+    std::string error;
+    expectTrue(watermelondb::writeSyntheticSlice(path, spec, &stats, error), "synthetic slice should be written");
+    std::vector<uint8_t> first = readFile(path);
+    expectTrue(stats.rows == 40000 && stats.compressedBytes == first.size(), "synthetic stats should match");
+
+    DecodedSlice slice = decode(first);
+    expectTrue(slice.ok && slice.tables.size() == 2, "synthetic slice should decode");
+    if (slice.tables.size() == 2) {
+        expectTrue(slice.tables[0].header.tableName == "tasks" && slice.tables[1].header.tableName == "tasks_1",
+                   "synthetic tables should be named after tasks");
+        expectTrue(slice.tables[0].header.columns == watermelondb::syntheticSliceColumns(),
+                   "synthetic columns should match");
+        expectTrue(slice.tables[0].rows.size() == 20000 && slice.tables[1].rows.size() == 20000,
+                   "synthetic row counts should match");
+    }
+
+    expectTrue(watermelondb::writeSyntheticSlice(path, spec, nullptr, error), "rewrite should succeed");
+    expectTrue(readFile(path) == first, "synthetic slices should be deterministic");
+    std::remove(path.c_str());
+}
+
+void test_parse_export_options() {
+    watermelondb::SliceExportOptions options;
+    std::string error;
+    expectTrue(watermelondb::parseSliceExportOptions(
+                   "{\"tables\":[\"tasks\",\"projects\"],\"sliceId\":\"handoff\",\"version\":12,\"compressionLevel\":9}",
+                   options, error),
+               "valid options should parse");
+    expectTrue(options.tables.size() == 2 && options.sliceId == "handoff" && options.version == 12 &&
+               options.compressionLevel == 9, "options should be read");
+    expectTrue(watermelondb::parseSliceExportOptions("", options, error) && options.tables.empty() &&
+               options.compressionLevel == watermelondb::SliceEncoder::DEFAULT_COMPRESSION_LEVEL,
+               "empty options should use defaults");
+    expectTrue(!watermelondb::parseSliceExportOptions("{\"compressionLevel\":99}", options, error),
+               "out of range level should fail");
+    expectTrue(!watermelondb::parseSliceExportOptions("{\"version\":-1}", options, error),
+               "negative version should fail");
+    expectTrue(!watermelondb::parseSliceExportOptions("{\"tables\":[1]}", options, error),
+               "non-string table should fail");
+}
+
+} // namespace
+
+int main() {
+    test_roundtrip_through_decoder();
+    test_delta_slice_roundtrip();
+    test_patch_from_previous_version();
+    test_rejects_malformed_slices();
+    test_export_from_sqlite();
+    test_synthetic_slice();
+    test_parse_export_options();
+
+    if (gFailures > 0) {
+        std::cerr << gFailures << " test(s) failed\n";
+        return 1;
+    }
+    std::cout << "All SliceEncoder tests passed\n";
+    return 0;
+}
@@ -0,0 +1,267 @@
+// End-to-end slice import benchmark over a local (memory-mapped) slice file. Not run as part of
+// the test suite:
+//   ./build/slice_import_benchmarks [rows] [path/to/existing.slice]
+// Without a path, a synthetic slice shaped like a WatermelonDB tasks table is generated first.
+#include "../SliceEncoder.h"
+#include "../SliceImportEngine.h"
+#include "../SliceLocalFile.h"
+#include "../SqliteInsertHelper.h"
+
+#include <sqlite3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace watermelondb::platform {
+
+void initializeWorkQueue() {}
+
+void runOnWorkQueue(const std::function<void()>& work) {
+    work();
+}
+
+std::string sliceCacheDirectory() {
+    return "";
+}
+
+unsigned long calculateOptimalBatchSize() {
+    return 1000;
+}
+
+class BenchmarkMemoryHandle : public MemoryAlertHandle {
+public:
+    void cancel() override {}
+};
+
+std::shared_ptr<MemoryAlertHandle> setupMemoryAlertCallback(const std::function<void(MemoryAlertLevel)>&) {
+    return std::make_shared<BenchmarkMemoryHandle>();
+}
+
+void cancelMemoryPressureMonitoring() {}
+
+std::shared_ptr<DownloadHandle> downloadFile(
+    const std::string&,
+    std::function<void(const uint8_t*, size_t)>,
+    std::function<void(const std::string&)> onComplete
+) {
+    onComplete("Network downloads are not available in benchmarks");
+    return nullptr;
+}
+
+void logInfo(const std::string& message) {
+    // Stage timings come from the engine's own summary line
+    if (message.rfind("Import timing", 0) == 0) {
+        std::printf("  %s\n", message.c_str());
+    }
+}
+void logDebug(const std::string&) {}
+void logError(const std::string& message) {
+    std::fprintf(stderr, "  error: %s\n", message.c_str());
+}
+
+} // namespace watermelondb::platform
+
+namespace {
+
+const char* kDatabasePath = "slice_import_benchmark.db";
+
+const char* kSchema =
+    "CREATE TABLE tasks ("
+    " id TEXT PRIMARY KEY, _changed TEXT, _status TEXT,"
+    " project_id TEXT, assignee_id TEXT, status TEXT, title TEXT, description TEXT,"
+    " priority INTEGER, estimate REAL, is_archived INTEGER, created_at INTEGER, updated_at INTEGER);"
+    "CREATE INDEX tasks_project_id ON tasks (project_id);"
+    "CREATE INDEX tasks_assignee_id ON tasks (assignee_id);"
+    "CREATE INDEX tasks_updated_at ON tasks (updated_at);";
+
+void execOrDie(sqlite3* db, const char* sql) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::fprintf(stderr, "SQL failed: %s\n", errMsg ? errMsg : "?");
+        std::exit(1);
+    }
+}
+
+// Minimal DatabaseInterface over a plain connection, same statements as the platform adapters
+class BenchmarkDatabase final : public watermelondb::DatabaseInterface {
+public:
+    explicit BenchmarkDatabase(sqlite3* db) : db_(db) {}
+    ~BenchmarkDatabase() override { helper_.finalizeStatements(); }
+
+    bool beginTransaction(std::string& errorMessage) override { return exec("BEGIN IMMEDIATE", errorMessage); }
+    bool commitTransaction(std::string& errorMessage) override {
+        return helper_.finishBulkLoad(db_, errorMessage) && exec("COMMIT", errorMessage);
+    }
+    void rollbackTransaction() override {
+        std::string ignored;
+        exec("ROLLBACK", ignored);
+        helper_.discardDeferredIndexes();
+    }
+    bool insertRows(const std::string& tableName,
+                    const std::vector<std::string>& columns,
+                    const watermelondb::RowSet& rows,
+                    std::string& errorMessage) override {
+        return helper_.insertRowsMulti(db_, tableName, columns, rows, errorMessage);
+    }
+    bool insertBatch(const watermelondb::BatchData& batch, std::string& errorMessage) override {
+        return helper_.insertBatch(db_, batch, errorMessage);
+    }
+    bool createSavepoint(std::string& errorMessage) override { return exec("SAVEPOINT sp", errorMessage); }
+    bool releaseSavepoint(std::string& errorMessage) override { return exec("RELEASE SAVEPOINT sp", errorMessage); }
+    bool beginTableLoad(const std::string& tableName, std::string& errorMessage) override {
+        return helper_.deferIndexes(db_, tableName, errorMessage);
+    }
+    bool endTableLoad(const std::string& tableName, std::string& errorMessage) override {
+        return helper_.restoreIndexes(db_, tableName, errorMessage);
+    }
+    bool getTableColumns(const std::string& tableName, std::vector<std::string>& columns,
+                         std::string& errorMessage) override {
+        return watermelondb::SqliteInsertHelper::tableColumns(db_, tableName, columns, errorMessage);
+    }
+
+private:
+    sqlite3* db_;
+    watermelondb::SqliteInsertHelper helper_;
+
+    bool exec(const char* sql, std::string& errorMessage) {
+        char* errMsg = nullptr;
+        if (sqlite3_exec(db_, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            errorMessage = errMsg ? errMsg : "SQLite error";
+            sqlite3_free(errMsg);
+            return false;
+        }
+        return true;
+    }
+};
+
+std::string writeSyntheticSlice(size_t rowCount) {
+    const std::string path = "slice_import_benchmark.slice";
+    watermelondb::SyntheticSliceSpec spec;
+    spec.rowsPerTable = rowCount;
+    watermelondb::SliceExportStats stats;
+    std::string error;
+    auto start = std::chrono::steady_clock::now();
+    if (!watermelondb::writeSyntheticSlice(path, spec, &stats, error)) {
+        std::fprintf(stderr, "synthetic slice failed: %s\n", error.c_str());
+        std::exit(1);
+    }
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("synthetic slice: %zu rows, %llu bytes raw, %llu bytes compressed\n", rowCount,
+                static_cast<unsigned long long>(stats.uncompressedBytes),
+                static_cast<unsigned long long>(stats.compressedBytes));
+    std::printf("encode:                %8.1f ms  (%zu rows, %.0f rows/s)\n", elapsed, rowCount, rowCount / (elapsed / 1000.0));
+    return path;
+}
+
+// Decompress + parse only, no database
+double decodeOnly(const std::string& path, size_t& rowsOut) {
+    auto start = std::chrono::steady_clock::now();
+    watermelondb::MappedFile file;
+    std::string error;
+    if (!file.open(path, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        std::exit(1);
+    }
+    watermelondb::SliceDecoder decoder;
+    decoder.initializeDecompression();
+    watermelondb::SliceHeader header;
+    watermelondb::TableHeader table;
+    bool headerParsed = false;
+    bool inTable = false;
+    std::vector<watermelondb::FieldValue> values;
+    rowsOut = 0;
+    const size_t chunkSize = 256 * 1024;
+    for (size_t offset = 0; offset < file.size(); offset += chunkSize) {
+        decoder.feedCompressedData(file.data() + offset, std::min(chunkSize, file.size() - offset));
+        if (!headerParsed) {
+            if (decoder.parseSliceHeader(header) != watermelondb::ParseStatus::Ok) {
+                continue;
+            }
+            headerParsed = true;
+        }
+        while (true) {
+            if (!inTable) {
+                if (decoder.parseTableHeader(table) != watermelondb::ParseStatus::Ok) {
+                    break;
+                }
+                inTable = true;
+            }
+            watermelondb::ParseStatus status;
+            while ((status = decoder.parseRowValues(table.columns, values)) == watermelondb::ParseStatus::Ok) {
+                rowsOut++;
+            }
+            if (status != watermelondb::ParseStatus::EndOfTable) {
+                break;
+            }
+            inTable = false;
+        }
+        decoder.compactBuffer();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double importFile(const std::string& path, const watermelondb::SliceImportOptions& options, size_t& rowsOut) {
+    std::remove(kDatabasePath);
+    std::remove("slice_import_benchmark.db-wal");
+    std::remove("slice_import_benchmark.db-shm");
+    sqlite3* db = nullptr;
+    sqlite3_open(kDatabasePath, &db);
+    execOrDie(db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL; PRAGMA temp_store=MEMORY; PRAGMA cache_size=-20000;");
+    execOrDie(db, kSchema);
+
+    auto database = std::make_shared<BenchmarkDatabase>(db);
+    auto engine = std::make_shared<watermelondb::SliceImportEngine>(database, options);
+    std::string result = "not completed";
+    auto start = std::chrono::steady_clock::now();
+    engine->startImport(path, [&result](const std::string& error) {
+        result = error;
+    });
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (!result.empty()) {
+        std::fprintf(stderr, "import failed: %s\n", result.c_str());
+        std::exit(1);
+    }
+    rowsOut = engine->getTotalRowsInserted();
+
+    engine.reset();
+    database.reset();
+    sqlite3_close(db);
+    std::remove(kDatabasePath);
+    std::remove("slice_import_benchmark.db-wal");
+    std::remove("slice_import_benchmark.db-shm");
+    return elapsed;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t rowCount = argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : 200000;
+    bool synthetic = argc <= 2;
+    std::string path = synthetic ? writeSyntheticSlice(rowCount) : std::string(argv[2]);
+    if (path[0] != '/') {
+        // Local imports are recognised by absolute path / file:// URL
+        char* cwd = realpath(".", nullptr);
+        path = std::string(cwd) + "/" + path;
+        std::free(cwd);
+    }
+
+    size_t rows = 0;
+    double decodeMs = decodeOnly(path, rows);
+    std::printf("decode only:           %8.1f ms  (%zu rows, %.0f rows/s)\n", decodeMs, rows, rows / (decodeMs / 1000.0));
+
+    if (synthetic) {
+        watermelondb::SliceImportOptions options;
+        double importMs = importFile(path, options, rows);
+        std::printf("import:                %8.1f ms  (%zu rows, %.0f rows/s)\n", importMs, rows, rows / (importMs / 1000.0));
+
+        options.bulkLoad = true;
+        importMs = importFile(path, options, rows);
+        std::printf("import (bulkLoad):     %8.1f ms  (%zu rows, %.0f rows/s)\n", importMs, rows, rows / (importMs / 1000.0));
+        std::remove(path.c_str());
+    }
+    return 0;
+}
@@ -1,15 +1,29 @@
 #define private public
 #include "../SliceImportEngine.h"
 #undef private
+#include "../SliceLocalFile.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <string>
+#include <unistd.h>
 #include <vector>
 
 namespace watermelondb::platform {
 
 void initializeWorkQueue() {}
 
+void runOnWorkQueue(const std::function<void()>& work) {
+    work();
+}
+
+std::string gSliceCacheDirectory;
+
+std::string sliceCacheDirectory() {
+    return gSliceCacheDirectory;
+}
+
 unsigned long calculateOptimalBatchSize() {
     return 1000;
 }
@@ -30,11 +44,22 @@ public:
     void cancel() override {}
 };
 
+// When set, downloads deliver this body synchronously in small chunks
+std::vector<uint8_t> gDownloadBody;
+int gDownloadCount = 0;
+
 std::shared_ptr<DownloadHandle> downloadFile(
     const std::string&,
-    std::function<void(const uint8_t*, size_t)>,
-    std::function<void(const std::string&)>
+    std::function<void(const uint8_t*, size_t)> onData,
+    std::function<void(const std::string&)> onComplete
 ) {
+    gDownloadCount++;
+    if (!gDownloadBody.empty()) {
+        for (size_t offset = 0; offset < gDownloadBody.size(); offset += 64) {
+            onData(gDownloadBody.data() + offset, std::min<size_t>(64, gDownloadBody.size() - offset));
+        }
+        onComplete("");
+    }
     return std::make_shared<DummyDownloadHandle>();
 }
 
@@ -55,6 +80,10 @@ void expectTrue(bool value, const char* message) {
     }
 }
 
+watermelondb::Identifier tableId(const char* name) {
+    return watermelondb::internIdentifier(name);
+}
+
 void appendVarint(std::vector<uint8_t>& out, uint64_t value) {
     while (value >= 0x80) {
         out.push_back(static_cast<uint8_t>((value & 0x7F) | 0x80));
@@ -87,7 +116,13 @@ struct FakeDb : public watermelondb::DatabaseInterface {
         beginCount++;
         return true;
     }
-    bool commitTransaction(std::string&) override {
+    // Commits after this many succeed fail (-1: never)
+    int failCommitsAfter = -1;
+    bool commitTransaction(std::string& errorMessage) override {
+        if (failCommitsAfter >= 0 && commitCount >= failCommitsAfter) {
+            errorMessage = "commit failed";
+            return false;
+        }
         commitCount++;
         return true;
     }
@@ -97,7 +132,7 @@ struct FakeDb : public watermelondb::DatabaseInterface {
     bool insertRows(
         const std::string&,
         const std::vector<std::string>&,
-        const std::vector<std::vector<watermelondb::FieldValue>>&,
+        const watermelondb::RowSet&,
         std::string&
     ) override {
         return true;
@@ -115,6 +150,26 @@ struct FakeDb : public watermelondb::DatabaseInterface {
         releaseSavepointCount++;
         return true;
     }
+    std::vector<std::string> tableLoadEvents;
+    bool beginTableLoad(const std::string& tableName, std::string&) override {
+        tableLoadEvents.push_back("begin:" + tableName + ":" + std::to_string(insertBatchCount));
+        return true;
+    }
+    bool endTableLoad(const std::string& tableName, std::string&) override {
+        tableLoadEvents.push_back("end:" + tableName + ":" + std::to_string(insertBatchCount));
+        return true;
+    }
+    std::unordered_map<std::string, std::vector<std::string>> declaredTables;
+    bool declareTable(const std::string& tableName, const std::vector<std::string>& columns, std::string&) override {
+        declaredTables[tableName] = columns;
+        return true;
+    }
+    std::unordered_map<std::string, std::vector<std::string>> localSchema;
+    bool getTableColumns(const std::string& tableName, std::vector<std::string>& columns, std::string&) override {
+        auto it = localSchema.find(tableName);
+        columns = it == localSchema.end() ? std::vector<std::string>() : it->second;
+        return true;
+    }
 };
 
 void setupDecoderWithSingleRow(watermelondb::SliceImportEngine& engine) {
@@ -155,6 +210,564 @@ void test_parse_decompressed_and_flush() {
     expectTrue(engine.totalRowsInserted_ == 1, "totalRowsInserted should increment");
 }
 
+std::vector<uint8_t> buildSliceWithTables(const std::vector<std::string>& tables) {
+    std::vector<uint8_t> data;
+    appendString(data, "slice1");
+    appendVarint(data, 1);
+    appendString(data, "high");
+    appendVarint(data, 1);
+    appendVarint(data, tables.size());
+
+    for (const auto& table : tables) {
+        appendString(data, table);
+        appendVarint(data, 1);
+        appendString(data, "id");
+        appendTextField(data, table + "_1");
+        appendTextField(data, table + "_2");
+        data.push_back(watermelondb::END_OF_TABLE_DELIMITER);
+    }
+    return data;
+}
+
+void setupDecoderWithTables(watermelondb::SliceImportEngine& engine, const std::vector<std::string>& tables) {
+    std::vector<uint8_t> data = buildSliceWithTables(tables);
+
+    engine.decoder_ = std::make_unique<watermelondb::SliceDecoder>();
+    engine.decoder_->streamInitialized_ = true;
+    engine.decoder_->streamEnded_ = true;
+    engine.decoder_->decompressedBuffer_ = data;
+    engine.decoder_->decompressedSize_ = data.size();
+    engine.decoder_->currentOffset_ = 0;
+    engine.headerParsed_ = false;
+    engine.failed_ = false;
+    engine.transactionStarted_ = true;
+}
+
+void test_atomic_mode_commits_once() {
+    auto db = std::make_shared<FakeDb>();
+    auto engine = std::make_shared<watermelondb::SliceImportEngine>(db);
+    std::vector<std::vector<std::string>> commits;
+    engine->setCommitCallback([&commits](const std::vector<std::string>& tables, size_t) {
+        commits.push_back(tables);
+    });
+    setupDecoderWithTables(*engine, {"users", "projects", "history"});
+
+    engine->parseDecompressedData();
+    expectTrue(db->commitCount == 0, "atomic mode should not commit while streaming");
+
+    engine->handleDownloadComplete("");
+    expectTrue(db->commitCount == 1, "atomic mode should commit once at the end");
+    expectTrue(commits.size() == 1 && commits[0].size() == 3, "atomic commit should report all tables");
+}
+
+void test_per_table_mode_commits_each_table() {
+    auto db = std::make_shared<FakeDb>();
+    watermelondb::SliceImportOptions options;
+    options.commitMode = watermelondb::SliceCommitMode::PerTable;
+    auto engine = std::make_shared<watermelondb::SliceImportEngine>(db, options);
+    std::vector<std::vector<std::string>> commits;
+    engine->setCommitCallback([&commits](const std::vector<std::string>& tables, size_t) {
+        commits.push_back(tables);
+    });
+    setupDecoderWithTables(*engine, {"users", "projects", "history"});
+
+    engine->parseDecompressedData();
+    expectTrue(db->commitCount == 3, "per-table mode should commit after every table");
+    expectTrue(db->beginCount == 3, "per-table mode should reopen a transaction after every commit");
+    expectTrue(engine->totalRowsInserted_ == 6, "all rows should be flushed before commits");
+
+    engine->handleDownloadComplete("");
+    expectTrue(db->commitCount == 4, "final (empty) transaction should be committed");
+    expectTrue(commits.size() == 3, "commit callback should fire once per table");
+    expectTrue(commits.size() == 3 && commits[1].size() == 1 && commits[1][0] == "projects", "commit should report its table");
+}
+
+void test_priority_groups_mode_commits_on_group_change() {
+    auto db = std::make_shared<FakeDb>();
+    watermelondb::SliceImportOptions options;
+    options.commitMode = watermelondb::SliceCommitMode::PriorityGroups;
+    options.priorityGroups = {{"users", "projects"}};
+    auto engine = std::make_shared<watermelondb::SliceImportEngine>(db, options);
+    std::vector<std::vector<std::string>> commits;
+    engine->setCommitCallback([&commits](const std::vector<std::string>& tables, size_t) {
+        commits.push_back(tables);
+    });
+    setupDecoderWithTables(*engine, {"users", "projects", "history", "audit"});
+
+    engine->parseDecompressedData();
+    expectTrue(db->commitCount == 1, "first group should be committed when the next group starts");
+
+    engine->handleDownloadComplete("");
+    expectTrue(db->commitCount == 2, "trailing group should be committed at the end");
+    expectTrue(commits.size() == 2, "commit callback should fire once per group");
+    expectTrue(commits.size() == 2 && commits[0].size() == 2 && commits[1].size() == 2, "groups should be reported together");
+}
+
+void test_bulk_load_wraps_each_table() {
+    auto db = std::make_shared<FakeDb>();
+    watermelondb::SliceImportOptions options;
+    options.bulkLoad = true;
+    auto engine = std::make_shared<watermelondb::SliceImportEngine>(db, options);
+    setupDecoderWithTables(*engine, {"users", "projects"});
+
+    engine->parseDecompressedData();
+    std::vector<std::string> expected = {
+        "begin:users:0", "end:users:1", "begin:projects:1", "end:projects:2"
+    };
+    expectTrue(db->tableLoadEvents == expected, "bulk load should flush each table before ending its load");
+    expectTrue(db->commitCount == 0, "bulk load should not change the commit mode");
+}
+
+void test_local_slice_urls() {
+    expectTrue(watermelondb::isLocalSliceUrl("file:///data/a.slice"), "file URLs are local");
+    expectTrue(watermelondb::isLocalSliceUrl("/data/a.slice"), "absolute paths are local");
+    expectTrue(!watermelondb::isLocalSliceUrl("https://example.com/a.slice"), "https URLs are not local");
+    expectTrue(watermelondb::localSlicePath("file:///data/a%20b.slice") == "/data/a b.slice", "file URLs should be decoded");
+    expectTrue(watermelondb::localSlicePath("file://localhost/data/a.slice") == "/data/a.slice", "localhost host should be dropped");
+}
+
+void test_local_file_import() {
+    std::vector<uint8_t> raw = buildSliceWithTables({"users", "projects"});
+    std::vector<uint8_t> compressed(ZSTD_compressBound(raw.size()));
+    size_t compressedSize = ZSTD_compress(compressed.data(), compressed.size(), raw.data(), raw.size(), 3);
+    expectTrue(!ZSTD_isError(compressedSize), "test slice should compress");
+    compressed.resize(compressedSize);
+
+    const std::string path = "slice_import_engine_test local.slice";
+    FILE* file = std::fopen(path.c_str(), "wb");
+    std::fwrite(compressed.data(), 1, compressed.size(), file);
+    std::fclose(file);
+
+    auto db = std::make_shared<FakeDb>();
+    auto engine = std::make_shared<watermelondb::SliceImportEngine>(db);
+    bool completed = false;
+    std::string completionError = "not called";
+    engine->startImport("file://slice_import_engine_test%20local.slice", [&](const std::string& error) {
+        completed = true;
+        completionError = error;
+    });
+    std::remove(path.c_str());
+
+    expectTrue(completed && completionError.empty(), "local import should complete");
+    expectTrue(engine->getTotalRowsInserted() == 4, "local import should insert every row");
+    expectTrue(db->commitCount == 1, "local import should commit");
+
+    auto missingDb = std::make_shared<FakeDb>();
+    auto missingEngine = std::make_shared<watermelondb::SliceImportEngine>(missingDb);
+    completionError.clear();
+    missingEngine->startImport("file:///nonexistent/slice.bin", [&](const std::string& error) {
+        completionError = error;
+    });
+    expectTrue(!completionError.empty(), "missing local file should fail the import");
+    expectTrue(missingDb->rollbackCount == 1, "missing local file should roll back");
+}
+
+std::vector<uint8_t> compressSlice(const std::vector<uint8_t>& raw) {
+    std::vector<uint8_t> compressed(ZSTD_compressBound(raw.size()));
+    size_t compressedSize = ZSTD_compress(compressed.data(), compressed.size(), raw.data(), raw.size(), 3);
+    compressed.resize(ZSTD_isError(compressedSize) ? 0 : compressedSize);
+    return compressed;
+}
+
+void test_cached_download_is_reused() {
+    watermelondb::platform::gSliceCacheDirectory = "slice_import_engine_test_cache";
+    watermelondb::platform::gDownloadBody = compressSlice(buildSliceWithTables({"users"}));
+    watermelondb::platform::gDownloadCount = 0;
+
+    auto runImport = [](const watermelondb::SliceImportOptions& options, std::shared_ptr<FakeDb> db) {
+        auto engine = std::make_shared<watermelondb::SliceImportEngine>(db, options);
+        std::string completionError = "not called";
+        engine->startImport("https://example.com/users.slice", [&](const std::string& error) {
+            completionError = error;
+        });
+        return completionError;
+    };
+
+    // No key yet: downloaded and stored under <sliceId>@<version> from the header
+    watermelondb::SliceImportOptions options;
+    options.cache = true;
+    auto firstDb = std::make_shared<FakeDb>();
+    expectTrue(runImport(options, firstDb).empty(), "first import should download");
+    expectTrue(watermelondb::platform::gDownloadCount == 1, "first import should hit the network");
+
+    watermelondb::SliceCache cache(watermelondb::platform::gSliceCacheDirectory);
+    expectTrue(!cache.lookup("slice1@1").empty(), "download should be cached under its header key");
+
+    options.cacheKey = "slice1@1";
+    auto secondDb = std::make_shared<FakeDb>();
+    expectTrue(runImport(options, secondDb).empty(), "cached import should succeed");
+    expectTrue(watermelondb::platform::gDownloadCount == 1, "cached import should not download");
+    expectTrue(secondDb->lastBatch.totalRows == 2, "cached import should insert every row");
+
+    // Corrupt download: nothing is cached under the requested key
+    watermelondb::platform::gDownloadBody = {0x28, 0xB5, 0x2F, 0xFD, 0x00};
+    options.cacheKey = "etag-broken";
+    expectTrue(!runImport(options, std::make_shared<FakeDb>()).empty(), "corrupt download should fail");
+    expectTrue(cache.lookup("etag-broken").empty(), "failed download should not be cached");
+
+    cache.remove("slice1@1");
+    ::rmdir(watermelondb::platform::gSliceCacheDirectory.c_str());
+    watermelondb::platform::gSliceCacheDirectory.clear();
+    watermelondb::platform::gDownloadBody.clear();
+}
+
+void test_patched_import_from_cached_reference() {
+    watermelondb::platform::gSliceCacheDirectory = "slice_import_engine_patch_cache";
+    watermelondb::platform::gDownloadCount = 0;
+
+    // Version 2 adds a table to version 1 (the version varint is the byte after "slice1")
+    std::vector<uint8_t> previous = buildSliceWithTables({"users", "projects"});
+    std::vector<uint8_t> next = buildSliceWithTables({"users", "projects", "tasks"});
+    next[7] = 2;
+
+    watermelondb::SliceCache cache(watermelondb::platform::gSliceCacheDirectory);
+    std::string error;
+    auto writer = cache.beginWrite(error);
+    std::vector<uint8_t> previousCompressed = compressSlice(previous);
+    writer->append(previousCompressed.data(), previousCompressed.size());
+    expectTrue(cache.commit(*writer, "slice1@1", error), "reference should be cached");
+
+    // What `zstd --patch-from` produces
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    ZSTD_CCtx_refPrefix(cctx, previous.data(), previous.size());
+    std::vector<uint8_t> patch(ZSTD_compressBound(next.size()));
+    size_t patchSize = ZSTD_compress2(cctx, patch.data(), patch.size(), next.data(), next.size());
+    ZSTD_freeCCtx(cctx);
+    patch.resize(ZSTD_isError(patchSize) ? 0 : patchSize);
+    watermelondb::platform::gDownloadBody = patch;
+
+    auto runImport = [](const watermelondb::SliceImportOptions& options, std::shared_ptr<FakeDb> db) {
+        auto engine = std::make_shared<watermelondb::SliceImportEngine>(db, options);
+        std::string completionError = "not called";
+        engine->startImport("https://example.com/slice1.patch", [&](const std::string& error) {
+            completionError = error;
+        });
+        return completionError;
+    };
+
+    watermelondb::SliceImportOptions options;
+    expectTrue(watermelondb::parseSliceImportOptions("{\"patchFrom\":\"slice1@1\"}", options, error),
+               "patchFrom should parse");
+    expectTrue(options.cache && options.patchFrom == "slice1@1", "patchFrom should imply cache");
+    auto db = std::make_shared<FakeDb>();
+    expectTrue(runImport(options, db).empty(), "patched import should succeed");
+    expectTrue(db->lastBatch.totalRows == 6 && db->lastBatch.tables.count(tableId("tasks")) == 1,
+               "patched import should insert the new version");
+
+    // The reconstructed slice is cached as a full slice, ready to be the next reference
+    std::string nextPath = cache.lookup("slice1@2");
+    expectTrue(!nextPath.empty(), "reconstructed slice should be cached under its header key");
+    watermelondb::MappedFile cached;
+    std::vector<uint8_t> cachedRaw;
+    expectTrue(cached.open(nextPath, error) &&
+               watermelondb::decompressSlice(cached.data(), cached.size(), cachedRaw, error) && cachedRaw == next,
+               "cached slice should decompress to the new version without a reference");
+
+    options.patchFrom = "slice1@0";
+    expectTrue(runImport(options, std::make_shared<FakeDb>()).find("not cached") != std::string::npos,
+               "missing reference should fail the import");
+    expectTrue(watermelondb::platform::gDownloadCount == 1, "missing reference should fail before downloading");
+
+    cache.remove("slice1@1");
+    cache.remove("slice1@2");
+    ::rmdir(watermelondb::platform::gSliceCacheDirectory.c_str());
+    watermelondb::platform::gSliceCacheDirectory.clear();
+    watermelondb::platform::gDownloadBody.clear();
+}
+
+// audit_log gets `auditRows` rows whose values are `auditText`
+std::vector<uint8_t> buildWideSlice(int auditRows = 2, const std::string& auditText = "audit trail") {
+    std::vector<uint8_t> data;
+    appendString(data, "slice1");
+    appendVarint(data, 1);
+    appendString(data, "high");
+    appendVarint(data, 1);
+    appendVarint(data, 3);
+    for (const std::string table : {"users", "audit_log", "tasks"}) {
+        appendString(data, table);
+        appendVarint(data, 3);
+        appendString(data, "id");
+        appendString(data, "name");
+        appendString(data, "server_audit");
+        const bool audit = table == std::string("audit_log");
+        for (int i = 1; i <= (audit ? auditRows : 2); i++) {
+            appendTextField(data, table + "_" + std::to_string(i));
+            appendTextField(data, audit ? auditText : "name");
+            appendTextField(data, audit ? auditText : "audit trail");
+        }
+        data.push_back(watermelondb::END_OF_TABLE_DELIMITER);
+    }
+    return data;
+}
+
+void setupDecoderWithData(watermelondb::SliceImportEngine& engine, const std::vector<uint8_t>& data) {
+    engine.decoder_ = std::make_unique<watermelondb::SliceDecoder>();
+    engine.decoder_->streamInitialized_ = true;
+    engine.decoder_->streamEnded_ = true;
+    engine.decoder_->decompressedBuffer_ = data;
+    engine.decoder_->decompressedSize_ = data.size();
+    engine.decoder_->currentOffset_ = 0;
+    engine.headerParsed_ = false;
+    engine.failed_ = false;
+    engine.transactionStarted_ = true;
+}
+
+void test_projection_skips_tables_and_columns() {
+    auto db = std::make_shared<FakeDb>();
+    watermelondb::SliceImportOptions options;
+    options.skipTables = {"audit_log"};
+    options.columnAllowlist["tasks"] = {"id", "name"};
+    auto engine = std::make_shared<watermelondb::SliceImportEngine>(db, options);
+    setupDecoderWithData(*engine, buildWideSlice());
+    engine->parseDecompressedData();
+    std::string error;
+    engine->flushBatch(error);
+
+    expectTrue(!engine->failed_, "projected import should not fail");
+    expectTrue(engine->getTotalRowsInserted() == 4, "skipped table rows should not be inserted");
+    expectTrue(db->lastBatch.tables.count(tableId("audit_log")) == 0, "skipped table should not reach the database");
+    expectTrue(db->lastBatch.tableColumns[tableId("tasks")] == std::vector<std::string>({"id", "name"}),
+               "allowlisted table should only bind listed columns");
+    expectTrue(db->lastBatch.tables[tableId("tasks")][0].size() == 2, "allowlisted rows should only carry listed values");
+    expectTrue(db->lastBatch.tableColumns[tableId("users")].size() == 3, "tables without projection keep every column");
+    expectTrue(db->declaredTables["tasks"] == std::vector<std::string>({"id", "name"}),
+               "tables should be declared with their projected columns");
+    expectTrue(db->declaredTables["users"].size() == 3, "unprojected tables should be declared with every column");
+    expectTrue(db->declaredTables.count("audit_log") == 0, "skipped tables should not be declared");
+
+    // Long values of a skipped section are stepped over, not copied into the batch arena
+    auto smallEngine = std::make_shared<watermelondb::SliceImportEngine>(std::make_shared<FakeDb>(), options);
+    setupDecoderWithData(*smallEngine, buildWideSlice());
+    smallEngine->decoder_->setValueArena(&smallEngine->currentBatch_.arena());
+    smallEngine->parseDecompressedData();
+    auto bigEngine = std::make_shared<watermelondb::SliceImportEngine>(std::make_shared<FakeDb>(), options);
+    setupDecoderWithData(*bigEngine, buildWideSlice(2000, std::string(200, 'a')));
+    bigEngine->decoder_->setValueArena(&bigEngine->currentBatch_.arena());
+    bigEngine->parseDecompressedData();
+    expectTrue(!bigEngine->failed_ && bigEngine->getTotalRowsInserted() == 0 && bigEngine->currentBatch_.totalRows == 4,
+               "large skipped section should parse without adding rows");
+    expectTrue(bigEngine->currentBatch_.arenaHighWaterMark() == smallEngine->currentBatch_.arenaHighWaterMark(),
+               "arena should stay flat across a skipped section");
+}
+
+void test_projection_to_local_schema() {
+    auto db = std::make_shared<FakeDb>();
+    db->localSchema["users"] = {"id", "_status", "_changed", "name"};
+    db->localSchema["tasks"] = {"id", "_status", "_changed", "name", "server_audit"};
+    watermelondb::SliceImportOptions options;
+    options.projectToLocalSchema = true;
+    auto engine = std::make_shared<watermelondb::SliceImportEngine>(db, options);
+    setupDecoderWithData(*engine, buildWideSlice());
+    engine->parseDecompressedData();
+    std::string error;
+    engine->flushBatch(error);
+
+    expectTrue(!engine->failed_, "local schema projection should not fail");
+    expectTrue(db->lastBatch.tableColumns[tableId("users")] == std::vector<std::string>({"id", "name"}),
+               "columns missing locally should be dropped");
+    expectTrue(db->lastBatch.tableColumns[tableId("tasks")].size() == 3, "tables matching the local schema keep every column");
+    expectTrue(db->lastBatch.tables.count(tableId("audit_log")) == 0, "tables missing locally should be skipped");
+}
+
+void test_delta_slice_batches_upserts_and_deletes() {
+    std::vector<uint8_t> data;
+    appendString(data, "delta");
+    appendVarint(data, 2);
+    appendString(data, "high");
+    appendVarint(data, 1);
+    appendVarint(data, (watermelondb::SLICE_FLAG_DELTA << watermelondb::SLICE_FLAGS_SHIFT) | 1);
+    appendString(data, "tasks");
+    appendVarint(data, 2);
+    appendString(data, "id");
+    appendString(data, "name");
+    data.push_back(static_cast<uint8_t>(watermelondb::DeltaOp::UPSERT));
+    appendTextField(data, "t1");
+    appendTextField(data, "Alpha");
+    data.push_back(static_cast<uint8_t>(watermelondb::DeltaOp::DELETE));
+    appendTextField(data, "t2");
+    data.push_back(watermelondb::END_OF_TABLE_DELIMITER);
+
+    auto db = std::make_shared<FakeDb>();
+    watermelondb::SliceImportEngine engine(db);
+    setupDecoderWithData(engine, data);
+    engine.parseDecompressedData();
+    std::string error;
+    engine.flushBatch(error);
+
+    expectTrue(!engine.failed_, "delta import should not fail");
+    expectTrue(db->lastBatch.delta, "batch should be marked as delta");
+    expectTrue(db->lastBatch.tables[tableId("tasks")].size() == 1 && db->lastBatch.tables[tableId("tasks")][0][1].text() == "Alpha",
+               "upserts should be batched as rows");
+    expectTrue(db->lastBatch.deletes[tableId("tasks")].size() == 1 && db->lastBatch.deletes[tableId("tasks")][0][0].text() == "t2",
+               "deletes should be batched by id");
+    expectTrue(engine.getTotalRowsInserted() == 2, "both ops should count as imported rows");
+}
+
+std::vector<uint8_t> buildDeltaSliceWithTables(const std::vector<std::string>& tables) {
+    std::vector<uint8_t> data;
+    appendString(data, "delta");
+    appendVarint(data, 2);
+    appendString(data, "high");
+    appendVarint(data, 1);
+    appendVarint(data, (watermelondb::SLICE_FLAG_DELTA << watermelondb::SLICE_FLAGS_SHIFT) | tables.size());
+    for (const auto& table : tables) {
+        appendString(data, table);
+        appendVarint(data, 2);
+        appendString(data, "name");
+        appendString(data, "id");
+        data.push_back(static_cast<uint8_t>(watermelondb::DeltaOp::UPSERT));
+        appendTextField(data, "Alpha");
+        appendTextField(data, table + "_1");
+        data.push_back(static_cast<uint8_t>(watermelondb::DeltaOp::DELETE));
+        appendTextField(data, table + "_2");
+        data.push_back(watermelondb::END_OF_TABLE_DELIMITER);
+    }
+    return data;
+}
+
+void test_delta_import_skips_tables() {
+    auto db = std::make_shared<FakeDb>();
+    watermelondb::SliceImportOptions options;
+    options.skipTables = {"projects"};
+    auto engine = std::make_shared<watermelondb::SliceImportEngine>(db, options);
+    setupDecoderWithData(*engine, buildDeltaSliceWithTables({"projects", "tasks"}));
+    engine->parseDecompressedData();
+    std::string error;
+    engine->flushBatch(error);
+
+    expectTrue(!engine->failed_, "delta import with a skipped table should not fail");
+    expectTrue(db->lastBatch.tables.count(tableId("projects")) == 0 && db->lastBatch.deletes.count(tableId("projects")) == 0,
+               "skipped table should contribute neither upserts nor deletes");
+    expectTrue(db->lastBatch.deletes[tableId("tasks")].size() == 1, "other tables should still apply their deletes");
+}
+
+void test_delta_import_reports_committed_changeset() {
+    auto db = std::make_shared<FakeDb>();
+    auto engine = std::make_shared<watermelondb::SliceImportEngine>(db);
+    setupDecoderWithTables(*engine, {});
+    std::vector<uint8_t> data = buildDeltaSliceWithTables({"tasks", "projects"});
+    engine->decoder_->decompressedBuffer_ = data;
+    engine->decoder_->decompressedSize_ = data.size();
+
+    engine->parseDecompressedData();
+    expectTrue(engine->takeCommittedChangeset().empty(), "uncommitted changes should not be reported");
+
+    engine->handleDownloadComplete("");
+    watermelondb::SyncChangeset changeset = engine->takeCommittedChangeset();
+    expectTrue(changeset.size() == 2, "changeset should list both tables");
+    expectTrue(changeset["tasks"].upserted == std::vector<std::string>({"tasks_1"}),
+               "upserted ids should be read from the id column");
+    expectTrue(changeset["projects"].deleted == std::vector<std::string>({"projects_2"}), "deleted ids should be reported");
+    expectTrue(engine->takeCommittedChangeset().empty(), "taking the changeset should reset it");
+
+    auto plainDb = std::make_shared<FakeDb>();
+    auto plainEngine = std::make_shared<watermelondb::SliceImportEngine>(plainDb);
+    setupDecoderWithTables(*plainEngine, {"users"});
+    plainEngine->parseDecompressedData();
+    plainEngine->handleDownloadComplete("");
+    expectTrue(plainEngine->takeCommittedChangeset().empty(), "plain slices should not report a changeset");
+}
+
+void test_delta_import_drops_rolled_back_changes() {
+    auto db = std::make_shared<FakeDb>();
+    db->failCommitsAfter = 1;
+    watermelondb::SliceImportOptions options;
+    options.commitMode = watermelondb::SliceCommitMode::PerTable;
+    auto engine = std::make_shared<watermelondb::SliceImportEngine>(db, options);
+    std::string completionError;
+    engine->completionCallback_ = [&completionError](const std::string& error) { completionError = error; };
+    setupDecoderWithTables(*engine, {});
+    std::vector<uint8_t> data = buildDeltaSliceWithTables({"tasks", "projects"});
+    engine->decoder_->decompressedBuffer_ = data;
+    engine->decoder_->decompressedSize_ = data.size();
+
+    engine->parseDecompressedData();
+    expectTrue(!completionError.empty(), "failed commit should fail the import");
+    watermelondb::SyncChangeset changeset = engine->takeCommittedChangeset();
+    expectTrue(changeset.size() == 1 && changeset.count("tasks") == 1,
+               "only the committed table should be reported");
+}
+
+void test_slice_import_result_json() {
+    watermelondb::SyncChangeset changeset;
+    changeset["tasks"].upserted.push_back("t1");
+    changeset["tasks"].deleted.push_back("t2");
+    expectTrue(watermelondb::sliceImportResultJson(changeset, "") ==
+                   "{\"changeset\":{\"tasks\":{\"upserted\":[\"t1\"],\"deleted\":[\"t2\"]}},\"error\":null}",
+               "result should carry the changeset");
+    expectTrue(watermelondb::sliceImportResultJson({}, "bad \"slice\"") ==
+                   "{\"changeset\":{},\"error\":\"bad \\\"slice\\\"\"}",
+               "result should carry the escaped error");
+}
+
+void test_parse_slice_import_options() {
+    watermelondb::SliceImportOptions options;
+    std::string error;
+    bool ok = watermelondb::parseSliceImportOptions(
+        "{\"commitMode\":\"priorityGroups\",\"priorityGroups\":[[\"users\",\"projects\"],[\"tasks\"]]}",
+        options,
+        error
+    );
+    expectTrue(ok, "options should parse");
+    expectTrue(options.commitMode == watermelondb::SliceCommitMode::PriorityGroups, "commitMode should parse");
+    expectTrue(options.priorityGroupOf("projects") == 0, "projects should be in the first group");
+    expectTrue(options.priorityGroupOf("tasks") == 1, "tasks should be in the second group");
+    expectTrue(options.priorityGroupOf("history") == 2, "unlisted tables should be in the trailing group");
+    expectTrue(!options.bulkLoad, "bulkLoad should default to off");
+
+    expectTrue(watermelondb::parseSliceImportOptions("{\"bulkLoad\":true}", options, error), "bulkLoad should parse");
+    expectTrue(options.bulkLoad, "bulkLoad should be enabled");
+    expectTrue(!options.sortById, "sortById should default to off");
+
+    expectTrue(watermelondb::parseSliceImportOptions("{\"sortById\":true}", options, error), "sortById should parse");
+    expectTrue(options.sortById, "sortById should be enabled");
+
+    expectTrue(watermelondb::parseSliceImportOptions("{\"bootstrap\":true}", options, error), "bootstrap should parse");
+    expectTrue(options.bootstrap && options.bulkLoad, "bootstrap should imply bulkLoad");
+    expectTrue(!watermelondb::parseSliceImportOptions("{\"commitMode\":\"table\",\"bootstrap\":true}", options, error),
+               "bootstrap should reject non-atomic commit modes");
+
+    expectTrue(watermelondb::parseSliceImportOptions("", options, error), "empty options should parse");
+    expectTrue(options.commitMode == watermelondb::SliceCommitMode::Atomic, "default commit mode is atomic");
+
+    expectTrue(!watermelondb::parseSliceImportOptions("{\"commitMode\":\"sometimes\"}", options, error),
+               "unknown commit mode should be rejected");
+
+    expectTrue(watermelondb::parseSliceImportOptions("{\"cacheKey\":\"W/\\\"5f2a\\\"\",\"cacheMaxBytes\":1048576}", options, error),
+               "cache options should parse");
+    expectTrue(options.cache && options.cacheKey == "W/\"5f2a\"", "cacheKey should imply cache");
+    expectTrue(options.cacheMaxBytes == 1048576, "cacheMaxBytes should parse");
+    expectTrue(!watermelondb::parseSliceImportOptions("{\"cacheMaxBytes\":-1}", options, error),
+               "negative cacheMaxBytes should be rejected");
+
+    expectTrue(watermelondb::parseSliceImportOptions(
+                   "{\"skipTables\":[\"audit_log\"],\"columns\":{\"tasks\":[\"id\",\"title\"]},\"projectToLocalSchema\":true}",
+                   options, error),
+               "projection options should parse");
+    expectTrue(options.skipTables == std::vector<std::string>({"audit_log"}), "skipTables should parse");
+    expectTrue(options.columnAllowlist["tasks"] == std::vector<std::string>({"id", "title"}), "columns should parse");
+    expectTrue(options.projectToLocalSchema, "projectToLocalSchema should parse");
+    expectTrue(!watermelondb::parseSliceImportOptions("{\"columns\":{\"tasks\":\"id\"}}", options, error),
+               "columns must be arrays");
+
+    expectTrue(watermelondb::parseSliceImportOptions(
+                   "{\"referencePath\":\"/tmp/catalog.db\",\"referenceIndexes\":{\"price_book\":[[\"sku\"],[\"model_id\",\"region\"]]}}",
+                   options, error),
+               "reference options should parse");
+    expectTrue(options.referencePath == "/tmp/catalog.db", "referencePath should parse");
+    expectTrue(options.referenceIndexes["price_book"].size() == 2 &&
+               options.referenceIndexes["price_book"][1] == std::vector<std::string>({"model_id", "region"}),
+               "referenceIndexes should parse");
+    expectTrue(!watermelondb::parseSliceImportOptions("{\"commitMode\":\"table\",\"referencePath\":\"/tmp/catalog.db\"}", options, error),
+               "reference imports should reject non-atomic commit modes");
+    expectTrue(!watermelondb::parseSliceImportOptions("{\"bootstrap\":true,\"referencePath\":\"/tmp/catalog.db\"}", options, error),
+               "reference imports should reject bootstrap");
+    expectTrue(!watermelondb::parseSliceImportOptions("{\"referenceIndexes\":{\"price_book\":[[\"sku\"]]}}", options, error),
+               "referenceIndexes should require referencePath");
+    expectTrue(!watermelondb::parseSliceImportOptions("{\"referencePath\":\"/tmp/catalog.db\",\"referenceIndexes\":{\"price_book\":[[]]}}", options, error),
+               "empty reference indexes should be rejected");
+}
+
 void test_savepoint_cycle_on_flush() {
     auto db = std::make_shared<FakeDb>();
     watermelondb::SliceImportEngine engine(db);
@@ -171,6 +784,54 @@ void test_savepoint_cycle_on_flush() {
     expectTrue(db->createSavepointCount == 1, "createSavepoint should be called");
 }
 
+void test_batch_rows_live_in_reused_arena() {
+    using watermelondb::FieldValue;
+    const std::string longName = "a task name longer than the inline capacity";
+    auto fillBatch = [&](watermelondb::BatchData& batch) {
+        for (int i = 0; i < 500; i++) {
+            batch.addRow("tasks", {"id", "name", "position"},
+                         {FieldValue::makeText("t" + std::to_string(i)), FieldValue::makeText(longName), FieldValue::makeInt(i)});
+        }
+        batch.addRow("tasks", {"id", "name", "position"}, {FieldValue::makeText("short")});
+        batch.addDelete("projects", FieldValue::makeText("p1"));
+    };
+
+    watermelondb::BatchData batch;
+    fillBatch(batch);
+    const watermelondb::RowSet& tasks = batch.tables[tableId("tasks")];
+    expectTrue(tasks.size() == 501 && tasks.columnCount() == 3, "rows should be stored with a fixed width");
+    expectTrue(tasks[42][1].text() == longName && tasks[42][1].borrowsBytes() && tasks[42][2].intValue() == 42,
+               "owned text should be moved into the arena");
+    expectTrue(tasks[500][0].text() == "short" && tasks[500][1].isNull() && tasks[500][2].isNull(),
+               "short rows should be padded with NULLs");
+    expectTrue(batch.deletes[tableId("projects")].size() == 1 && batch.deletes[tableId("projects")][0][0].text() == "p1",
+               "deletes should be stored in the arena too");
+
+    watermelondb::BatchData copy = batch;
+    const size_t reserved = batch.arena().bytesReserved();
+    const size_t peak = batch.arenaHighWaterMark();
+    expectTrue(peak > 0 && batch.arena().bytesUsed() == peak, "high-water mark should track the batch");
+
+    batch.clear();
+    expectTrue(batch.arena().bytesUsed() == 0 && batch.arena().bytesReserved() == reserved,
+               "clear should rewind the arena and keep its blocks");
+    expectTrue(copy.tables[tableId("tasks")].size() == 501 && copy.tables[tableId("tasks")][499][1].text() == longName,
+               "copies should not depend on the source arena");
+
+    fillBatch(batch);
+    expectTrue(batch.arena().bytesReserved() == reserved && batch.arenaHighWaterMark() == peak,
+               "a batch of the same size should reuse the arena without growing");
+
+    watermelondb::SliceArena arena(64);
+    arena.allocate(48, 8);
+    const void* oversized = arena.allocate(1000, 8);
+    expectTrue(oversized != nullptr && arena.bytesReserved() == 64 + 1000, "oversized allocations get their own block");
+    arena.reset();
+    arena.allocate(48, 8);
+    expectTrue(arena.allocate(1000, 8) == oversized && arena.bytesReserved() == 64 + 1000,
+               "kept blocks should be reused after reset");
+}
+
 void test_memory_pressure_adjusts_batch() {
     auto db = std::make_shared<FakeDb>();
     watermelondb::SliceImportEngine engine(db);
@@ -190,6 +851,23 @@ int main() {
     test_parse_decompressed_and_flush();
     test_savepoint_cycle_on_flush();
     test_memory_pressure_adjusts_batch();
+    test_batch_rows_live_in_reused_arena();
+    test_atomic_mode_commits_once();
+    test_per_table_mode_commits_each_table();
+    test_priority_groups_mode_commits_on_group_change();
+    test_bulk_load_wraps_each_table();
+    test_local_slice_urls();
+    test_local_file_import();
+    test_cached_download_is_reused();
+    test_patched_import_from_cached_reference();
+    test_projection_skips_tables_and_columns();
+    test_projection_to_local_schema();
+    test_delta_slice_batches_upserts_and_deletes();
+    test_delta_import_skips_tables();
+    test_delta_import_reports_committed_changeset();
+    test_delta_import_drops_rolled_back_changes();
+    test_slice_import_result_json();
+    test_parse_slice_import_options();
 
     if (gFailures > 0) {
         std::cerr << gFailures << " test(s) failed\n";
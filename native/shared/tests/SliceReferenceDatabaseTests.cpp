@@ -0,0 +1,215 @@
+#include "../SliceReferenceDatabase.h"
+
+#include <sqlite3.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace {
+
+static int gFailures = 0;
+
+void expectTrue(bool value, const char* message) {
+    if (!value) {
+        std::cerr << "FAIL: " << message << "\n";
+        gFailures++;
+    }
+}
+
+bool execSql(sqlite3* db, const char* sql, std::string& error) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        if (errMsg) {
+            error = errMsg;
+            sqlite3_free(errMsg);
+        } else {
+            error = "sqlite3_exec failed";
+        }
+        return false;
+    }
+    return true;
+}
+
+int querySingleInt(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return -1;
+    }
+    int value = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+bool fileExists(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (file) {
+        std::fclose(file);
+        return true;
+    }
+    return false;
+}
+
+const char* kReferencePath = "slice_reference_test.db";
+const char* kLivePath = "slice_reference_live_test.db";
+
+void removeTestFiles() {
+    std::remove(kReferencePath);
+    std::remove((std::string(kReferencePath) + ".partial").c_str());
+    std::remove(kLivePath);
+    std::remove((std::string(kLivePath) + "-wal").c_str());
+    std::remove((std::string(kLivePath) + "-shm").c_str());
+}
+
+watermelondb::BatchData makeCatalogBatch(int count, const std::string& region) {
+    watermelondb::BatchData batch;
+    std::vector<std::string> columns = {"id", "sku", "region", "price"};
+    for (int i = 0; i < count; i++) {
+        batch.addRow("price_book", columns, {
+            watermelondb::FieldValue::makeText("pb" + std::to_string(i)),
+            watermelondb::FieldValue::makeText("sku" + std::to_string(i)),
+            watermelondb::FieldValue::makeText(region),
+            watermelondb::FieldValue::makeInt(100 + i)
+        });
+    }
+    return batch;
+}
+
+bool materializeCatalog(int count, const std::string& region, std::string& error) {
+    watermelondb::SliceReferenceDatabase::IndexSpec indexes;
+    indexes["price_book"] = {{"sku"}, {"region", "price"}};
+    watermelondb::SliceReferenceDatabase reference(kReferencePath, indexes);
+    return reference.beginTransaction(error) &&
+           reference.declareTable("price_book", {"id", "sku", "region", "price"}, error) &&
+           reference.insertBatch(makeCatalogBatch(count, region), error) &&
+           reference.commitTransaction(error);
+}
+
+sqlite3* openLiveDatabase() {
+    sqlite3* db = nullptr;
+    sqlite3_open(kLivePath, &db);
+    std::string error;
+    execSql(db, "PRAGMA journal_mode=WAL", error);
+    // WatermelonDB creates every schema table, catalogs included; the reference view shadows it
+    execSql(db, "CREATE TABLE price_book (id PRIMARY KEY, sku, region, price, _changed, _status)", error);
+    execSql(db, "CREATE TABLE tasks (id PRIMARY KEY, name, _changed, _status)", error);
+    execSql(db, "INSERT INTO tasks (id, name, _status) VALUES ('t1', 'local', 'synced')", error);
+    return db;
+}
+
+void test_reference_import_materializes_indexed_file() {
+    removeTestFiles();
+    std::string error;
+    expectTrue(materializeCatalog(50, "eu", error), ("materializing should succeed: " + error).c_str());
+    expectTrue(fileExists(kReferencePath), "reference database should be in place");
+    expectTrue(!fileExists(std::string(kReferencePath) + ".partial"), "partial file should be gone");
+
+    sqlite3* db = nullptr;
+    sqlite3_open_v2(kReferencePath, &db, SQLITE_OPEN_READONLY, nullptr);
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM price_book WHERE _status = 'synced'") == 50,
+               "rows should be imported as synced");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND name = 'price_book_sku'") == 1,
+               "single-column index should be built");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND name = 'price_book_region_price'") == 1,
+               "multi-column index should be built");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM sqlite_master WHERE name = 'sqlite_stat1'") == 1,
+               "ANALYZE should have run");
+    sqlite3_close(db);
+    removeTestFiles();
+}
+
+void test_reference_rollback_removes_partial_file() {
+    removeTestFiles();
+    std::string error;
+    {
+        watermelondb::SliceReferenceDatabase reference(kReferencePath, {});
+        reference.beginTransaction(error);
+        reference.declareTable("price_book", {"id", "sku", "region", "price"}, error);
+        reference.insertBatch(makeCatalogBatch(5, "eu"), error);
+        expectTrue(fileExists(reference.partialPath()), "partial file should exist during import");
+        reference.rollbackTransaction();
+        expectTrue(!fileExists(reference.partialPath()), "rollback should delete the partial file");
+    }
+    expectTrue(!fileExists(kReferencePath), "rollback should not publish anything");
+
+    watermelondb::SliceReferenceDatabase::IndexSpec indexes;
+    indexes["models"] = {{"name"}};
+    watermelondb::SliceReferenceDatabase reference(kReferencePath, indexes);
+    reference.beginTransaction(error);
+    reference.declareTable("price_book", {"id", "sku"}, error);
+    expectTrue(!reference.commitTransaction(error), "index on a table missing from the slice should fail");
+    expectTrue(!fileExists(kReferencePath), "failed commit should not publish anything");
+
+    watermelondb::BatchData delta = makeCatalogBatch(1, "eu");
+    delta.delta = true;
+    reference.beginTransaction(error);
+    expectTrue(!reference.insertBatch(delta, error), "delta batches should be rejected");
+    reference.rollbackTransaction();
+    removeTestFiles();
+}
+
+void test_attach_exposes_views_on_every_connection() {
+    removeTestFiles();
+    std::string error;
+    expectTrue(materializeCatalog(20, "eu", error), "materializing should succeed");
+
+    sqlite3* writer = openLiveDatabase();
+    sqlite3* reader = nullptr;
+    sqlite3_open(kLivePath, &reader);
+    execSql(reader, "PRAGMA query_only=1", error);
+
+    expectTrue(watermelondb::attachReferenceDatabase(writer, kReferencePath, "catalog", error),
+               ("attach on the writer should succeed: " + error).c_str());
+    expectTrue(watermelondb::attachReferenceDatabase(reader, kReferencePath, "catalog", error),
+               ("attach on a query_only reader should succeed: " + error).c_str());
+    expectTrue(querySingleInt(reader, "PRAGMA query_only") == 1, "query_only should be restored");
+
+    expectTrue(querySingleInt(writer, "SELECT COUNT(*) FROM price_book") == 20, "writer should read the catalog");
+    expectTrue(querySingleInt(reader, "SELECT COUNT(*) FROM price_book WHERE sku = 'sku3'") == 1,
+               "reader should read the catalog");
+    expectTrue(querySingleInt(reader, "SELECT COUNT(*) FROM tasks") == 1, "other tables should be unaffected");
+    expectTrue(!execSql(writer, "INSERT INTO price_book (id) VALUES ('x')", error), "catalog views should be read-only");
+
+    // Refresh: a new file replaces the attached one, and re-attaching picks it up
+    expectTrue(materializeCatalog(30, "us", error), "refreshing should succeed while attached");
+    expectTrue(querySingleInt(writer, "SELECT COUNT(*) FROM price_book WHERE region = 'eu'") == 20,
+               "attached connections keep the old file until re-attached");
+    expectTrue(watermelondb::attachReferenceDatabase(writer, kReferencePath, "catalog", error),
+               ("re-attach should succeed: " + error).c_str());
+    expectTrue(querySingleInt(writer, "SELECT COUNT(*) FROM price_book WHERE region = 'us'") == 30,
+               "re-attached connection should read the new file");
+
+    expectTrue(watermelondb::detachReferenceDatabase(reader, "catalog", error),
+               ("detach should succeed: " + error).c_str());
+    expectTrue(querySingleInt(reader, "SELECT COUNT(*) FROM price_book") == 0,
+               "detached connection should fall back to the main table");
+    expectTrue(watermelondb::detachReferenceDatabase(reader, "catalog", error), "detaching twice should be a no-op");
+
+    expectTrue(!watermelondb::attachReferenceDatabase(writer, "missing_reference.db", "other", error),
+               "missing reference file should be rejected");
+    expectTrue(!fileExists("missing_reference.db"), "a failed attach should not create the file");
+    expectTrue(!watermelondb::attachReferenceDatabase(writer, kReferencePath, "main", error),
+               "main should not be a valid alias");
+
+    sqlite3_close(reader);
+    sqlite3_close(writer);
+    removeTestFiles();
+}
+
+} // namespace
+
+int main() {
+    test_reference_import_materializes_indexed_file();
+    test_reference_rollback_removes_partial_file();
+    test_attach_exposes_views_on_every_connection();
+
+    if (gFailures > 0) {
+        std::cerr << gFailures << " test(s) failed\n";
+        return 1;
+    }
+    std::cout << "All SliceReferenceDatabase tests passed\n";
+    return 0;
+}
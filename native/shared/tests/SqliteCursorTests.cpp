@@ -0,0 +1,287 @@
+#include "../SqliteCursor.h"
+
+#include <sqlite3.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+static int gFailures = 0;
+
+void expectTrue(bool value, const char* message) {
+    if (!value) {
+        std::cerr << "FAIL: " << message << "\n";
+        gFailures++;
+    }
+}
+
+bool execSql(sqlite3* db, const char* sql, std::string& error) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        if (errMsg) {
+            error = errMsg;
+            sqlite3_free(errMsg);
+        } else {
+            error = "sqlite3_exec failed";
+        }
+        return false;
+    }
+    return true;
+}
+
+void removeDatabase(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+// `rowCount` tasks with positions 1...rowCount
+sqlite3* openWriter(const std::string& path, int rowCount) {
+    removeDatabase(path);
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    std::string error;
+    execSql(db, "PRAGMA journal_mode=WAL", error);
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, name TEXT, position INTEGER)", error);
+    execSql(db, "BEGIN", error);
+    sqlite3_stmt* insert = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO tasks (id, name, position) VALUES (?, ?, ?)", -1, &insert, nullptr);
+    for (int i = 1; i <= rowCount; i++) {
+        const std::string id = "t" + std::to_string(i);
+        const std::string name = "task number " + std::to_string(i);
+        sqlite3_bind_text(insert, 1, id.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(insert, 2, name.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int(insert, 3, i);
+        sqlite3_step(insert);
+        sqlite3_reset(insert);
+    }
+    sqlite3_finalize(insert);
+    execSql(db, "COMMIT", error);
+    return db;
+}
+
+std::string fullPath(sqlite3* db) {
+    const char* filename = sqlite3_db_filename(db, "main");
+    return filename ? filename : "";
+}
+
+void test_pages() {
+    sqlite3* writer = openWriter("sqlite_cursor_test.db", 10);
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 2);
+    std::string error;
+
+    watermelondb::QueryArgument minimum;
+    minimum.type = watermelondb::QueryArgument::Type::Number;
+    minimum.number = 1;
+    auto cursor = watermelondb::SqliteCursor::open(pool, "SELECT id, position FROM tasks WHERE position >= ? ORDER BY position",
+                                                   {minimum}, error);
+    expectTrue(cursor != nullptr, "cursor should open");
+    if (!cursor) {
+        return;
+    }
+    expectTrue(sqlite3_column_count(cursor->statement()) == 2, "statement should have the query's columns");
+
+    std::vector<int> positions;
+    auto readRow = [&](sqlite3_stmt* stmt) { positions.push_back(sqlite3_column_int(stmt, 1)); };
+    expectTrue(cursor->fetch(4, 0, readRow, error) == watermelondb::SqliteCursor::FetchResult::More, "first page");
+    expectTrue(positions.size() == 4, "first page should have 4 rows");
+
+    // Later pages come from the first page's read transaction
+    execSql(writer, "INSERT INTO tasks (id, name, position) VALUES ('t11', 'late', 11)", error);
+
+    expectTrue(cursor->fetch(4, 0, readRow, error) == watermelondb::SqliteCursor::FetchResult::More, "second page");
+    expectTrue(cursor->fetch(4, 0, readRow, error) == watermelondb::SqliteCursor::FetchResult::Done, "last page");
+    expectTrue(positions.size() == 10, "cursor should read every row once");
+    expectTrue(positions.front() == 1 && positions.back() == 10, "rows should be in query order");
+    expectTrue(cursor->isDone() && cursor->rowsRead() == 10, "cursor should be done");
+    expectTrue(cursor->fetch(4, 0, readRow, error) == watermelondb::SqliteCursor::FetchResult::Done, "fetch after done");
+
+    // Done cursors give their connection back
+    std::string leaseError;
+    auto first = pool->tryAcquire(leaseError);
+    auto second = pool->tryAcquire(leaseError);
+    expectTrue(first && second, "done cursor should release its connection");
+
+    cursor.reset();
+    pool->close();
+    sqlite3_close(writer);
+    removeDatabase("sqlite_cursor_test.db");
+}
+
+void test_time_budget() {
+    sqlite3* writer = openWriter("sqlite_cursor_budget_test.db", 100);
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 2);
+    std::string error;
+
+    auto cursor = watermelondb::SqliteCursor::open(pool, "SELECT id FROM tasks", {}, error);
+    size_t rows = 0;
+    auto slowRow = [&](sqlite3_stmt*) {
+        rows++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    };
+    expectTrue(cursor && cursor->fetch(0, 10, slowRow, error) == watermelondb::SqliteCursor::FetchResult::More,
+               "time budget should end the page");
+    expectTrue(rows > 0 && rows < 100, "page should stop once out of time");
+
+    // At least one row per fetch, even with no time left
+    rows = 0;
+    auto slowerRow = [&](sqlite3_stmt*) {
+        rows++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    };
+    cursor->fetch(0, 1, slowerRow, error);
+    expectTrue(rows == 1, "fetch should make progress");
+
+    cursor.reset();
+    pool->close();
+    sqlite3_close(writer);
+    removeDatabase("sqlite_cursor_budget_test.db");
+}
+
+void test_open_errors() {
+    sqlite3* writer = openWriter("sqlite_cursor_errors_test.db", 3);
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 1);
+    std::string error;
+
+    expectTrue(!watermelondb::SqliteCursor::open(pool, "DELETE FROM tasks", {}, error), "writes should be rejected");
+    expectTrue(error.find("read-only") != std::string::npos, "error should say why");
+    error.clear();
+    expectTrue(!watermelondb::SqliteCursor::open(pool, "SELECT * FROM tasks WHERE id = ?", {}, error),
+               "missing arguments should be rejected");
+    expectTrue(!error.empty(), "missing arguments should have an error");
+    error.clear();
+    expectTrue(!watermelondb::SqliteCursor::open(pool, "SELEKT", {}, error), "invalid SQL should be rejected");
+    expectTrue(!error.empty(), "invalid SQL should have an error");
+
+    // Failed opens give their connection back; an open cursor holds it
+    auto cursor = watermelondb::SqliteCursor::open(pool, "SELECT * FROM tasks", {}, error);
+    expectTrue(cursor != nullptr, "cursor should open after failed ones");
+    error.clear();
+    expectTrue(!watermelondb::SqliteCursor::open(pool, "SELECT * FROM tasks", {}, error),
+               "open should fail instead of waiting for a connection");
+    expectTrue(!error.empty(), "busy pool should have an error");
+    cursor->close();
+    expectTrue(watermelondb::SqliteCursor::open(pool, "SELECT * FROM tasks", {}, error) != nullptr,
+               "closed cursor should release its connection");
+
+    pool->close();
+    sqlite3_close(writer);
+    removeDatabase("sqlite_cursor_errors_test.db");
+}
+
+void test_registry() {
+    sqlite3* writer = openWriter("sqlite_cursor_registry_test.db", 3);
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 3);
+    watermelondb::SqliteCursors cursors;
+    std::string error;
+
+    const uint64_t first = cursors.open(pool, "SELECT * FROM tasks", {}, error);
+    const uint64_t second = cursors.open(pool, "SELECT * FROM tasks", {}, error);
+    expectTrue(first != 0 && second != 0 && first != second, "cursors should get distinct ids");
+    expectTrue(cursors.open(pool, "SELECT * FROM tasks", {}, error) == 0, "one connection should stay free for queries");
+    expectTrue(error.find("Too many") != std::string::npos, "error should say why");
+
+    std::string leaseError;
+    expectTrue(static_cast<bool>(pool->tryAcquire(leaseError)), "queries should still get a connection");
+
+    expectTrue(cursors.find(first) != nullptr, "open cursor should be found");
+    expectTrue(cursors.close(first), "open cursor should close");
+    expectTrue(!cursors.close(first), "closed cursor should not close again");
+    expectTrue(cursors.find(first) == nullptr, "closed cursor should be gone");
+    expectTrue(cursors.open(pool, "SELECT * FROM tasks", {}, error) != 0, "closing should make room for a cursor");
+
+    // A cursor read to the end no longer counts against the pool
+    auto cursor = cursors.find(second);
+    cursor->fetch(0, 0, [](sqlite3_stmt*) {}, error);
+    expectTrue(cursors.open(pool, "SELECT * FROM tasks", {}, error) != 0, "done cursors should make room");
+    expectTrue(cursors.openCount() == 3, "done cursors stay registered until closed");
+
+    pool->close();
+    sqlite3_close(writer);
+    removeDatabase("sqlite_cursor_registry_test.db");
+}
+
+// sqlite_cursor_tests --benchmark [rows]: time until the first 100 rows are available, and bytes
+// held at once, when reading the whole result up front vs paging through it with a cursor
+void benchmark_paging(int rowCount) {
+    const std::string dbPath = "sqlite_cursor_benchmark.db";
+    sqlite3* writer = openWriter(dbPath, rowCount);
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 2);
+    const char* sql = "SELECT id, name, position FROM tasks ORDER BY position";
+    std::string error;
+
+    using Clock = std::chrono::steady_clock;
+    auto millis = [](Clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+    auto rowBytes = [](sqlite3_stmt* stmt) {
+        return static_cast<size_t>(sqlite3_column_bytes(stmt, 0) + sqlite3_column_bytes(stmt, 1) + sizeof(double));
+    };
+
+    {
+        const auto start = Clock::now();
+        std::string leaseError;
+        auto lease = pool->acquire(leaseError);
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(lease.db(), sql, -1, &stmt, nullptr);
+        std::vector<std::string> rows;
+        size_t bytes = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            rows.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
+            bytes += rowBytes(stmt);
+        }
+        sqlite3_finalize(stmt);
+        std::printf("%-10s first rows after %8.2f ms, %zu rows, %zu bytes held\n", "up front", millis(Clock::now() - start),
+                    rows.size(), bytes);
+    }
+    {
+        const auto start = Clock::now();
+        auto cursor = watermelondb::SqliteCursor::open(pool, sql, {}, error);
+        size_t pageBytes = 0;
+        size_t peakBytes = 0;
+        size_t rows = 0;
+        double firstPage = 0;
+        auto result = watermelondb::SqliteCursor::FetchResult::More;
+        while (result == watermelondb::SqliteCursor::FetchResult::More) {
+            pageBytes = 0;
+            result = cursor->fetch(100, 0, [&](sqlite3_stmt* stmt) {
+                pageBytes += rowBytes(stmt);
+                rows++;
+            }, error);
+            if (firstPage == 0) {
+                firstPage = millis(Clock::now() - start);
+            }
+            peakBytes = std::max(peakBytes, pageBytes);
+        }
+        std::printf("%-10s first rows after %8.2f ms, %zu rows, %zu bytes held\n", "cursor", firstPage, rows, peakBytes);
+    }
+
+    pool->close();
+    sqlite3_close(writer);
+    removeDatabase(dbPath);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+        benchmark_paging(argc > 2 ? std::atoi(argv[2]) : 200000);
+        return 0;
+    }
+
+    test_pages();
+    test_time_budget();
+    test_open_errors();
+    test_registry();
+
+    if (gFailures > 0) {
+        std::cerr << gFailures << " test(s) failed\n";
+        return 1;
+    }
+    std::cout << "All SqliteCursor tests passed\n";
+    return 0;
+}
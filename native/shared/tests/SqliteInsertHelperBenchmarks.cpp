@@ -0,0 +1,180 @@
+// Insert-path benchmarks for SqliteInsertHelper. Not run as part of the test suite:
+//   ./build/sqlite_insert_helper_benchmarks [rows]
+#include "../SqliteInsertHelper.h"
+
+#include <sqlite3.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Shaped like a typical WatermelonDB app table: text ids, foreign keys, a few numbers and
+// timestamps, and indexes on every column that is queried by.
+const char* kSchema =
+    "CREATE TABLE tasks ("
+    " id TEXT PRIMARY KEY, _changed TEXT, _status TEXT,"
+    " project_id TEXT, assignee_id TEXT, parent_id TEXT, status TEXT, title TEXT, description TEXT,"
+    " priority INTEGER, estimate REAL, position REAL, is_archived INTEGER,"
+    " due_at INTEGER, created_at INTEGER, updated_at INTEGER);"
+    "CREATE INDEX tasks_project_id ON tasks (project_id);"
+    "CREATE INDEX tasks_assignee_id ON tasks (assignee_id);"
+    "CREATE INDEX tasks_parent_id ON tasks (parent_id);"
+    "CREATE INDEX tasks_status ON tasks (status);"
+    "CREATE INDEX tasks_updated_at ON tasks (updated_at);"
+    "CREATE INDEX tasks__status ON tasks (_status);";
+
+const std::vector<std::string> kColumns = {
+    "id", "project_id", "assignee_id", "parent_id", "status", "title", "description",
+    "priority", "estimate", "position", "is_archived", "due_at", "created_at", "updated_at"
+};
+
+void execOrDie(sqlite3* db, const char* sql) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::fprintf(stderr, "SQL failed: %s\n", errMsg ? errMsg : "?");
+        std::exit(1);
+    }
+}
+
+std::vector<std::vector<watermelondb::FieldValue>> makeRows(size_t count) {
+    using watermelondb::FieldValue;
+    static const char* kStatuses[] = {"todo", "in_progress", "review", "done"};
+    std::vector<std::vector<FieldValue>> rows;
+    rows.reserve(count);
+    uint64_t seed = 42;
+    auto next = [&seed]() {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        return seed >> 33;
+    };
+    for (size_t i = 0; i < count; i++) {
+        // Random-looking ids, like the ones the server hands out
+        char id[17];
+        std::snprintf(id, sizeof(id), "%016llx", static_cast<unsigned long long>(next() * 2654435761ULL));
+        rows.push_back({
+            FieldValue::makeText(id),
+            FieldValue::makeText("project_" + std::to_string(next() % 500)),
+            FieldValue::makeText("user_" + std::to_string(next() % 2000)),
+            (i % 4 == 0) ? FieldValue::makeNull() : FieldValue::makeText("task_" + std::to_string(next() % count)),
+            FieldValue::makeText(kStatuses[next() % 4]),
+            FieldValue::makeText("Task title number " + std::to_string(i)),
+            FieldValue::makeText("A longer description for the task so rows have a realistic width " + std::to_string(next())),
+            FieldValue::makeInt(static_cast<int64_t>(next() % 5)),
+            FieldValue::makeReal(static_cast<double>(next() % 100) / 4.0),
+            FieldValue::makeReal(static_cast<double>(i)),
+            FieldValue::makeInt(static_cast<int64_t>(next() % 10 == 0)),
+            FieldValue::makeInt(1700000000000LL + static_cast<int64_t>(next() % 100000000)),
+            FieldValue::makeInt(1600000000000LL + static_cast<int64_t>(next() % 100000000)),
+            FieldValue::makeInt(1650000000000LL + static_cast<int64_t>(next() % 100000000))
+        });
+    }
+    return rows;
+}
+
+struct ImportResult {
+    double ms;
+    int64_t fileBytes;
+};
+
+// Batches of SliceImportEngine's default size, built before the clock starts
+std::vector<watermelondb::BatchData> makeBatches(const std::vector<std::vector<watermelondb::FieldValue>>& rows,
+                                                 bool sortById) {
+    const size_t batchSize = 1000;
+    std::vector<watermelondb::BatchData> batches;
+    for (size_t offset = 0; offset < rows.size(); offset += batchSize) {
+        batches.emplace_back();
+        watermelondb::BatchData& batch = batches.back();
+        batch.sortById = sortById;
+        for (size_t i = offset; i < std::min(rows.size(), offset + batchSize); i++) {
+            batch.addRow("tasks", kColumns, rows[i]);
+        }
+    }
+    return batches;
+}
+
+ImportResult runImport(const std::vector<watermelondb::BatchData>& batches, bool bulkLoad, bool useSelect) {
+    const char* path = "sqlite_insert_helper_benchmark.db";
+    std::remove(path);
+    std::remove("sqlite_insert_helper_benchmark.db-wal");
+    sqlite3* db = nullptr;
+    sqlite3_open(path, &db);
+    execOrDie(db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL; PRAGMA temp_store=MEMORY; PRAGMA cache_size=-20000;");
+    execOrDie(db, kSchema);
+
+    watermelondb::SqliteInsertHelper helper;
+    helper.setUseVirtualTable(useSelect);
+    std::string error;
+    auto start = std::chrono::steady_clock::now();
+    execOrDie(db, "BEGIN IMMEDIATE");
+    if (bulkLoad && !helper.deferIndexes(db, "tasks", error)) {
+        std::fprintf(stderr, "deferIndexes failed: %s\n", error.c_str());
+        std::exit(1);
+    }
+    for (const auto& batch : batches) {
+        if (!helper.insertBatch(db, batch, error)) {
+            std::fprintf(stderr, "insert failed: %s\n", error.c_str());
+            std::exit(1);
+        }
+    }
+    if (bulkLoad && !helper.restoreIndexes(db, "tasks", error)) {
+        std::fprintf(stderr, "restoreIndexes failed: %s\n", error.c_str());
+        std::exit(1);
+    }
+    if (!helper.finishBulkLoad(db, error)) {
+        std::fprintf(stderr, "finishBulkLoad failed: %s\n", error.c_str());
+        std::exit(1);
+    }
+    execOrDie(db, "COMMIT");
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Size the database will have once the WAL is checkpointed
+    int64_t pages = 0;
+    int64_t pageSize = 0;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT page_count, page_size FROM pragma_page_count, pragma_page_size", -1, &stmt,
+                           nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        pages = sqlite3_column_int64(stmt, 0);
+        pageSize = sqlite3_column_int64(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+
+    helper.finalizeStatements();
+    sqlite3_close(db);
+    std::remove(path);
+    std::remove("sqlite_insert_helper_benchmark.db-wal");
+    std::remove("sqlite_insert_helper_benchmark.db-shm");
+    return {elapsed, pages * pageSize};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t rowCount = argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : 200000;
+    auto rows = makeRows(rowCount);
+    std::printf("tasks: %zu rows, %zu columns, 6 secondary indexes\n", rowCount, kColumns.size());
+
+    const int runs = 3;
+    for (bool sortById : {false, true}) {
+        auto batches = makeBatches(rows, sortById);
+        for (bool bulkLoad : {false, true}) {
+            for (bool useSelect : {false, true}) {
+                ImportResult best = {0, 0};
+                for (int i = 0; i < runs; i++) {
+                    ImportResult result = runImport(batches, bulkLoad, useSelect);
+                    if (i == 0 || result.ms < best.ms) {
+                        best = result;
+                    }
+                }
+                std::printf("  %-28s %-24s %-16s %8.1f ms  (%.0f rows/s, best of %d)  %6.1f MB\n",
+                            bulkLoad ? "deferred indexes (bulkLoad)" : "indexes maintained per row",
+                            useSelect ? "INSERT ... SELECT vtab" : "multi-row VALUES",
+                            sortById ? "sorted by id" : "slice order",
+                            best.ms, rowCount / (best.ms / 1000.0), runs, best.fileBytes / (1024.0 * 1024.0));
+            }
+        }
+    }
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include "../SqliteInsertHelper.h"
+#include "../SliceRowsVirtualTable.h"
 
 #include <sqlite3.h>
 #include <string>
@@ -146,12 +147,359 @@ void test_insert_batch_multiple_tables() {
     sqlite3_close(db);
 }
 
+void test_defer_indexes_on_empty_table() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, project_id TEXT, code TEXT, _status TEXT)", error);
+    execSql(db, "CREATE INDEX tasks_project_id ON tasks (project_id)", error);
+    execSql(db, "CREATE UNIQUE INDEX tasks_code ON tasks (code)", error);
+    execSql(db, "BEGIN", error);
+
+    watermelondb::SqliteInsertHelper helper;
+    expectTrue(helper.deferIndexes(db, "tasks", error), "deferIndexes should succeed");
+    expectTrue(helper.hasDeferredIndexes("tasks"), "empty table indexes should be deferred");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM sqlite_master WHERE name = 'tasks_project_id'") == 0,
+               "non-unique index should be dropped");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM sqlite_master WHERE name = 'tasks_code'") == 1,
+               "unique index should be kept");
+
+    std::vector<std::string> columns = {"id", "project_id", "code"};
+    std::vector<std::vector<watermelondb::FieldValue>> rows;
+    for (int i = 0; i < 50; i++) {
+        rows.push_back({
+            watermelondb::FieldValue::makeText("t" + std::to_string(i)),
+            watermelondb::FieldValue::makeText("p" + std::to_string(i % 5)),
+            watermelondb::FieldValue::makeText("c" + std::to_string(i % 40))
+        });
+    }
+    expectTrue(helper.insertRowsMulti(db, "tasks", columns, rows, error), "insert should succeed");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM tasks") == 40, "unique index should still ignore duplicates");
+
+    expectTrue(helper.restoreIndexes(db, "tasks", error), "restoreIndexes should succeed");
+    expectTrue(!helper.hasDeferredIndexes("tasks"), "restored table should not be deferred");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM sqlite_master WHERE name = 'tasks_project_id'") == 1,
+               "index should be recreated");
+    expectTrue(helper.finishBulkLoad(db, error), "finishBulkLoad should succeed");
+    execSql(db, "COMMIT", error);
+
+    helper.finalizeStatements();
+    sqlite3_close(db);
+}
+
+void test_defer_indexes_skips_non_empty_table() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, project_id TEXT, _status TEXT)", error);
+    execSql(db, "CREATE INDEX tasks_project_id ON tasks (project_id)", error);
+    execSql(db, "INSERT INTO tasks (id, project_id, _status) VALUES ('t0', 'p0', 'synced')", error);
+
+    watermelondb::SqliteInsertHelper helper;
+    expectTrue(helper.deferIndexes(db, "tasks", error), "deferIndexes should succeed");
+    expectTrue(!helper.hasDeferredIndexes("tasks"), "non-empty table should keep its indexes");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM sqlite_master WHERE name = 'tasks_project_id'") == 1,
+               "index should not be dropped");
+
+    sqlite3_close(db);
+}
+
+void test_defer_indexes_rollback_restores_schema() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, project_id TEXT, _status TEXT)", error);
+    execSql(db, "CREATE INDEX tasks_project_id ON tasks (project_id)", error);
+    execSql(db, "BEGIN", error);
+
+    watermelondb::SqliteInsertHelper helper;
+    helper.deferIndexes(db, "tasks", error);
+    execSql(db, "ROLLBACK", error);
+    helper.discardDeferredIndexes();
+
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM sqlite_master WHERE name = 'tasks_project_id'") == 1,
+               "rollback should bring the index back");
+    expectTrue(helper.finishBulkLoad(db, error), "finishBulkLoad after discard should be a no-op");
+
+    sqlite3_close(db);
+}
+
 } // namespace
 
+void test_insert_rows_select() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, name TEXT, count INTEGER, score REAL, data BLOB, _status TEXT)", error);
+    execSql(db, "INSERT INTO tasks (id, name, _status) VALUES ('t2', 'local', 'updated')", error);
+
+    watermelondb::SqliteInsertHelper helper;
+    std::vector<std::string> columns = {"id", "name", "count", "score", "data"};
+    std::vector<std::vector<watermelondb::FieldValue>> rows;
+    rows.push_back({
+        watermelondb::FieldValue::makeText("t1"),
+        watermelondb::FieldValue::makeText("alpha"),
+        watermelondb::FieldValue::makeInt(5),
+        watermelondb::FieldValue::makeReal(3.5),
+        watermelondb::FieldValue::makeBlob({1, 2, 3})
+    });
+    rows.push_back({
+        watermelondb::FieldValue::makeText("t2"),
+        watermelondb::FieldValue::makeText("server"),
+        watermelondb::FieldValue::makeNull(),
+        watermelondb::FieldValue::makeReal(0.0),
+        watermelondb::FieldValue::makeBlob({})
+    });
+    // Short row: missing trailing values read as NULL
+    rows.push_back({watermelondb::FieldValue::makeText("t3")});
+
+    expectTrue(helper.insertRowsSelect(db, "tasks", columns, rows, error), "insertRowsSelect should succeed");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM tasks") == 3, "rows should be inserted");
+    expectTrue(querySingleText(db, "SELECT name FROM tasks WHERE id='t1'") == "alpha", "text should round-trip");
+    expectTrue(querySingleInt(db, "SELECT count FROM tasks WHERE id='t1'") == 5, "int should round-trip");
+    expectTrue(querySingleText(db, "SELECT typeof(score) || ':' || score FROM tasks WHERE id='t1'") == "real:3.5",
+               "real should round-trip");
+    expectTrue(querySingleText(db, "SELECT hex(data) FROM tasks WHERE id='t1'") == "010203", "blob should round-trip");
+    expectTrue(querySingleText(db, "SELECT _status FROM tasks WHERE id='t1'") == "synced", "_status should be synced");
+    expectTrue(querySingleText(db, "SELECT name FROM tasks WHERE id='t2'") == "local", "existing rows should be ignored");
+    expectTrue(querySingleText(db, "SELECT typeof(name) FROM tasks WHERE id='t3'") == "null", "short rows should pad with NULL");
+
+    // Reusing the cached statement with a different batch
+    std::vector<std::vector<watermelondb::FieldValue>> more = {{watermelondb::FieldValue::makeText("t4")}};
+    expectTrue(helper.insertRowsSelect(db, "tasks", columns, more, error), "cached statement should be reusable");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM tasks") == 4, "second batch should be inserted");
+
+    // Without a bound source the virtual table is empty
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM slice_rows") == 0, "unbound slice_rows should be empty");
+
+    helper.finalizeStatements();
+    sqlite3_close(db);
+}
+
+void test_statement_cache_keys_on_columns() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, name TEXT, _status TEXT)", error);
+
+    using watermelondb::FieldValue;
+    for (bool useSelect : {true, false}) {
+        watermelondb::SqliteInsertHelper helper;
+        const std::string prefix = useSelect ? "s" : "m";
+        std::vector<std::vector<FieldValue>> idFirst = {{FieldValue::makeText(prefix + "1"), FieldValue::makeText("first")}};
+        std::vector<std::vector<FieldValue>> nameFirst = {{FieldValue::makeText("second"), FieldValue::makeText(prefix + "2")}};
+        bool ok = useSelect
+            ? helper.insertRowsSelect(db, "tasks", {"id", "name"}, idFirst, error) &&
+              helper.insertRowsSelect(db, "tasks", {"name", "id"}, nameFirst, error)
+            : helper.insertRowsMulti(db, "tasks", {"id", "name"}, idFirst, error) &&
+              helper.insertRowsMulti(db, "tasks", {"name", "id"}, nameFirst, error);
+        expectTrue(ok, "inserts with reordered columns should succeed");
+        expectTrue(querySingleText(db, ("SELECT name FROM tasks WHERE id='" + prefix + "2'").c_str()) == "second",
+                   "a different column order should not reuse the cached statement");
+        helper.finalizeStatements();
+    }
+    sqlite3_close(db);
+}
+
+void test_sort_order_by_key() {
+    using watermelondb::FieldValue;
+    watermelondb::RowSet rows = {
+        {FieldValue::makeInt(0), FieldValue::makeText("b")},
+        {FieldValue::makeInt(1), FieldValue::makeText("ab")},
+        {FieldValue::makeInt(2), FieldValue::makeText("a")},
+        {FieldValue::makeInt(3), FieldValue::makeText("")},
+        {FieldValue::makeInt(4), FieldValue::makeText("a")},
+        {FieldValue::makeInt(5), FieldValue::makeText("aa")},
+    };
+    std::vector<uint32_t> order;
+    expectTrue(watermelondb::SqliteInsertHelper::sortOrderByKey(rows, 1, order), "text keys should sort");
+    expectTrue(order == std::vector<uint32_t>({3, 2, 4, 5, 1, 0}),
+               "keys should sort bytewise, prefixes first, duplicates in input order");
+
+    // Enough keys with shared prefixes to go through the radix passes
+    watermelondb::RowSet many;
+    for (int i = 0; i < 500; i++) {
+        const int key = (i * 7919) % 500;
+        many.append({FieldValue::makeText("record" + std::to_string(key)), FieldValue::makeInt(i)});
+    }
+    expectTrue(watermelondb::SqliteInsertHelper::sortOrderByKey(many, 0, order), "many keys should sort");
+    bool sorted = order.size() == many.size();
+    for (size_t i = 1; sorted && i < order.size(); i++) {
+        sorted = std::string(many[order[i - 1]][0].data(), many[order[i - 1]][0].size()) <=
+                 std::string(many[order[i]][0].data(), many[order[i]][0].size());
+    }
+    expectTrue(sorted, "radix-sorted keys should be in order");
+
+    expectTrue(!watermelondb::SqliteInsertHelper::sortOrderByKey(rows, 0, order), "non-text keys should not sort");
+}
+
+void test_insert_batch_sorted_by_id() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, name TEXT, _status TEXT)", error);
+
+    using watermelondb::FieldValue;
+    for (bool useSelect : {false, true}) {
+        execSql(db, "DELETE FROM tasks", error);
+        watermelondb::BatchData batch;
+        batch.sortById = true;
+        const char* ids[] = {"c", "a", "b", "a"};
+        for (int i = 0; i < 4; i++) {
+            batch.addRow("tasks", {"id", "name"}, {FieldValue::makeText(ids[i]), FieldValue::makeText("row" + std::to_string(i))});
+        }
+        watermelondb::SqliteInsertHelper helper;
+        helper.setUseVirtualTable(useSelect);
+        expectTrue(helper.insertBatch(db, batch, error), ("sorted insertBatch should succeed: " + error).c_str());
+        expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM tasks") == 3, "duplicate ids should be ignored");
+        expectTrue(querySingleText(db, "SELECT name FROM tasks WHERE id='a'") == "row1",
+                   "sorting should keep the first of duplicate ids");
+        expectTrue(querySingleText(db, "SELECT group_concat(id, '') FROM (SELECT id FROM tasks ORDER BY rowid)") == "abc",
+                   "rows should be inserted in id order");
+        helper.finalizeStatements();
+    }
+    sqlite3_close(db);
+}
+
+void test_insert_rows_select_wide_table_falls_back() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    std::string createSql = "CREATE TABLE wide (id TEXT PRIMARY KEY, _status TEXT";
+    std::vector<std::string> columns = {"id"};
+    std::vector<watermelondb::FieldValue> row = {watermelondb::FieldValue::makeText("w1")};
+    for (size_t i = 0; i < watermelondb::SLICE_ROWS_MAX_COLUMNS + 10; i++) {
+        std::string name = "f" + std::to_string(i);
+        createSql += ", " + name + " INTEGER";
+        columns.push_back(name);
+        row.push_back(watermelondb::FieldValue::makeInt(static_cast<int64_t>(i)));
+    }
+    createSql += ")";
+    execSql(db, createSql.c_str(), error);
+
+    watermelondb::SqliteInsertHelper helper;
+    std::vector<std::vector<watermelondb::FieldValue>> rows = {row};
+    expectTrue(helper.insertRowsSelect(db, "wide", columns, rows, error), "wide table insert should fall back");
+    std::string lastColumnSql = "SELECT f" + std::to_string(watermelondb::SLICE_ROWS_MAX_COLUMNS + 9) + " FROM wide";
+    expectTrue(querySingleInt(db, lastColumnSql.c_str()) == static_cast<int>(watermelondb::SLICE_ROWS_MAX_COLUMNS + 9),
+               "every column of a wide table should be inserted");
+
+    helper.finalizeStatements();
+    sqlite3_close(db);
+}
+
+void test_table_columns() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, _changed TEXT, _status TEXT, name TEXT)", error);
+
+    std::vector<std::string> columns;
+    expectTrue(watermelondb::SqliteInsertHelper::tableColumns(db, "tasks", columns, error), "tableColumns should succeed");
+    expectTrue(columns == std::vector<std::string>({"id", "_changed", "_status", "name"}), "columns should be in schema order");
+    expectTrue(watermelondb::SqliteInsertHelper::tableColumns(db, "missing", columns, error), "missing table is not an error");
+    expectTrue(columns.empty(), "missing table should have no columns");
+    sqlite3_close(db);
+}
+
+// Delta upserts follow sync pull rules: locally created/deleted rows are kept, updated rows keep
+// their _changed columns, deletes are unconditional
+void check_delta_batch(bool useVirtualTable) {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, name TEXT, count INTEGER, _changed TEXT, _status TEXT)", error);
+    execSql(db,
+            "INSERT INTO tasks (id, name, count, _changed, _status) VALUES "
+            "('synced', 'old', 1, '', 'synced'), "
+            "('updated', 'mine', 1, 'name', 'updated'), "
+            "('created', 'mine', 1, '', 'created'), "
+            "('deleted', 'mine', 1, '', 'deleted'), "
+            "('gone', 'old', 1, '', 'synced')",
+            error);
+
+    watermelondb::SqliteInsertHelper helper;
+    helper.setUseVirtualTable(useVirtualTable);
+    watermelondb::BatchData batch;
+    batch.delta = true;
+    std::vector<std::string> columns = {"id", "name", "count"};
+    for (const char* id : {"synced", "updated", "created", "deleted", "new"}) {
+        batch.addRow("tasks", columns, {
+            watermelondb::FieldValue::makeText(id),
+            watermelondb::FieldValue::makeText("server"),
+            watermelondb::FieldValue::makeInt(2)
+        });
+    }
+    batch.addDelete("tasks", watermelondb::FieldValue::makeText("gone"));
+    batch.addDelete("projects", watermelondb::FieldValue::makeText("p1"));
+    execSql(db, "CREATE TABLE projects (id TEXT PRIMARY KEY, _changed TEXT, _status TEXT)", error);
+    execSql(db, "INSERT INTO projects (id, _changed, _status) VALUES ('p1', '', 'synced'), ('p2', '', 'synced')", error);
+
+    expectTrue(helper.insertBatch(db, batch, error), "delta batch should apply");
+    expectTrue(querySingleText(db, "SELECT name || ':' || count FROM tasks WHERE id='synced'") == "server:2",
+               "synced rows should be overwritten");
+    expectTrue(querySingleText(db, "SELECT name || ':' || count || ':' || _status FROM tasks WHERE id='updated'") ==
+               "mine:2:updated", "updated rows should keep their _changed columns and status");
+    expectTrue(querySingleText(db, "SELECT name || ':' || count FROM tasks WHERE id='created'") == "mine:1",
+               "locally created rows should be left alone");
+    expectTrue(querySingleText(db, "SELECT name || ':' || count FROM tasks WHERE id='deleted'") == "mine:1",
+               "locally deleted rows should be left alone");
+    expectTrue(querySingleText(db, "SELECT name || ':' || _status || ':' || _changed FROM tasks WHERE id='new'") ==
+               "server:synced:", "new rows should be inserted as synced");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM tasks WHERE id='gone'") == 0, "deleted ids should be removed");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM projects") == 1, "delete-only tables should be applied");
+
+    // Tables without an id column can't be upserted
+    std::vector<std::vector<watermelondb::FieldValue>> rows = {{watermelondb::FieldValue::makeText("x")}};
+    expectTrue(!helper.upsertRows(db, "tasks", {"name"}, rows, error), "upsert without id should fail");
+
+    helper.finalizeStatements();
+    sqlite3_close(db);
+}
+
+void test_delta_batch() {
+    check_delta_batch(true);
+    check_delta_batch(false);
+}
+
+void test_delete_rows_chunking() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, _changed TEXT, _status TEXT)", error);
+    execSql(db,
+            "WITH RECURSIVE n(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i < 1999) "
+            "INSERT INTO tasks (id) SELECT 't' || i FROM n",
+            error);
+
+    watermelondb::SqliteInsertHelper helper;
+    helper.setUseVirtualTable(false);
+    std::vector<std::vector<watermelondb::FieldValue>> ids;
+    for (int i = 0; i < 1900; i++) {
+        ids.push_back({watermelondb::FieldValue::makeText("t" + std::to_string(i))});
+    }
+    expectTrue(helper.deleteRows(db, "tasks", ids, error), "chunked deletes should succeed");
+    expectTrue(querySingleInt(db, "SELECT COUNT(*) FROM tasks") == 100, "every chunk should be applied");
+
+    helper.finalizeStatements();
+    sqlite3_close(db);
+}
+
 int main() {
     test_insert_rows_multi_basic();
     test_insert_rows_multi_chunking();
     test_insert_batch_multiple_tables();
+    test_defer_indexes_on_empty_table();
+    test_defer_indexes_skips_non_empty_table();
+    test_defer_indexes_rollback_restores_schema();
+    test_table_columns();
+    test_insert_rows_select();
+    test_insert_rows_select_wide_table_falls_back();
+    test_statement_cache_keys_on_columns();
+    test_sort_order_by_key();
+    test_insert_batch_sorted_by_id();
+    test_delta_batch();
+    test_delete_rows_chunking();
 
     if (gFailures > 0) {
         std::cerr << gFailures << " test(s) failed\n";
@@ -0,0 +1,344 @@
+#include "../SqliteReaderPool.h"
+
+#include <sqlite3.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+static int gFailures = 0;
+
+void expectTrue(bool value, const char* message) {
+    if (!value) {
+        std::cerr << "FAIL: " << message << "\n";
+        gFailures++;
+    }
+}
+
+bool execSql(sqlite3* db, const char* sql, std::string& error) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        if (errMsg) {
+            error = errMsg;
+            sqlite3_free(errMsg);
+        } else {
+            error = "sqlite3_exec failed";
+        }
+        return false;
+    }
+    return true;
+}
+
+void removeDatabase(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+}
+
+// The writer, as the platform opens it: WAL, so pooled readers don't block it
+sqlite3* openWriter(const std::string& path) {
+    removeDatabase(path);
+    sqlite3* db = nullptr;
+    sqlite3_open(path.c_str(), &db);
+    std::string error;
+    execSql(db, "PRAGMA journal_mode=WAL", error);
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, name TEXT, position INTEGER)", error);
+    execSql(db, "INSERT INTO tasks (id, name, position) VALUES ('t1', 'alpha', 1), ('t2', 'bravo', 2)", error);
+    return db;
+}
+
+std::string fullPath(sqlite3* db) {
+    const char* filename = sqlite3_db_filename(db, "main");
+    return filename ? filename : "";
+}
+
+int64_t countRows(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return -1;
+    }
+    int64_t count = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        count = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+void test_leases_reuse_connections() {
+    sqlite3* writer = openWriter("sqlite_reader_pool_test.db");
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 4);
+    std::string error;
+    sqlite3* first = nullptr;
+    {
+        auto lease = pool->acquire(error);
+        expectTrue(static_cast<bool>(lease), "lease has a connection");
+        first = lease.db();
+        expectTrue(countRows(lease.db(), "SELECT count(*) FROM tasks") == 2, "reader sees the writer's rows");
+        expectTrue(sqlite3_exec(lease.db(), "DELETE FROM tasks", nullptr, nullptr, nullptr) != SQLITE_OK,
+                   "reader connections are read-only");
+    }
+    {
+        auto lease = pool->acquire(error);
+        expectTrue(lease.db() == first, "an idle connection is reused before a new one is opened");
+
+        auto second = pool->acquire(error);
+        expectTrue(second && second.db() != first, "concurrent leases get different connections");
+    }
+    expectTrue(pool->stats().opened == 2, "connections are opened on demand");
+    expectTrue(pool->stats().leases == 3, "leases are counted");
+
+    execSql(writer, "INSERT INTO tasks (id, name, position) VALUES ('t3', 'charlie', 3)", error);
+    {
+        auto lease = pool->acquire(error);
+        expectTrue(countRows(lease.db(), "SELECT count(*) FROM tasks") == 3, "reader sees later commits");
+    }
+
+    pool.reset();
+    sqlite3_close(writer);
+    removeDatabase("sqlite_reader_pool_test.db");
+}
+
+void test_acquire_waits_for_release() {
+    sqlite3* writer = openWriter("sqlite_reader_pool_wait_test.db");
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 1);
+    std::string error;
+
+    auto held = std::make_unique<watermelondb::SqliteReaderPool::Lease>(pool->acquire(error));
+    std::string tryError;
+    expectTrue(!pool->tryAcquire(tryError), "tryAcquire fails while every connection is leased");
+    expectTrue(!tryError.empty(), "tryAcquire says why");
+    std::atomic<bool> acquired{false};
+    std::thread waiter([&]() {
+        std::string waiterError;
+        auto lease = pool->acquire(waiterError);
+        acquired = static_cast<bool>(lease);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    expectTrue(!acquired, "acquire waits while every connection is leased");
+    held.reset();
+    waiter.join();
+    expectTrue(acquired, "a released connection goes to the waiter");
+    expectTrue(pool->stats().waits == 1 && pool->stats().opened == 1, "the waiter reused the connection");
+
+    pool.reset();
+    sqlite3_close(writer);
+    removeDatabase("sqlite_reader_pool_wait_test.db");
+}
+
+void test_connection_hooks() {
+    sqlite3* writer = openWriter("sqlite_reader_pool_hook_test.db");
+    auto pool = std::make_shared<watermelondb::SqliteReaderPool>(fullPath(writer), 2);
+    std::string error;
+
+    // One connection open before the hook is set, one opened after
+    auto before = pool->acquire(error);
+    before = watermelondb::SqliteReaderPool::Lease();
+
+    int applied = 0;
+    int undone = 0;
+    pool->setConnectionHook(
+        "first_task",
+        [&](sqlite3* db, std::string& hookError) {
+            applied++;
+            return execSql(db, "CREATE TEMP VIEW first_task AS SELECT * FROM tasks WHERE position = 1", hookError);
+        },
+        [&](sqlite3* db, std::string& hookError) {
+            undone++;
+            return execSql(db, "DROP VIEW IF EXISTS temp.first_task", hookError);
+        });
+    {
+        auto a = pool->acquire(error);
+        auto b = pool->acquire(error);
+        expectTrue(countRows(a.db(), "SELECT count(*) FROM first_task") == 1, "hook applied to an open connection");
+        expectTrue(countRows(b.db(), "SELECT count(*) FROM first_task") == 1, "hook applied to a new connection");
+    }
+    {
+        auto lease = pool->acquire(error);
+    }
+    expectTrue(applied == 2, "hook applied once per connection");
+
+    pool->removeConnectionHook("first_task");
+    {
+        auto a = pool->acquire(error);
+        auto b = pool->acquire(error);
+        expectTrue(countRows(a.db(), "SELECT count(*) FROM first_task") == -1, "removed hook is undone");
+        expectTrue(countRows(b.db(), "SELECT count(*) FROM first_task") == -1, "removed hook is undone everywhere");
+    }
+    expectTrue(undone == 2, "hook undone once per connection");
+
+    pool->setConnectionHook(
+        "broken",
+        [](sqlite3* db, std::string& hookError) { return execSql(db, "SELECT * FROM missing_table", hookError); },
+        nullptr);
+    auto failed = pool->acquire(error);
+    expectTrue(!failed && error.find("missing_table") != std::string::npos, "hook errors fail the lease");
+    pool->removeConnectionHook("broken");
+    error.clear();
+    auto recovered = pool->acquire(error);
+    expectTrue(static_cast<bool>(recovered), "the connection is usable once the hook is gone");
+    recovered = watermelondb::SqliteReaderPool::Lease();
+
+    pool.reset();
+    sqlite3_close(writer);
+    removeDatabase("sqlite_reader_pool_hook_test.db");
+}
+
+void test_registry_and_close() {
+    sqlite3* writer = openWriter("sqlite_reader_pool_registry_test.db");
+    const std::string path = fullPath(writer);
+    std::string error;
+
+    expectTrue(watermelondb::SqliteReaderPool::forPath("") == nullptr, "no pool for in-memory databases");
+    auto pool = watermelondb::SqliteReaderPool::forPath(path);
+    expectTrue(pool && pool == watermelondb::SqliteReaderPool::forPath(path), "one pool per path");
+    expectTrue(pool->size() == watermelondb::SqliteReaderPool::defaultSize(), "registry pools are sized to the cores");
+
+    auto lease = pool->acquire(error);
+    watermelondb::SqliteReaderPool::dropPath(path);
+    expectTrue(pool->isClosed(), "dropPath closes the pool");
+    expectTrue(countRows(lease.db(), "SELECT count(*) FROM tasks") == 2, "a lease outlives close()");
+    lease = watermelondb::SqliteReaderPool::Lease();
+    expectTrue(!pool->acquire(error) && !error.empty(), "closed pool hands out no connections");
+
+    auto reopened = watermelondb::SqliteReaderPool::forPath(path);
+    expectTrue(reopened && reopened != pool && !reopened->isClosed(), "a dropped path gets a new pool");
+    watermelondb::SqliteReaderPool::dropPath(path);
+
+    sqlite3_close(writer);
+    removeDatabase("sqlite_reader_pool_registry_test.db");
+}
+
+// sqlite_reader_pool_tests --benchmark [threads]: `threads` readers run an aggregate over 50k rows
+// while a writer inserts rows one transaction at a time. "module lock" is the old JSI bridge
+// behavior, every call under one lock and every read on one reader connection; "pooled" gives each
+// read a pooled connection and the writer its own lock.
+void benchmark_contention(int threadCount) {
+    const std::string dbPath = "sqlite_reader_pool_benchmark.db";
+    sqlite3* writer = openWriter(dbPath);
+    std::string error;
+    execSql(writer, "BEGIN", error);
+    execSql(writer,
+            "WITH RECURSIVE n(i) AS (SELECT 3 UNION ALL SELECT i + 1 FROM n WHERE i < 50000) "
+            "INSERT INTO tasks (id, name, position) SELECT 't' || i, 'task ' || (i % 97), i FROM n",
+            error);
+    execSql(writer, "COMMIT", error);
+    const std::string path = fullPath(writer);
+
+    const int readsPerThread = 20;
+    const int writes = 200;
+    const char* readSql = "SELECT name, count(*), sum(position) FROM tasks GROUP BY name ORDER BY 2 DESC";
+
+    auto runRead = [&](sqlite3* db) {
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(db, readSql, -1, &stmt, nullptr);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+        }
+        sqlite3_finalize(stmt);
+    };
+    std::atomic<int> nextId{1000000};
+    auto runWrite = [&](sqlite3* db) {
+        const std::string sql = "INSERT INTO tasks (id, name, position) VALUES ('w" +
+                                std::to_string(nextId++) + "', 'written', 0)";
+        std::string writeError;
+        execSql(db, sql.c_str(), writeError);
+    };
+
+    auto measure = [&](const char* label, const std::function<void()>& read, const std::function<void()>& write) {
+        const auto start = std::chrono::steady_clock::now();
+        double worstWriteMs = 0;
+        double readsDoneMs = 0;
+        std::vector<std::thread> readers;
+        for (int t = 0; t < threadCount; t++) {
+            readers.emplace_back([&]() {
+                for (int i = 0; i < readsPerThread; i++) {
+                    read();
+                }
+            });
+        }
+        std::thread writerThread([&]() {
+            for (int i = 0; i < writes; i++) {
+                const auto writeStart = std::chrono::steady_clock::now();
+                write();
+                const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - writeStart).count();
+                worstWriteMs = std::max(worstWriteMs, ms);
+            }
+        });
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        readsDoneMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        writerThread.join();
+        const double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-12s %d readers x %d reads: reads done in %8.1f ms, all done in %8.1f ms, worst write %7.2f ms\n",
+                    label, threadCount, readsPerThread, readsDoneMs, totalMs, worstWriteMs);
+    };
+
+    {
+        sqlite3* reader = nullptr;
+        sqlite3_open_v2(path.c_str(), &reader, SQLITE_OPEN_READONLY, nullptr);
+        std::mutex moduleLock;
+        measure(
+            "module lock",
+            [&]() {
+                const std::lock_guard<std::mutex> lock(moduleLock);
+                runRead(reader);
+            },
+            [&]() {
+                const std::lock_guard<std::mutex> lock(moduleLock);
+                runWrite(writer);
+            });
+        sqlite3_close(reader);
+    }
+    {
+        auto pool = std::make_shared<watermelondb::SqliteReaderPool>(path, watermelondb::SqliteReaderPool::defaultSize());
+        std::mutex writerLock;
+        measure(
+            "pooled",
+            [&]() {
+                std::string leaseError;
+                auto lease = pool->acquire(leaseError);
+                runRead(lease.db());
+            },
+            [&]() {
+                const std::lock_guard<std::mutex> lock(writerLock);
+                runWrite(writer);
+            });
+        const auto stats = pool->stats();
+        std::printf("pool of %zu: %zu opened, %llu of %llu leases waited\n", pool->size(), stats.opened,
+                    static_cast<unsigned long long>(stats.waits), static_cast<unsigned long long>(stats.leases));
+    }
+
+    sqlite3_close(writer);
+    removeDatabase(dbPath);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--benchmark") == 0) {
+        benchmark_contention(argc > 2 ? std::atoi(argv[2]) : 4);
+        return 0;
+    }
+
+    test_leases_reuse_connections();
+    test_acquire_waits_for_release();
+    test_connection_hooks();
+    test_registry_and_close();
+
+    if (gFailures > 0) {
+        std::cerr << gFailures << " test(s) failed\n";
+        return 1;
+    }
+    std::cout << "All SqliteReaderPool tests passed\n";
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include "../SqliteStatementCache.h"
+
+#include <sqlite3.h>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace {
+
+static int gFailures = 0;
+
+void expectTrue(bool value, const char* message) {
+    if (!value) {
+        std::cerr << "FAIL: " << message << "\n";
+        gFailures++;
+    }
+}
+
+bool execSql(sqlite3* db, const char* sql, std::string& error) {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        if (errMsg) {
+            error = errMsg;
+            sqlite3_free(errMsg);
+        } else {
+            error = "sqlite3_exec failed";
+        }
+        return false;
+    }
+    return true;
+}
+
+sqlite3* openTasksDatabase() {
+    sqlite3* db = nullptr;
+    sqlite3_open(":memory:", &db);
+    std::string error;
+    execSql(db, "CREATE TABLE tasks (id TEXT PRIMARY KEY, name TEXT)", error);
+    execSql(db, "INSERT INTO tasks (id, name) VALUES ('t1', 'alpha'), ('t2', 'bravo')", error);
+    return db;
+}
+
+std::string nameOf(watermelondb::SqliteStatementCache& cache, const char* id) {
+    int rc;
+    sqlite3_stmt* stmt = cache.acquire("SELECT name FROM tasks WHERE id = ?", rc);
+    if (!stmt) {
+        return "";
+    }
+    sqlite3_bind_text(stmt, 1, id, -1, SQLITE_TRANSIENT);
+    std::string name;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    }
+    cache.release(stmt);
+    return name;
+}
+
+void test_cache_reuses_statements() {
+    sqlite3* db = openTasksDatabase();
+    {
+        watermelondb::SqliteStatementCache cache(db);
+        expectTrue(nameOf(cache, "t1") == "alpha", "first query should read t1");
+        expectTrue(nameOf(cache, "t2") == "bravo", "cached statement should be rebound");
+        auto stats = cache.stats();
+        expectTrue(stats.misses == 1 && stats.hits == 1 && stats.size == 1, "second query should hit");
+
+        int rc;
+        sqlite3_stmt* stmt = cache.acquire("SELECT ?", rc);
+        sqlite3_bind_text(stmt, 1, "bound", -1, SQLITE_TRANSIENT);
+        cache.release(stmt);
+        stmt = cache.acquire("SELECT ?", rc);
+        expectTrue(sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) == SQLITE_NULL,
+                   "released statements should have their bindings cleared");
+        cache.release(stmt);
+
+        expectTrue(!cache.acquire("SELECT nope FROM tasks", rc) && rc != SQLITE_OK, "bad SQL should fail to prepare");
+        expectTrue(cache.stats().size == 2, "failed prepares should not be cached");
+    }
+    expectTrue(sqlite3_next_stmt(db, nullptr) == nullptr, "destroying the cache should finalize its statements");
+    sqlite3_close(db);
+}
+
+void test_cache_evicts_least_recently_used() {
+    sqlite3* db = openTasksDatabase();
+    {
+        watermelondb::SqliteStatementCache cache(db, 2);
+        int rc;
+        const std::string a = "SELECT 1", b = "SELECT 2", c = "SELECT 3";
+        cache.release(cache.acquire(a, rc));
+        cache.release(cache.acquire(b, rc));
+        cache.release(cache.acquire(a, rc));
+        cache.release(cache.acquire(c, rc));
+        auto stats = cache.stats();
+        expectTrue(stats.size == 2 && stats.evictions == 1, "the cache should stay within capacity");
+        cache.release(cache.acquire(a, rc));
+        expectTrue(cache.stats().hits == 2, "the recently used statement should have been kept");
+        cache.release(cache.acquire(b, rc));
+        expectTrue(cache.stats().misses == 4, "the least recently used statement should have been evicted");
+
+        // Leased statements are not evicted, nor handed out twice
+        sqlite3_stmt* first = cache.acquire(a, rc);
+        sqlite3_stmt* second = cache.acquire(a, rc);
+        expectTrue(first && second && first != second, "a leased statement should not be handed out again");
+        sqlite3_stmt* third = cache.acquire(c, rc);
+        cache.release(second);
+        cache.release(third);
+        cache.release(first);
+        expectTrue(cache.stats().size == 2, "the cache should shrink back to capacity once released");
+    }
+    expectTrue(sqlite3_next_stmt(db, nullptr) == nullptr, "uncached statements should be finalized on release");
+    sqlite3_close(db);
+}
+
+void test_cache_invalidated_on_schema_change() {
+    sqlite3* db = openTasksDatabase();
+    auto cache = std::make_unique<watermelondb::SqliteStatementCache>(db);
+    std::string error;
+    expectTrue(nameOf(*cache, "t1") == "alpha", "query should succeed");
+
+    int rc;
+    sqlite3_stmt* leased = cache->acquire("SELECT COUNT(*) FROM tasks", rc);
+    execSql(db, "CREATE TABLE projects (id TEXT PRIMARY KEY)", error);
+    expectTrue(nameOf(*cache, "t2") == "bravo", "query after a schema change should succeed");
+    auto stats = cache->stats();
+    expectTrue(stats.invalidations == 1 && stats.misses == 3, "a schema change should empty the cache");
+    cache->release(leased);
+    expectTrue(cache->stats().size == 1, "statements leased across a schema change should not be cached");
+
+    cache->clear();
+    expectTrue(cache->stats().size == 0, "clear should finalize idle statements");
+    cache.reset();
+    sqlite3_close(db);
+}
+
+void test_connection_registry() {
+    const char* path = "sqlite_statement_cache_test.db";
+    std::remove(path);
+    sqlite3* writer = nullptr;
+    sqlite3* reader = nullptr;
+    sqlite3_open(path, &writer);
+    sqlite3_open(path, &reader);
+    std::string error;
+    execSql(writer, "CREATE TABLE tasks (id TEXT PRIMARY KEY)", error);
+
+    using watermelondb::SqliteStatementCache;
+    auto writerCache = SqliteStatementCache::forConnection(writer);
+    expectTrue(SqliteStatementCache::forConnection(writer) == writerCache, "a connection should keep its cache");
+    expectTrue(!SqliteStatementCache::existingForConnection(reader), "caches should be created on first use");
+    int rc;
+    writerCache->release(writerCache->acquire("SELECT id FROM tasks", rc));
+    auto readerCache = SqliteStatementCache::forConnection(reader);
+    readerCache->release(readerCache->acquire("SELECT id FROM tasks", rc));
+
+    SqliteStatementCache::dropConnectionsTo(sqlite3_db_filename(writer, "main"));
+    expectTrue(!SqliteStatementCache::existingForConnection(writer) &&
+                   !SqliteStatementCache::existingForConnection(reader),
+               "every connection to the file should be dropped");
+    expectTrue(sqlite3_close(writer) == SQLITE_OK && sqlite3_close(reader) == SQLITE_OK,
+               "connections should close once their caches are dropped");
+    std::remove(path);
+}
+
+} // namespace
+
+int main() {
+    test_cache_reuses_statements();
+    test_cache_evicts_least_recently_used();
+    test_cache_invalidated_on_schema_change();
+    test_connection_registry();
+
+    if (gFailures > 0) {
+        std::cerr << gFailures << " test(s) failed\n";
+        return 1;
+    }
+    std::cout << "All SqliteStatementCache tests passed\n";
+    return 0;
+}
@@ -91,6 +91,17 @@ run_test "sync_apply_engine_tests" native/shared/tests/build/sync_apply_engine_t
 run_test "slice_decoder_tests" native/shared/tests/build/slice_decoder_tests
 run_test "slice_import_engine_tests" native/shared/tests/build/slice_import_engine_tests
 run_test "sqlite_insert_helper_tests" native/shared/tests/build/sqlite_insert_helper_tests
+run_test "slice_bootstrap_database_tests" native/shared/tests/build/slice_bootstrap_database_tests
+run_test "slice_reference_database_tests" native/shared/tests/build/slice_reference_database_tests
+run_test "slice_cache_tests" native/shared/tests/build/slice_cache_tests
+run_test "slice_encoder_tests" native/shared/tests/build/slice_encoder_tests
+run_test "sqlite_statement_cache_tests" native/shared/tests/build/sqlite_statement_cache_tests
+run_test "packed_result_tests" native/shared/tests/build/packed_result_tests
+run_test "record_cache_tests" native/shared/tests/build/record_cache_tests
+run_test "sqlite_reader_pool_tests" native/shared/tests/build/sqlite_reader_pool_tests
+run_test "async_query_tests" native/shared/tests/build/async_query_tests
+run_test "sqlite_cursor_tests" native/shared/tests/build/sqlite_cursor_tests
+run_test "bound_array_tests" native/shared/tests/build/bound_array_tests
 if [ -f native/shared/tests/build/database_utils_tests ]; then
   run_test "database_utils_tests" native/shared/tests/build/database_utils_tests
 else
@@ -4,10 +4,52 @@ export interface Spec extends TurboModule {
   query(tag: number, table: string, query: string): Record<string, any>[]
   execSqlQuery(tag: number, sql: string, args: Record<string, any>[]): Record<string, any>[]
   execSqlQueryOnWriter(tag: number, sql: string, args: Record<string, any>[]): Record<string, any>[]
+  // Same as execSqlQuery, but one array per column instead of one object per row:
+  // { columns: string[], rowCount: number, values: Array<Float64Array | any[]> }. All-numeric
+  // columns are Float64Arrays. See src/adapters/sqlite/columnarResult.
+  execSqlQueryColumnar(tag: number, sql: string, args: Record<string, any>[]): Object
+  // Same as execSqlQuery, but the whole result encoded in one ArrayBuffer, for bulk reads.
+  // Decode with src/adapters/sqlite/packedResult.
+  execSqlQueryPacked(tag: number, sql: string, args: Record<string, any>[]): Object
+  // Same as execSqlQuery, but rows are read-only host objects that convert a column to a JS value
+  // only when it is read, from a native snapshot of the result
+  execSqlQueryLazy(tag: number, sql: string, args: Record<string, any>[]): Record<string, any>[]
+  // Same as query / execSqlQuery, but the SQL runs on a native reader thread and only the JS result
+  // is built on the JS thread. `requestId` identifies the query to cancelQuery. Queries
+  // execSqlQuery would send to the writer (and in-memory databases) run synchronously instead.
+  queryAsync(tag: number, table: string, query: string, requestId: number): Promise<Record<string, any>[]>
+  execSqlQueryAsync(
+    tag: number,
+    sql: string,
+    args: Record<string, any>[],
+    requestId: number,
+  ): Promise<Record<string, any>[]>
+  // Rejects the promise of a queued or running async query with "Query cancelled". Returns false
+  // if it had already completed.
+  cancelQuery(requestId: number): boolean
+  // Opens a cursor over a read-only query on a reader connection and returns its id. Rows are
+  // stepped in place by fetchCursor, a page at a time, from one read transaction.
+  openCursor(tag: number, sql: string, args: Record<string, any>[]): number
+  // Next page of at most `maxRows` rows (0: no limit), cut short after `maxMillis` (0: no limit).
+  // A cursor that is done is closed.
+  fetchCursor(cursorId: number, maxRows: number, maxMillis: number): Object
+  // Returns false if the cursor was already closed
+  closeCursor(cursorId: number): boolean
+  // optionsJson: { commitMode?: 'atomic' | 'table' | 'priorityGroups', priorityGroups?: string[][], bulkLoad?: boolean, bootstrap?: boolean }
+  // Once the import has run, resolves a JSON string { changeset, error } (same envelope as
+  // syncDatabaseAsync): the records a delta slice upserted or deleted, and the error if it failed
   importRemoteSlice(
     tag: number,
-    sliceUrl: string
-  ): Promise<void>
+    sliceUrl: string,
+    optionsJson: string
+  ): Promise<string>
+  // optionsJson: { tables?: string[], sliceId?: string, version?: number, priority?: string, compressionLevel?: number }
+  // Resolves a JSON string: { tables, rows, uncompressedBytes, compressedBytes }
+  exportSlice(tag: number, path: string, optionsJson: string): Promise<string>
+  // Attaches the reference database at `path` (written by importRemoteSlice with referencePath) to
+  // every connection as `alias`, exposing its tables as views. Call again after a refresh.
+  attachReferenceSlice(tag: number, path: string, alias: string): void
+  detachReferenceSlice(tag: number, alias: string): void
   configureSync(configJson: string): void
   startSync(reason: string): void
   // Resolves the JSON changeset the pull applied ({ "<table>": { "upserted": [...], "deleted": [...] } }).
@@ -0,0 +1,42 @@
+import type { RawRecord } from '../../../RawRecord'
+
+// Result of execSqlQueryColumnar: one array per column instead of one object per row. Columns
+// whose values are all numbers come back as a Float64Array; others as an array of
+// string | number | null.
+export type ColumnarQueryResult = {
+  columns: string[]
+  rowCount: number
+  values: Array<Float64Array | Array<string | number | null>>
+}
+
+export function columnIndex(result: ColumnarQueryResult, column: string): number {
+  return result.columns.indexOf(column)
+}
+
+export function columnarValue(
+  result: ColumnarQueryResult,
+  rowIndex: number,
+  column: number,
+): string | number | null {
+  return result.values[column][rowIndex]
+}
+
+// Builds the row at `rowIndex` as a plain object, the shape execSqlQuery returns
+export function columnarRow(result: ColumnarQueryResult, rowIndex: number): RawRecord {
+  const { columns, values } = result
+  const row: { [column: string]: any } = {}
+  for (let i = 0; i < columns.length; i += 1) {
+    row[columns[i]] = values[i][rowIndex]
+  }
+  return row as RawRecord
+}
+
+// Every row as a plain object. Prefer columnarRow (or reading `values` directly) when only some
+// rows or columns are needed: that is what the columnar shape saves.
+export function columnarRows(result: ColumnarQueryResult): RawRecord[] {
+  const rows = new Array(result.rowCount)
+  for (let i = 0; i < result.rowCount; i += 1) {
+    rows[i] = columnarRow(result, i)
+  }
+  return rows
+}
@@ -0,0 +1,27 @@
+import { columnIndex, columnarValue, columnarRow, columnarRows } from './index'
+
+const result = {
+  columns: ['id', 'name', 'position'],
+  rowCount: 3,
+  values: [['t1', 't2', 't3'], ['alpha', null, 'gamma'], new Float64Array([1, 2.5, 3])],
+}
+
+describe('SQLite columnarResult', () => {
+  it('reads single values', () => {
+    expect(columnIndex(result, 'position')).toBe(2)
+    expect(columnIndex(result, 'missing')).toBe(-1)
+    expect(columnarValue(result, 1, 2)).toBe(2.5)
+    expect(columnarValue(result, 1, 1)).toBe(null)
+  })
+  it('hydrates rows', () => {
+    expect(columnarRow(result, 0)).toEqual({ id: 't1', name: 'alpha', position: 1 })
+    expect(columnarRows(result)).toEqual([
+      { id: 't1', name: 'alpha', position: 1 },
+      { id: 't2', name: null, position: 2.5 },
+      { id: 't3', name: 'gamma', position: 3 },
+    ])
+  })
+  it('hydrates empty results', () => {
+    expect(columnarRows({ columns: ['id'], rowCount: 0, values: [[]] })).toEqual([])
+  })
+})
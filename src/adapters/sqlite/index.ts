@@ -21,17 +21,23 @@ import {
   validateAdapter,
   validateTable,
 } from '../common'
+import type { DirtyQueryResult } from '../common'
 import type {
   DispatcherType,
   SQL,
   SQLiteAdapterOptions,
   SQLiteArg,
+  SQLiteQueryArg,
   SQLiteQuery,
   NativeBridgeBatchOperation,
   NativeDispatcher,
+  CursorPage,
 } from './type'
 
 import encodeQuery from './encodeQuery'
+import type { ColumnarQueryResult } from './columnarResult'
+import { decodePackedResult } from './packedResult'
+import type { PackedQueryResult } from './packedResult'
 import encodeUpdate from './encodeUpdate'
 import encodeInsert from './encodeInsert'
 
@@ -39,7 +45,15 @@ let makeDispatcher: any = null
 let DatabaseBridge: any = null
 let getDispatcherType: any = null
 
-export type { SQL, SQLiteArg, SQLiteQuery, NativeDispatcher, SQLiteAdapterOptions }
+// Arguments are passed to native as strings, except arrays, which are bound as a whole to a
+// `bound_array(?)` placeholder
+const encodeParams = (params: any[]): SQLiteQueryArg[] =>
+  params?.map((param: any) => (Array.isArray(param) ? param : `${param}`))
+
+// Identifies queryAsync / execSqlQueryAsync calls to cancelQuery; unique across adapters
+let nextAsyncQueryId = 1
+
+export type { SQL, SQLiteArg, SQLiteQueryArg, SQLiteQuery, NativeDispatcher, SQLiteAdapterOptions }
 
 // Hacky-ish way to create an object with NativeModule-like shape, but that can dispatch method
 // calls to async, synch NativeModule, or JSI implementation w/ type safety in rest of the impl
@@ -261,7 +275,7 @@ export default class SQLiteAdapter implements DatabaseAdapter, SQLDatabaseAdapte
   execSqlQuery(sql: string, params: any[], callback: ResultCallback<CachedQueryResult>): void {
     this._dispatcher.execSqlQuery(
       sql,
-      params?.map((param: any) => `${param}`),
+      encodeParams(params),
       (result) => callback(result),
     )
   }
@@ -270,9 +284,163 @@ export default class SQLiteAdapter implements DatabaseAdapter, SQLDatabaseAdapte
   execSqlQueryOnWriter(sql: string, params: any[], callback: ResultCallback<CachedQueryResult>): void {
     this._dispatcher.execSqlQueryOnWriter(
       sql,
-      params?.map((param: any) => `${param}`),
+      encodeParams(params),
+      (result) => callback(result),
+    )
+  }
+
+  // Like execSqlQuery, but the result holds one array per column (see columnarResult), so native
+  // code creates no object per row. Requires the Turbo Module.
+  execSqlQueryColumnar(
+    sql: string,
+    params: any[],
+    callback: ResultCallback<ColumnarQueryResult>,
+  ): void {
+    if (!this._dispatcher.execSqlQueryColumnar) {
+      callback({
+        error: new Error('execSqlQueryColumnar is only available with the WatermelonDB Turbo Module'),
+      })
+      return
+    }
+    this._dispatcher.execSqlQueryColumnar(
+      sql,
+      encodeParams(params),
+      (result) => callback(result),
+    )
+  }
+
+  // Like execSqlQuery, but the whole result comes back encoded in one ArrayBuffer, decoded on demand
+  // (see packedResult). Meant for bulk reads of many rows. Requires the Turbo Module.
+  execSqlQueryPacked(sql: string, params: any[], callback: ResultCallback<PackedQueryResult>): void {
+    if (!this._dispatcher.execSqlQueryPacked) {
+      callback({
+        error: new Error('execSqlQueryPacked is only available with the WatermelonDB Turbo Module'),
+      })
+      return
+    }
+    this._dispatcher.execSqlQueryPacked(
+      sql,
+      encodeParams(params),
+      (result) => callback(mapValue(decodePackedResult, result)),
+    )
+  }
+
+  // Like execSqlQuery, but each row is a read-only host object that converts a column to a JS value
+  // only when it is read, so code that looks at a few columns of wide rows skips the rest. Rows
+  // are not sanitized (that would read every column) and do not go through the record cache.
+  // Requires the Turbo Module.
+  execSqlQueryLazy(sql: string, params: any[], callback: ResultCallback<DirtyQueryResult>): void {
+    if (!this._dispatcher.execSqlQueryLazy) {
+      callback({
+        error: new Error('execSqlQueryLazy is only available with the WatermelonDB Turbo Module'),
+      })
+      return
+    }
+    this._dispatcher.execSqlQueryLazy(
+      sql,
+      encodeParams(params),
+      (result) => callback(result),
+    )
+  }
+
+  // Like query, but the SQL runs on a native reader thread, so a slow read doesn't block the JS
+  // thread; only the result is built there. Returns a function that cancels the query, after which
+  // the callback gets a "Query cancelled" error instead. Requires the Turbo Module.
+  //
+  // Ordering: the query sees every write whose callback was called before queryAsync, and never a
+  // batch that is still in progress. Writes made after queryAsync may or may not be visible.
+  // Several async queries run in parallel and may call back in any order.
+  queryAsync(query: SerializedQuery, callback: ResultCallback<CachedQueryResult>): () => void {
+    validateTable(query.table, this.schema)
+    const queryAsync = this._dispatcher.queryAsync
+    if (!queryAsync) {
+      callback({ error: new Error('queryAsync is only available with the WatermelonDB Turbo Module') })
+      return () => {}
+    }
+    const { table } = query
+    const requestId = nextAsyncQueryId++
+    queryAsync(table, encodeQuery(query, false, this.schema), requestId, (result) =>
+      callback(
+        mapValue(
+          (rawRecords: any) => sanitizeQueryResult(rawRecords, this.schema.tables[table] as any),
+          result,
+        ),
+      ),
+    )
+    return () => this._cancelQuery(requestId)
+  }
+
+  // Like execSqlQuery, but run on a native reader thread, with queryAsync's cancellation and
+  // ordering. Statements execSqlQuery would send to the writer run synchronously instead. Requires
+  // the Turbo Module.
+  execSqlQueryAsync(
+    sql: string,
+    params: any[],
+    callback: ResultCallback<DirtyQueryResult>,
+  ): () => void {
+    const execSqlQueryAsync = this._dispatcher.execSqlQueryAsync
+    if (!execSqlQueryAsync) {
+      callback({
+        error: new Error('execSqlQueryAsync is only available with the WatermelonDB Turbo Module'),
+      })
+      return () => {}
+    }
+    const requestId = nextAsyncQueryId++
+    execSqlQueryAsync(
+      sql,
+      encodeParams(params),
+      requestId,
       (result) => callback(result),
     )
+    return () => this._cancelQuery(requestId)
+  }
+
+  _cancelQuery(requestId: number): void {
+    this._dispatcher.cancelQuery?.(requestId, () => {})
+  }
+
+  // Opens a cursor over a read-only query, for reading a large result a page at a time with
+  // fetchCursor instead of all at once. All pages come from the same snapshot of the database, so
+  // writes made while paging aren't seen. Until it is done or closed, the cursor holds a reader
+  // connection and keeps the WAL from being checkpointed, so close cursors that aren't read to the
+  // end. Only a few cursors can be open at once. Requires the Turbo Module.
+  openCursor(sql: string, params: any[], callback: ResultCallback<number>): void {
+    const openCursor = this._dispatcher.openCursor
+    if (!openCursor) {
+      callback({ error: new Error('openCursor is only available with the WatermelonDB Turbo Module') })
+      return
+    }
+    openCursor(
+      sql,
+      encodeParams(params),
+      (result) => callback(result),
+    )
+  }
+
+  // Next page of a cursor: at most `maxRows` rows, or fewer if reading them takes longer than
+  // `maxMillis` (0: no limit for either). Once `done`, the cursor is closed.
+  fetchCursor(
+    cursorId: number,
+    maxRows: number,
+    maxMillis: number,
+    callback: ResultCallback<CursorPage>,
+  ): void {
+    const fetchCursor = this._dispatcher.fetchCursor
+    if (!fetchCursor) {
+      callback({ error: new Error('fetchCursor is only available with the WatermelonDB Turbo Module') })
+      return
+    }
+    fetchCursor(cursorId, maxRows, maxMillis, (result) => callback(result))
+  }
+
+  // Releases the cursor's connection. Calls back false if it was already closed.
+  closeCursor(cursorId: number, callback: ResultCallback<boolean>): void {
+    const closeCursor = this._dispatcher.closeCursor
+    if (!closeCursor) {
+      callback({ value: false })
+      return
+    }
+    closeCursor(cursorId, (result) => callback(result))
   }
 
   unsafeSqlQuery(
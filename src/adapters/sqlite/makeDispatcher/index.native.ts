@@ -14,15 +14,31 @@ import type {
   SQLiteAdapterOptions,
   NativeDispatcher,
   NativeBridgeType,
+  CursorPage,
 } from '../type'
 
 import { syncReturnToResult } from '../common'
+import type { ColumnarQueryResult } from '../columnarResult'
 
 // Local type definition for the Turbo Module
 type NativeWatermelonDBModuleSpec = {
   query(tag: number, table: string, query: string): Record<string, any>[]
   execSqlQuery(tag: number, sql: string, args: Record<string, any>[]): Record<string, any>[]
   execSqlQueryOnWriter(tag: number, sql: string, args: Record<string, any>[]): Record<string, any>[]
+  execSqlQueryColumnar(tag: number, sql: string, args: Record<string, any>[]): ColumnarQueryResult
+  execSqlQueryPacked(tag: number, sql: string, args: Record<string, any>[]): ArrayBuffer
+  execSqlQueryLazy(tag: number, sql: string, args: Record<string, any>[]): Record<string, any>[]
+  queryAsync(tag: number, table: string, query: string, requestId: number): Promise<Record<string, any>[]>
+  execSqlQueryAsync(
+    tag: number,
+    sql: string,
+    args: Record<string, any>[],
+    requestId: number,
+  ): Promise<Record<string, any>[]>
+  cancelQuery(requestId: number): boolean
+  openCursor(tag: number, sql: string, args: Record<string, any>[]): number
+  fetchCursor(cursorId: number, maxRows: number, maxMillis: number): CursorPage
+  closeCursor(cursorId: number): boolean
   configureSync(configJson: string): void
   startSync(reason: string): void
   getSyncStateJson(): string
@@ -80,13 +96,47 @@ const dispatcherMethods = [
   'removeLocal',
   'execSqlQuery',
   'execSqlQueryOnWriter',
+  'execSqlQueryColumnar',
+  'execSqlQueryPacked',
+  'execSqlQueryLazy',
+  'queryAsync',
+  'execSqlQueryAsync',
+  'cancelQuery',
+  'openCursor',
+  'fetchCursor',
+  'closeCursor',
   'enableNativeCDC',
   'disableNativeCDC',
   'setCDCEnabled',
 ]
 
 const supportedHybridJSIMethods = new Set(['query', 'execSqlQuery', 'execSqlQueryOnWriter'])
-const supportedTurboModuleMethods = new Set(['query', 'execSqlQuery', 'execSqlQueryOnWriter'])
+const supportedTurboModuleMethods = new Set([
+  'query',
+  'execSqlQuery',
+  'execSqlQueryOnWriter',
+  'execSqlQueryColumnar',
+  'execSqlQueryPacked',
+  'execSqlQueryLazy',
+  'queryAsync',
+  'execSqlQueryAsync',
+  'cancelQuery',
+  'openCursor',
+  'fetchCursor',
+  'closeCursor',
+])
+// Only implemented by the Turbo Module
+const turboModuleOnlyMethods = new Set([
+  'execSqlQueryColumnar',
+  'execSqlQueryPacked',
+  'execSqlQueryLazy',
+  'queryAsync',
+  'execSqlQueryAsync',
+  'cancelQuery',
+  'openCursor',
+  'fetchCursor',
+  'closeCursor',
+])
 
 export const makeDispatcher = (
   type: DispatcherType,
@@ -95,9 +145,16 @@ export const makeDispatcher = (
   useHybridJSI?: boolean,
 ): NativeDispatcher => {
   const methods = dispatcherMethods.map((methodName) => {
+    if (turboModuleOnlyMethods.has(methodName) && !NativeWatermelonDBModule) {
+      return [methodName, undefined]
+    }
+
     // batchJSON is missing on Android, and not available when using Hybrid JSI
-    // @ts-ignore
-    if (!DatabaseBridge[methodName] || (methodName === 'batchJSON' && useHybridJSI)) {
+    if (
+      !turboModuleOnlyMethods.has(methodName) &&
+      // @ts-ignore
+      (!DatabaseBridge[methodName] || (methodName === 'batchJSON' && useHybridJSI))
+    ) {
       return [methodName, undefined]
     }
 
@@ -111,6 +168,24 @@ export const makeDispatcher = (
 
         // Use Turbo Module if available for supported methods
         if (NativeWatermelonDBModule && supportedTurboModuleMethods.has(methodName)) {
+          if (methodName === 'queryAsync' || methodName === 'execSqlQueryAsync') {
+            // Read on a native reader thread; the callback runs once the promise settles
+            let promise: Promise<any>
+            try {
+              if (methodName === 'queryAsync') {
+                const [table, query, requestId] = otherArgs
+                promise = NativeWatermelonDBModule.queryAsync(tag, table, query, requestId)
+              } else {
+                const [sql, args, requestId] = otherArgs
+                promise = NativeWatermelonDBModule.execSqlQueryAsync(tag, sql, args, requestId)
+              }
+            } catch (error: any) {
+              callback({ error })
+              return
+            }
+            fromPromise(promise, callback)
+            return
+          }
           try {
             let returnValue: any
             if (methodName === 'query') {
@@ -125,6 +200,31 @@ export const makeDispatcher = (
               // For execSqlQueryOnWriter method: always uses writer connection
               const [sql, args] = otherArgs
               returnValue = NativeWatermelonDBModule.execSqlQueryOnWriter(tag, sql, args)
+            } else if (methodName === 'execSqlQueryColumnar') {
+              // Same connection routing as execSqlQuery, one array per column
+              const [sql, args] = otherArgs
+              returnValue = NativeWatermelonDBModule.execSqlQueryColumnar(tag, sql, args)
+            } else if (methodName === 'execSqlQueryPacked') {
+              // Same connection routing as execSqlQuery, the result encoded in one ArrayBuffer
+              const [sql, args] = otherArgs
+              returnValue = NativeWatermelonDBModule.execSqlQueryPacked(tag, sql, args)
+            } else if (methodName === 'execSqlQueryLazy') {
+              // Same connection routing as execSqlQuery, rows read lazily from a native snapshot
+              const [sql, args] = otherArgs
+              returnValue = NativeWatermelonDBModule.execSqlQueryLazy(tag, sql, args)
+            } else if (methodName === 'cancelQuery') {
+              const [requestId] = otherArgs
+              returnValue = NativeWatermelonDBModule.cancelQuery(requestId)
+            } else if (methodName === 'openCursor') {
+              // Always on a reader connection; the SQL must be read-only
+              const [sql, args] = otherArgs
+              returnValue = NativeWatermelonDBModule.openCursor(tag, sql, args)
+            } else if (methodName === 'fetchCursor') {
+              const [cursorId, maxRows, maxMillis] = otherArgs
+              returnValue = NativeWatermelonDBModule.fetchCursor(cursorId, maxRows, maxMillis)
+            } else if (methodName === 'closeCursor') {
+              const [cursorId] = otherArgs
+              returnValue = NativeWatermelonDBModule.closeCursor(cursorId)
             }
             callback({
               value: returnValue,
@@ -0,0 +1,148 @@
+import type { RawRecord } from '../../../RawRecord'
+
+// Reader for execSqlQueryPacked results: the rows of a query encoded in one ArrayBuffer (format in
+// native/shared/PackedResult.h). Column names and row offsets are read up front; cells are decoded
+// only when asked for.
+
+const MAGIC = 0x4b504d57 // "WMPK"
+const VERSION = 1
+const HEADER_SIZE = 16
+
+const TAG_NULL = 0
+const TAG_NUMBER = 1
+const TAG_TEXT = 2
+
+type CellValue = string | number | null
+
+// @ts-ignore
+const textDecoder: any = typeof TextDecoder !== 'undefined' ? new TextDecoder('utf-8') : null
+
+function decodeUtf8(bytes: Uint8Array, start: number, end: number): string {
+  if (textDecoder) {
+    return textDecoder.decode(bytes.subarray(start, end))
+  }
+  let result = ''
+  let i = start
+  while (i < end) {
+    const byte = bytes[i]
+    let codePoint
+    if (byte < 0x80) {
+      codePoint = byte
+      i += 1
+    } else if (byte < 0xe0) {
+      codePoint = ((byte & 0x1f) << 6) | (bytes[i + 1] & 0x3f)
+      i += 2
+    } else if (byte < 0xf0) {
+      codePoint = ((byte & 0x0f) << 12) | ((bytes[i + 1] & 0x3f) << 6) | (bytes[i + 2] & 0x3f)
+      i += 3
+    } else {
+      codePoint =
+        ((byte & 0x07) << 18) |
+        ((bytes[i + 1] & 0x3f) << 12) |
+        ((bytes[i + 2] & 0x3f) << 6) |
+        (bytes[i + 3] & 0x3f)
+      i += 4
+    }
+    result += String.fromCodePoint(codePoint)
+  }
+  return result
+}
+
+export class PackedQueryResult {
+  columns: string[]
+
+  rowCount: number
+
+  _view: DataView
+
+  _bytes: Uint8Array
+
+  _rowOffsetsAt: number
+
+  constructor(buffer: ArrayBuffer) {
+    const view = new DataView(buffer)
+    if (buffer.byteLength < HEADER_SIZE || view.getUint32(0, true) !== MAGIC) {
+      throw new Error('Not a packed query result')
+    }
+    if (view.getUint8(4) !== VERSION) {
+      throw new Error(`Unsupported packed query result version ${view.getUint8(4)}`)
+    }
+    this._view = view
+    this._bytes = new Uint8Array(buffer)
+    this.rowCount = view.getUint32(8, true)
+    this._rowOffsetsAt = view.getUint32(12, true)
+
+    const columnCount = view.getUint16(6, true)
+    const columns = new Array(columnCount)
+    let at = HEADER_SIZE
+    for (let i = 0; i < columnCount; i += 1) {
+      const length = view.getUint32(at, true)
+      columns[i] = decodeUtf8(this._bytes, at + 4, at + 4 + length)
+      at += 4 + length
+    }
+    this.columns = columns
+  }
+
+  // Value of `column` (an index into `columns`) in row `rowIndex`
+  value(rowIndex: number, column: number): CellValue {
+    let at = this._rowStart(rowIndex)
+    for (let i = 0; i < column; i += 1) {
+      at = this._skipCell(at)
+    }
+    return this._readCell(at)
+  }
+
+  // The row at `rowIndex` as a plain object, the shape execSqlQuery returns
+  row(rowIndex: number): RawRecord {
+    const { columns } = this
+    const row: { [column: string]: any } = {}
+    let at = this._rowStart(rowIndex)
+    for (let i = 0; i < columns.length; i += 1) {
+      row[columns[i]] = this._readCell(at)
+      at = this._skipCell(at)
+    }
+    return row as RawRecord
+  }
+
+  rows(): RawRecord[] {
+    const rows = new Array(this.rowCount)
+    for (let i = 0; i < this.rowCount; i += 1) {
+      rows[i] = this.row(i)
+    }
+    return rows
+  }
+
+  _rowStart(rowIndex: number): number {
+    if (rowIndex < 0 || rowIndex >= this.rowCount) {
+      throw new Error(`Row ${rowIndex} out of range (${this.rowCount} rows)`)
+    }
+    return this._view.getUint32(this._rowOffsetsAt + rowIndex * 4, true)
+  }
+
+  _readCell(at: number): CellValue {
+    const tag = this._bytes[at]
+    if (tag === TAG_NUMBER) {
+      return this._view.getFloat64(at + 1, true)
+    } else if (tag === TAG_TEXT) {
+      const length = this._view.getUint32(at + 1, true)
+      return decodeUtf8(this._bytes, at + 5, at + 5 + length)
+    }
+    return null
+  }
+
+  _skipCell(at: number): number {
+    const tag = this._bytes[at]
+    if (tag === TAG_NUMBER) {
+      return at + 9
+    } else if (tag === TAG_TEXT) {
+      return at + 5 + this._view.getUint32(at + 1, true)
+    }
+    return at + 1
+  }
+}
+
+export function decodePackedResult(buffer: ArrayBuffer): PackedQueryResult {
+  return new PackedQueryResult(buffer)
+}
+
+export { TAG_NULL, TAG_NUMBER, TAG_TEXT }
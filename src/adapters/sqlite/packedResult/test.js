@@ -0,0 +1,105 @@
+import { decodePackedResult, TAG_NULL, TAG_NUMBER, TAG_TEXT } from './index'
+
+// Same layout as encodePackedResult (native/shared/PackedResult.cpp)
+function encode(columns, rows) {
+  const encoder = new TextEncoder()
+  const parts = []
+  const push = (size, write) => {
+    const bytes = new Uint8Array(size)
+    write(new DataView(bytes.buffer), bytes)
+    parts.push(bytes)
+  }
+  const sizeSoFar = () => parts.reduce((sum, part) => sum + part.length, 0)
+
+  push(16, (view) => {
+    view.setUint32(0, 0x4b504d57, true)
+    view.setUint8(4, 1)
+    view.setUint16(6, columns.length, true)
+    view.setUint32(8, rows.length, true)
+  })
+  columns.forEach((name) => {
+    const bytes = encoder.encode(name)
+    push(4 + bytes.length, (view, out) => {
+      view.setUint32(0, bytes.length, true)
+      out.set(bytes, 4)
+    })
+  })
+  const offsets = rows.map((row) => {
+    const offset = sizeSoFar()
+    row.forEach((value) => {
+      if (value === null) {
+        push(1, (view) => view.setUint8(0, TAG_NULL))
+      } else if (typeof value === 'number') {
+        push(9, (view) => {
+          view.setUint8(0, TAG_NUMBER)
+          view.setFloat64(1, value, true)
+        })
+      } else {
+        const bytes = encoder.encode(value)
+        push(5 + bytes.length, (view, out) => {
+          view.setUint8(0, TAG_TEXT)
+          view.setUint32(1, bytes.length, true)
+          out.set(bytes, 5)
+        })
+      }
+    })
+    return offset
+  })
+  const offsetsAt = sizeSoFar()
+  push(offsets.length * 4, (view) => offsets.forEach((offset, i) => view.setUint32(i * 4, offset, true)))
+
+  const buffer = new Uint8Array(sizeSoFar())
+  parts.reduce((at, part) => {
+    buffer.set(part, at)
+    return at + part.length
+  }, 0)
+  new DataView(buffer.buffer).setUint32(12, offsetsAt, true)
+  return buffer.buffer
+}
+
+const columns = ['id', 'position', 'name']
+const rows = [
+  ['t1', 1, 'alpha'],
+  ['t2', -2.5, null],
+  ['t3', 3, 'zażółć 🍉'],
+]
+
+describe('SQLite packedResult', () => {
+  it('reads the header', () => {
+    const result = decodePackedResult(encode(columns, rows))
+    expect(result.columns).toEqual(columns)
+    expect(result.rowCount).toBe(3)
+  })
+  it('reads single cells', () => {
+    const result = decodePackedResult(encode(columns, rows))
+    expect(result.value(1, 1)).toBe(-2.5)
+    expect(result.value(1, 2)).toBe(null)
+    expect(result.value(2, 2)).toBe('zażółć 🍉')
+    expect(() => result.value(3, 0)).toThrow()
+  })
+  it('hydrates rows', () => {
+    const result = decodePackedResult(encode(columns, rows))
+    expect(result.rows()).toEqual([
+      { id: 't1', position: 1, name: 'alpha' },
+      { id: 't2', position: -2.5, name: null },
+      { id: 't3', position: 3, name: 'zażółć 🍉' },
+    ])
+    expect(decodePackedResult(encode(['id'], [])).rows()).toEqual([])
+  })
+  it('decodes UTF-8 without TextDecoder', () => {
+    const { TextDecoder: savedTextDecoder } = global
+    delete global.TextDecoder
+    try {
+      jest.isolateModules(() => {
+        // eslint-disable-next-line global-require
+        const { decodePackedResult: decode } = require('./index')
+        expect(decode(encode(columns, rows)).row(2)).toEqual({ id: 't3', position: 3, name: 'zażółć 🍉' })
+      })
+    } finally {
+      global.TextDecoder = savedTextDecoder
+    }
+  })
+  it('rejects other buffers', () => {
+    expect(() => decodePackedResult(new ArrayBuffer(16))).toThrow('Not a packed query result')
+  })
+})
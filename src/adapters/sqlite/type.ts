@@ -6,10 +6,14 @@ import type { AppSchema, TableName, SchemaVersion } from '../../Schema'
 import type { SchemaMigrations } from '../../Schema/migrations'
 
 import { DirtyFindResult, DirtyQueryResult } from '../common'
+import type { ColumnarQueryResult } from './columnarResult'
 
 export type SQL = string
 export type SQLiteArg = string | boolean | number | null
 export type SQLiteQuery = [SQL, SQLiteArg[]]
+// execSqlQuery* arguments; an array is bound as a whole to one `bound_array(?)` placeholder
+// (`WHERE id IN bound_array(?)`) by the Turbo Module, whatever its length
+export type SQLiteQueryArg = SQLiteArg | SQLiteArg[]
 
 export type SQLiteAdapterOptions = {
   dbName?: string
@@ -20,6 +24,9 @@ export type SQLiteAdapterOptions = {
   onReady?: () => void
 }
 
+// One fetchCursor page; `done` once the cursor has no more rows (and is closed)
+export type CursorPage = { rows: DirtyQueryResult; done: boolean }
+
 export type DispatcherType = 'asynchronous' | 'synchronous'
 
 export type NativeBridgeBatchOperation =
@@ -81,8 +88,32 @@ export type NativeDispatcher = {
   setLocal: (arg1: string, arg2: string, arg3: ResultCallback<undefined>) => void
   removeLocal: (arg1: string, arg2: ResultCallback<undefined>) => void
   copyTables: (tables: any, srcDB: any, callback: ResultCallback<undefined>) => void
-  execSqlQuery: (arg1: SQL, arg2: SQLiteArg[], arg3: ResultCallback<DirtyQueryResult>) => void
-  execSqlQueryOnWriter: (arg1: SQL, arg2: SQLiteArg[], arg3: ResultCallback<DirtyQueryResult>) => void
+  execSqlQuery: (arg1: SQL, arg2: SQLiteQueryArg[], arg3: ResultCallback<DirtyQueryResult>) => void
+  execSqlQueryOnWriter: (arg1: SQL, arg2: SQLiteQueryArg[], arg3: ResultCallback<DirtyQueryResult>) => void
+  // Only with the Turbo Module (React Native JSI)
+  execSqlQueryColumnar?: (
+    arg1: SQL,
+    arg2: SQLiteQueryArg[],
+    arg3: ResultCallback<ColumnarQueryResult>,
+  ) => void
+  execSqlQueryPacked?: (arg1: SQL, arg2: SQLiteQueryArg[], arg3: ResultCallback<ArrayBuffer>) => void
+  execSqlQueryLazy?: (arg1: SQL, arg2: SQLiteQueryArg[], arg3: ResultCallback<DirtyQueryResult>) => void
+  queryAsync?: (
+    arg1: TableName<any>,
+    arg2: SQL,
+    arg3: number,
+    arg4: ResultCallback<DirtyQueryResult>,
+  ) => void
+  execSqlQueryAsync?: (
+    arg1: SQL,
+    arg2: SQLiteQueryArg[],
+    arg3: number,
+    arg4: ResultCallback<DirtyQueryResult>,
+  ) => void
+  cancelQuery?: (arg1: number, arg2: ResultCallback<boolean>) => void
+  openCursor?: (arg1: SQL, arg2: SQLiteQueryArg[], arg3: ResultCallback<number>) => void
+  fetchCursor?: (arg1: number, arg2: number, arg3: number, arg4: ResultCallback<CursorPage>) => void
+  closeCursor?: (arg1: number, arg2: ResultCallback<boolean>) => void
   enableNativeCDC: (arg1: ResultCallback<undefined>) => void
   disableNativeCDC: (arg1: ResultCallback<undefined>) => void
   setCDCEnabled?: (enabled: boolean, callback: ResultCallback<undefined>) => void
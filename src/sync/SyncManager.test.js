@@ -15,6 +15,9 @@ const makeModule = () => {
     syncSocketAuthenticate: jest.fn(),
     syncSocketDisconnect: jest.fn(),
     importRemoteSlice: jest.fn(() => Promise.resolve()),
+    exportSlice: jest.fn(() => Promise.resolve({ tables: 1, rows: 0 })),
+    attachReferenceSlice: jest.fn(),
+    detachReferenceSlice: jest.fn(),
     cancelSync: jest.fn(),
     configureBackgroundSync: jest.fn(),
     enableBackgroundSync: jest.fn(),
@@ -288,7 +291,90 @@ describe('SyncManager', () => {
     })
 
     await SyncManager.importRemoteSlice('https://example.com/slice')
-    expect(nativeSync.importRemoteSlice).toHaveBeenCalledWith(7, 'https://example.com/slice')
+    expect(nativeSync.importRemoteSlice).toHaveBeenCalledWith(7, 'https://example.com/slice', undefined)
+
+    const options = { commitMode: 'priorityGroups', priorityGroups: [['users', 'projects']] }
+    await SyncManager.importRemoteSlice('https://example.com/slice', options)
+    expect(nativeSync.importRemoteSlice).toHaveBeenLastCalledWith(7, 'https://example.com/slice', options)
+  })
+
+  it('applies the changeset of a delta slice import', async () => {
+    const { SyncManager, nativeSync } = makeModule()
+    const notify = jest.fn()
+    const applyNativePullChanges = jest.fn(() => Promise.resolve())
+    const database = { schema: { tables: { tasks: {}, projects: {} } }, notify, applyNativePullChanges }
+    SyncManager.configure({
+      database,
+      adapter: { _tag: 1 },
+      pushChangesProvider: jest.fn(),
+      pullChangesUrl: 'https://example.com/pull',
+    })
+
+    const changeSet = { tasks: { upserted: ['t1'], deleted: ['t2'] } }
+    nativeSync.importRemoteSlice.mockResolvedValueOnce(JSON.stringify({ changeset: changeSet, error: null }))
+    await SyncManager.importRemoteSlice('https://example.com/delta.slice')
+    expect(applyNativePullChanges).toHaveBeenCalledWith(changeSet)
+    expect(notify).not.toHaveBeenCalled()
+
+    // A plain slice reports no changes: nothing to refresh
+    nativeSync.importRemoteSlice.mockResolvedValueOnce(JSON.stringify({ changeset: {}, error: null }))
+    await SyncManager.importRemoteSlice('https://example.com/full.slice')
+    expect(applyNativePullChanges).toHaveBeenCalledTimes(1)
+    expect(notify).not.toHaveBeenCalled()
+  })
+
+  it('applies the committed changeset then rejects when a slice import fails', async () => {
+    const { SyncManager, nativeSync } = makeModule()
+    const applyNativePullChanges = jest.fn(() => Promise.resolve())
+    const database = { schema: { tables: { tasks: {} } }, notify: jest.fn(), applyNativePullChanges }
+    SyncManager.configure({
+      database,
+      adapter: { _tag: 1 },
+      pushChangesProvider: jest.fn(),
+      pullChangesUrl: 'https://example.com/pull',
+    })
+
+    const changeSet = { tasks: { upserted: ['t1'], deleted: [] } }
+    nativeSync.importRemoteSlice.mockResolvedValueOnce(
+      JSON.stringify({ changeset: changeSet, error: 'Stream ended with unparsed bytes' }),
+    )
+    await expect(
+      SyncManager.importRemoteSlice('https://example.com/delta.slice', { commitMode: 'table' }),
+    ).rejects.toThrow('Stream ended with unparsed bytes')
+    expect(applyNativePullChanges).toHaveBeenCalledWith(changeSet)
+  })
+
+  it('routes exportSlice through to native', async () => {
+    const { SyncManager, nativeSync } = makeModule()
+    expect(() => SyncManager.exportSlice('/tmp/backup.slice')).toThrow(
+      '[WatermelonDB][Sync] SyncManager.configure(...) must be called before exportSlice.',
+    )
+    SyncManager.configure({
+      adapter: { _tag: 7 },
+      pushChangesProvider: jest.fn(),
+      pullChangesUrl: 'https://example.com/pull',
+    })
+
+    const options = { tables: ['tasks'], compressionLevel: 9 }
+    await SyncManager.exportSlice('/tmp/backup.slice', options)
+    expect(nativeSync.exportSlice).toHaveBeenCalledWith(7, '/tmp/backup.slice', options)
+  })
+
+  it('routes reference slice attachment through to native', () => {
+    const { SyncManager, nativeSync } = makeModule()
+    expect(() => SyncManager.attachReferenceSlice('/tmp/catalog.db', 'catalog')).toThrow(
+      '[WatermelonDB][Sync] SyncManager.configure(...) must be called before attachReferenceSlice.',
+    )
+    SyncManager.configure({
+      adapter: { _tag: 7 },
+      pushChangesProvider: jest.fn(),
+      pullChangesUrl: 'https://example.com/pull',
+    })
+
+    SyncManager.attachReferenceSlice('/tmp/catalog.db', 'catalog')
+    expect(nativeSync.attachReferenceSlice).toHaveBeenCalledWith(7, '/tmp/catalog.db', 'catalog')
+    SyncManager.detachReferenceSlice('catalog')
+    expect(nativeSync.detachReferenceSlice).toHaveBeenCalledWith(7, 'catalog')
   })
 
   it('syncDatabaseAsync resolves', async () => {
@@ -15,12 +15,20 @@ import {
   syncSocketAuthenticate as nativeSyncSocketAuthenticate,
   syncSocketDisconnect as nativeSyncSocketDisconnect,
   importRemoteSlice as nativeImportRemoteSlice,
+  exportSlice as nativeExportSlice,
+  attachReferenceSlice as nativeAttachReferenceSlice,
+  detachReferenceSlice as nativeDetachReferenceSlice,
   cancelSync as nativeCancelSync,
   configureBackgroundSync as nativeConfigureBackgroundSync,
   enableBackgroundSync as nativeEnableBackgroundSync,
   disableBackgroundSync as nativeDisableBackgroundSync,
 } from './nativeSync'
-import type { BackgroundSyncConfig } from './nativeSync'
+import type {
+  BackgroundSyncConfig,
+  SliceImportOptions,
+  SliceExportOptions,
+  SliceExportResult,
+} from './nativeSync'
 
 export type SyncState = {
   state?: string
@@ -287,13 +295,56 @@ export class SyncManager {
     SyncManager.initSocket(socketUrl)
   }
 
-  static importRemoteSlice(sliceUrl: string): Promise<void> {
+  static importRemoteSlice(sliceUrl: string, options?: SliceImportOptions): Promise<void> {
     SyncManager.assertConfigured('importRemoteSlice')
     const tag = SyncManager.connectionTag
     if (!tag) {
       throw new Error('[WatermelonDB][Sync] importRemoteSlice requires a configured database or adapter.')
     }
-    return nativeImportRemoteSlice(tag, sliceUrl)
+    // Delta slices update and delete records behind the JS layer's back, like a native pull: apply
+    // the changeset they report (refresh cached records, wake observers), then rethrow any error. A
+    // failed import with progressive commits may still have committed some of its changes.
+    return nativeImportRemoteSlice(tag, sliceUrl, options).then((resultJson) =>
+      SyncManager.applySliceImportResult(resultJson),
+    )
+  }
+
+  private static applySliceImportResult(resultJson: string | void): Promise<void> {
+    const { changeSet, error } = SyncManager.parsePullResult(resultJson)
+    const hasChanges = changeSet !== null && Object.keys(changeSet).length > 0
+    // Plain slices report no changeset: there is nothing cached to refresh
+    return (hasChanges ? SyncManager.refreshFromChangeSet(changeSet) : Promise.resolve()).then(() => {
+      if (error) {
+        throw new Error(error)
+      }
+    })
+  }
+
+  static exportSlice(path: string, options?: SliceExportOptions): Promise<SliceExportResult> {
+    SyncManager.assertConfigured('exportSlice')
+    const tag = SyncManager.connectionTag
+    if (!tag) {
+      throw new Error('[WatermelonDB][Sync] exportSlice requires a configured database or adapter.')
+    }
+    return nativeExportSlice(tag, path, options)
+  }
+
+  static attachReferenceSlice(path: string, alias: string): void {
+    SyncManager.assertConfigured('attachReferenceSlice')
+    const tag = SyncManager.connectionTag
+    if (!tag) {
+      throw new Error('[WatermelonDB][Sync] attachReferenceSlice requires a configured database or adapter.')
+    }
+    nativeAttachReferenceSlice(tag, path, alias)
+  }
+
+  static detachReferenceSlice(alias: string): void {
+    SyncManager.assertConfigured('detachReferenceSlice')
+    const tag = SyncManager.connectionTag
+    if (!tag) {
+      throw new Error('[WatermelonDB][Sync] detachReferenceSlice requires a configured database or adapter.')
+    }
+    nativeDetachReferenceSlice(tag, alias)
   }
 
   static cancelSync(): void {
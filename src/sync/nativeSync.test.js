@@ -13,6 +13,11 @@ const makeTurboModule = () => ({
   syncSocketAuthenticate: jest.fn(),
   syncSocketDisconnect: jest.fn(),
   importRemoteSlice: jest.fn(() => Promise.resolve()),
+  exportSlice: jest.fn(() =>
+    Promise.resolve('{"tables":1,"rows":2,"uncompressedBytes":30,"compressedBytes":20}'),
+  ),
+  attachReferenceSlice: jest.fn(),
+  detachReferenceSlice: jest.fn(),
   cancelSync: jest.fn(),
   configureBackgroundSync: jest.fn(),
   enableBackgroundSync: jest.fn(),
@@ -107,7 +112,30 @@ describe('nativeSync', () => {
     expect(moduleInstance.initSyncSocket).toHaveBeenCalledWith('wss://example.com')
     expect(moduleInstance.syncSocketAuthenticate).toHaveBeenCalledWith('token')
     expect(moduleInstance.syncSocketDisconnect).toHaveBeenCalledWith()
-    expect(moduleInstance.importRemoteSlice).toHaveBeenCalledWith(3, 'https://example.com/slice')
+    expect(moduleInstance.importRemoteSlice).toHaveBeenCalledWith(3, 'https://example.com/slice', '{}')
+  })
+
+  it('serializes exportSlice options and parses the result', async () => {
+    const moduleInstance = makeTurboModule()
+    const nativeSync = setupModule(moduleInstance)
+
+    const result = await nativeSync.exportSlice(3, '/tmp/backup.slice', { tables: ['tasks'] })
+    expect(moduleInstance.exportSlice).toHaveBeenCalledWith(
+      3,
+      '/tmp/backup.slice',
+      '{"tables":["tasks"]}',
+    )
+    expect(result).toEqual({ tables: 1, rows: 2, uncompressedBytes: 30, compressedBytes: 20 })
+  })
+
+  it('passes through reference slice attachment', () => {
+    const moduleInstance = makeTurboModule()
+    const nativeSync = setupModule(moduleInstance)
+
+    nativeSync.attachReferenceSlice(3, '/tmp/catalog.db', 'catalog')
+    expect(moduleInstance.attachReferenceSlice).toHaveBeenCalledWith(3, '/tmp/catalog.db', 'catalog')
+    nativeSync.detachReferenceSlice(3, 'catalog')
+    expect(moduleInstance.detachReferenceSlice).toHaveBeenCalledWith(3, 'catalog')
   })
 
   it('passes through cancelSync', () => {
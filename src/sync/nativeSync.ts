@@ -22,7 +22,10 @@ interface NativeSyncModule extends TurboModule {
   configureBackgroundSync(configJson: string): void
   enableBackgroundSync(): void
   disableBackgroundSync(): void
-  importRemoteSlice(tag: number, sliceUrl: string): Promise<void>
+  importRemoteSlice(tag: number, sliceUrl: string, optionsJson: string): Promise<string | void>
+  exportSlice(tag: number, path: string, optionsJson: string): Promise<string>
+  attachReferenceSlice(tag: number, path: string, alias: string): void
+  detachReferenceSlice(tag: number, alias: string): void
 }
 
 type SyncConfig = Record<string, any>
@@ -150,7 +153,108 @@ export function disableBackgroundSync(): void {
   module.disableBackgroundSync()
 }
 
-export function importRemoteSlice(tag: number, sliceUrl: string): Promise<void> {
+// 'atomic' (default): the whole slice commits at once.
+// 'table': commits after every table; tables already committed survive a failed import.
+// 'priorityGroups': commits each group of `priorityGroups` as soon as it is loaded, so the listed
+// tables become queryable before the rest of the slice arrives. Unlisted tables form a last group.
+// Every intermediate commit emits a { type: 'slice_commit', tables, rowsCommitted } sync event.
+// bulkLoad: tables that are empty before the import are loaded with their (non-unique) indexes
+// dropped, and the indexes are rebuilt once the table is loaded. Recommended for first imports.
+// sortById (experimental): each batch of a table is inserted in id order. Only batches are sorted,
+// not the whole slice, and no repeatable speedup has been measured yet.
+// bootstrap: the slice is imported into a separate database file (no journal, no fsync) that is
+// copied over the app database at the end, so JS reads are not blocked during the import. The
+// copy is one write of the whole database through the WAL, which is truncated afterwards unless
+// readers keep it busy. Fails if the app database is written to during the import. Always atomic;
+// implies bulkLoad.
+// cache: keep the compressed slice in the app's cache directory (LRU, capped at cacheMaxBytes,
+// 512 MB by default). cacheKey (the slice's ETag, or `${sliceId}@${version}`) looks the slice up
+// before downloading, so re-importing the same version after a logout or reset reads it from disk.
+// Without a cacheKey, downloads are stored under `${sliceId}@${version}`. cacheKey implies cache.
+// patchFrom: the URL points to a patch (`zstd --patch-from=<previous slice, decompressed>`) instead
+// of a full slice, and this is the cache key of the previous version it was made against, e.g.
+// `tasks@41`. The new version is cached as a full slice. Rejects if the previous version isn't
+// cached, in which case the full slice should be imported instead. patchFrom implies cache.
+// skipTables / columns: tables to leave out, and per-table column allowlists. Excluded fields are
+// skipped by the decoder without being copied. projectToLocalSchema additionally drops columns the
+// local table doesn't have, and skips tables that don't exist locally.
+// referencePath: for read-only catalogs. The slice is written into a standalone database file at
+// this path instead of the app database, with the indexes listed in referenceIndexes
+// ({ table: [[column, ...], ...] }) built once at the end. The file is replaced only once the new
+// one is complete; attach it with attachReferenceSlice. Always atomic; can't be combined with
+// bootstrap or projectToLocalSchema.
+export type SliceImportOptions = {
+  commitMode?: 'atomic' | 'table' | 'priorityGroups'
+  priorityGroups?: string[][]
+  bulkLoad?: boolean
+  sortById?: boolean
+  bootstrap?: boolean
+  cache?: boolean
+  cacheKey?: string
+  cacheMaxBytes?: number
+  patchFrom?: string
+  skipTables?: string[]
+  columns?: { [tableName: string]: string[] }
+  projectToLocalSchema?: boolean
+  referencePath?: string
+  referenceIndexes?: { [tableName: string]: string[][] }
+}
+
+// Resolves the JSON envelope { changeset, error } once the import has run, like syncDatabaseAsync:
+// changeset lists the records a delta slice upserted or deleted, per table. SyncManager applies it
+// and rethrows the error — see SyncManager.importRemoteSlice.
+export function importRemoteSlice(
+  tag: number,
+  sliceUrl: string,
+  options: SliceImportOptions = {},
+): Promise<string | void> {
+  const module = getNativeModule()
+  return module.importRemoteSlice(tag, sliceUrl, JSON.stringify(options))
+}
+
+// tables: tables to export, in order (default: every synced table, i.e. every table with a _status
+// column). _status and _changed are not exported and rows pending deletion are skipped; importing
+// the slice marks every row synced, so unpushed local changes are lost and the slice is not a
+// backup. Values keep their SQLite types, and empty strings stay empty strings (slices written
+// before this version, or read by an older build, turn them into NULL).
+// compressionLevel is the zstd level (default 3, up to 19).
+// The slice is written to `path` (a local file path) and can be imported elsewhere with
+// importRemoteSlice(tag, path).
+export type SliceExportOptions = {
+  tables?: string[]
+  sliceId?: string
+  version?: number
+  priority?: string
+  compressionLevel?: number
+}
+
+export type SliceExportResult = {
+  tables: number
+  rows: number
+  uncompressedBytes: number
+  compressedBytes: number
+}
+
+export async function exportSlice(
+  tag: number,
+  path: string,
+  options: SliceExportOptions = {},
+): Promise<SliceExportResult> {
+  const module = getNativeModule()
+  const resultJson = await module.exportSlice(tag, path, JSON.stringify(options))
+  return JSON.parse(resultJson)
+}
+
+// Attaches the reference database at `path` to the writer and reader connections as schema `alias`,
+// and exposes each of its tables through a temp view of the same name, so queries on e.g.
+// `price_book` read the catalog instead of the (empty) app table. Views are read-only. Call again
+// after re-importing the reference slice to switch to the new file.
+export function attachReferenceSlice(tag: number, path: string, alias: string): void {
+  const module = getNativeModule()
+  module.attachReferenceSlice(tag, path, alias)
+}
+
+export function detachReferenceSlice(tag: number, alias: string): void {
   const module = getNativeModule()
-  return module.importRemoteSlice(tag, sliceUrl)
+  module.detachReferenceSlice(tag, alias)
 }